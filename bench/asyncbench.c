@@ -0,0 +1,340 @@
+/* asyncbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Compares touch_many() driven by the asynchronous batch executor against the
+// same calls run one at a time, in each of the given directories. Running it
+// once on tmpfs and once on a disk file system shows how much of the gain
+// comes from fewer system calls and how much from overlapping I/O. Every run
+// is checked: all files must exist afterwards and carry the expected times.
+//
+// Usage: asyncbench [-n COUNT] [-r ROUNDS] [DIR]...
+//
+//   -n COUNT    Number of files per scenario (default 10000).
+//   -r ROUNDS   Number of times each scenario is run, best one wins (default 5).
+//   DIR         Directories to run in, such as /dev/shm and /var/tmp (default .).
+//
+// The backend must be built with FS_COUNT_SYSCALLS for system calls to be
+// counted; CMake does that for this target.
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "touchop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define BENCH_PATH_CAPACITY 512
+
+// 2001-01-01T00:00:00Z, the time existing files start out with
+#define BASE_TIME 126227808000000000ULL
+
+#define ADJUST_SECONDS (-3600)
+
+typedef enum scenario_kind {
+    // touch FILE..., where no file exists yet
+    SCENARIO_CREATE,
+    // touch -A -010000 FILE..., where every file exists
+    SCENARIO_ADJUST
+} ScenarioKind;
+
+typedef struct scenario {
+    const TCHAR *name;
+    ScenarioKind kind;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { _T("create"), SCENARIO_CREATE },
+    { _T("adjust"), SCENARIO_ADJUST }
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct result {
+    double files_per_sec;
+    double syscalls_per_file;
+} Result;
+
+#ifdef FS_COUNT_SYSCALLS
+#define SYSCALLS() fs_syscalls
+#else
+#define SYSCALLS() 0ULL
+#endif
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+static void *xmalloc(size_t size) {
+    void *ptr = malloc(size);
+
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return ptr;
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "%s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+/*!
+ * @brief
+ * Creates or removes the files so they match what a scenario expects.
+ */
+static void prepare_files(TCHAR **files, size_t count, ScenarioKind kind) {
+    FsTimes base = { FS_TIME_OMIT, BASE_TIME, BASE_TIME };
+
+    for (size_t i = 0; i < count; i++) {
+        if (kind == SCENARIO_CREATE) {
+            _tremove(files[i]);
+            continue;
+        }
+
+        FsFile file;
+
+        if (!fs_open(&file, files[i], FS_OPEN_CREATE)) {
+            fail("could not create a benchmark file");
+        }
+
+        fs_close(&file);
+
+        if (!fs_set_times_by_path(files[i], true, &base)) {
+            fail("could not set the times of a benchmark file");
+        }
+    }
+}
+
+/*!
+ * @brief
+ * Checks that every file exists and, after an adjustment, was moved back by
+ * exactly the adjustment.
+ */
+static void verify_files(TCHAR **files, size_t count, ScenarioKind kind) {
+    FsTime expected = BASE_TIME + (FsTime)((long long)ADJUST_SECONDS * FS_TICKS_PER_SECOND);
+
+    for (size_t i = 0; i < count; i++) {
+        FsTimes times;
+
+        if (!fs_stat_times(files[i], true, &times)) {
+            fail("a touched file is missing");
+        }
+
+        if (kind == SCENARIO_ADJUST && (times.access != expected || times.write != expected)) {
+            fail("a file was not adjusted correctly");
+        }
+    }
+}
+
+static Result run_scenario(
+    const Scenario *sc, FsBatch *batch,
+    TCHAR **files, size_t count, unsigned int rounds,
+    TouchStatus *status) {
+
+    FileTimeFlags flags = FT_ACCESS | FT_WRITE;
+    double best = 0;
+    unsigned long long calls = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        prepare_files(files, count, sc->kind);
+
+        TimestampOperation op = prepare_timestamp(
+            NULL, NULL, flags,
+            (sc->kind == SCENARIO_ADJUST) ? ADJUST_SECONDS : 0);
+
+        unsigned long long start_calls = SYSCALLS();
+        double start = now_seconds();
+
+        touch_many(batch, NULL, (const TCHAR *const *)files, count, false, true, &op, NULL, status);
+
+        double elapsed = now_seconds() - start;
+
+        calls += SYSCALLS() - start_calls;
+
+        for (size_t i = 0; i < count; i++) {
+            if (!status[i].ok) {
+                fail("touch_many() reported a failure");
+            }
+        }
+
+        verify_files(files, count, sc->kind);
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    Result res = {
+        .files_per_sec = (double)count / best,
+        .syscalls_per_file = (double)calls / ((double)rounds * (double)count)
+    };
+
+    return res;
+}
+
+static bool parse_uint(const TCHAR *str, unsigned long max, unsigned long *out) {
+    unsigned long value = 0;
+
+    if (*str == '\0') {
+        return false;
+    }
+
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+
+        value = value * 10 + (unsigned long)(*str - '0');
+
+        if (value > max) {
+            return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: asyncbench [-n COUNT] [-r ROUNDS] [DIR]...\n");
+    exit(EXIT_FAILURE);
+}
+
+/*!
+ * @brief
+ * Runs every scenario in one directory with both executors.
+ */
+static void bench_dir(const TCHAR *dir, size_t count, unsigned int rounds) {
+    // Leaves room in each path for the file name
+    TCHAR root[BENCH_PATH_CAPACITY / 2];
+    _sntprintf(root, BENCH_PATH_CAPACITY / 2, _T("%s%casyncbench"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR **files = xmalloc(count * sizeof(TCHAR *));
+
+    for (size_t i = 0; i < count; i++) {
+        files[i] = xmalloc(BENCH_PATH_CAPACITY * sizeof(TCHAR));
+        _sntprintf(files[i], BENCH_PATH_CAPACITY, _T("%s%cf%08zu"), root, PATH_SEP, i);
+    }
+
+    TouchStatus *status = xmalloc(count * sizeof(TouchStatus));
+    FsBatch *blocking = fs_batch_open(FS_BATCH_BLOCKING);
+    FsBatch *async = fs_batch_open(FS_BATCH_ASYNC);
+
+    if (!blocking || !async) {
+        fail("out of memory");
+    }
+
+    _tprintf(_T("%s: %zu files, best of %u rounds, %s executor\n\n"),
+        dir, count, rounds,
+        fs_batch_is_async(async) ? _T("io_uring") : _T("blocking (io_uring unavailable)"));
+
+    _tprintf(_T("%-10s %14s %14s %14s %14s %9s\n"),
+        _T("scenario"), _T("blocking f/s"), _T("sys/file"), _T("async f/s"), _T("sys/file"), _T("speedup"));
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        Result base = run_scenario(&scenarios[i], blocking, files, count, rounds, status);
+        Result fast = run_scenario(&scenarios[i], async, files, count, rounds, status);
+
+        _tprintf(_T("%-10s %14.0f %14.2f %14.0f %14.2f %8.2fx\n"),
+            scenarios[i].name,
+            base.files_per_sec, base.syscalls_per_file,
+            fast.files_per_sec, fast.syscalls_per_file,
+            fast.files_per_sec / base.files_per_sec);
+    }
+
+    _tprintf(_T("\n"));
+
+    fs_batch_close(async);
+    fs_batch_close(blocking);
+
+    for (size_t i = 0; i < count; i++) {
+        _tremove(files[i]);
+        free(files[i]);
+    }
+
+    remove_dir(root);
+    free(status);
+    free(files);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    unsigned long count = 10000;
+    unsigned long rounds = 5;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        const TCHAR *arg = argv[i];
+
+        if (arg[2] != '\0' || i + 1 == argc) {
+            usage();
+        }
+
+        const TCHAR *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 100000000, &count) && count > 0; break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage();
+        }
+    }
+
+    if (i == argc) {
+        bench_dir(_T("."), count, (unsigned int)rounds);
+    }
+
+    for (; i < argc; i++) {
+        bench_dir(argv[i], count, (unsigned int)rounds);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,435 @@
+/* calbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks the integer calendar core in caltime.h against the operating system
+// and against a plain day-by-day walk of the calendar, for every date from
+// January 1, 1601 to December 31, 30827. Ordinal and week dates for every day
+// up to the year 9999, the last one a timestamp can express, are also run
+// through parse_timestamp(). The program fails on the first mismatch, and
+// otherwise times the core against the OS conversions.
+//
+// Usage: calbench [--check] [-n COUNT] [-r ROUNDS]
+//
+//   --check     Only run the checks, as the calendar test does.
+//   -n COUNT    Number of random dates to time conversions on (default 1000000).
+//   -r ROUNDS   Number of timing rounds, best one wins (default 5).
+
+#ifndef _WIN32
+// Required for timegm()
+#define _DEFAULT_SOURCE
+#endif
+
+#include "platform.h"
+#include "caltime.h"
+#include "timeparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#define YEAR_MIN 1601
+#define YEAR_MAX 30827
+
+// Timestamps have four-digit years
+#define STAMP_YEAR_MAX 9999
+
+#define TICKS_PER_DAY ((int64_t)CAL_SECONDS_PER_DAY * CAL_TICKS_PER_SECOND)
+
+typedef struct date {
+    int32_t year;
+    int32_t month;
+    int32_t day;
+} Date;
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static bool os_days_from_civil(const Date *date, int32_t *out) {
+    SYSTEMTIME st = {
+        .wYear = (WORD)date->year,
+        .wMonth = (WORD)date->month,
+        .wDay = (WORD)date->day
+    };
+
+    FILETIME ft;
+
+    if (!SystemTimeToFileTime(&st, &ft)) {
+        return false;
+    }
+
+    int64_t ticks = ((int64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    *out = (int32_t)(ticks / TICKS_PER_DAY);
+
+    return true;
+}
+
+static bool os_civil_from_days(int32_t days, Date *out) {
+    int64_t ticks = (int64_t)days * TICKS_PER_DAY;
+    FILETIME ft = {
+        .dwLowDateTime = (DWORD)(ticks & 0xFFFFFFFF),
+        .dwHighDateTime = (DWORD)(ticks >> 32)
+    };
+
+    SYSTEMTIME st;
+
+    if (!FileTimeToSystemTime(&ft, &st)) {
+        return false;
+    }
+
+    out->year = st.wYear;
+    out->month = st.wMonth;
+    out->day = st.wDay;
+
+    return true;
+}
+#else
+// Days between January 1, 1601 and January 1, 1970
+#define UNIX_EPOCH_DAYS 134774
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool os_days_from_civil(const Date *date, int32_t *out) {
+    struct tm tm = {
+        .tm_year = date->year - 1900,
+        .tm_mon = date->month - 1,
+        .tm_mday = date->day
+    };
+
+    time_t t = timegm(&tm);
+    *out = (int32_t)(t / CAL_SECONDS_PER_DAY + UNIX_EPOCH_DAYS);
+
+    return true;
+}
+
+static bool os_civil_from_days(int32_t days, Date *out) {
+    time_t t = (time_t)(days - UNIX_EPOCH_DAYS) * CAL_SECONDS_PER_DAY;
+    struct tm tm;
+
+    if (!gmtime_r(&t, &tm)) {
+        return false;
+    }
+
+    out->year = tm.tm_year + 1900;
+    out->month = tm.tm_mon + 1;
+    out->day = tm.tm_mday;
+
+    return true;
+}
+#endif
+
+static bool same_date(const Date *a, const Date *b) {
+    return a->year == b->year && a->month == b->month && a->day == b->day;
+}
+
+static bool fail(const char *what, const Date *date) {
+    printf("mismatch: %s on %04d-%02d-%02d\n", what, date->year, date->month, date->day);
+    return false;
+}
+
+/*!
+ * @brief
+ * Parses a formatted date with parse_timestamp() and checks the result.
+ */
+static bool check_parsed(const TCHAR *stamp, const Date *expected) {
+    Timestamp ts;
+
+    if (!parse_timestamp(stamp, &ts)) {
+        return false;
+    }
+
+    Date parsed = { ts.st.wYear, ts.st.wMonth, ts.st.wDay };
+    return same_date(&parsed, expected);
+}
+
+/*!
+ * @brief
+ * Walks the calendar one day at a time from 1601-01-01 to 30827-12-31, keeping
+ * track of the date, the ordinal day, the day of the week and the ISO week
+ * with nothing but increments, and checks the core against each of them.
+ */
+static bool check_all_days(void) {
+    static const int32_t month_days[] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+
+    Date date = { YEAR_MIN, 1, 1 };
+    int32_t ordinal_day = 1;
+    // January 1, 1601 was the Monday of ISO week 1601-W01
+    int32_t weekday = 1;
+    int32_t iso_year = YEAR_MIN;
+    int32_t iso_week = 1;
+
+    TCHAR stamp[32];
+
+    for (int32_t days = 0; date.year <= YEAR_MAX; days++) {
+        bool leap =
+            (date.year % 4 == 0 && date.year % 100 != 0) ||
+            date.year % 400 == 0;
+
+        int32_t month_length = month_days[date.month - 1] + (date.month == 2 && leap);
+
+        if (cal_days_from_civil(date.year, date.month, date.day) != days) {
+            return fail("cal_days_from_civil", &date);
+        }
+
+        Date civil;
+        cal_civil_from_days(days, &civil.year, &civil.month, &civil.day);
+
+        if (!same_date(&civil, &date)) {
+            return fail("cal_civil_from_days", &date);
+        }
+
+        if (cal_day_of_week(days) != weekday) {
+            return fail("cal_day_of_week", &date);
+        }
+
+        if (cal_is_leap_year(date.year) != leap ||
+            cal_days_in_month(date.year, date.month) != month_length) {
+            return fail("cal_days_in_month", &date);
+        }
+
+        Date ordinal = { date.year, 0, 0 };
+        cal_month_from_ordinal(date.year, ordinal_day, &ordinal.month, &ordinal.day);
+
+        if (!same_date(&ordinal, &date)) {
+            return fail("cal_month_from_ordinal", &date);
+        }
+
+        int32_t os_days;
+
+        if (!os_days_from_civil(&date, &os_days) || os_days != days) {
+            return fail("OS date to time", &date);
+        }
+
+        Date os_civil;
+
+        if (!os_civil_from_days(days, &os_civil) || !same_date(&os_civil, &date)) {
+            return fail("OS time to date", &date);
+        }
+
+        if (date.year <= STAMP_YEAR_MAX) {
+            _sntprintf(stamp, sizeof(stamp) / sizeof(TCHAR), _T("%04d-%03d"),
+                (int)date.year, (int)ordinal_day);
+
+            if (!check_parsed(stamp, &date)) {
+                return fail("ordinal date", &date);
+            }
+        }
+
+        // The week-based year of the last days of 9999 is out of range
+        if (iso_year <= STAMP_YEAR_MAX) {
+            _sntprintf(stamp, sizeof(stamp) / sizeof(TCHAR), _T("%04d-W%02d-%d"),
+                (int)iso_year, (int)iso_week, (int)(weekday == 0 ? 7 : weekday));
+
+            if (!check_parsed(stamp, &date)) {
+                return fail("week date", &date);
+            }
+        }
+
+        // Next day
+        ordinal_day++;
+        weekday = (weekday + 1) % 7;
+
+        if (++date.day > month_length) {
+            date.day = 1;
+
+            if (++date.month > 12) {
+                date.month = 1;
+                date.year++;
+                ordinal_day = 1;
+            }
+        }
+
+        // Week 1 of an ISO year is the one containing January 4, so it starts
+        // on a Monday between December 29 and January 4
+        if (weekday == 1) {
+            if ((date.month == 12 && date.day >= 29) ||
+                (date.month == 1 && date.day <= 4)) {
+                iso_year = (date.month == 12) ? date.year + 1 : date.year;
+                iso_week = 1;
+            } else {
+                iso_week++;
+            }
+        }
+    }
+
+    return true;
+}
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+typedef enum conversion {
+    CONV_CORE_TO_DAYS,
+    CONV_OS_TO_DAYS,
+    CONV_CORE_TO_DATE,
+    CONV_OS_TO_DATE
+} Conversion;
+
+/*!
+ * @return
+ * The best time of all rounds, in nanoseconds per conversion.
+ */
+static double time_conversion(
+    Conversion conv,
+    const Date *dates, const int32_t *days, size_t count,
+    unsigned int rounds) {
+
+    double best = 0.0;
+    // Keeps the compiler from discarding the results
+    volatile int64_t sink = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        int64_t acc = 0;
+        double start = now_seconds();
+
+        for (size_t i = 0; i < count; i++) {
+            int32_t d = 0;
+            Date date = { 0 };
+
+            switch (conv) {
+                case CONV_CORE_TO_DAYS:
+                    d = cal_days_from_civil(dates[i].year, dates[i].month, dates[i].day);
+                    break;
+                case CONV_OS_TO_DAYS:
+                    os_days_from_civil(&dates[i], &d);
+                    break;
+                case CONV_CORE_TO_DATE:
+                    cal_civil_from_days(days[i], &date.year, &date.month, &date.day);
+                    break;
+                case CONV_OS_TO_DATE:
+                    os_civil_from_days(days[i], &date);
+                    break;
+            }
+
+            acc += d + date.day;
+        }
+
+        double elapsed = now_seconds() - start;
+        sink += acc;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    (void)sink;
+    return best * 1e9 / (double)count;
+}
+
+static bool parse_uint(const char *str, unsigned long max, unsigned long *out) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0' || value > max) {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--check] [-n COUNT] [-r ROUNDS]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = 1000000;
+    unsigned long rounds = 5;
+    bool check_only = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (strcmp(arg, "--check") == 0) {
+            check_only = true;
+            continue;
+        }
+
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 == argc) {
+            usage(argv[0]);
+        }
+
+        const char *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 100000000, &count) && count > 0; break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+        }
+    }
+
+    if (!check_all_days()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("every day from %d-01-01 to %d-12-31 matches\n", YEAR_MIN, YEAR_MAX);
+
+    if (check_only) {
+        return EXIT_SUCCESS;
+    }
+
+    int32_t max_days = cal_days_from_civil(YEAR_MAX, 12, 31);
+    Date *dates = malloc(count * sizeof(Date));
+    int32_t *days = malloc(count * sizeof(int32_t));
+
+    if (!dates || !days) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        days[i] = (int32_t)(rng_next() % (uint32_t)(max_days + 1));
+        cal_civil_from_days(days[i], &dates[i].year, &dates[i].month, &dates[i].day);
+    }
+
+    printf("\n%-14s %10s %10s %9s\n", "conversion", "OS ns", "core ns", "speedup");
+
+    double os_ns = time_conversion(CONV_OS_TO_DAYS, dates, days, count, (unsigned int)rounds);
+    double core_ns = time_conversion(CONV_CORE_TO_DAYS, dates, days, count, (unsigned int)rounds);
+
+    printf("%-14s %10.2f %10.2f %8.2fx\n", "date to days", os_ns, core_ns, os_ns / core_ns);
+
+    os_ns = time_conversion(CONV_OS_TO_DATE, dates, days, count, (unsigned int)rounds);
+    core_ns = time_conversion(CONV_CORE_TO_DATE, dates, days, count, (unsigned int)rounds);
+
+    printf("%-14s %10.2f %10.2f %8.2fx\n", "days to date", os_ns, core_ns, os_ns / core_ns);
+
+    free(dates);
+    free(days);
+
+    return EXIT_SUCCESS;
+}
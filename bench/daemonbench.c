@@ -0,0 +1,414 @@
+/* daemonbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Compares three ways a build could touch one file per step: starting a touch
+// process for each, starting a touch -F client for each, and sending each
+// request to the server from a client that is already running, as a build
+// tool could, which is what this program stands in for. The server is started
+// with touch -D for the run. Every file must carry the scenario's timestamp
+// afterwards.
+//
+// Usage: daemonbench [-n COUNT] [-j THREADS] TOUCH [DIR]
+//
+//   -n COUNT    Number of files, and requests, per scenario (default 500).
+//   -j THREADS  Number of threads the server runs with (default 1).
+//   TOUCH       Path to the touch executable.
+//   DIR         Directory to run in (default .).
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "daemon.h"
+#include "ipc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define BENCH_PATH_CAPACITY 512
+
+// Number of times to check whether the server is up before giving up
+#define SERVER_START_TRIES 500
+
+typedef enum scenario_kind {
+    // touch -t STAMP FILE, in a process of its own
+    SCENARIO_SPAWN,
+    // touch -F ADDRESS -t STAMP FILE, in a process of its own
+    SCENARIO_CLIENT,
+    // The same request, sent from this process
+    SCENARIO_DIRECT
+} ScenarioKind;
+
+typedef struct scenario {
+    const TCHAR *name;
+    ScenarioKind kind;
+    const TCHAR *stamp;
+    // The stamp as an FsTime, which every file must have afterwards
+    FsTime expected;
+} Scenario;
+
+// Each scenario sets a time of its own, so a file left alone by one shows
+static const Scenario scenarios[] = {
+    { _T("spawn"), SCENARIO_SPAWN, _T("2001-01-01T00:00:00Z"), 126227808000000000ULL },
+    { _T("client"), SCENARIO_CLIENT, _T("2002-01-01T00:00:00Z"), 126543168000000000ULL },
+    { _T("direct"), SCENARIO_DIRECT, _T("2003-01-01T00:00:00Z"), 126858528000000000ULL }
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+#ifdef _WIN32
+typedef HANDLE Process;
+
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+
+static void sleep_ms(unsigned int ms) {
+    Sleep(ms);
+}
+
+/*!
+ * @brief
+ * Starts a process with the given arguments, which must not need quoting.
+ */
+static bool start_process(const TCHAR *const *args, Process *out) {
+    TCHAR cmd[BENCH_PATH_CAPACITY * 4];
+    size_t used = 0;
+
+    for (size_t i = 0; args[i]; i++) {
+        int n = _sntprintf(&cmd[used], sizeof(cmd) / sizeof(TCHAR) - used,
+            i ? _T(" %s") : _T("%s"), args[i]);
+
+        if (n < 0) {
+            return false;
+        }
+
+        used += (size_t)n;
+    }
+
+    STARTUPINFO si = { .cb = sizeof(si) };
+    PROCESS_INFORMATION pi;
+
+    if (!CreateProcess(args[0], cmd, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+        return false;
+    }
+
+    CloseHandle(pi.hThread);
+    *out = pi.hProcess;
+
+    return true;
+}
+
+static int wait_process(Process proc) {
+    DWORD code = 1;
+
+    WaitForSingleObject(proc, INFINITE);
+    GetExitCodeProcess(proc, &code);
+    CloseHandle(proc);
+
+    return (int)code;
+}
+
+static void stop_process(Process proc) {
+    TerminateProcess(proc, 0);
+    wait_process(proc);
+}
+#else
+typedef pid_t Process;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+
+static void sleep_ms(unsigned int ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+static bool start_process(const TCHAR *const *args, Process *out) {
+    return posix_spawn(out, args[0], NULL, NULL, (char *const *)args, environ) == 0;
+}
+
+static int wait_process(Process proc) {
+    int status;
+
+    if (waitpid(proc, &status, 0) != proc || !WIFEXITED(status)) {
+        return -1;
+    }
+
+    return WEXITSTATUS(status);
+}
+
+static void stop_process(Process proc) {
+    kill(proc, SIGTERM);
+    waitpid(proc, NULL, 0);
+}
+#endif
+
+static void *xmalloc(size_t size) {
+    void *ptr = malloc(size);
+
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return ptr;
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "%s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void report_failure(void *ctx, const TCHAR *path, FsError err) {
+    (void)ctx;
+    (void)path;
+    (void)err;
+
+    fail("the server could not touch a file");
+}
+
+/*!
+ * @brief
+ * Checks that every file carries the timestamp of a scenario.
+ */
+static void verify_files(TCHAR **files, size_t count, const Scenario *sc) {
+    for (size_t i = 0; i < count; i++) {
+        FsTimes times;
+
+        if (!fs_stat_times(files[i], true, &times)) {
+            fail("a touched file is missing");
+        }
+
+        if (times.access != sc->expected || times.write != sc->expected) {
+            fail("a file does not have the timestamp it was given");
+        }
+    }
+}
+
+/*!
+ * @brief
+ * Touches each file with a request of its own.
+ *
+ * @return
+ * Number of requests per second.
+ */
+static double run_scenario(
+    const Scenario *sc, const TCHAR *touch_path, const TCHAR *address,
+    TCHAR **files, size_t count) {
+
+    double start = now_seconds();
+
+    for (size_t i = 0; i < count; i++) {
+        if (sc->kind == SCENARIO_DIRECT) {
+            DaemonRequest req = {
+                .paths = (const TCHAR *const *)&files[i],
+                .count = 1,
+                .ft_flags = FT_ACCESS | FT_WRITE,
+                .stamp = sc->stamp,
+                .follow_symlinks = true
+            };
+
+            if (daemon_forward(address, &req, report_failure, NULL) != DAEMON_OK) {
+                fail("a request to the server failed");
+            }
+
+            continue;
+        }
+
+        const TCHAR *spawn_args[] = { touch_path, _T("-t"), sc->stamp, files[i], NULL };
+        const TCHAR *client_args[] = { touch_path, _T("-F"), address, _T("-t"), sc->stamp, files[i], NULL };
+        Process proc;
+
+        if (!start_process((sc->kind == SCENARIO_SPAWN) ? spawn_args : client_args, &proc)) {
+            fail("could not start touch");
+        }
+
+        if (wait_process(proc) != 0) {
+            fail("touch failed");
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+
+    verify_files(files, count, sc);
+
+    return (double)count / elapsed;
+}
+
+static bool parse_uint(const TCHAR *str, unsigned long max, unsigned long *out) {
+    unsigned long value = 0;
+
+    if (*str == '\0') {
+        return false;
+    }
+
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+
+        value = value * 10 + (unsigned long)(*str - '0');
+
+        if (value > max) {
+            return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: daemonbench [-n COUNT] [-j THREADS] TOUCH [DIR]\n");
+    exit(EXIT_FAILURE);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    unsigned long count = 500;
+    unsigned long threads = 1;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        const TCHAR *arg = argv[i];
+
+        if (arg[2] != '\0' || i + 1 == argc) {
+            usage();
+        }
+
+        const TCHAR *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 1000000, &count) && count > 0; break;
+            case 'j': ok = parse_uint(value, 256, &threads) && threads > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage();
+        }
+    }
+
+    if (i == argc || argc - i > 2) {
+        usage();
+    }
+
+    const TCHAR *touch_path = argv[i];
+    const TCHAR *dir = (i + 1 < argc) ? argv[i + 1] : _T(".");
+
+    // Leaves room in each path for the file name
+    TCHAR root[BENCH_PATH_CAPACITY / 2];
+    _sntprintf(root, BENCH_PATH_CAPACITY / 2, _T("%s%cdaemonbench"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR address[BENCH_PATH_CAPACITY];
+#ifdef _WIN32
+    _sntprintf(address, BENCH_PATH_CAPACITY, _T("touch-daemonbench-%lu"), GetCurrentProcessId());
+#else
+    _sntprintf(address, BENCH_PATH_CAPACITY, _T("%s%csock"), root, PATH_SEP);
+#endif
+
+    TCHAR **files = xmalloc(count * sizeof(TCHAR *));
+
+    for (size_t f = 0; f < count; f++) {
+        files[f] = xmalloc(BENCH_PATH_CAPACITY * sizeof(TCHAR));
+        _sntprintf(files[f], BENCH_PATH_CAPACITY, _T("%s%cf%08zu"), root, PATH_SEP, f);
+    }
+
+    TCHAR jobs[24];
+    _sntprintf(jobs, 24, _T("%lu"), threads);
+
+    const TCHAR *server_args[] = { touch_path, _T("-D"), address, _T("-j"), jobs, NULL };
+    Process server;
+
+    if (!start_process(server_args, &server)) {
+        fail("could not start the server");
+    }
+
+    // The server is up once it accepts a connection
+    IpcConn *probe = NULL;
+
+    for (int tries = 0; !probe && tries < SERVER_START_TRIES; tries++) {
+        probe = ipc_connect(address);
+
+        if (!probe) {
+            sleep_ms(10);
+        }
+    }
+
+    if (!probe) {
+        stop_process(server);
+        fail("the server did not start");
+    }
+
+    ipc_close(probe);
+
+    _tprintf(_T("%s: %lu requests of one file each, %lu server threads\n\n"), dir, count, threads);
+    _tprintf(_T("%-10s %14s %9s\n"), _T("scenario"), _T("requests/s"), _T("speedup"));
+
+    double base = 0;
+
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        double rate = run_scenario(&scenarios[s], touch_path, address, files, count);
+
+        if (s == 0) {
+            base = rate;
+        }
+
+        _tprintf(_T("%-10s %14.0f %8.2fx\n"), scenarios[s].name, rate, rate / base);
+    }
+
+    stop_process(server);
+
+    for (size_t f = 0; f < count; f++) {
+        _tremove(files[f]);
+        free(files[f]);
+    }
+
+    _tremove(address);
+    remove_dir(root);
+    free(files);
+
+    return EXIT_SUCCESS;
+}
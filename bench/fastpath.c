@@ -0,0 +1,246 @@
+/* fastpath.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Compares the regular handle-based timestamp flow of touch() with the
+// path-based fast path on a set of existing files, reporting throughput and
+// the number of system calls issued per file.
+//
+// Usage: fastpath [COUNT] [ROUNDS]
+
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_DIR "fastpath-bench"
+
+static unsigned long long syscalls;
+
+// Counts every system call a strategy issues
+#define SYSCALL(call) (syscalls++, (call))
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static bool make_file(const char *path) {
+    HANDLE h = CreateFileA(path, GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    CloseHandle(h);
+    return true;
+}
+
+static void make_dir(const char *path) {
+    CreateDirectoryA(path, NULL);
+}
+
+typedef struct stamp {
+    FILETIME ft;
+} Stamp;
+
+static void get_stamp(Stamp *out) {
+    GetSystemTimeAsFileTime(&out->ft);
+}
+
+static void remove_dir(const char *path) {
+    RemoveDirectoryA(path);
+}
+
+// Regular flow: open for read + attribute write, set, close
+static bool touch_handle(const char *path, const Stamp *stamp) {
+    HANDLE h = SYSCALL(CreateFileA(
+        path, GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ,
+        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_BACKUP_SEMANTICS, NULL));
+
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    bool ok = SYSCALL(SetFileTime(h, NULL, &stamp->ft, &stamp->ft));
+    SYSCALL(CloseHandle(h));
+
+    return ok;
+}
+
+// Fast path: Win32 has no by-name setter, so this is an attribute-only open
+// that needs no read access and breaks no oplocks
+static bool touch_path(const char *path, const Stamp *stamp) {
+    HANDLE h = SYSCALL(CreateFileA(
+        path, FILE_WRITE_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL));
+
+    if (h == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    bool ok = SYSCALL(SetFileTime(h, NULL, &stamp->ft, &stamp->ft));
+    SYSCALL(CloseHandle(h));
+
+    return ok;
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool make_file(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    close(fd);
+    return true;
+}
+
+static void make_dir(const char *path) {
+    mkdir(path, 0755);
+}
+
+typedef struct stamp {
+    struct timespec ts[2];
+} Stamp;
+
+static void get_stamp(Stamp *out) {
+    clock_gettime(CLOCK_REALTIME, &out->ts[0]);
+    out->ts[1] = out->ts[0];
+}
+
+static void remove_dir(const char *path) {
+    rmdir(path);
+}
+
+// Regular flow: open, set times through the descriptor, close
+static bool touch_handle(const char *path, const Stamp *stamp) {
+    int fd = SYSCALL(open(path, O_WRONLY | O_CREAT | O_NONBLOCK | O_NOCTTY | O_CLOEXEC, 0666));
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = SYSCALL(futimens(fd, stamp->ts)) == 0;
+    SYSCALL(close(fd));
+
+    return ok;
+}
+
+// Fast path: a single by-name call
+static bool touch_path(const char *path, const Stamp *stamp) {
+    return SYSCALL(utimensat(AT_FDCWD, path, stamp->ts, 0)) == 0;
+}
+#endif
+
+typedef bool (*TouchFn)(const char *path, const Stamp *stamp);
+
+static void run(const char *name, TouchFn fn, char **paths, size_t count, int rounds) {
+    Stamp stamp;
+    get_stamp(&stamp);
+
+    double best = 0;
+    unsigned long long calls = 0;
+    size_t failures = 0;
+
+    for (int r = 0; r < rounds; r++) {
+        syscalls = 0;
+
+        double start = now_seconds();
+
+        for (size_t i = 0; i < count; i++) {
+            if (!fn(paths[i], &stamp)) {
+                failures++;
+            }
+        }
+
+        double elapsed = now_seconds() - start;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+
+        calls = syscalls;
+    }
+
+    printf("%-8s %12.0f files/s %8.2f syscalls/file %8zu failures\n",
+        name,
+        (double)count / best,
+        (double)calls / (double)count,
+        failures);
+}
+
+int main(int argc, char **argv) {
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 5;
+
+    if (count == 0 || rounds < 1) {
+        fprintf(stderr, "usage: %s [COUNT] [ROUNDS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char **paths = calloc(count, sizeof(char *));
+
+    if (!paths) {
+        return EXIT_FAILURE;
+    }
+
+    make_dir(BENCH_DIR);
+
+    for (size_t i = 0; i < count; i++) {
+        paths[i] = malloc(64);
+
+        if (!paths[i]) {
+            return EXIT_FAILURE;
+        }
+
+        snprintf(paths[i], 64, BENCH_DIR "/f%08zu", i);
+
+        if (!make_file(paths[i])) {
+            fprintf(stderr, "could not create %s\n", paths[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%zu existing files, best of %d rounds\n", count, rounds);
+
+    run("handle", touch_handle, paths, count, rounds);
+    run("path", touch_path, paths, count, rounds);
+
+    for (size_t i = 0; i < count; i++) {
+        remove(paths[i]);
+        free(paths[i]);
+    }
+
+    remove_dir(BENCH_DIR);
+
+    free(paths);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,570 @@
+/* parsebench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Microbenchmark of parse_timestamp(). The parser is linked twice: once as
+// built for the tool, with the word-at-a-time path for fixed-width timestamps,
+// and once built with TIMEPARSE_NO_SWAR and renamed to parse_timestamp_scalar().
+//
+// Before timing anything, both parsers are run over a generated corpus of
+// valid, invalid, truncated and corrupted timestamps, and the program fails if
+// they disagree on a single result. The same corpus is also run through the
+// batch parse_timestamps(), whose results must match those of converting each
+// timestamp on its own. Only then is the throughput of each parser measured on
+// fixed-width timestamps and on the other formats, followed by that of batch
+// conversion.
+//
+// Usage: parsebench [--check] [-n COUNT] [-r ROUNDS] [-s SEED]
+//
+//   --check     Only run the checks, as the parser test does.
+//   -n COUNT    Number of random timestamps in each corpus (default 100000).
+//   -r ROUNDS   Number of timing rounds per parser, best one wins (default 5).
+//   -s SEED     Seed of the corpus generator (default 1).
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "timeparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+// Maximum length of a generated timestamp, including the terminating null character
+#define STAMP_CAPACITY 48
+
+// The same parser built without the fast path
+bool parse_timestamp_scalar(const TCHAR *stamp, Timestamp *out);
+
+typedef bool (*ParseFn)(const TCHAR *stamp, Timestamp *out);
+
+typedef struct corpus {
+    TCHAR (*stamps)[STAMP_CAPACITY];
+    size_t count;
+    size_t capacity;
+} Corpus;
+
+// Shapes of generated timestamps. 'd' stands for a random digit, anything else
+// is copied as is
+static const char *const fixed_shapes[] = {
+    "ddddddddTdddddd",
+    "dddd-dd-ddTdd:dd:dd"
+};
+
+static const char *const fixed_tails[] = {
+    "", ".ddd", "Z", ".dddZ", "+dd", "-dddd", "+dd:dd", ".ddd-dd:dd", ".dd", "+d"
+};
+
+static const char *const other_shapes[] = {
+    "dddddddd", "dddd-dd-dd",
+    "ddddddddTdd", "ddddddddTdddd", "dddd-dd-ddTdd:dd",
+    "dddddddTdddd", "dddd-dddTdd:ddZ",
+    "ddddWdddTdddd", "dddd-Wdd-dTdd:dd+dd:dd"
+};
+
+// Characters substituted into valid timestamps to corrupt them
+static const unsigned int corruptions[] = {
+    '0', '5', '9', '/', ':', '-', 'T', 't', 'W', 'Z', '+', '.', ' ', 'a', 0x7F,
+#ifdef _UNICODE
+    // Code units whose low byte is a digit or a separator
+    0x0130, 0x0A3A, 0x2D2D, 0x3054, 0xFF10
+#else
+    0x80, 0xB0, 0xFF
+#endif
+};
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+static uint64_t rng_state;
+
+static uint32_t rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rng_below(uint32_t n) {
+    return rng_next() % n;
+}
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+#endif
+
+static void corpus_add(Corpus *corpus, const TCHAR *stamp) {
+    if (corpus->count == corpus->capacity) {
+        corpus->capacity = corpus->capacity ? corpus->capacity * 2 : 1024;
+        corpus->stamps = realloc(corpus->stamps, corpus->capacity * sizeof(*corpus->stamps));
+
+        if (!corpus->stamps) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    memcpy(corpus->stamps[corpus->count++], stamp, STAMP_CAPACITY * sizeof(TCHAR));
+}
+
+/*!
+ * @brief
+ * Appends a shape to a timestamp, replacing each 'd' with a random digit.
+ * The first four digits form a year between 1900 and 2099, and the others lean
+ * towards small values so that a fair share of the timestamps is valid.
+ */
+static size_t fill_shape(TCHAR *out, size_t len, const char *shape, bool with_year) {
+    char year[5];
+    snprintf(year, sizeof(year), "%04u", 1900 + rng_below(200));
+
+    for (size_t digit = 0; *shape; shape++) {
+        if (*shape != 'd') {
+            out[len++] = (TCHAR)*shape;
+            continue;
+        }
+
+        if (with_year && digit < 4) {
+            out[len++] = (TCHAR)year[digit++];
+        } else {
+            out[len++] = (TCHAR)('0' + (rng_below(4) != 0 ? rng_below(3) : rng_below(10)));
+        }
+    }
+
+    out[len] = '\0';
+    return len;
+}
+
+static void generate(TCHAR *out, const char *const *shapes, size_t shape_count, bool with_tail) {
+    size_t len = fill_shape(out, 0, shapes[rng_below((uint32_t)shape_count)], true);
+
+    if (with_tail) {
+        fill_shape(out, len, fixed_tails[rng_below((uint32_t)COUNT_OF(fixed_tails))], false);
+    }
+}
+
+/*!
+ * @brief
+ * Builds the equivalence corpus: random timestamps of every shape, each of
+ * them truncated at every length, and each character of the fixed-width ones
+ * replaced with every corruption.
+ */
+static void build_check_corpus(Corpus *corpus, size_t count) {
+    TCHAR stamp[STAMP_CAPACITY] = { 0 };
+    TCHAR variant[STAMP_CAPACITY];
+
+    for (size_t i = 0; i < count; i++) {
+        bool fixed = rng_below(4) != 0;
+
+        if (fixed) {
+            generate(stamp, fixed_shapes, COUNT_OF(fixed_shapes), true);
+        } else {
+            generate(stamp, other_shapes, COUNT_OF(other_shapes), false);
+        }
+
+        corpus_add(corpus, stamp);
+
+        size_t len = _tcslen(stamp);
+
+        for (size_t n = 1; n < len; n++) {
+            memcpy(variant, stamp, sizeof(variant));
+            variant[n] = '\0';
+            corpus_add(corpus, variant);
+        }
+
+        if (!fixed) {
+            continue;
+        }
+
+        for (size_t pos = 0; pos < len; pos++) {
+            for (size_t c = 0; c < COUNT_OF(corruptions); c++) {
+                memcpy(variant, stamp, sizeof(variant));
+                variant[pos] = (TCHAR)corruptions[c];
+                corpus_add(corpus, variant);
+            }
+        }
+    }
+}
+
+static bool same_result(bool ok_a, const Timestamp *a, bool ok_b, const Timestamp *b) {
+    if (ok_a != ok_b) {
+        return false;
+    }
+
+    if (!ok_a) {
+        return true;
+    }
+
+    return a->st.wYear == b->st.wYear &&
+           a->st.wMonth == b->st.wMonth &&
+           a->st.wDay == b->st.wDay &&
+           a->st.wDayOfWeek == b->st.wDayOfWeek &&
+           a->st.wHour == b->st.wHour &&
+           a->st.wMinute == b->st.wMinute &&
+           a->st.wSecond == b->st.wSecond &&
+           a->st.wMilliseconds == b->st.wMilliseconds &&
+           a->utc_offset.specified == b->utc_offset.specified &&
+           a->utc_offset.minutes == b->utc_offset.minutes;
+}
+
+static void print_stamp(const TCHAR *stamp) {
+    for (; *stamp; stamp++) {
+        unsigned int c = (sizeof(TCHAR) == 1) ?
+            (unsigned char)*stamp :
+            (unsigned int)*stamp;
+
+        if (c >= 0x20 && c < 0x7F) {
+            putchar((int)c);
+        } else {
+            printf("\\x%02X", c);
+        }
+    }
+}
+
+/*!
+ * @return
+ * The number of timestamps on which the two parsers disagree.
+ */
+static size_t check_equivalence(const Corpus *corpus, size_t *accepted) {
+    size_t mismatches = 0;
+    *accepted = 0;
+
+    for (size_t i = 0; i < corpus->count; i++) {
+        Timestamp fast, scalar;
+        memset(&fast, 0, sizeof(fast));
+        memset(&scalar, 0, sizeof(scalar));
+
+        bool ok_fast = parse_timestamp(corpus->stamps[i], &fast);
+        bool ok_scalar = parse_timestamp_scalar(corpus->stamps[i], &scalar);
+
+        *accepted += ok_scalar;
+
+        if (same_result(ok_fast, &fast, ok_scalar, &scalar)) {
+            continue;
+        }
+
+        if (mismatches++ < 10) {
+            printf("mismatch: \"");
+            print_stamp(corpus->stamps[i]);
+            printf("\" (fast %s, scalar %s)\n",
+                ok_fast ? "accepts" : "rejects",
+                ok_scalar ? "accepts" : "rejects");
+        }
+    }
+
+    return mismatches;
+}
+
+/*!
+ * @brief
+ * Converts a timestamp string to an FsTime one at a time, the way the tool did
+ * before parse_timestamps() existed. Serves as the reference for the batch.
+ */
+static bool convert_one(const TCHAR *stamp, FsTime *out) {
+    Timestamp ts;
+
+    if (!parse_timestamp_scalar(stamp, &ts)) {
+        return false;
+    }
+
+    if (!ts.utc_offset.specified) {
+        return fs_local_systemtime_to_time(&ts.st, out);
+    }
+
+    FsTime time;
+
+    if (!fs_systemtime_to_time(&ts.st, &time)) {
+        return false;
+    }
+
+    int64_t delta = (int64_t)ts.utc_offset.minutes * 60 * FS_TICKS_PER_SECOND;
+
+    if (delta > 0 && time < (FsTime)delta) {
+        return false;
+    }
+
+    *out = time - (FsTime)delta;
+    return true;
+}
+
+static const TCHAR **corpus_pointers(const Corpus *corpus) {
+    const TCHAR **stamps = malloc(corpus->count * sizeof(*stamps));
+
+    if (!stamps) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < corpus->count; i++) {
+        stamps[i] = corpus->stamps[i];
+    }
+
+    return stamps;
+}
+
+/*!
+ * @return
+ * The number of timestamps on which parse_timestamps() and convert_one()
+ * disagree.
+ */
+static size_t check_batch(const Corpus *corpus) {
+    const TCHAR **stamps = corpus_pointers(corpus);
+    FsTime *times = malloc(corpus->count * sizeof(FsTime));
+    TimestampStatus *status = malloc(corpus->count * sizeof(TimestampStatus));
+
+    if (!times || !status) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    parse_timestamps(stamps, corpus->count, times, status);
+
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < corpus->count; i++) {
+        FsTime expected;
+        bool ok = convert_one(stamps[i], &expected);
+
+        if (ok == (status[i] == TS_STATUS_OK) && (!ok || expected == times[i])) {
+            continue;
+        }
+
+        if (mismatches++ < 10) {
+            printf("batch mismatch: \"");
+            print_stamp(stamps[i]);
+            printf("\" (batch status %d, one by one %s)\n",
+                (int)status[i], ok ? "converts" : "fails");
+        }
+    }
+
+    free(stamps);
+    free(times);
+    free(status);
+
+    return mismatches;
+}
+
+/*!
+ * @return
+ * The best time of all rounds, in nanoseconds per timestamp.
+ */
+static double time_parser(ParseFn parse, const Corpus *corpus, unsigned int rounds) {
+    double best = 0.0;
+    // Keeps the compiler from discarding the parsed results
+    volatile unsigned long sink = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        unsigned long acc = 0;
+        double start = now_seconds();
+
+        for (size_t i = 0; i < corpus->count; i++) {
+            Timestamp ts;
+
+            if (parse(corpus->stamps[i], &ts)) {
+                acc += ts.st.wSecond + ts.st.wDay;
+            }
+        }
+
+        double elapsed = now_seconds() - start;
+        sink += acc;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    (void)sink;
+    return best * 1e9 / (double)corpus->count;
+}
+
+/*!
+ * @brief
+ * Times the conversion of a corpus to FsTime values, either one timestamp at
+ * a time or in a single batch.
+ *
+ * @return
+ * The best time of all rounds, in nanoseconds per timestamp.
+ */
+static double time_conversion(const Corpus *corpus, bool batch, unsigned int rounds) {
+    const TCHAR **stamps = corpus_pointers(corpus);
+    FsTime *times = malloc(corpus->count * sizeof(FsTime));
+    TimestampStatus *status = malloc(corpus->count * sizeof(TimestampStatus));
+
+    if (!times || !status) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double best = 0.0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        double start = now_seconds();
+
+        if (batch) {
+            parse_timestamps(stamps, corpus->count, times, status);
+        } else {
+            for (size_t i = 0; i < corpus->count; i++) {
+                status[i] = convert_one(stamps[i], &times[i]) ?
+                    TS_STATUS_OK :
+                    TS_STATUS_MALFORMED;
+            }
+        }
+
+        double elapsed = now_seconds() - start;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    free(stamps);
+    free(times);
+    free(status);
+
+    return best * 1e9 / (double)corpus->count;
+}
+
+static bool parse_uint(const char *str, unsigned long max, unsigned long *out) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0' || value > max) {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--check] [-n COUNT] [-r ROUNDS] [-s SEED]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = 100000;
+    unsigned long rounds = 5;
+    unsigned long seed = 1;
+    bool check_only = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (strcmp(arg, "--check") == 0) {
+            check_only = true;
+            continue;
+        }
+
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 == argc) {
+            usage(argv[0]);
+        }
+
+        const char *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 10000000, &count) && count > 0; break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            case 's': ok = parse_uint(value, 0xFFFFFFFFUL, &seed) && seed > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+        }
+    }
+
+    rng_state = seed;
+
+    Corpus check = { 0 };
+    build_check_corpus(&check, count);
+
+    size_t accepted;
+    size_t mismatches = check_equivalence(&check, &accepted);
+
+    printf("equivalence: %zu timestamps, %zu accepted, %zu mismatches\n",
+        check.count, accepted, mismatches);
+
+    size_t batch_mismatches = check_batch(&check);
+
+    printf("batch: %zu mismatches\n", batch_mismatches);
+
+    free(check.stamps);
+
+    if (mismatches != 0 || batch_mismatches != 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (check_only) {
+        return EXIT_SUCCESS;
+    }
+
+    Corpus fixed = { 0 };
+    Corpus other = { 0 };
+    Corpus utc = { 0 };
+    TCHAR stamp[STAMP_CAPACITY] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        generate(stamp, fixed_shapes, COUNT_OF(fixed_shapes), rng_below(2) != 0);
+        corpus_add(&fixed, stamp);
+
+        generate(stamp, other_shapes, COUNT_OF(other_shapes), false);
+        corpus_add(&other, stamp);
+
+        // Local times are converted by the C library or Windows one at a
+        // time either way, so batch conversion is timed on UTC timestamps
+        size_t len = fill_shape(stamp, 0, fixed_shapes[rng_below(COUNT_OF(fixed_shapes))], true);
+        fill_shape(stamp, len, "Z", false);
+        corpus_add(&utc, stamp);
+    }
+
+    printf("\n%-8s %12s %12s %9s\n", "corpus", "scalar ns", "fast ns", "speedup");
+
+    const struct {
+        const char *name;
+        const Corpus *corpus;
+    } sets[] = {
+        { "fixed", &fixed },
+        { "other", &other }
+    };
+
+    for (size_t i = 0; i < COUNT_OF(sets); i++) {
+        double scalar_ns = time_parser(parse_timestamp_scalar, sets[i].corpus, (unsigned int)rounds);
+        double fast_ns = time_parser(parse_timestamp, sets[i].corpus, (unsigned int)rounds);
+
+        printf("%-8s %12.2f %12.2f %8.2fx\n",
+            sets[i].name, scalar_ns, fast_ns, scalar_ns / fast_ns);
+    }
+
+    double single_ns = time_conversion(&utc, false, (unsigned int)rounds);
+    double batch_ns = time_conversion(&utc, true, (unsigned int)rounds);
+
+    printf("\n%-8s %12s %12s %9s\n", "corpus", "single ns", "batch ns", "speedup");
+    printf("%-8s %12.2f %12.2f %8.2fx\n",
+        "utc", single_ns, batch_ns, single_ns / batch_ns);
+
+    free(fixed.stamps);
+    free(other.stamps);
+    free(utc.stamps);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,371 @@
+/* planbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Compares touch_many(), which opens the directory of a group of siblings once
+// and reaches them by name, against touch() on each whole path. The files sit
+// at the bottom of a chain of directories, once one level deep and once DEPTH
+// levels deep, so the cost of resolving the directory for every file shows up
+// as the chain grows. Both sides run one step at a time, so the difference is
+// down to path lookups alone, except for "adjust" on POSIX, where touch_many()
+// also reads and writes back the times by name instead of opening each file.
+// Every run is checked: all files must carry the expected times afterwards.
+//
+// Usage: planbench [-n COUNT] [-d DEPTH] [-r ROUNDS] [DIR]
+//
+//   -n COUNT    Number of files in the directory (default 10000).
+//   -d DEPTH    Number of directory levels above the files (default 16).
+//   -r ROUNDS   Number of times each scenario is run, best one wins (default 5).
+//   DIR         Directory to run in (default .).
+//
+// The backend must be built with FS_COUNT_SYSCALLS for system calls to be
+// counted; CMake does that for this target.
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "touchop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define BENCH_PATH_CAPACITY 1024
+
+// Name of each directory level
+#define LEVEL_NAME _T("level")
+
+// 2001-01-01T00:00:00Z, the time files start out with
+#define BASE_TIME 126227808000000000ULL
+
+// 2002-01-01T00:00:00Z, the time the "set" scenario writes
+#define SET_TIME 126543168000000000ULL
+
+#define ADJUST_SECONDS (-3600)
+
+typedef enum scenario_kind {
+    // touch -t STAMP FILE..., a single call per file
+    SCENARIO_SET,
+    // touch -A -010000 FILE..., an open, stat, write and close per file
+    SCENARIO_ADJUST
+} ScenarioKind;
+
+typedef struct scenario {
+    const TCHAR *name;
+    ScenarioKind kind;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { _T("set"), SCENARIO_SET },
+    { _T("adjust"), SCENARIO_ADJUST }
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct result {
+    double files_per_sec;
+    double syscalls_per_file;
+} Result;
+
+#ifdef FS_COUNT_SYSCALLS
+#define SYSCALLS() fs_syscalls
+#else
+#define SYSCALLS() 0ULL
+#endif
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+static void *xmalloc(size_t size) {
+    void *ptr = malloc(size);
+
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return ptr;
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "%s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+/*!
+ * @brief
+ * Creates the files if needed and gives all of them the base time.
+ */
+static void reset_files(TCHAR **files, size_t count) {
+    FsTimes base = { FS_TIME_OMIT, BASE_TIME, BASE_TIME };
+
+    for (size_t i = 0; i < count; i++) {
+        if (fs_set_times_by_path(files[i], true, &base)) {
+            continue;
+        }
+
+        FsFile file;
+
+        if (!fs_open(&file, files[i], FS_OPEN_CREATE)) {
+            fail("could not create a benchmark file");
+        }
+
+        bool ok = fs_set_times(&file, &base);
+        fs_close(&file);
+
+        if (!ok) {
+            fail("could not set the times of a benchmark file");
+        }
+    }
+}
+
+static void verify_files(TCHAR **files, size_t count, ScenarioKind kind) {
+    FsTime expected = (kind == SCENARIO_SET) ?
+        SET_TIME :
+        BASE_TIME + (FsTime)((long long)ADJUST_SECONDS * FS_TICKS_PER_SECOND);
+
+    for (size_t i = 0; i < count; i++) {
+        FsTimes times;
+
+        if (!fs_stat_times(files[i], true, &times)) {
+            fail("a touched file is missing");
+        }
+
+        if (times.access != expected || times.write != expected) {
+            fail("a file does not have the expected times");
+        }
+    }
+}
+
+static Result run_scenario(
+    const Scenario *sc, FsBatch *batch,
+    TCHAR **files, size_t count, unsigned int rounds,
+    TouchStatus *status) {
+
+    FsTime stamp = SET_TIME;
+    TimestampOperation op = (sc->kind == SCENARIO_SET) ?
+        prepare_timestamp(&stamp, NULL, FT_ACCESS | FT_WRITE, 0) :
+        prepare_timestamp(NULL, NULL, FT_ACCESS | FT_WRITE, ADJUST_SECONDS);
+
+    double best = 0;
+    unsigned long long calls = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        reset_files(files, count);
+
+        unsigned long long start_calls = SYSCALLS();
+        double start = now_seconds();
+
+        if (batch) {
+            touch_many(batch, NULL, (const TCHAR *const *)files, count, false, true, &op, NULL, status);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                status[i].ok = touch(files[i], false, true, &op);
+            }
+        }
+
+        double elapsed = now_seconds() - start;
+
+        calls += SYSCALLS() - start_calls;
+
+        for (size_t i = 0; i < count; i++) {
+            if (!status[i].ok) {
+                fail("a file could not be touched");
+            }
+        }
+
+        verify_files(files, count, sc->kind);
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    Result res = {
+        .files_per_sec = (double)count / best,
+        .syscalls_per_file = (double)calls / ((double)rounds * (double)count)
+    };
+
+    return res;
+}
+
+static bool parse_uint(const TCHAR *str, unsigned long max, unsigned long *out) {
+    unsigned long value = 0;
+
+    if (*str == '\0') {
+        return false;
+    }
+
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+
+        value = value * 10 + (unsigned long)(*str - '0');
+
+        if (value > max) {
+            return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: planbench [-n COUNT] [-d DEPTH] [-r ROUNDS] [DIR]\n");
+    exit(EXIT_FAILURE);
+}
+
+/*!
+ * @brief
+ * Runs every scenario on files DEPTH directories below \p dir.
+ */
+static void bench_depth(const TCHAR *dir, size_t count, unsigned int depth, unsigned int rounds) {
+    // Leaves room in each path for the file name
+    TCHAR leaf[BENCH_PATH_CAPACITY / 2];
+    size_t len = (size_t)_sntprintf(leaf, BENCH_PATH_CAPACITY / 2, _T("%s"), dir);
+
+    for (unsigned int i = 0; i < depth; i++) {
+        len += (size_t)_sntprintf(
+            &leaf[len], BENCH_PATH_CAPACITY / 2 - len,
+            _T("%c%s"), PATH_SEP, LEVEL_NAME);
+
+        if (len >= BENCH_PATH_CAPACITY / 2) {
+            fail("the directory chain is too deep");
+        }
+
+        make_dir(leaf);
+    }
+
+    TCHAR **files = xmalloc(count * sizeof(TCHAR *));
+
+    for (size_t i = 0; i < count; i++) {
+        files[i] = xmalloc(BENCH_PATH_CAPACITY * sizeof(TCHAR));
+        _sntprintf(files[i], BENCH_PATH_CAPACITY, _T("%s%cf%08zu"), leaf, PATH_SEP, i);
+    }
+
+    TouchStatus *status = xmalloc(count * sizeof(TouchStatus));
+    FsBatch *batch = fs_batch_open(FS_BATCH_BLOCKING);
+
+    if (!batch) {
+        fail("out of memory");
+    }
+
+    _tprintf(_T("%zu files %u levels deep, best of %u rounds\n\n"), count, depth, rounds);
+
+    _tprintf(_T("%-10s %14s %14s %14s %14s %9s\n"),
+        _T("scenario"), _T("by path f/s"), _T("sys/file"), _T("by dir f/s"), _T("sys/file"), _T("speedup"));
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        Result base = run_scenario(&scenarios[i], NULL, files, count, rounds, status);
+        Result fast = run_scenario(&scenarios[i], batch, files, count, rounds, status);
+
+        _tprintf(_T("%-10s %14.0f %14.2f %14.0f %14.2f %8.2fx\n"),
+            scenarios[i].name,
+            base.files_per_sec, base.syscalls_per_file,
+            fast.files_per_sec, fast.syscalls_per_file,
+            fast.files_per_sec / base.files_per_sec);
+    }
+
+    _tprintf(_T("\n"));
+
+    fs_batch_close(batch);
+
+    for (size_t i = 0; i < count; i++) {
+        _tremove(files[i]);
+        free(files[i]);
+    }
+
+    // Remove the chain from the bottom up
+    for (unsigned int i = 0; i < depth; i++) {
+        remove_dir(leaf);
+        *_tcsrchr(leaf, PATH_SEP) = '\0';
+    }
+
+    free(status);
+    free(files);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    unsigned long count = 10000;
+    unsigned long depth = 16;
+    unsigned long rounds = 5;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        const TCHAR *arg = argv[i];
+
+        if (arg[2] != '\0' || i + 1 == argc) {
+            usage();
+        }
+
+        const TCHAR *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 100000000, &count) && count > 0; break;
+            case 'd': ok = parse_uint(value, 64, &depth) && depth > 0; break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage();
+        }
+    }
+
+    if (i + 1 < argc) {
+        usage();
+    }
+
+    const TCHAR *dir = (i < argc) ? argv[i] : _T(".");
+
+    bench_depth(dir, count, 1, (unsigned int)rounds);
+
+    if (depth > 1) {
+        bench_depth(dir, count, (unsigned int)depth, (unsigned int)rounds);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,390 @@
+/* startbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Measures how long touch takes from the start of its process to its exit when
+// touching a single file, which is what most of its runs in a build look like.
+// Each run is timed from before the process is created until it has been
+// waited for, and the median and 90th percentile of the runs are reported.
+//
+// The floor is this program started again, doing nothing but exiting, which
+// is what starting any process costs. Given another touch executable, such as
+// the previous release, it is timed the same way as a baseline, so that a
+// regression in startup shows as a positive difference.
+//
+// Usage: startbench [-n RUNS] [-b BASELINE] TOUCH [DIR]
+//
+//   -n RUNS      Number of runs per scenario (default 200).
+//   -b BASELINE  Path to a touch executable to compare against.
+//   TOUCH        Path to the touch executable.
+//   DIR          Directory to run in (default .).
+
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define BENCH_PATH_CAPACITY 512
+
+// Argument that makes this program exit as soon as it starts
+#define EXIT_ARG _T("--exit")
+
+typedef enum scenario_kind {
+    // This program, exiting at once
+    SCENARIO_FLOOR,
+    // touch FILE, on a file that exists
+    SCENARIO_UPDATE,
+    // touch FILE, on a file that does not exist yet
+    SCENARIO_CREATE,
+    // The baseline executable, as SCENARIO_UPDATE
+    SCENARIO_BASELINE
+} ScenarioKind;
+
+typedef struct scenario {
+    const TCHAR *name;
+    ScenarioKind kind;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { _T("floor"), SCENARIO_FLOOR },
+    { _T("update"), SCENARIO_UPDATE },
+    { _T("create"), SCENARIO_CREATE },
+    { _T("baseline"), SCENARIO_BASELINE }
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+#ifdef _WIN32
+typedef HANDLE Process;
+
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+
+static const TCHAR *self_path(const TCHAR *argv0) {
+    static TCHAR path[MAX_PATH];
+    (void)argv0;
+
+    return GetModuleFileName(NULL, path, MAX_PATH) ? path : NULL;
+}
+
+/*!
+ * @brief
+ * Starts a process with the given arguments, which must not need quoting.
+ */
+static bool start_process(const TCHAR *const *args, Process *out) {
+    TCHAR cmd[BENCH_PATH_CAPACITY * 4];
+    size_t used = 0;
+
+    for (size_t i = 0; args[i]; i++) {
+        int n = _sntprintf(&cmd[used], sizeof(cmd) / sizeof(TCHAR) - used,
+            i ? _T(" %s") : _T("%s"), args[i]);
+
+        if (n < 0) {
+            return false;
+        }
+
+        used += (size_t)n;
+    }
+
+    STARTUPINFO si = { .cb = sizeof(si) };
+    PROCESS_INFORMATION pi;
+
+    if (!CreateProcess(args[0], cmd, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) {
+        return false;
+    }
+
+    CloseHandle(pi.hThread);
+    *out = pi.hProcess;
+
+    return true;
+}
+
+static int wait_process(Process proc) {
+    DWORD code = 1;
+
+    WaitForSingleObject(proc, INFINITE);
+    GetExitCodeProcess(proc, &code);
+    CloseHandle(proc);
+
+    return (int)code;
+}
+#else
+typedef pid_t Process;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+
+static const TCHAR *self_path(const TCHAR *argv0) {
+    // posix_spawn() does not search PATH, so a bare name is taken as a file in
+    // the working directory
+    return argv0;
+}
+
+static bool start_process(const TCHAR *const *args, Process *out) {
+    return posix_spawn(out, args[0], NULL, NULL, (char *const *)args, environ) == 0;
+}
+
+static int wait_process(Process proc) {
+    int status;
+
+    if (waitpid(proc, &status, 0) != proc || !WIFEXITED(status)) {
+        return -1;
+    }
+
+    return WEXITSTATUS(status);
+}
+#endif
+
+static void *xmalloc(size_t size) {
+    void *ptr = malloc(size);
+
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return ptr;
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "%s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+
+    return (da > db) - (da < db);
+}
+
+/*!
+ * @brief
+ * Gets the value at a percentile of sorted samples.
+ */
+static double percentile(const double *sorted, size_t count, unsigned int pct) {
+    size_t index = (count * pct) / 100;
+    return sorted[(index < count) ? index : count - 1];
+}
+
+/*!
+ * @brief
+ * Runs a process to completion and returns how long it took, in seconds.
+ */
+static double time_run(const TCHAR *const *args) {
+    Process proc;
+    double start = now_seconds();
+
+    if (!start_process(args, &proc)) {
+        fail("could not start a process");
+    }
+
+    if (wait_process(proc) != 0) {
+        fail("a process failed");
+    }
+
+    return now_seconds() - start;
+}
+
+static bool parse_uint(const TCHAR *str, unsigned long max, unsigned long *out) {
+    unsigned long value = 0;
+
+    if (*str == '\0') {
+        return false;
+    }
+
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+
+        value = value * 10 + (unsigned long)(*str - '0');
+
+        if (value > max) {
+            return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: startbench [-n RUNS] [-b BASELINE] TOUCH [DIR]\n");
+    exit(EXIT_FAILURE);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    if (argc == 2 && _tcscmp(argv[1], EXIT_ARG) == 0) {
+        return EXIT_SUCCESS;
+    }
+
+    unsigned long runs = 200;
+    const TCHAR *baseline_path = NULL;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        const TCHAR *arg = argv[i];
+
+        if (arg[2] != '\0' || i + 1 == argc) {
+            usage();
+        }
+
+        const TCHAR *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 1000000, &runs) && runs > 0; break;
+            case 'b': baseline_path = value; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage();
+        }
+    }
+
+    if (i == argc || argc - i > 2) {
+        usage();
+    }
+
+    const TCHAR *touch_path = argv[i];
+    const TCHAR *dir = (i + 1 < argc) ? argv[i + 1] : _T(".");
+    const TCHAR *self = self_path(argv[0]);
+
+    if (!self) {
+        fail("could not find this program");
+    }
+
+    // Leaves room in each path for the file name
+    TCHAR root[BENCH_PATH_CAPACITY / 2];
+    _sntprintf(root, BENCH_PATH_CAPACITY / 2, _T("%s%cstartbench"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR existing[BENCH_PATH_CAPACITY];
+    _sntprintf(existing, BENCH_PATH_CAPACITY, _T("%s%cexisting"), root, PATH_SEP);
+
+    TCHAR created[BENCH_PATH_CAPACITY];
+    double *samples[SCENARIO_COUNT] = { 0 };
+
+    // Scenarios take turns, run by run, so that whatever else the system is
+    // doing weighs on all of them alike. The first round warms up the caches
+    // and is not counted
+    for (size_t r = 0; r <= runs; r++) {
+        for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+            const Scenario *sc = &scenarios[s];
+
+            if (sc->kind == SCENARIO_BASELINE && !baseline_path) {
+                continue;
+            }
+
+            const TCHAR *floor_args[] = { self, EXIT_ARG, NULL };
+            const TCHAR *touch_args[] = { touch_path, existing, NULL };
+            const TCHAR *const *args = touch_args;
+
+            if (sc->kind == SCENARIO_FLOOR) {
+                args = floor_args;
+            } else if (sc->kind == SCENARIO_CREATE) {
+                _sntprintf(created, BENCH_PATH_CAPACITY, _T("%s%cnew%08zu"), root, PATH_SEP, r);
+                touch_args[1] = created;
+            } else if (sc->kind == SCENARIO_BASELINE) {
+                touch_args[0] = baseline_path;
+            }
+
+            double elapsed = time_run(args) * 1e6;
+
+            if (r == 0) {
+                continue;
+            }
+
+            if (!samples[s]) {
+                samples[s] = xmalloc(runs * sizeof(double));
+            }
+
+            samples[s][r - 1] = elapsed;
+        }
+    }
+
+    _tprintf(_T("%s: %lu runs per scenario, times in microseconds\n\n"), dir, runs);
+    _tprintf(_T("%-10s %10s %10s %12s\n"), _T("scenario"), _T("median"), _T("p90"), _T("over floor"));
+
+    double medians[SCENARIO_COUNT];
+
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        if (!samples[s]) {
+            continue;
+        }
+
+        qsort(samples[s], runs, sizeof(double), compare_doubles);
+        medians[s] = percentile(samples[s], runs, 50);
+
+        _tprintf(_T("%-10s %10.0f %10.0f %12.0f\n"),
+            scenarios[s].name, medians[s], percentile(samples[s], runs, 90),
+            medians[s] - medians[SCENARIO_FLOOR]);
+    }
+
+    if (baseline_path) {
+        _tprintf(_T("\nupdate takes %+.0f microseconds compared to the baseline\n"),
+            medians[SCENARIO_UPDATE] - medians[SCENARIO_BASELINE]);
+    }
+
+    // Every created file must exist, or touch reported success without
+    // creating it
+    for (size_t r = 0; r <= runs; r++) {
+        _sntprintf(created, BENCH_PATH_CAPACITY, _T("%s%cnew%08zu"), root, PATH_SEP, r);
+
+        if (_tremove(created) != 0) {
+            fail("a file touch was to create is missing");
+        }
+    }
+
+    _tremove(existing);
+    remove_dir(root);
+
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        free(samples[s]);
+    }
+
+    return EXIT_SUCCESS;
+}
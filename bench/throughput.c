@@ -0,0 +1,481 @@
+/* throughput.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// End-to-end benchmark of touch() on a synthetic directory tree. Each scenario
+// mirrors a common invocation of the tool and reports throughput, per-file
+// latency percentiles and the number of system calls issued per file. Results
+// can also be written as JSON to compare runs over time.
+//
+// Usage: throughput [-n COUNT] [-d DEPTH] [-f FANOUT] [-m MISSING] [-r ROUNDS] [-o FILE]
+//
+//   -n COUNT    Number of files in the tree (default 10000).
+//   -d DEPTH    Number of directory levels below the root (default 2).
+//   -f FANOUT   Number of subdirectories per directory (default 8).
+//   -m MISSING  Percentage of files missing in the "nocreate" scenario (default 90).
+//   -r ROUNDS   Number of times each scenario is run (default 3).
+//   -o FILE     Also write the results as JSON to FILE.
+//
+// The backend must be built with FS_COUNT_SYSCALLS for system calls to be
+// counted; CMake does that for this target.
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "touchop.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define BENCH_PLAT "windows"
+#else
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#define BENCH_PLAT "posix"
+#endif
+
+#define BENCH_ROOT _T("throughput-bench")
+
+// Maximum length of a generated path, including the terminating null character
+#define BENCH_PATH_CAPACITY 256
+
+/*!
+ * @brief
+ * State of the files that a scenario expects before it runs.
+ */
+typedef enum file_state {
+    STATE_ALL_MISSING,
+    STATE_ALL_EXISTING,
+    STATE_MOSTLY_MISSING
+} FileState;
+
+/*!
+ * @brief
+ * Source of the timestamps a scenario applies.
+ */
+typedef enum stamp_kind {
+    STAMP_NOW,
+    STAMP_REFERENCE,
+    STAMP_ADJUST
+} StampKind;
+
+typedef struct scenario {
+    const char *name;
+    // Equivalent command line, for the report
+    const char *command;
+    FileState state;
+    StampKind stamp;
+    bool existing_only;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { "create",    "touch FILE...",            STATE_ALL_MISSING,    STAMP_NOW,       false },
+    { "update",    "touch FILE...",            STATE_ALL_EXISTING,   STAMP_NOW,       false },
+    { "reference", "touch -r REF FILE...",     STATE_ALL_EXISTING,   STAMP_REFERENCE, false },
+    { "adjust",    "touch -A -010000 FILE...", STATE_ALL_EXISTING,   STAMP_ADJUST,    false },
+    { "nocreate",  "touch -c FILE...",         STATE_MOSTLY_MISSING, STAMP_NOW,       true  }
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct tree {
+    // Directories in creation order, so parents precede their children
+    TCHAR **dirs;
+    size_t dir_count;
+    TCHAR **files;
+    size_t file_count;
+    TCHAR *ref;
+} Tree;
+
+typedef struct result {
+    double files_per_sec;
+    double p50_us;
+    double p99_us;
+    double syscalls_per_file;
+    size_t failures;
+} Result;
+
+#ifdef FS_COUNT_SYSCALLS
+#define SYSCALLS() fs_syscalls
+#else
+#define SYSCALLS() 0ULL
+#endif
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+static void *xmalloc(size_t size) {
+    void *ptr = malloc(size);
+
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return ptr;
+}
+
+static TCHAR *join_path(const TCHAR *dir, const TCHAR *fmt, size_t index) {
+    TCHAR name[32];
+    _sntprintf(name, 32, fmt, index);
+
+    TCHAR *path = xmalloc(BENCH_PATH_CAPACITY * sizeof(TCHAR));
+    _sntprintf(path, BENCH_PATH_CAPACITY, _T("%s%c%s"), dir, PATH_SEP, name);
+
+    return path;
+}
+
+static bool create_file(const TCHAR *path) {
+    FsFile file;
+
+    if (!fs_open(&file, path, FS_OPEN_CREATE)) {
+        return false;
+    }
+
+    fs_close(&file);
+    return true;
+}
+
+/*!
+ * @brief
+ * Builds the tree in memory and creates its directories. Files are spread
+ * round-robin over the directories of the deepest level and are not created.
+ */
+static void build_tree(Tree *tree, size_t count, unsigned int depth, unsigned int fanout) {
+    size_t level_size = 1;
+    size_t dir_count = 1;
+
+    for (unsigned int i = 0; i < depth; i++) {
+        level_size *= fanout;
+        dir_count += level_size;
+    }
+
+    tree->dirs = xmalloc(dir_count * sizeof(TCHAR *));
+    tree->dirs[0] = xmalloc(BENCH_PATH_CAPACITY * sizeof(TCHAR));
+    _sntprintf(tree->dirs[0], BENCH_PATH_CAPACITY, _T("%s"), BENCH_ROOT);
+    tree->dir_count = 1;
+
+    // Directories of the previous level start at this index
+    size_t level_start = 0;
+    size_t level_count = 1;
+
+    for (unsigned int d = 0; d < depth; d++) {
+        for (size_t i = 0; i < level_count; i++) {
+            for (unsigned int f = 0; f < fanout; f++) {
+                tree->dirs[tree->dir_count++] =
+                    join_path(tree->dirs[level_start + i], _T("d%zu"), f);
+            }
+        }
+
+        level_start += level_count;
+        level_count *= fanout;
+    }
+
+    for (size_t i = 0; i < tree->dir_count; i++) {
+        make_dir(tree->dirs[i]);
+    }
+
+    tree->files = xmalloc(count * sizeof(TCHAR *));
+    tree->file_count = count;
+
+    for (size_t i = 0; i < count; i++) {
+        const TCHAR *dir = tree->dirs[level_start + (i % level_count)];
+        tree->files[i] = join_path(dir, _T("f%08zu"), i);
+    }
+
+    tree->ref = join_path(tree->dirs[0], _T("ref%zu"), 0);
+
+    // Give the reference file distinct, fixed times
+    FsTimes ref_times = {
+        .creation = FS_TIME_OMIT,
+        .access = 126227808000000000ULL, // 2001-01-01T00:00:00Z
+        .write = 126227808000000000ULL
+    };
+
+    if (!create_file(tree->ref) ||
+        !fs_set_times_by_path(tree->ref, true, &ref_times)) {
+        fprintf(stderr, "could not create the reference file\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void destroy_tree(Tree *tree) {
+    for (size_t i = 0; i < tree->file_count; i++) {
+        _tremove(tree->files[i]);
+        free(tree->files[i]);
+    }
+
+    _tremove(tree->ref);
+    free(tree->ref);
+
+    // Children before parents
+    for (size_t i = tree->dir_count; i-- > 0;) {
+        remove_dir(tree->dirs[i]);
+        free(tree->dirs[i]);
+    }
+
+    free(tree->files);
+    free(tree->dirs);
+}
+
+/*!
+ * @brief
+ * Creates or removes files so the tree matches the state a scenario expects.
+ */
+static void prepare_files(const Tree *tree, FileState state, unsigned int missing_percent) {
+    for (size_t i = 0; i < tree->file_count; i++) {
+        bool exists =
+            (state == STATE_ALL_EXISTING) ||
+            (state == STATE_MOSTLY_MISSING && (i % 100) >= missing_percent);
+
+        if (exists) {
+            if (!create_file(tree->files[i])) {
+                fprintf(stderr, "could not create a benchmark file\n");
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            _tremove(tree->files[i]);
+        }
+    }
+}
+
+static TimestampOperation prepare_op(const Tree *tree, StampKind kind) {
+    FileTimeFlags flags = FT_ACCESS | FT_WRITE;
+
+    if (kind == STAMP_REFERENCE) {
+        FsTimes ref;
+
+        if (!get_ref_timestamps(tree->ref, &ref)) {
+            fprintf(stderr, "could not read the reference file\n");
+            exit(EXIT_FAILURE);
+        }
+
+        return prepare_timestamp(NULL, &ref, flags, 0);
+    }
+
+    if (kind == STAMP_ADJUST) {
+        return prepare_timestamp(NULL, NULL, flags, -3600);
+    }
+
+    return prepare_timestamp(NULL, NULL, flags, 0);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double q) {
+    return sorted[(size_t)(q * (double)(n - 1))];
+}
+
+static Result run_scenario(
+    const Scenario *sc, const Tree *tree,
+    unsigned int rounds, unsigned int missing_percent,
+    double *latencies) {
+
+    Result res = { 0 };
+    size_t count = tree->file_count;
+    double best = 0;
+    unsigned long long calls = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        prepare_files(tree, sc->state, missing_percent);
+
+        // Like the tool, build the operation once per run, outside the loop
+        TimestampOperation op = prepare_op(tree, sc->stamp);
+        double *samples = &latencies[(size_t)r * count];
+
+        unsigned long long start_calls = SYSCALLS();
+        double start = now_seconds();
+
+        for (size_t i = 0; i < count; i++) {
+            double t0 = now_seconds();
+
+            if (!touch(tree->files[i], sc->existing_only, true, &op)) {
+                res.failures++;
+            }
+
+            samples[i] = now_seconds() - t0;
+        }
+
+        double elapsed = now_seconds() - start;
+
+        calls += SYSCALLS() - start_calls;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    size_t n = (size_t)rounds * count;
+    qsort(latencies, n, sizeof(double), compare_double);
+
+    res.files_per_sec = (double)count / best;
+    res.p50_us = percentile(latencies, n, 0.50) * 1e6;
+    res.p99_us = percentile(latencies, n, 0.99) * 1e6;
+    res.syscalls_per_file = (double)calls / (double)n;
+
+    return res;
+}
+
+static bool parse_uint(const char *str, unsigned long max, unsigned long *out) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0' || value > max) {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [-n COUNT] [-d DEPTH] [-f FANOUT] [-m MISSING] [-r ROUNDS] [-o FILE]\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = 10000;
+    unsigned long depth = 2;
+    unsigned long fanout = 8;
+    unsigned long missing_percent = 90;
+    unsigned long rounds = 3;
+    const char *json_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 == argc) {
+            usage(argv[0]);
+        }
+
+        const char *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 100000000, &count) && count > 0; break;
+            case 'd': ok = parse_uint(value, 6, &depth); break;
+            case 'f': ok = parse_uint(value, 64, &fanout) && fanout > 0; break;
+            case 'm': ok = parse_uint(value, 100, &missing_percent); break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            case 'o': json_path = value; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+        }
+    }
+
+    Tree tree;
+    build_tree(&tree, count, (unsigned int)depth, (unsigned int)fanout);
+
+    double *latencies = xmalloc((size_t)rounds * count * sizeof(double));
+    Result results[SCENARIO_COUNT];
+
+    printf("%lu files, %zu directories (depth %lu, fan-out %lu), best of %lu rounds\n\n",
+        count, tree.dir_count, depth, fanout, rounds);
+
+    printf("%-10s %12s %10s %10s %14s %9s\n",
+        "scenario", "files/s", "p50 us", "p99 us", "syscalls/file", "failures");
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        results[i] = run_scenario(
+            &scenarios[i], &tree,
+            (unsigned int)rounds, (unsigned int)missing_percent,
+            latencies);
+
+        printf("%-10s %12.0f %10.2f %10.2f %14.2f %9zu\n",
+            scenarios[i].name,
+            results[i].files_per_sec,
+            results[i].p50_us,
+            results[i].p99_us,
+            results[i].syscalls_per_file,
+            results[i].failures);
+    }
+
+    destroy_tree(&tree);
+    free(latencies);
+
+    if (!json_path) {
+        return EXIT_SUCCESS;
+    }
+
+    FILE *fp = fopen(json_path, "w");
+
+    if (!fp) {
+        fprintf(stderr, "could not open %s\n", json_path);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(fp,
+        "{\n"
+        "  \"platform\": \"%s\",\n"
+        "  \"count\": %lu,\n"
+        "  \"depth\": %lu,\n"
+        "  \"fanout\": %lu,\n"
+        "  \"missing_percent\": %lu,\n"
+        "  \"rounds\": %lu,\n"
+        "  \"scenarios\": [\n",
+        BENCH_PLAT, count, depth, fanout, missing_percent, rounds);
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        fprintf(fp,
+            "    {\"name\": \"%s\", \"command\": \"%s\", \"files_per_sec\": %.1f, "
+            "\"p50_us\": %.3f, \"p99_us\": %.3f, \"syscalls_per_file\": %.3f, "
+            "\"failures\": %zu}%s\n",
+            scenarios[i].name,
+            scenarios[i].command,
+            results[i].files_per_sec,
+            results[i].p50_us,
+            results[i].p99_us,
+            results[i].syscalls_per_file,
+            results[i].failures,
+            (i + 1 < SCENARIO_COUNT) ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+
+    return EXIT_SUCCESS;
+}
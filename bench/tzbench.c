@@ -0,0 +1,273 @@
+/* tzbench.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks the cached time zone table in localzone.c against the backend's own
+// local time conversion, for every quarter of an hour from 1970 through 2099
+// in the current time zone. Set TZ to try other zones. Local times that are
+// skipped or repeated around a transition may be resolved differently by the
+// C library; those are counted apart and only fail the check when the two
+// results are not one transition apart. The program fails on any other
+// mismatch, and otherwise times both conversions.
+//
+// Usage: tzbench [-n COUNT] [-r ROUNDS]
+//
+//   -n COUNT    Number of random local times to time conversions on (default 1000000).
+//   -r ROUNDS   Number of timing rounds, best one wins (default 5).
+
+#include "platform.h"
+#include "caltime.h"
+#include "fsbackend.h"
+#include "localzone.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#define YEAR_MIN 1970
+#define YEAR_MAX 2099
+
+#define STEP_TICKS (15 * 60 * CAL_TICKS_PER_SECOND)
+
+// Local times this close to a transition may be skipped or repeated
+#define TRANSITION_WINDOW (3 * 3600 * CAL_TICKS_PER_SECOND)
+
+#ifdef _WIN32
+static double now_seconds(void) {
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)freq.QuadPart;
+}
+#else
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+#endif
+
+/*!
+ * @brief
+ * Converts a local time through the backend, the way timestamps were
+ * converted before the table existed.
+ */
+static bool backend_to_utc(int64_t local, FsTime *out) {
+    int64_t ticks_per_day = (int64_t)CAL_SECONDS_PER_DAY * CAL_TICKS_PER_SECOND;
+    int64_t ticks_of_day = local % ticks_per_day;
+    int32_t seconds = (int32_t)(ticks_of_day / CAL_TICKS_PER_SECOND);
+    int32_t year, month, day;
+
+    cal_civil_from_days((int32_t)(local / ticks_per_day), &year, &month, &day);
+
+    SYSTEMTIME st = {
+        .wYear = (WORD)year,
+        .wMonth = (WORD)month,
+        .wDay = (WORD)day,
+        .wHour = (WORD)(seconds / 3600),
+        .wMinute = (WORD)(seconds / 60 % 60),
+        .wSecond = (WORD)(seconds % 60)
+    };
+
+    return fs_local_systemtime_to_time(&st, out);
+}
+
+/*!
+ * @return
+ * The offset from UTC the backend applies at a local time, or 0 if the
+ * conversion fails.
+ */
+static int64_t backend_offset(int64_t local) {
+    FsTime utc;
+    return backend_to_utc(local, &utc) ? local - (int64_t)utc : 0;
+}
+
+static void print_local(const char *what, int64_t local, FsTime table, FsTime backend) {
+    int64_t ticks_per_day = (int64_t)CAL_SECONDS_PER_DAY * CAL_TICKS_PER_SECOND;
+    int32_t minutes = (int32_t)(local % ticks_per_day / CAL_TICKS_PER_SECOND / 60);
+    int32_t year, month, day;
+
+    cal_civil_from_days((int32_t)(local / ticks_per_day), &year, &month, &day);
+
+    fprintf(stderr, "%s: %04d-%02d-%02dT%02d:%02d local: table %lld, backend %lld\n",
+        what, year, month, day, minutes / 60, minutes % 60,
+        (long long)table, (long long)backend);
+}
+
+static bool check_all_times(unsigned long *near_transitions) {
+    int64_t first = cal_ticks(cal_days_from_civil(YEAR_MIN, 1, 1), 0, 0, 0, 0);
+    int64_t last = cal_ticks(cal_days_from_civil(YEAR_MAX + 1, 1, 1), 0, 0, 0, 0);
+
+    *near_transitions = 0;
+
+    for (int64_t local = first; local < last; local += STEP_TICKS) {
+        FsTime table, backend;
+        bool table_ok = localzone_to_utc(local, &table);
+        bool backend_ok = backend_to_utc(local, &backend);
+
+        if (table_ok != backend_ok) {
+            print_local("only one conversion failed", local, table_ok ? table : 0, backend_ok ? backend : 0);
+            return false;
+        }
+
+        if (!table_ok || table == backend) {
+            continue;
+        }
+
+        // Both results must be valid readings of the local time, one with the
+        // offset before a nearby transition and the other with the one after
+        int64_t before = backend_offset(local - TRANSITION_WINDOW);
+        int64_t after = backend_offset(local + TRANSITION_WINDOW);
+        int64_t diff = (int64_t)backend - (int64_t)table;
+
+        if (before == after || (diff != before - after && diff != after - before)) {
+            print_local("mismatch", local, table, backend);
+            return false;
+        }
+
+        (*near_transitions)++;
+    }
+
+    return true;
+}
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/*!
+ * @return
+ * The best time of all rounds, in nanoseconds per conversion.
+ */
+static double time_conversion(
+    bool use_table,
+    const int64_t *locals, size_t count,
+    unsigned int rounds) {
+
+    double best = 0.0;
+    // Keeps the compiler from discarding the results
+    volatile uint64_t sink = 0;
+
+    for (unsigned int r = 0; r < rounds; r++) {
+        uint64_t acc = 0;
+        double start = now_seconds();
+
+        for (size_t i = 0; i < count; i++) {
+            FsTime utc = 0;
+
+            if (use_table) {
+                localzone_to_utc(locals[i], &utc);
+            } else {
+                backend_to_utc(locals[i], &utc);
+            }
+
+            acc += utc;
+        }
+
+        double elapsed = now_seconds() - start;
+        sink += acc;
+
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    (void)sink;
+    return best * 1e9 / (double)count;
+}
+
+static bool parse_uint(const char *str, unsigned long max, unsigned long *out) {
+    char *end;
+    unsigned long value = strtoul(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0' || value > max) {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n COUNT] [-r ROUNDS]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = 1000000;
+    unsigned long rounds = 5;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 == argc) {
+            usage(argv[0]);
+        }
+
+        const char *value = argv[++i];
+        bool ok = true;
+
+        switch (arg[1]) {
+            case 'n': ok = parse_uint(value, 100000000, &count) && count > 0; break;
+            case 'r': ok = parse_uint(value, 1000, &rounds) && rounds > 0; break;
+            default: ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+        }
+    }
+
+#ifndef _WIN32
+    // mktime() is only required to read TZ through tzset()
+    tzset();
+#endif
+
+    unsigned long near_transitions;
+
+    if (!check_all_times(&near_transitions)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("every quarter hour from %d to %d matches (%lu resolved differently "
+           "next to a transition)\n", YEAR_MIN, YEAR_MAX, near_transitions);
+
+    int64_t first = cal_ticks(cal_days_from_civil(YEAR_MIN, 1, 1), 0, 0, 0, 0);
+    int64_t span = cal_ticks(cal_days_from_civil(YEAR_MAX + 1, 1, 1), 0, 0, 0, 0) - first;
+    int64_t *locals = malloc(count * sizeof(int64_t));
+
+    if (!locals) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t r = ((uint64_t)rng_next() << 32) | rng_next();
+        locals[i] = first + (int64_t)(r % (uint64_t)(span / CAL_TICKS_PER_SECOND)) * CAL_TICKS_PER_SECOND;
+    }
+
+    printf("\n%-14s %10s %10s %9s\n", "conversion", "backend ns", "table ns", "speedup");
+
+    double backend_ns = time_conversion(false, locals, count, (unsigned int)rounds);
+    double table_ns = time_conversion(true, locals, count, (unsigned int)rounds);
+
+    printf("%-14s %10.2f %10.2f %8.2fx\n", "local to UTC", backend_ns, table_ns, backend_ns / table_ns);
+
+    free(locals);
+    return EXIT_SUCCESS;
+}
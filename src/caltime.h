@@ -0,0 +1,164 @@
+/* caltime.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef CALTIME_H
+#define CALTIME_H
+
+// Integer arithmetic on the proleptic Gregorian calendar. Dates are counted in
+// days since January 1, 1601 and instants in 100-nanosecond ticks since the
+// same epoch, which is the FsTime representation.
+//
+// Everything here is pure arithmetic without OS calls, and defined inline so
+// that loops over many dates can be vectorized. Functions do not validate
+// their arguments; callers are expected to pass existing dates.
+
+#include <stdint.h>
+
+// Number of ticks in one second
+#define CAL_TICKS_PER_SECOND 10000000LL
+
+#define CAL_SECONDS_PER_DAY 86400
+
+// Days from March 1 of year 0 to January 1, 1601
+#define CAL_DAYS_TO_1601 584694
+
+// Days in the 400-year cycle after which the calendar repeats itself
+#define CAL_DAYS_PER_ERA 146097
+
+/*!
+ * @brief
+ * Number of days in the year before the first day of each month, for common
+ * and leap years. The thirteenth entry is the length of the year.
+ */
+static const int16_t cal_days_before_month[2][13] = {
+    { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+    { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+/*!
+ * @return
+ * 1 if \p year is a leap year; 0 otherwise.
+ */
+static inline int32_t cal_is_leap_year(int32_t year) {
+    return ((year % 4 == 0) & (year % 100 != 0)) | (year % 400 == 0);
+}
+
+/*!
+ * @brief
+ * Determines the number of days in a month without a table lookup.
+ *
+ * @param month
+ * The month (1-12).
+ */
+static inline int32_t cal_days_in_month(int32_t year, int32_t month) {
+    // Months alternate between 31 and 30 days, starting over in August
+    return (month == 2) ?
+        28 + cal_is_leap_year(year) :
+        30 + ((month ^ (month >> 3)) & 1);
+}
+
+/*!
+ * @brief
+ * Converts a calendar date to the number of days since January 1, 1601.
+ *
+ * Years are counted in 400-year eras of a calendar that starts on March 1, so
+ * that leap days fall at the end of the year.
+ * https://howardhinnant.github.io/date_algorithms.html#days_from_civil
+ */
+static inline int32_t cal_days_from_civil(int32_t year, int32_t month, int32_t day) {
+    year -= (month <= 2);
+
+    // Rounds towards negative infinity for years before 0
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    int32_t year_of_era = year - era * 400;
+    int32_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+    return era * CAL_DAYS_PER_ERA + day_of_era - CAL_DAYS_TO_1601;
+}
+
+/*!
+ * @brief
+ * Converts a number of days since January 1, 1601 to a calendar date. This is
+ * the inverse of cal_days_from_civil().
+ *
+ * @param days
+ * Number of days since January 1, 1601.
+ */
+static inline void cal_civil_from_days(
+    int32_t days,
+    int32_t *year, int32_t *month, int32_t *day) {
+
+    days += CAL_DAYS_TO_1601;
+
+    int32_t era = (days >= 0 ? days : days - (CAL_DAYS_PER_ERA - 1)) / CAL_DAYS_PER_ERA;
+    int32_t day_of_era = days - era * CAL_DAYS_PER_ERA;
+    int32_t year_of_era =
+        (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int32_t shifted_month = (5 * day_of_year + 2) / 153;
+
+    *day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    *month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    *year = year_of_era + era * 400 + (*month <= 2);
+}
+
+/*!
+ * @brief
+ * Converts an ordinal day of a year to a month and day of month.
+ *
+ * @param ordinal_day
+ * The ordinal day of the year (1-365 or 1-366 for leap years).
+ */
+static inline void cal_month_from_ordinal(
+    int32_t year, int32_t ordinal_day,
+    int32_t *month, int32_t *day) {
+
+    const int16_t *before = cal_days_before_month[cal_is_leap_year(year)];
+
+    // No month has more than 32 days, so this estimate is either the month
+    // itself or the one before it
+    int32_t m = (ordinal_day + 31) / 32;
+
+    if (ordinal_day > before[m]) {
+        m++;
+    }
+
+    *month = m;
+    *day = ordinal_day - before[m - 1];
+}
+
+/*!
+ * @brief
+ * Determines the day of the week of a number of days since January 1, 1601.
+ *
+ * @return
+ * The day of the week, where Sunday=0, Monday=1, ..., Saturday=6.
+ */
+static inline int32_t cal_day_of_week(int32_t days) {
+    // January 1, 1601 was a Monday
+    return (days % 7 + 8) % 7;
+}
+
+/*!
+ * @brief
+ * Combines a number of days since January 1, 1601 and a time of day into
+ * ticks since the same epoch.
+ */
+static inline int64_t cal_ticks(
+    int32_t days,
+    int32_t hour, int32_t minute, int32_t second, int32_t millisecond) {
+
+    int64_t seconds =
+        (int64_t)days * CAL_SECONDS_PER_DAY +
+        hour * 3600 + minute * 60 + second;
+
+    return seconds * CAL_TICKS_PER_SECOND +
+           (int64_t)millisecond * (CAL_TICKS_PER_SECOND / 1000);
+}
+
+#endif // CALTIME_H
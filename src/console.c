@@ -8,17 +8,222 @@
 #include "console.h"
 
 #include <stdlib.h>
+#include <string.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Resets all graphic attributes
+#define VT_RESET _T("\x1b[0m")
+
+static bool stream_is_vt(const Console *console, FILE *stream) {
+    if (stream == stdout) {
+        return console->out_vt;
+    }
+
+    if (stream == stderr) {
+        return console->err_vt;
+    }
+
+    return false;
+}
+
+/*!
+ * @brief
+ * Maps a console color to the offset of its VT color code. Console colors
+ * follow the Windows layout, where bit 0 is blue, bit 1 green, bit 2 red and
+ * bit 3 intensity, while VT orders the color bits the other way around.
+ */
+static int vt_color(ConsoleColor color) {
+    int vt =
+        ((color & 0x4) ? 1 : 0) |
+        ((color & 0x2) ? 2 : 0) |
+        ((color & 0x1) ? 4 : 0);
+
+    // Bright colors are 60 codes above the normal ones
+    return (color & 0x8) ? (vt + 60) : vt;
+}
+
+/*!
+ * @brief
+ * Writes the buffered output to its stream. The lock must be held.
+ */
+static void flush_buffer(Console *console) {
+    if (console->used == 0) {
+        return;
+    }
+
+    console->buf[console->used] = '\0';
+    console->used = 0;
+
+    // Formatted output never contains null characters, so the buffer can be
+    // written as a string, which lets the runtime convert wide characters
+    _fputts(console->buf, console->stream);
+    fflush(console->stream);
+}
+
+/*!
+ * @brief
+ * Directs the buffer to a stream, writing out what was buffered for another
+ * stream first. The lock must be held.
+ */
+static void select_stream(Console *console, FILE *stream) {
+    if (console->stream != stream) {
+        flush_buffer(console);
+        console->stream = stream;
+    }
+}
+
+/*!
+ * @brief
+ * Appends a string to the buffer. The lock must be held.
+ */
+static void append_string(Console *console, const TCHAR *str) {
+    size_t len = _tcslen(str);
+
+    if (len > CONSOLE_BUFFER_SIZE - console->used) {
+        flush_buffer(console);
+
+        if (len > CONSOLE_BUFFER_SIZE) {
+            _fputts(str, console->stream);
+            return;
+        }
+    }
+
+    memcpy(&console->buf[console->used], str, len * sizeof(TCHAR));
+    console->used += len;
+}
+
+/*!
+ * @brief
+ * Appends formatted text to the buffer. Text that does not fit in the whole
+ * buffer is written to the stream directly instead. The lock must be held.
+ *
+ * @return
+ * Number of characters printed, or a negative value on error.
+ */
+static int append_vformat(Console *console, const TCHAR *fmt, va_list args) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t space = CONSOLE_BUFFER_SIZE + 1 - console->used;
+
+        va_list copy;
+        va_copy(copy, args);
+
+        int len = _vsntprintf(&console->buf[console->used], space, fmt, copy);
+
+        va_end(copy);
+
+        if (len >= 0 && (size_t)len < space) {
+            console->used += (size_t)len;
+            return len;
+        }
+
+        if (console->used == 0) {
+            break;
+        }
+
+        flush_buffer(console);
+    }
+
+    return _vftprintf(console->stream, fmt, args);
+}
+
+/*!
+ * @brief
+ * Appends the escape sequences that select colors to the buffer. The lock
+ * must be held.
+ */
+static void append_colors(Console *console, ConsoleColor bg, ConsoleColor fg) {
+    TCHAR seq[16];
+
+    if (bg != CONSOLE_COLOR_NONE) {
+        _sntprintf(seq, sizeof(seq) / sizeof(TCHAR), _T("\x1b[%dm"), 40 + vt_color(bg));
+        append_string(console, seq);
+    }
+
+    if (fg != CONSOLE_COLOR_NONE) {
+        _sntprintf(seq, sizeof(seq) / sizeof(TCHAR), _T("\x1b[%dm"), 30 + vt_color(fg));
+        append_string(console, seq);
+    }
+}
+
+/*!
+ * @brief
+ * Checks whether the last \p len characters appended to the buffer end with a
+ * new line.
+ */
+static bool buffer_ends_with_newline(const Console *console, int len) {
+    // Text too long for the buffer went straight to the stream
+    return len > 0 && console->used > 0 && console->buf[console->used - 1] == '\n';
+}
+
+#ifdef _WIN32
 #define FG_MASK (FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY)
 #define BG_MASK (BACKGROUND_RED | BACKGROUND_GREEN | BACKGROUND_BLUE | BACKGROUND_INTENSITY)
 
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+/*!
+ * @brief
+ * Turns on VT processing for a console handle, which Windows 10 and later
+ * support.
+ *
+ * @param mode
+ * Pointer to a DWORD that receives the mode to restore on close, or 0 if the
+ * mode was left as it was.
+ *
+ * @return
+ * true if the handle is a console that processes VT sequences; false
+ * otherwise.
+ */
+static bool enable_vt(HANDLE h, DWORD *mode) {
+    DWORD prev;
+
+    *mode = 0;
+
+    if (!h || h == INVALID_HANDLE_VALUE || !GetConsoleMode(h, &prev)) {
+        return false;
+    }
+
+    if (prev & ENABLE_VIRTUAL_TERMINAL_PROCESSING) {
+        return true;
+    }
+
+    if (!SetConsoleMode(h, prev | ENABLE_VIRTUAL_TERMINAL_PROCESSING)) {
+        return false;
+    }
+
+    *mode = prev;
+    return true;
+}
+
 Console *console_open(void) {
     Console *console = calloc(1, sizeof(Console));
     if (!console) {
         return NULL;
     }
 
-    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (mtx_init(&console->lock, mtx_plain) != thrd_success) {
+        free(console);
+        return NULL;
+    }
+
+    console->stream = stderr;
+
+    console->out_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    console->err_handle = GetStdHandle(STD_ERROR_HANDLE);
+
+    console->out_vt = enable_vt(console->out_handle, &console->out_mode);
+    console->err_vt = enable_vt(console->err_handle, &console->err_mode);
+
+    if (console->out_vt || console->err_vt) {
+        return console;
+    }
+
+    HANDLE h = console->out_handle;
     if (!h || h == INVALID_HANDLE_VALUE) {
         return console;
     }
@@ -41,18 +246,36 @@ void console_close(Console *console) {
         return;
     }
 
+    flush_buffer(console);
+
     if (console->is_tty) {
         SetConsoleTextAttribute(console->handle, console->attributes);
     }
 
-    free(console);
-}
+    if (console->out_vt) {
+        _fputts(VT_RESET, stdout);
+        fflush(stdout);
+    }
 
-void console_set_colors(Console *console, ConsoleColor bg, ConsoleColor fg) {
-    if (!console || !console->is_tty) {
-        return;
+    // Both handles may refer to the same console, so they are restored in
+    // the reverse order they were changed in
+    if (console->err_mode) {
+        SetConsoleMode(console->err_handle, console->err_mode);
     }
 
+    if (console->out_mode) {
+        SetConsoleMode(console->out_handle, console->out_mode);
+    }
+
+    mtx_destroy(&console->lock);
+    free(console);
+}
+
+/*!
+ * @brief
+ * Sets the attributes of a console without VT support. The lock must be held.
+ */
+static void set_attributes(Console *console, ConsoleColor bg, ConsoleColor fg) {
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(console->handle, &csbi)) {
         return;
@@ -71,61 +294,198 @@ void console_set_colors(Console *console, ConsoleColor bg, ConsoleColor fg) {
     SetConsoleTextAttribute(console->handle, attrs);
 }
 
+/*!
+ * @brief
+ * Prints colored text to a console without VT support. Attributes apply to
+ * text as it is written, so the buffer is written out before the colors are
+ * set, and again before they are restored. The lock must be held.
+ */
+static int legacy_vfprintf_color(
+    Console *console, ConsoleColor bg, ConsoleColor fg,
+    FILE *stream, const TCHAR *fmt, va_list args) {
+
+    select_stream(console, stream);
+    flush_buffer(console);
+
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (!GetConsoleScreenBufferInfo(console->handle, &csbi)) {
+        // Fallback
+        csbi.wAttributes = console->attributes;
+    }
+
+    WORD prev_attr = csbi.wAttributes;
+
+    set_attributes(console, bg, fg);
+
+    int ret = append_vformat(console, fmt, args);
+
+    // If the text ends with a new line and a background color is used, it's
+    // going to leak onto the next line once the console begins scrolling
+    //
+    // It's just how the console buffer appears to work and the only fix is to
+    // hold back the new line, reset the color, then add it back
+    bool hold_newline = bg != CONSOLE_COLOR_NONE && buffer_ends_with_newline(console, ret);
+
+    if (hold_newline) {
+        console->used--;
+    }
+
+    flush_buffer(console);
+    SetConsoleTextAttribute(console->handle, prev_attr);
+
+    if (hold_newline) {
+        append_string(console, _T("\n"));
+    }
+
+    return ret;
+}
+
+void console_set_colors(Console *console, ConsoleColor bg, ConsoleColor fg) {
+    if (!console) {
+        return;
+    }
+
+    mtx_lock(&console->lock);
+
+    if (console->out_vt) {
+        select_stream(console, stdout);
+        append_colors(console, bg, fg);
+    } else if (console->is_tty) {
+        flush_buffer(console);
+        set_attributes(console, bg, fg);
+    }
+
+    mtx_unlock(&console->lock);
+}
+
 void console_reset_colors(Console *console) {
-    if (!console || !console->is_tty) {
+    if (!console) {
         return;
     }
 
-    SetConsoleTextAttribute(console->handle, console->attributes);
+    mtx_lock(&console->lock);
+
+    if (console->out_vt) {
+        select_stream(console, stdout);
+        append_string(console, VT_RESET);
+    } else if (console->is_tty) {
+        flush_buffer(console);
+        SetConsoleTextAttribute(console->handle, console->attributes);
+    }
+
+    mtx_unlock(&console->lock);
 }
+#else
+Console *console_open(void) {
+    Console *console = calloc(1, sizeof(Console));
+    if (!console) {
+        return NULL;
+    }
 
-int console_vfprintf_color(
-    Console *console, ConsoleColor bg, ConsoleColor fg,
-    FILE *stream, _Printf_format_string_ const TCHAR *fmt, va_list args) {
+    if (mtx_init(&console->lock, mtx_plain) != thrd_success) {
+        free(console);
+        return NULL;
+    }
 
-    if (!console || !console->is_tty) {
-        return _vftprintf(stream, fmt, args);
+    console->stream = stderr;
+    console->out_vt = isatty(STDOUT_FILENO);
+    console->err_vt = isatty(STDERR_FILENO);
+
+    return console;
+}
+
+void console_close(Console *console) {
+    if (!console) {
+        return;
     }
 
-    // If the format string ends with a new line and a background color is used,
-    // it's going to leak onto the next line once the console begins scrolling
-    // 
-    // It's just how the console buffer appears to work and the only fix is to
-    // trim the new line, reset the color, then add it back
-    size_t len = _tcslen(fmt);
-    bool ends_with_newline = (len > 0) && (fmt[len - 1] == '\n');
+    flush_buffer(console);
 
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    if (!GetConsoleScreenBufferInfo(console->handle, &csbi)) {
-        // Fallback
-        csbi.wAttributes = console->attributes;
+    if (console->out_vt) {
+        fputs(VT_RESET, stdout);
+        fflush(stdout);
     }
 
-    WORD prev_attr = csbi.wAttributes;
+    mtx_destroy(&console->lock);
+    free(console);
+}
+
+void console_set_colors(Console *console, ConsoleColor bg, ConsoleColor fg) {
+    if (!console || !console->out_vt) {
+        return;
+    }
+
+    mtx_lock(&console->lock);
+    select_stream(console, stdout);
+    append_colors(console, bg, fg);
+    mtx_unlock(&console->lock);
+}
 
-    if (bg != CONSOLE_COLOR_NONE || fg != CONSOLE_COLOR_NONE) {
-        console_set_colors(console, bg, fg);
+void console_reset_colors(Console *console) {
+    if (!console || !console->out_vt) {
+        return;
+    }
+
+    mtx_lock(&console->lock);
+    select_stream(console, stdout);
+    append_string(console, VT_RESET);
+    mtx_unlock(&console->lock);
+}
+#endif
+
+void console_flush(Console *console) {
+    if (!console) {
+        return;
     }
 
+    mtx_lock(&console->lock);
+    flush_buffer(console);
+    mtx_unlock(&console->lock);
+}
+
+int console_vfprintf_color(
+    Console *console, ConsoleColor bg, ConsoleColor fg,
+    FILE *stream, _Printf_format_string_ const TCHAR *fmt, va_list args) {
+
+    if (!console) {
+        return _vftprintf(stream, fmt, args);
+    }
+
+    bool colored = bg != CONSOLE_COLOR_NONE || fg != CONSOLE_COLOR_NONE;
     int ret;
 
-    if (!ends_with_newline || bg == CONSOLE_COLOR_NONE) {
-        ret = _vftprintf(stream, fmt, args);
-        SetConsoleTextAttribute(console->handle, prev_attr);
-    } else {
-        TCHAR *tmp = _tcsdup(fmt);
-        tmp[len - 1] = '\0';
+    mtx_lock(&console->lock);
 
-        ret = _vftprintf(stream, tmp, args);
+#ifdef _WIN32
+    if (colored && !stream_is_vt(console, stream) && console->is_tty) {
+        ret = legacy_vfprintf_color(console, bg, fg, stream, fmt, args);
+        mtx_unlock(&console->lock);
+        return ret;
+    }
+#endif
 
-        free(tmp);
-        SetConsoleTextAttribute(console->handle, prev_attr);
+    select_stream(console, stream);
 
-        if (_puttc('\n', stream) != _TEOF) {
-            ret++;
+    if (!colored || !stream_is_vt(console, stream)) {
+        ret = append_vformat(console, fmt, args);
+    } else {
+        append_colors(console, bg, fg);
+
+        ret = append_vformat(console, fmt, args);
+
+        // As on legacy consoles, a background color would leak onto the next
+        // line once the terminal scrolls, so the color is reset before the
+        // trailing new line
+        if (buffer_ends_with_newline(console, ret)) {
+            console->used--;
+            append_string(console, VT_RESET _T("\n"));
+        } else {
+            append_string(console, VT_RESET);
         }
     }
 
+    mtx_unlock(&console->lock);
+
     return ret;
 }
 
@@ -156,4 +516,4 @@ int console_printf_error(
 
     va_end(args);
     return ret;
-}
\ No newline at end of file
+}
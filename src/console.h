@@ -8,20 +8,44 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
-#define WIN32_LEAN_AND_MEAN
+#include "platform.h"
 
+#include <stdarg.h>
 #include <stdbool.h>
-#include <windows.h>
-#include <tchar.h>
+#include <stdio.h>
+#include <threads.h>
+
+// Number of characters of output held back before they are written out
+#define CONSOLE_BUFFER_SIZE 16384
 
  /*!
   * @brief
   * Represents a console instance.
   */
 typedef struct console {
+    // Output is gathered here, colors included, and written to its stream in
+    // one piece once the buffer fills up, the stream changes or the console
+    // is flushed. Room is left for a terminating null character
+    TCHAR buf[CONSOLE_BUFFER_SIZE + 1];
+    size_t used;
+    FILE *stream;
+    // Messages may be printed from worker threads
+    mtx_t lock;
+    // Colors are written as VT escape sequences, so they are only emitted to
+    // streams that refer to a terminal that understands them
+    bool out_vt;
+    bool err_vt;
+#ifdef _WIN32
+    // Consoles without VT support are colored through the attribute API
     HANDLE handle;
     WORD attributes;
     bool is_tty;
+    // Modes to restore on close, for the handles VT processing was enabled on
+    HANDLE out_handle;
+    HANDLE err_handle;
+    DWORD out_mode;
+    DWORD err_mode;
+#endif
 } Console;
 
 /*!
@@ -60,7 +84,8 @@ Console *console_open(void);
 
 /*!
  * @brief
- * Restores original console attributes and frees the instance.
+ * Writes out buffered output, restores original console attributes and
+ * frees the instance.
  *
  * @param console
  * Console instance to close. If NULL, no action is taken.
@@ -88,6 +113,17 @@ void console_set_colors(Console *console, ConsoleColor bg, ConsoleColor fg);
  */
 void console_reset_colors(Console *console);
 
+/*!
+ * @brief
+ * Writes out the output buffered by the console. Must be called before
+ * writing to stdout or stderr other than through the console, so that the
+ * output stays in order.
+ *
+ * @param console
+ * Console instance. If NULL, no action is taken.
+ */
+void console_flush(Console *console);
+
 int console_vfprintf_color(
     Console *console, ConsoleColor bg, ConsoleColor fg,
     FILE *stream, _Printf_format_string_ const TCHAR *fmt, va_list args);
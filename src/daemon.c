@@ -0,0 +1,956 @@
+/* daemon.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "daemon.h"
+#include "ipc.h"
+#include "timeparse.h"
+
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#define REQUEST_MAGIC "touch 1"
+
+// Largest request a server accepts, in bytes
+#define REQUEST_MAX ((size_t)1 << 28)
+
+// Number of bytes read from a connection at a time
+#define READ_CHUNK 65536
+
+// Longest line of a reply, including the terminating null character
+#define REPLY_LINE_CAPACITY 64
+
+#ifdef _WIN32
+#define ERR_PROTOCOL ERROR_INVALID_DATA
+#else
+#define ERR_PROTOCOL EPROTO
+#endif
+
+/*!
+ * @brief
+ * A growable array of bytes.
+ */
+typedef struct byte_buffer {
+    char *data;
+    size_t used;
+    size_t capacity;
+} ByteBuffer;
+
+/*!
+ * @brief
+ * A thread of the server, with everything it keeps from one request to the
+ * next.
+ */
+typedef struct daemon_worker {
+    IpcServer *server;
+    FsBatch *executor;
+    TouchWorkspace *workspace;
+    ByteBuffer request;
+    ByteBuffer reply;
+#ifdef UNICODE
+    // The request converted to UTF-16
+    TCHAR *chars;
+    size_t chars_capacity;
+#endif
+    // Paths joined with the directory given by the cwd field
+    TCHAR *joined;
+    size_t joined_capacity;
+    const TCHAR **paths;
+    TouchStatus *results;
+    size_t paths_capacity;
+} DaemonWorker;
+
+/*!
+ * @brief
+ * The fields of a request.
+ */
+typedef struct request_fields {
+    FileTimeFlags ft_flags;
+    const TCHAR *stamp;
+    const TCHAR *ref_path;
+    const TCHAR *offset;
+    const TCHAR *cwd;
+    bool existing_only;
+    bool follow_symlinks;
+} RequestFields;
+
+static void set_last_error(FsError err) {
+#ifdef _WIN32
+    SetLastError(err);
+#else
+    errno = (int)err;
+#endif
+}
+
+/*!
+ * @brief
+ * Makes room for at least \p size more bytes in a buffer.
+ *
+ * @return
+ * true if there is room; false if memory could not be allocated.
+ */
+static bool buffer_reserve(ByteBuffer *buf, size_t size) {
+    if (buf->capacity - buf->used >= size) {
+        return true;
+    }
+
+    size_t capacity = buf->capacity ? buf->capacity : READ_CHUNK;
+
+    while (capacity - buf->used < size) {
+        capacity *= 2;
+    }
+
+    char *data = realloc(buf->data, capacity);
+
+    if (!data) {
+        return false;
+    }
+
+    buf->data = data;
+    buf->capacity = capacity;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Appends bytes to a buffer.
+ */
+static bool buffer_append(ByteBuffer *buf, const void *data, size_t size) {
+    if (!buffer_reserve(buf, size)) {
+        return false;
+    }
+
+    memcpy(&buf->data[buf->used], data, size);
+    buf->used += size;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Appends a string to a buffer as UTF-8, followed by a null character.
+ */
+static bool buffer_append_string(ByteBuffer *buf, const TCHAR *str) {
+#ifdef UNICODE
+    int size = WideCharToMultiByte(CP_UTF8, 0, str, -1, NULL, 0, NULL, NULL);
+
+    if (size <= 0 || !buffer_reserve(buf, (size_t)size)) {
+        return false;
+    }
+
+    WideCharToMultiByte(CP_UTF8, 0, str, -1, &buf->data[buf->used], size, NULL, NULL);
+    buf->used += (size_t)size;
+
+    return true;
+#else
+    return buffer_append(buf, str, strlen(str) + 1);
+#endif
+}
+
+/*!
+ * @brief
+ * Appends a field to a request.
+ */
+static bool append_field(ByteBuffer *buf, const char *key, const TCHAR *value) {
+    return buffer_append(buf, key, strlen(key)) && buffer_append_string(buf, value);
+}
+
+static bool is_relative(const TCHAR *path) {
+#ifdef _WIN32
+    // Paths that start with a drive letter, even one without a separator,
+    // are left alone
+    return path[0] != '\\' && path[0] != '/' && !(path[0] && path[1] == ':');
+#else
+    return path[0] != '/';
+#endif
+}
+
+/*!
+ * @brief
+ * Reads a decimal number, from a reply line or the count field of a request.
+ *
+ * @return
+ * Pointer past the number, or NULL if there is none.
+ */
+static const char *parse_number(const char *str, unsigned long long *out) {
+    if (*str < '0' || *str > '9') {
+        return NULL;
+    }
+
+    unsigned long long value = 0;
+
+    while (*str >= '0' && *str <= '9') {
+        // Saturates rather than wraps, so that no count is mistaken for a
+        // smaller one
+        unsigned long long digit = (unsigned long long)(*str++ - '0');
+        value = (value > (ULLONG_MAX - digit) / 10) ? ULLONG_MAX : value * 10 + digit;
+    }
+
+    *out = value;
+
+    return str;
+}
+
+/*!
+ * @brief
+ * Reads a request from a connection: the fields, then as many paths as the
+ * count field gives, then the empty string that ends it.
+ *
+ * @param size
+ * Pointer to a size_t that receives the size of the request in bytes.
+ *
+ * @param count
+ * Pointer to a size_t that receives the number of paths.
+ *
+ * @return
+ * NULL if a whole request was read; "size" if it is larger than a server
+ * accepts; "count" if the count field is missing or does not match the
+ * paths; an empty string if the connection broke first.
+ */
+static const char *read_request(DaemonWorker *w, IpcConn *conn, size_t *size, size_t *count) {
+    ByteBuffer *buf = &w->request;
+    size_t scanned = 0;
+    size_t string_start = 0;
+    bool in_paths = false;
+    bool have_count = false;
+    unsigned long long expected = 0;
+    size_t paths = 0;
+
+    buf->used = 0;
+
+    for (;;) {
+        if (!buffer_reserve(buf, READ_CHUNK)) {
+            return "memory";
+        }
+
+        size_t received;
+
+        if (!ipc_read(conn, &buf->data[buf->used], READ_CHUNK, &received) || received == 0) {
+            return "";
+        }
+
+        buf->used += received;
+
+        // Paths can be empty, so they are counted rather than ended by an
+        // empty string the way the fields are
+        while (scanned < buf->used) {
+            const char *nul = memchr(&buf->data[scanned], '\0', buf->used - scanned);
+
+            if (!nul) {
+                scanned = buf->used;
+                break;
+            }
+
+            size_t pos = (size_t)(nul - buf->data);
+            const char *str = &buf->data[string_start];
+
+            if (!in_paths) {
+                if (pos == string_start) {
+                    if (!have_count) {
+                        return "count";
+                    }
+
+                    in_paths = true;
+                } else if (strncmp(str, "count=", 6) == 0) {
+                    const char *rest = parse_number(str + 6, &expected);
+
+                    if (!rest || *rest) {
+                        return "count";
+                    }
+
+                    have_count = true;
+                }
+            } else if (paths < expected) {
+                paths++;
+            } else if (pos != string_start) {
+                return "count";
+            } else {
+                *size = pos + 1;
+                *count = paths;
+                return NULL;
+            }
+
+            string_start = scanned = pos + 1;
+        }
+
+        if (buf->used > REQUEST_MAX) {
+            return "size";
+        }
+    }
+}
+
+/*!
+ * @brief
+ * Reads the fields of a request.
+ *
+ * @param cursor
+ * Pointer to the first field, which receives a pointer past the empty string
+ * that ends the fields.
+ *
+ * @return
+ * NULL if every field is valid; otherwise the reason the request is rejected.
+ */
+static const char *parse_fields(TCHAR **cursor, RequestFields *fields) {
+    TCHAR *str = *cursor;
+
+    for (TCHAR *next; *str; str = next) {
+        // Found before the field is split in two
+        next = str + _tcslen(str) + 1;
+
+        TCHAR *value = _tcschr(str, '=');
+
+        if (!value) {
+            return "field";
+        }
+
+        *value++ = '\0';
+
+        if (_tcscmp(str, _T("flags")) == 0) {
+            for (const TCHAR *c = value; *c; c++) {
+                if (*c == 'C') {
+                    fields->ft_flags |= FT_CREATION;
+                } else if (*c == 'a') {
+                    fields->ft_flags |= FT_ACCESS;
+                } else if (*c == 'm') {
+                    fields->ft_flags |= FT_WRITE;
+                } else {
+                    return "flags";
+                }
+            }
+        } else if (_tcscmp(str, _T("time")) == 0) {
+            fields->stamp = value;
+        } else if (_tcscmp(str, _T("ref")) == 0) {
+            fields->ref_path = value;
+        } else if (_tcscmp(str, _T("adjust")) == 0) {
+            fields->offset = value;
+        } else if (_tcscmp(str, _T("cwd")) == 0) {
+            fields->cwd = value;
+        } else if (_tcscmp(str, _T("count")) == 0) {
+            // Already checked by read_request(), which it frames the paths for
+            continue;
+        } else if (_tcscmp(str, _T("create")) == 0 || _tcscmp(str, _T("follow")) == 0) {
+            if (_tcscmp(value, _T("0")) != 0 && _tcscmp(value, _T("1")) != 0) {
+                return "field";
+            }
+
+            bool on = value[0] == '1';
+
+            if (str[0] == 'c') {
+                fields->existing_only = !on;
+            } else {
+                fields->follow_symlinks = on;
+            }
+        } else {
+            return "field";
+        }
+    }
+
+    *cursor = str + 1;
+
+    return NULL;
+}
+
+/*!
+ * @brief
+ * Collects the paths of a request, joining relative ones with \p cwd.
+ *
+ * @param cursor
+ * Pointer to the first path.
+ *
+ * @param chars
+ * Number of characters from \p cursor to the end of the request.
+ *
+ * @param n
+ * Number of paths, as read by read_request().
+ *
+ * @return
+ * NULL on success; otherwise the reason the request is rejected.
+ */
+static const char *collect_paths(
+    DaemonWorker *w, TCHAR *cursor, size_t chars,
+    const TCHAR *cwd, size_t n) {
+
+    if (n > w->paths_capacity) {
+        const TCHAR **paths = realloc(w->paths, n * sizeof(TCHAR *));
+
+        if (paths) {
+            w->paths = paths;
+        }
+
+        TouchStatus *results = realloc(w->results, n * sizeof(TouchStatus));
+
+        if (results) {
+            w->results = results;
+        }
+
+        if (!paths || !results) {
+            return "memory";
+        }
+
+        w->paths_capacity = n;
+    }
+
+    size_t cwd_len = cwd ? _tcslen(cwd) : 0;
+
+    // Room for every path to be joined
+    if (cwd) {
+        size_t capacity = chars + n * (cwd_len + 1);
+
+        if (capacity > w->joined_capacity) {
+            TCHAR *joined = realloc(w->joined, capacity * sizeof(TCHAR));
+
+            if (!joined) {
+                return "memory";
+            }
+
+            w->joined = joined;
+            w->joined_capacity = capacity;
+        }
+    }
+
+    bool cwd_has_sep = cwd_len > 0 && (cwd[cwd_len - 1] == PATH_SEP || cwd[cwd_len - 1] == '/');
+    size_t used = 0;
+    TCHAR *str = cursor;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t len = _tcslen(str);
+
+        // An empty path names no file, here as on the command line, rather
+        // than the directory it would be joined with
+        if (cwd && len > 0 && is_relative(str)) {
+            TCHAR *path = &w->joined[used];
+
+            memcpy(path, cwd, cwd_len * sizeof(TCHAR));
+            used += cwd_len;
+
+            if (!cwd_has_sep) {
+                w->joined[used++] = PATH_SEP;
+            }
+
+            memcpy(&w->joined[used], str, (len + 1) * sizeof(TCHAR));
+            used += len + 1;
+
+            w->paths[i] = path;
+        } else {
+            w->paths[i] = str;
+        }
+
+        str += len + 1;
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief
+ * Appends a line to the reply.
+ */
+static bool reply_line(DaemonWorker *w, const char *fmt, ...) {
+    if (!buffer_reserve(&w->reply, REPLY_LINE_CAPACITY)) {
+        return false;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+
+    int len = vsnprintf(&w->reply.data[w->reply.used], REPLY_LINE_CAPACITY, fmt, args);
+
+    va_end(args);
+
+    if (len < 0 || len >= REPLY_LINE_CAPACITY) {
+        return false;
+    }
+
+    w->reply.used += (size_t)len;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Carries out a request read into the worker's buffer and builds its reply.
+ *
+ * @return
+ * NULL on success; otherwise the reason the request is rejected.
+ */
+static const char *run_request(DaemonWorker *w, size_t size, size_t count) {
+#ifdef UNICODE
+    if (size > w->chars_capacity) {
+        TCHAR *chars = realloc(w->chars, size * sizeof(TCHAR));
+
+        if (!chars) {
+            return "memory";
+        }
+
+        w->chars = chars;
+        w->chars_capacity = size;
+    }
+
+    // The null characters that separate the strings are converted with them
+    int len = MultiByteToWideChar(
+        CP_UTF8, MB_ERR_INVALID_CHARS,
+        w->request.data, (int)size, w->chars, (int)w->chars_capacity);
+
+    if (len <= 0) {
+        return "encoding";
+    }
+
+    TCHAR *start = w->chars;
+    size_t chars = (size_t)len;
+#else
+    TCHAR *start = w->request.data;
+    size_t chars = size;
+#endif
+
+    if (_tcscmp(start, _T(REQUEST_MAGIC)) != 0) {
+        return "version";
+    }
+
+    RequestFields fields = { .follow_symlinks = true };
+    TCHAR *cursor = start + _tcslen(start) + 1;
+    const char *reason = parse_fields(&cursor, &fields);
+
+    if (reason) {
+        return reason;
+    }
+
+    reason = collect_paths(w, cursor, chars - (size_t)(cursor - start), fields.cwd, count);
+
+    if (reason) {
+        return reason;
+    }
+
+    // Same defaults as the command line
+    if (!(fields.ft_flags & (FT_CREATION | FT_ACCESS | FT_WRITE))) {
+        fields.ft_flags |= (FT_ACCESS | FT_WRITE);
+    }
+
+    FsTime stamp, *stamp_ptr = NULL;
+    FsTimes ref_stamps, *ref_stamps_ptr = NULL;
+    int adjustment_seconds = 0;
+
+    if (fields.stamp) {
+        if (!parse_timestamp_string(fields.stamp, &stamp)) {
+            return "time";
+        }
+
+        stamp_ptr = &stamp;
+    }
+
+    if (fields.offset && !parse_hhmmss(fields.offset, &adjustment_seconds)) {
+        return "adjust";
+    }
+
+    if (fields.ref_path) {
+        const TCHAR *ref_path = fields.ref_path;
+        TCHAR *joined = NULL;
+
+        if (fields.cwd && is_relative(ref_path)) {
+            size_t cwd_len = _tcslen(fields.cwd);
+            size_t len = _tcslen(ref_path);
+
+            joined = malloc((cwd_len + len + 2) * sizeof(TCHAR));
+
+            if (!joined) {
+                return "memory";
+            }
+
+            memcpy(joined, fields.cwd, cwd_len * sizeof(TCHAR));
+            joined[cwd_len] = PATH_SEP;
+            memcpy(&joined[cwd_len + 1], ref_path, (len + 1) * sizeof(TCHAR));
+
+            ref_path = joined;
+        }
+
+        bool ok = get_ref_timestamps(ref_path, &ref_stamps);
+        free(joined);
+
+        if (!ok) {
+            return "ref";
+        }
+
+        ref_stamps_ptr = &ref_stamps;
+    }
+
+    TimestampOperation op = prepare_timestamp(
+        stamp_ptr, ref_stamps_ptr,
+        fields.ft_flags, adjustment_seconds);
+
+    if (w->executor && count > 1) {
+        touch_many(
+            w->executor, w->workspace, w->paths, count,
+            fields.existing_only, fields.follow_symlinks,
+            &op, NULL, w->results);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            TouchStatus *result = &w->results[i];
+
+            result->ok = touch(w->paths[i], fields.existing_only, fields.follow_symlinks, &op);
+            result->err = result->ok ? FS_OK : fs_last_error();
+        }
+    }
+
+    size_t failed = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (w->results[i].ok) {
+            continue;
+        }
+
+        failed++;
+
+        if (!reply_line(w, "fail %zu %lu\n", i, (unsigned long)w->results[i].err)) {
+            return "memory";
+        }
+    }
+
+    if (!reply_line(w, "ok %zu %zu\n", count - failed, failed)) {
+        return "memory";
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief
+ * Reads a request from a connection, carries it out and writes the reply.
+ */
+static void serve_connection(DaemonWorker *w, IpcConn *conn) {
+    size_t size, count;
+    const char *reason = read_request(w, conn, &size, &count);
+
+    // The client went away before finishing its request
+    if (reason && !*reason) {
+        return;
+    }
+
+    w->reply.used = 0;
+
+    if (!reason) {
+        reason = run_request(w, size, count);
+    }
+
+    if (reason) {
+        w->reply.used = 0;
+
+        if (!reply_line(w, "error %s\n", reason)) {
+            return;
+        }
+    }
+
+    ipc_write(conn, w->reply.data, w->reply.used);
+}
+
+static int worker_main(void *arg) {
+    DaemonWorker *w = arg;
+
+    for (;;) {
+        IpcConn *conn = ipc_accept(w->server);
+
+        // Running out of descriptors or memory passes once other requests
+        // are done, so wait a little instead of spinning
+        if (!conn) {
+            thrd_sleep(&(struct timespec) { .tv_nsec = 10000000 }, NULL);
+            continue;
+        }
+
+        serve_connection(w, conn);
+        ipc_close(conn);
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+// Path of the socket, which is removed when the server is ended by a signal
+static const char *socket_path;
+
+static void handle_exit_signal(int sig) {
+    unlink(socket_path);
+
+    // End the process the way the signal would have
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void install_signal_handlers(const char *path) {
+    struct sigaction sa;
+
+    socket_path = path;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_exit_signal;
+    sigemptyset(&sa.sa_mask);
+
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+
+    // Replies to clients that have gone away fail rather than end the server
+    signal(SIGPIPE, SIG_IGN);
+}
+#endif
+
+bool daemon_serve(const TCHAR *address, unsigned int threads) {
+    IpcServer *server = ipc_listen(address);
+
+    if (!server) {
+        return false;
+    }
+
+#ifndef _WIN32
+    install_signal_handlers(address);
+#endif
+
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    DaemonWorker *workers = calloc(threads, sizeof(DaemonWorker));
+
+    if (!workers) {
+        ipc_server_close(server);
+        set_last_error(FS_ERR_NO_MEMORY);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < threads; i++) {
+        workers[i].server = server;
+        // Only the thread's own requests use its executor and workspace, so
+        // they stay warm from one to the next
+        workers[i].executor = fs_batch_open(FS_BATCH_AUTO);
+        workers[i].workspace = touch_workspace_open();
+    }
+
+    // The calling thread serves as well, so one fewer thread is started. If
+    // some cannot be started, the rest serve without them
+    for (unsigned int i = 1; i < threads; i++) {
+        thrd_t thread;
+
+        if (thrd_create(&thread, worker_main, &workers[i]) == thrd_success) {
+            thrd_detach(thread);
+        }
+    }
+
+    worker_main(&workers[0]);
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Gets the working directory of the process.
+ *
+ * @return
+ * Pointer to the path, which must be freed, or NULL on failure.
+ */
+static TCHAR *get_cwd(void) {
+#ifdef _WIN32
+    DWORD len = GetCurrentDirectory(0, NULL);
+    TCHAR *cwd = len ? malloc(len * sizeof(TCHAR)) : NULL;
+
+    if (cwd && GetCurrentDirectory(len, cwd) == 0) {
+        free(cwd);
+        cwd = NULL;
+    }
+
+    return cwd;
+#else
+    size_t capacity = 256;
+
+    for (;;) {
+        char *cwd = malloc(capacity);
+
+        if (!cwd || getcwd(cwd, capacity)) {
+            return cwd;
+        }
+
+        free(cwd);
+
+        if (errno != ERANGE) {
+            return NULL;
+        }
+
+        capacity *= 2;
+    }
+#endif
+}
+
+/*!
+ * @brief
+ * Encodes a request.
+ *
+ * @return
+ * true if the request was encoded; false if memory could not be allocated
+ * or a path could not be converted to UTF-8.
+ */
+static bool encode_request(ByteBuffer *buf, const DaemonRequest *req) {
+    char flags[4];
+    size_t n = 0;
+
+    if (req->ft_flags & FT_CREATION) {
+        flags[n++] = 'C';
+    }
+
+    if (req->ft_flags & FT_ACCESS) {
+        flags[n++] = 'a';
+    }
+
+    if (req->ft_flags & FT_WRITE) {
+        flags[n++] = 'm';
+    }
+
+    flags[n] = '\0';
+
+    char count[24];
+    snprintf(count, sizeof(count), "count=%zu", req->count);
+
+    TCHAR *cwd = get_cwd();
+
+    bool ok = cwd &&
+        buffer_append(buf, REQUEST_MAGIC, sizeof(REQUEST_MAGIC)) &&
+        buffer_append(buf, count, strlen(count) + 1) &&
+        buffer_append(buf, "flags=", 6) && buffer_append(buf, flags, n + 1) &&
+        append_field(buf, "cwd=", cwd) &&
+        (!req->stamp || append_field(buf, "time=", req->stamp)) &&
+        (!req->ref_path || append_field(buf, "ref=", req->ref_path)) &&
+        (!req->offset || append_field(buf, "adjust=", req->offset)) &&
+        (!req->existing_only || buffer_append(buf, "create=0", 9)) &&
+        (req->follow_symlinks || buffer_append(buf, "follow=0", 9)) &&
+        buffer_append(buf, "", 1);
+
+    free(cwd);
+
+    for (size_t i = 0; ok && i < req->count; i++) {
+        ok = buffer_append_string(buf, req->paths[i]);
+    }
+
+    return ok && buffer_append(buf, "", 1);
+}
+
+/*!
+ * @brief
+ * Reads the reply to a request, reporting each file that failed.
+ */
+static DaemonStatus read_reply(
+    IpcConn *conn, ByteBuffer *buf, const DaemonRequest *req,
+    TreeReportFn report, void *ctx) {
+
+    buf->used = 0;
+
+    for (;;) {
+        size_t received;
+
+        if (!buffer_reserve(buf, READ_CHUNK + 1)) {
+            return DAEMON_NO_MEMORY;
+        }
+
+        if (!ipc_read(conn, &buf->data[buf->used], READ_CHUNK, &received)) {
+            return DAEMON_IO_ERROR;
+        }
+
+        if (received == 0) {
+            break;
+        }
+
+        buf->used += received;
+    }
+
+    buf->data[buf->used] = '\0';
+
+    size_t failed = 0;
+
+    for (char *line = buf->data; *line;) {
+        char *end = strchr(line, '\n');
+
+        if (!end) {
+            break;
+        }
+
+        *end = '\0';
+
+        unsigned long long index, code;
+        const char *rest;
+
+        if (strncmp(line, "fail ", 5) == 0) {
+            rest = parse_number(line + 5, &index);
+            rest = (rest && *rest == ' ') ? parse_number(rest + 1, &code) : NULL;
+
+            if (!rest || *rest || index >= req->count) {
+                break;
+            }
+
+            report(ctx, req->paths[index], (FsError)code);
+            failed++;
+        } else if (strncmp(line, "ok ", 3) == 0) {
+            unsigned long long touched, not_touched;
+
+            rest = parse_number(line + 3, &touched);
+            rest = (rest && *rest == ' ') ? parse_number(rest + 1, &not_touched) : NULL;
+
+            // Every file must be accounted for, or some were never touched
+            if (!rest || *rest || not_touched != failed ||
+                touched != req->count - failed) {
+                break;
+            }
+
+            return failed ? DAEMON_FAILED : DAEMON_OK;
+        } else if (strncmp(line, "error ", 6) == 0) {
+            return DAEMON_REJECTED;
+        } else {
+            break;
+        }
+
+        line = end + 1;
+    }
+
+    set_last_error(ERR_PROTOCOL);
+
+    return DAEMON_IO_ERROR;
+}
+
+DaemonStatus daemon_forward(
+    const TCHAR *address, const DaemonRequest *req,
+    TreeReportFn report, void *ctx) {
+
+    ByteBuffer buf = { 0 };
+
+    if (!encode_request(&buf, req)) {
+        free(buf.data);
+        return DAEMON_NO_MEMORY;
+    }
+
+    IpcConn *conn = ipc_connect(address);
+
+    if (!conn) {
+        free(buf.data);
+        return DAEMON_UNREACHABLE;
+    }
+
+    DaemonStatus status = ipc_write(conn, buf.data, buf.used) ?
+        read_reply(conn, &buf, req, report, ctx) :
+        DAEMON_IO_ERROR;
+
+    FsError err = fs_last_error();
+
+    ipc_close(conn);
+    free(buf.data);
+
+    set_last_error(err);
+
+    return status;
+}
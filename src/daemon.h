@@ -0,0 +1,132 @@
+/* daemon.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "platform.h"
+#include "touchop.h"
+#include "treewalk.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A server that touches files on behalf of other processes, which saves them
+// the cost of starting a touch process of their own. It is reached over a
+// local connection (see ipc.h), which carries one request and its reply.
+//
+// A request is a series of UTF-8 strings, each ended by a null character:
+//
+//   "touch 1"          The protocol version
+//   KEY=VALUE...       Fields describing the operation, in any order
+//   ""                 End of the fields
+//   PATH...            Files to touch, as many as the count field gives. A
+//                      path may be empty, and fails as it would on the
+//                      command line
+//   ""                 End of the request
+//
+// The count field is required, and a request whose paths do not match it is
+// rejected. The other fields stand in for the options of the same effect, and
+// are optional:
+//
+//   count=N            Number of paths
+//   flags=LETTERS      Any of C, a and m, as -C, -a and -m
+//   time=STAMP         As -t
+//   ref=PATH           As -r
+//   adjust=OFFSET      As -A
+//   create=0           As -c
+//   follow=0           As -d
+//   cwd=DIR            Directory that relative paths, including that of ref,
+//                      are relative to. Without it, they are relative to the
+//                      working directory of the server
+//
+// The reply is a series of lines, one for each file that failed, followed by
+// one that ends the reply:
+//
+//   "fail INDEX CODE"  The file at zero-based INDEX failed with the backend
+//                      error code CODE
+//   "ok TOUCHED FAILED" The request was carried out, with the number of files
+//                      that were and were not touched, which add up to the
+//                      count of the request
+//   "error REASON"     The request was rejected, with a single word saying
+//                      why, such as "time" for an invalid timestamp
+
+/*!
+ * @brief
+ * The operation and files a client asks a server to touch.
+ */
+typedef struct daemon_request {
+    const TCHAR *const *paths;
+    size_t count;
+    FileTimeFlags ft_flags;
+    // Arguments of the -t, -r and -A options, or NULL
+    const TCHAR *stamp;
+    const TCHAR *ref_path;
+    const TCHAR *offset;
+    bool existing_only;
+    bool follow_symlinks;
+} DaemonRequest;
+
+typedef enum daemon_status {
+    // Every file was touched
+    DAEMON_OK,
+    // Some files could not be touched, and were reported
+    DAEMON_FAILED,
+    // No server accepts connections at the address
+    DAEMON_UNREACHABLE,
+    // The connection broke, or the reply could not be understood
+    DAEMON_IO_ERROR,
+    // The server rejected the request
+    DAEMON_REJECTED,
+    DAEMON_NO_MEMORY
+} DaemonStatus;
+
+/*!
+ * @brief
+ * Serves requests at an address until the process is ended. Each thread
+ * keeps its batch executor and buffers from one request to the next. A
+ * client that stops sending its request or reading the reply for longer than
+ * IPC_SERVER_TIMEOUT_MS is dropped, so that it does not hold its thread.
+ *
+ * @param address
+ * The address to accept connections at.
+ *
+ * @param threads
+ * Number of requests to serve at once.
+ *
+ * @return
+ * false if the address could not be listened on, in which case fs_last_error()
+ * describes the failure. Does not return otherwise.
+ */
+bool daemon_serve(const TCHAR *address, unsigned int threads);
+
+/*!
+ * @brief
+ * Sends a request to a server and waits for its reply.
+ *
+ * @param address
+ * The address of the server.
+ *
+ * @param req
+ * Pointer to the request.
+ *
+ * @param report
+ * Called with each file the server could not touch, in the order they were
+ * given.
+ *
+ * @param ctx
+ * Context pointer passed to \p report.
+ *
+ * @return
+ * A DaemonStatus describing the result. If DAEMON_UNREACHABLE or
+ * DAEMON_IO_ERROR is returned, fs_last_error() describes the failure.
+ */
+DaemonStatus daemon_forward(
+    const TCHAR *address, const DaemonRequest *req,
+    TreeReportFn report, void *ctx);
+
+#endif // DAEMON_H
@@ -0,0 +1,197 @@
+/* errlog.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "errlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Maximum size of a path in bytes, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Maximum size of a path in UTF-8. A UTF-16 code unit takes at most three bytes
+#define PATH_BYTES_CAPACITY (PATH_CAPACITY * 3)
+
+// Size of the write buffer of the list file
+#define LIST_BUFFER_SIZE (1 << 16)
+
+struct error_log {
+    ErrorGroup *groups;
+    size_t group_count;
+    size_t group_capacity;
+    // Group of the last failure. Failures tend to come in runs of one code,
+    // such as every file below a directory that cannot be written to
+    size_t last;
+    size_t max_samples;
+    FILE *list;
+    char delimiter;
+    // Whether every path so far made it into the list
+    bool list_ok;
+#ifdef UNICODE
+    char *utf8;
+#endif
+};
+
+ErrorLog *error_log_open(size_t max_samples, const TCHAR *list_path, bool nul_delimited) {
+    ErrorLog *log = calloc(1, sizeof(ErrorLog));
+
+    if (!log) {
+        return NULL;
+    }
+
+    log->max_samples = max_samples;
+    log->delimiter = nul_delimited ? '\0' : '\n';
+    log->list_ok = true;
+
+    bool ok = true;
+
+#ifdef UNICODE
+    if (list_path) {
+        log->utf8 = malloc(PATH_BYTES_CAPACITY);
+        ok = log->utf8 != NULL;
+    }
+#endif
+
+    if (ok && list_path) {
+        log->list = _tfopen(list_path, _T("wb"));
+        ok = log->list != NULL;
+
+        if (ok) {
+            setvbuf(log->list, NULL, _IOFBF, LIST_BUFFER_SIZE);
+        }
+    }
+
+    if (!ok) {
+        error_log_close(log);
+        return NULL;
+    }
+
+    return log;
+}
+
+/*!
+ * @brief
+ * Finds the group of an error code, adding one if the code is new.
+ *
+ * @return
+ * Pointer to the group, or NULL if memory could not be allocated.
+ */
+static ErrorGroup *find_group(ErrorLog *log, FsError err) {
+    if (log->group_count > 0 && log->groups[log->last].err == err) {
+        return &log->groups[log->last];
+    }
+
+    for (size_t i = 0; i < log->group_count; i++) {
+        if (log->groups[i].err == err) {
+            log->last = i;
+            return &log->groups[i];
+        }
+    }
+
+    if (log->group_count == log->group_capacity) {
+        size_t capacity = log->group_capacity ? log->group_capacity * 2 : 4;
+        ErrorGroup *groups = realloc(log->groups, capacity * sizeof(ErrorGroup));
+
+        if (!groups) {
+            return NULL;
+        }
+
+        log->groups = groups;
+        log->group_capacity = capacity;
+    }
+
+    ErrorGroup *group = &log->groups[log->group_count];
+    *group = (ErrorGroup) { .err = err };
+
+    if (log->max_samples > 0) {
+        // Without room for samples, the group still keeps its count
+        group->samples = malloc(log->max_samples * sizeof(TCHAR *));
+    }
+
+    log->last = log->group_count++;
+    return group;
+}
+
+/*!
+ * @brief
+ * Appends a path to the list file, followed by the delimiter.
+ */
+static void write_list(ErrorLog *log, const TCHAR *path) {
+#ifdef UNICODE
+    int len = WideCharToMultiByte(CP_UTF8, 0, path, -1, log->utf8, PATH_BYTES_CAPACITY, NULL, NULL);
+
+    if (len <= 0) {
+        log->list_ok = false;
+        return;
+    }
+
+    // The length includes the terminating null character
+    size_t size = (size_t)len - 1;
+    const char *utf8 = log->utf8;
+#else
+    size_t size = strlen(path);
+    const char *utf8 = path;
+#endif
+
+    if (fwrite(utf8, 1, size, log->list) != size || putc(log->delimiter, log->list) == EOF) {
+        log->list_ok = false;
+    }
+}
+
+void error_log_add(ErrorLog *log, const TCHAR *path, FsError err) {
+    ErrorGroup *group = find_group(log, err);
+
+    if (group) {
+        group->count++;
+
+        if (group->samples && group->sample_count < log->max_samples) {
+            TCHAR *sample = _tcsdup(path);
+
+            if (sample) {
+                group->samples[group->sample_count++] = sample;
+            }
+        }
+    }
+
+    if (log->list) {
+        write_list(log, path);
+    }
+}
+
+const ErrorGroup *error_log_groups(const ErrorLog *log, size_t *count) {
+    *count = log->group_count;
+    return log->groups;
+}
+
+bool error_log_close(ErrorLog *log) {
+    if (!log) {
+        return true;
+    }
+
+    bool ok = log->list_ok;
+
+    if (log->list && fclose(log->list) != 0) {
+        ok = false;
+    }
+
+    for (size_t i = 0; i < log->group_count; i++) {
+        for (size_t j = 0; j < log->groups[i].sample_count; j++) {
+            free(log->groups[i].samples[j]);
+        }
+
+        free(log->groups[i].samples);
+    }
+
+#ifdef UNICODE
+    free(log->utf8);
+#endif
+    free(log->groups);
+    free(log);
+
+    return ok;
+}
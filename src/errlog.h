@@ -0,0 +1,103 @@
+/* errlog.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef ERRLOG_H
+#define ERRLOG_H
+
+#include "platform.h"
+#include "fsbackend.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*!
+ * @brief
+ * The failures that share an error code.
+ */
+typedef struct error_group {
+    FsError err;
+    unsigned long long count;
+    // The first paths that failed with the error, at most as many as the
+    // log keeps per code
+    TCHAR **samples;
+    size_t sample_count;
+} ErrorGroup;
+
+/*!
+ * @brief
+ * Failures collected to be summarized once the work is done, rather than
+ * reported one line at a time.
+ */
+typedef struct error_log ErrorLog;
+
+/*!
+ * @brief
+ * Creates an error log.
+ *
+ * @param max_samples
+ * Number of paths to keep for each error code.
+ *
+ * @param list_path
+ * Path to a file that receives every failed path as UTF-8, in a form that -i
+ * reads back, or NULL to keep none but the samples.
+ *
+ * @param nul_delimited
+ * Specifies whether paths in the list are separated by null characters
+ * instead of newlines.
+ *
+ * @return
+ * Pointer to a new ErrorLog, or NULL if the list could not be created or
+ * memory could not be allocated.
+ */
+ErrorLog *error_log_open(size_t max_samples, const TCHAR *list_path, bool nul_delimited);
+
+/*!
+ * @brief
+ * Records a failure. This costs a lookup of its code, and a copy of the path
+ * for the first few failures of each code only. Calls must not overlap, which
+ * the reporters of the walkers already ensure.
+ *
+ * @param log
+ * Pointer to the error log.
+ *
+ * @param path
+ * Path that failed.
+ *
+ * @param err
+ * The backend error code of the failure.
+ */
+void error_log_add(ErrorLog *log, const TCHAR *path, FsError err);
+
+/*!
+ * @brief
+ * Gets the failures recorded so far, grouped by error code in the order the
+ * codes were first seen.
+ *
+ * @param log
+ * Pointer to the error log.
+ *
+ * @param count
+ * Pointer to a size_t that receives the number of groups.
+ *
+ * @return
+ * Pointer to the groups, valid until the next call on the log.
+ */
+const ErrorGroup *error_log_groups(const ErrorLog *log, size_t *count);
+
+/*!
+ * @brief
+ * Finishes the list file, if any, and frees the error log.
+ *
+ * @param log
+ * Pointer to the error log. If NULL, no action is taken.
+ *
+ * @return
+ * true if every failed path was written to the list; false otherwise.
+ */
+bool error_log_close(ErrorLog *log);
+
+#endif // ERRLOG_H
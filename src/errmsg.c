@@ -7,7 +7,11 @@
 
 #include "errmsg.h"
 
-TCHAR *get_win32_error_msg(DWORD code) {
+#include <errno.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+TCHAR *get_error_msg(unsigned long code) {
     TCHAR *msg = NULL;
     FormatMessage(
         FORMAT_MESSAGE_ALLOCATE_BUFFER |FORMAT_MESSAGE_FROM_SYSTEM,
@@ -22,7 +26,43 @@ TCHAR *get_win32_error_msg(DWORD code) {
     return msg;
 }
 
-TCHAR *get_win32_last_error_msg(void) {
+TCHAR *get_last_error_msg(void) {
     DWORD code = GetLastError();
-    return get_win32_error_msg(code);
-}
\ No newline at end of file
+    return get_error_msg(code);
+}
+
+void free_error_msg(TCHAR *msg) {
+    LocalFree(msg);
+}
+#else
+TCHAR *get_error_msg(unsigned long code) {
+    char desc[256];
+
+    // The XSI variant is used; unlike strerror(), it's safe to call from the
+    // worker threads
+    if (strerror_r((int)code, desc, sizeof(desc)) != 0) {
+        snprintf(desc, sizeof(desc), "Unknown error %lu", code);
+    }
+
+    // Match FormatMessage(), whose messages end with a line break
+    size_t len = strlen(desc);
+    char *msg = malloc(len + 2);
+
+    if (msg) {
+        memcpy(msg, desc, len);
+        msg[len] = '\n';
+        msg[len + 1] = '\0';
+    }
+
+    return msg;
+}
+
+TCHAR *get_last_error_msg(void) {
+    int code = errno;
+    return get_error_msg((unsigned long)code);
+}
+
+void free_error_msg(TCHAR *msg) {
+    free(msg);
+}
+#endif
\ No newline at end of file
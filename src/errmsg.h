@@ -8,29 +8,40 @@
 #ifndef ERRMSG_H
 #define ERRMSG_H
 
-#define WIN32_LEAN_AND_MEAN
-
-#include <windows.h>
+#include "platform.h"
 
 /*!
  * @brief
  * Gets an error message based on the specified code.
  * 
  * @param code
- * The error code to retrieve its relevant error message.
+ * The error code to retrieve its relevant error message. This is a Win32 error
+ * code on Windows and an errno value elsewhere.
  * 
  * @return
- * System-formatted string containing an error message.
+ * Newline-terminated string containing an error message, or NULL on failure.
+ * The string must be released with free_error_msg().
  */
-TCHAR *get_win32_error_msg(unsigned long code);
+TCHAR *get_error_msg(unsigned long code);
 
 /*!
  * @brief
- * Gets an error message based on value of GetLastError().
+ * Gets an error message based on value of GetLastError(), or errno on
+ * platforms other than Windows.
  * 
  * @return
- * System-formatted string containing an error message.
+ * Newline-terminated string containing an error message, or NULL on failure.
+ * The string must be released with free_error_msg().
+ */
+TCHAR *get_last_error_msg(void);
+
+/*!
+ * @brief
+ * Frees a string returned by get_error_msg() or get_last_error_msg().
+ *
+ * @param msg
+ * The string to free. If NULL, no action is taken.
  */
-TCHAR *get_win32_last_error_msg(void);
+void free_error_msg(TCHAR *msg);
 
 #endif // ERRMSG_H
\ No newline at end of file
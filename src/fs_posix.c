@@ -0,0 +1,1027 @@
+/* fs_posix.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef _WIN32
+
+// Required for O_PATH and statx()
+#define _GNU_SOURCE
+
+#include "fsbackend.h"
+#include "caltime.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/vfs.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef FS_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+// Seconds between the FsTime epoch (1601-01-01) and the Unix epoch (1970-01-01)
+#define UNIX_EPOCH_OFFSET 11644473600LL
+
+#ifdef FS_COUNT_SYSCALLS
+thread_local unsigned long long fs_syscalls;
+#endif
+
+// Number of file systems whose timestamp granularity is remembered
+#define GRANULARITY_CACHE_SIZE 16
+
+// Magic numbers reported by statfs() for the file systems that store
+// timestamps more coarsely than FsTime
+#define MSDOS_SUPER_MAGIC 0x4d44
+#define EXFAT_SUPER_MAGIC 0x2011BAB0
+#define HFS_SUPER_MAGIC 0x4244
+#define HFSPLUS_SUPER_MAGIC 0x482b
+
+// Number of steps a batch submits to io_uring at a time
+#define BATCH_RING_ENTRIES 256
+
+struct fs_dir {
+    DIR *dir;
+};
+
+struct fs_batch {
+#ifdef FS_HAVE_IO_URING
+    // Ring descriptor, or -1 if steps are run one at a time
+    int ring_fd;
+
+    // Shared rings, as mapped from the kernel
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned int entries;
+#else
+    int ring_fd;
+#endif
+};
+
+/*!
+ * @brief
+ * What stat_times_at() reports about the file itself, besides its times.
+ */
+typedef struct stat_info {
+    dev_t dev;
+    ino_t ino;
+    bool is_link;
+} StatInfo;
+
+/*!
+ * @brief
+ * Timestamp granularity of the file systems seen so far, keyed by device.
+ */
+static struct granularity_cache {
+    mtx_t lock;
+    dev_t devs[GRANULARITY_CACHE_SIZE];
+    FsTimes granularity[GRANULARITY_CACHE_SIZE];
+    size_t count;
+} granularity_cache;
+
+static once_flag granularity_once = ONCE_FLAG_INIT;
+
+static FsTime from_timespec(int64_t sec, long nsec) {
+    int64_t ticks =
+        (sec + UNIX_EPOCH_OFFSET) * FS_TICKS_PER_SECOND +
+        (nsec / 100);
+
+    // Times before 1601 cannot be represented
+    return (ticks < 0) ? 0 : (FsTime)ticks;
+}
+
+static struct timespec to_timespec(FsTime time) {
+    struct timespec ts;
+
+    if (time == FS_TIME_OMIT || time == FS_TIME_NOW) {
+        ts.tv_sec = 0;
+        ts.tv_nsec = (time == FS_TIME_OMIT) ? UTIME_OMIT : UTIME_NOW;
+        return ts;
+    }
+
+    ts.tv_sec = (time_t)((int64_t)(time / FS_TICKS_PER_SECOND) - UNIX_EPOCH_OFFSET);
+    ts.tv_nsec = (long)(time % FS_TICKS_PER_SECOND) * 100;
+
+    return ts;
+}
+
+/*!
+ * @brief
+ * Builds the access/modification pair expected by futimens() and utimensat().
+ *
+ * @return
+ * false if there is nothing to set.
+ */
+static bool to_utimens(const FsTimes *times, struct timespec ts[2]) {
+    ts[0] = to_timespec(times->access);
+    ts[1] = to_timespec(times->write);
+
+    return times->access != FS_TIME_OMIT ||
+           times->write != FS_TIME_OMIT;
+}
+
+/*!
+ * @brief
+ * Fails with ENOTSUP if a creation time was requested, since POSIX offers no
+ * way to set it.
+ */
+static bool check_creation_unset(const FsTimes *times) {
+    if (times->creation != FS_TIME_OMIT) {
+        errno = ENOTSUP;
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef STATX_BTIME
+static void from_statx(const struct statx *stx, FsTimes *out) {
+    out->access = from_timespec(stx->stx_atime.tv_sec, stx->stx_atime.tv_nsec);
+    out->write = from_timespec(stx->stx_mtime.tv_sec, stx->stx_mtime.tv_nsec);
+    out->creation = (stx->stx_mask & STATX_BTIME) ?
+        from_timespec(stx->stx_btime.tv_sec, stx->stx_btime.tv_nsec) :
+        FS_TIME_OMIT;
+}
+
+static bool stat_times_at(int dirfd, const char *path, int flags, FsTimes *out, StatInfo *info) {
+    struct statx stx;
+    unsigned int mask = STATX_ATIME | STATX_MTIME | STATX_BTIME | (info ? STATX_TYPE | STATX_INO : 0);
+
+    if (FS_SYSCALL(statx(dirfd, path, flags, mask, &stx)) != 0) {
+        return false;
+    }
+
+    from_statx(&stx, out);
+
+    if (info) {
+        info->dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+        info->ino = (ino_t)stx.stx_ino;
+        info->is_link = S_ISLNK(stx.stx_mode);
+    }
+
+    return true;
+}
+#else
+static bool stat_times_at(int dirfd, const char *path, int flags, FsTimes *out, StatInfo *info) {
+    struct stat st;
+
+    if (flags & AT_EMPTY_PATH) {
+        if (FS_SYSCALL(fstat(dirfd, &st)) != 0) {
+            return false;
+        }
+    } else if (FS_SYSCALL(fstatat(dirfd, path, &st, flags)) != 0) {
+        return false;
+    }
+
+    out->access = from_timespec(st.st_atim.tv_sec, st.st_atim.tv_nsec);
+    out->write = from_timespec(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+    out->creation = FS_TIME_OMIT;
+
+    if (info) {
+        info->dev = st.st_dev;
+        info->ino = st.st_ino;
+        info->is_link = S_ISLNK(st.st_mode);
+    }
+
+    return true;
+}
+#endif
+
+static void init_granularity_cache(void) {
+    mtx_init(&granularity_cache.lock, mtx_plain);
+}
+
+/*!
+ * @brief
+ * Works out the timestamp granularity of the file system holding \p path from
+ * its type. Types that aren't known to be coarser than FsTime report 1 tick,
+ * which never makes two different times compare equal.
+ */
+static FsTimes query_granularity(const char *path) {
+    FsTimes granularity = { 1, 1, 1 };
+    struct statfs sfs;
+
+    if (FS_SYSCALL(statfs(path, &sfs)) != 0) {
+        return granularity;
+    }
+
+    switch ((unsigned long)sfs.f_type) {
+        case MSDOS_SUPER_MAGIC:
+            // Creation times in 10 ms, write times in 2 s, and access dates only
+            granularity.creation = FS_TICKS_PER_SECOND / 100;
+            granularity.access = FS_TICKS_PER_SECOND * 86400;
+            granularity.write = FS_TICKS_PER_SECOND * 2;
+            break;
+        case EXFAT_SUPER_MAGIC:
+            granularity.creation = FS_TICKS_PER_SECOND / 100;
+            granularity.access = FS_TICKS_PER_SECOND * 2;
+            granularity.write = FS_TICKS_PER_SECOND / 100;
+            break;
+        case HFS_SUPER_MAGIC:
+        case HFSPLUS_SUPER_MAGIC:
+            granularity.creation = FS_TICKS_PER_SECOND;
+            granularity.access = FS_TICKS_PER_SECOND;
+            granularity.write = FS_TICKS_PER_SECOND;
+            break;
+        default:
+            break;
+    }
+
+    return granularity;
+}
+
+/*!
+ * @brief
+ * Looks up the timestamp granularity of a device, querying and remembering it
+ * on first use. \p path must be a file on that device that statfs() can reach.
+ */
+static FsTimes device_granularity(dev_t dev, const char *path) {
+    call_once(&granularity_once, init_granularity_cache);
+
+    struct granularity_cache *cache = &granularity_cache;
+    FsTimes granularity;
+    bool found = false;
+
+    mtx_lock(&cache->lock);
+
+    for (size_t i = 0; i < cache->count; i++) {
+        if (cache->devs[i] == dev) {
+            granularity = cache->granularity[i];
+            found = true;
+            break;
+        }
+    }
+
+    mtx_unlock(&cache->lock);
+
+    if (found) {
+        return granularity;
+    }
+
+    // Errors only cost precision, so they must not leak into the caller's
+    // error state
+    int err = errno;
+    granularity = query_granularity(path);
+    errno = err;
+
+    mtx_lock(&cache->lock);
+
+    if (cache->count < GRANULARITY_CACHE_SIZE) {
+        cache->devs[cache->count] = dev;
+        cache->granularity[cache->count] = granularity;
+        cache->count++;
+    }
+
+    mtx_unlock(&cache->lock);
+
+    return granularity;
+}
+
+FsError fs_last_error(void) {
+    return (FsError)errno;
+}
+
+bool fs_error_is_missing(FsError err) {
+    return err == ENOENT || err == ENOTDIR;
+}
+
+/*!
+ * @brief
+ * Gets the flags fs_open() passes to open() for the given FsOpenFlags.
+ */
+static int open_flags(unsigned int flags) {
+    int oflags = O_WRONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK;
+
+    if (flags & FS_OPEN_CREATE) {
+        oflags |= O_CREAT;
+    }
+
+    if (flags & FS_OPEN_NOFOLLOW) {
+        oflags |= O_NOFOLLOW;
+    }
+
+    return oflags;
+}
+
+/*!
+ * @brief
+ * Directories, links opened without following them, read-only files and
+ * special files cannot be opened for writing, yet their timestamps can still
+ * be changed by the owner. Checks whether an open failed for such a reason.
+ */
+static bool needs_path_only(int err) {
+    return err == EISDIR || err == ELOOP || err == EACCES ||
+           err == EPERM || err == ETXTBSY || err == ENXIO || err == EROFS;
+}
+
+/*!
+ * @brief
+ * Gets the descriptor the *_at() system calls take for a parent.
+ */
+static int parent_fd(const FsParent *parent) {
+    return parent ? parent->fd : AT_FDCWD;
+}
+
+bool fs_open(FsFile *file, const TCHAR *path, unsigned int flags) {
+    return fs_open_at(NULL, file, path, flags);
+}
+
+bool fs_open_at(const FsParent *parent, FsFile *file, const TCHAR *name, unsigned int flags) {
+    bool follow = !(flags & FS_OPEN_NOFOLLOW);
+    int oflags = open_flags(flags);
+    int dirfd = parent_fd(parent);
+
+    file->path = name;
+    file->dirfd = dirfd;
+    file->path_only = false;
+    file->follow_symlinks = follow;
+    file->fd = FS_SYSCALL(openat(dirfd, name, oflags, 0666));
+
+    if (file->fd >= 0) {
+        return true;
+    }
+
+    int err = errno;
+
+    if (!needs_path_only(err)) {
+        return false;
+    }
+
+    file->fd = FS_SYSCALL(openat(dirfd, name, O_PATH | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW)));
+
+    if (file->fd < 0) {
+        // Report why the regular open failed, unless the file simply vanished.
+        // An open that was to create the file found it missing too, and then
+        // failed for want of a way to create it, which is what to report
+        if ((oflags & O_CREAT) || !fs_error_is_missing(errno)) {
+            errno = err;
+        }
+
+        return false;
+    }
+
+    file->path_only = true;
+    return true;
+}
+
+void fs_close(FsFile *file) {
+    FS_SYSCALL(close(file->fd));
+    file->fd = -1;
+}
+
+bool fs_get_times(FsFile *file, FsTimes *out) {
+    return stat_times_at(file->fd, "", AT_EMPTY_PATH, out, NULL);
+}
+
+bool fs_set_times(FsFile *file, const FsTimes *times) {
+    struct timespec ts[2];
+
+    if (to_utimens(times, ts)) {
+        int rc = file->path_only ?
+            FS_SYSCALL(utimensat(file->dirfd, file->path, ts, file->follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW)) :
+            FS_SYSCALL(futimens(file->fd, ts));
+
+        if (rc != 0) {
+            return false;
+        }
+    }
+
+    return check_creation_unset(times);
+}
+
+bool fs_set_times_by_path(
+    const TCHAR *path, bool follow_symlinks,
+    const FsTimes *times) {
+
+    return fs_set_times_at(NULL, path, follow_symlinks, times);
+}
+
+bool fs_set_times_at(
+    const FsParent *parent, const TCHAR *name,
+    bool follow_symlinks, const FsTimes *times) {
+
+    struct timespec ts[2];
+
+    if (!to_utimens(times, ts)) {
+        return check_creation_unset(times);
+    }
+
+    if (FS_SYSCALL(utimensat(parent_fd(parent), name, ts, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW)) != 0) {
+        return false;
+    }
+
+    return check_creation_unset(times);
+}
+
+bool fs_stat_times(const TCHAR *path, bool follow_symlinks, FsTimes *out) {
+    return stat_times_at(AT_FDCWD, path, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW, out, NULL);
+}
+
+bool fs_stat_times_granular(
+    const TCHAR *path, bool follow_symlinks,
+    FsTimes *out, FsTimes *granularity) {
+
+    StatInfo info;
+
+    if (!stat_times_at(AT_FDCWD, path, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW, out, &info)) {
+        return false;
+    }
+
+    // statfs() follows links, so it would describe the wrong file system for
+    // a link that isn't followed
+    if (info.is_link) {
+        *granularity = (FsTimes) { 1, 1, 1 };
+    } else {
+        *granularity = device_granularity(info.dev, path);
+    }
+
+    return true;
+}
+
+bool fs_is_directory(const TCHAR *path, bool follow_symlinks) {
+    struct stat st;
+
+    if (FS_SYSCALL(fstatat(AT_FDCWD, path, &st, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW)) != 0) {
+        return false;
+    }
+
+    return S_ISDIR(st.st_mode);
+}
+
+FsDir *fs_dir_open(const TCHAR *path) {
+    FsDir *dir = malloc(sizeof(FsDir));
+
+    if (!dir) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    dir->dir = FS_SYSCALL(opendir(path));
+
+    if (!dir->dir) {
+        int err = errno;
+        free(dir);
+        errno = err;
+        return NULL;
+    }
+
+    return dir;
+}
+
+bool fs_dir_next(FsDir *dir, FsDirEntry *out, FsError *err) {
+    *err = FS_OK;
+
+    while (true) {
+        errno = 0;
+
+        struct dirent *entry = readdir(dir->dir);
+
+        if (!entry) {
+            *err = (FsError)errno;
+            return false;
+        }
+
+        const char *name = entry->d_name;
+
+        if (name[0] == '.' &&
+           (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        unsigned char type = entry->d_type;
+
+        // Not every file system fills in the entry type
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+
+            if (FS_SYSCALL(fstatat(dirfd(dir->dir), name, &st, AT_SYMLINK_NOFOLLOW)) == 0) {
+                type = S_ISDIR(st.st_mode) ? DT_DIR :
+                       S_ISLNK(st.st_mode) ? DT_LNK : DT_REG;
+            }
+        }
+
+        out->name = name;
+        out->is_dir = (type == DT_DIR);
+        out->is_link = (type == DT_LNK);
+
+        return true;
+    }
+}
+
+void fs_dir_close(FsDir *dir) {
+    if (!dir) {
+        return;
+    }
+
+    FS_SYSCALL(closedir(dir->dir));
+    free(dir);
+}
+
+size_t fs_parent_length(const TCHAR *path) {
+    const char *sep = strrchr(path, '/');
+
+    // A trailing separator makes the lookup fail unless the file is a
+    // directory, which the name on its own wouldn't
+    if (!sep || sep[1] == '\0') {
+        return 0;
+    }
+
+    return (size_t)(sep - path) + 1;
+}
+
+bool fs_parent_open(FsParent *parent, const TCHAR *path) {
+    parent->fd = FS_SYSCALL(open(path, O_PATH | O_DIRECTORY | O_CLOEXEC));
+    return parent->fd >= 0;
+}
+
+void fs_parent_close(FsParent *parent) {
+    FS_SYSCALL(close(parent->fd));
+    parent->fd = -1;
+}
+
+/*!
+ * @brief
+ * Runs an FS_BATCH_STAT step by path, retrieving the identity of the file
+ * along with its times if the step asks for it.
+ */
+static bool stat_path_step(FsBatchStep *step) {
+    StatInfo info;
+    int flags = (step->flags & FS_OPEN_NOFOLLOW) ? AT_SYMLINK_NOFOLLOW : 0;
+
+    if (!stat_times_at(parent_fd(step->parent), step->path, flags, step->times,
+            step->id ? &info : NULL)) {
+        return false;
+    }
+
+    if (step->id) {
+        step->id->volume = (unsigned long long)info.dev;
+        step->id->index = (unsigned long long)info.ino;
+    }
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Runs a single batch step with the regular blocking calls.
+ */
+static void run_step(FsBatchStep *step) {
+    bool ok = true;
+
+    switch (step->op) {
+        case FS_BATCH_OPEN:
+            ok = fs_open_at(step->parent, step->file, step->path, step->flags);
+            break;
+        case FS_BATCH_STAT:
+            ok = step->file ?
+                fs_get_times(step->file, step->times) :
+                stat_path_step(step);
+            break;
+        case FS_BATCH_CLOSE:
+            fs_close(step->file);
+            break;
+    }
+
+    step->err = ok ? FS_OK : fs_last_error();
+}
+
+#ifdef FS_HAVE_IO_URING
+static void ring_teardown(FsBatch *batch) {
+    if (batch->sqes && batch->sqes != MAP_FAILED) {
+        FS_SYSCALL(munmap(batch->sqes, batch->sqes_size));
+    }
+
+    if (batch->cq_map && batch->cq_map != MAP_FAILED && batch->cq_map != batch->sq_map) {
+        FS_SYSCALL(munmap(batch->cq_map, batch->cq_map_size));
+    }
+
+    if (batch->sq_map && batch->sq_map != MAP_FAILED) {
+        FS_SYSCALL(munmap(batch->sq_map, batch->sq_map_size));
+    }
+
+    if (batch->ring_fd >= 0) {
+        FS_SYSCALL(close(batch->ring_fd));
+    }
+
+    batch->sq_map = batch->cq_map = NULL;
+    batch->sqes = NULL;
+    batch->ring_fd = -1;
+}
+
+/*!
+ * @brief
+ * Checks whether the kernel supports every operation a batch submits. Both
+ * arrived in Linux 5.6, a while after io_uring itself.
+ */
+static bool ring_supports_steps(int ring_fd) {
+    static const unsigned char ops[] = { IORING_OP_OPENAT, IORING_OP_CLOSE };
+
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+
+    if (!probe) {
+        return false;
+    }
+
+    bool ok = FS_SYSCALL(syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, 256)) == 0;
+
+    for (size_t i = 0; ok && i < sizeof(ops); i++) {
+        ok = ops[i] <= probe->last_op &&
+            (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+    return ok;
+}
+
+/*!
+ * @brief
+ * Sets up the rings of a batch.
+ *
+ * @return
+ * false if io_uring is not available, e.g. because the kernel is too old or a
+ * seccomp filter blocks it, in which case steps are run one at a time.
+ */
+static bool ring_setup(FsBatch *batch) {
+    struct io_uring_params params = { 0 };
+
+    // Only the thread that owns a batch ever submits to it, and it always
+    // waits for completions, so the kernel can defer completion work until
+    // then instead of interrupting the thread for every step
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    batch->ring_fd = (int)FS_SYSCALL(syscall(__NR_io_uring_setup, BATCH_RING_ENTRIES, &params));
+
+    // Kernels before 6.1 reject those flags
+    if (batch->ring_fd < 0 && errno == EINVAL) {
+        memset(&params, 0, sizeof(params));
+        batch->ring_fd = (int)FS_SYSCALL(syscall(__NR_io_uring_setup, BATCH_RING_ENTRIES, &params));
+    }
+
+    if (batch->ring_fd < 0) {
+        return false;
+    }
+
+    batch->entries = params.sq_entries;
+    batch->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    batch->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    batch->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    // Recent kernels share one mapping between both rings
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+    if (single_map && batch->cq_map_size > batch->sq_map_size) {
+        batch->sq_map_size = batch->cq_map_size;
+    }
+
+    batch->sq_map = FS_SYSCALL(mmap(
+        NULL, batch->sq_map_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, batch->ring_fd, IORING_OFF_SQ_RING));
+
+    batch->cq_map = single_map ? batch->sq_map : FS_SYSCALL(mmap(
+        NULL, batch->cq_map_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, batch->ring_fd, IORING_OFF_CQ_RING));
+
+    batch->sqes = FS_SYSCALL(mmap(
+        NULL, batch->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, batch->ring_fd, IORING_OFF_SQES));
+
+    if (batch->sq_map == MAP_FAILED || batch->cq_map == MAP_FAILED ||
+        batch->sqes == MAP_FAILED || !ring_supports_steps(batch->ring_fd)) {
+        ring_teardown(batch);
+        return false;
+    }
+
+    char *sq = batch->sq_map;
+    char *cq = batch->cq_map;
+
+    batch->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+    batch->sq_mask = (unsigned int *)(sq + params.sq_off.ring_mask);
+    batch->sq_array = (unsigned int *)(sq + params.sq_off.array);
+    batch->cq_head = (unsigned int *)(cq + params.cq_off.head);
+    batch->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+    batch->cq_mask = (unsigned int *)(cq + params.cq_off.ring_mask);
+    batch->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Fills in the submission queue entry of an open or close step.
+ */
+static void ring_prepare(struct io_uring_sqe *sqe, const FsBatchStep *step, size_t index) {
+    memset(sqe, 0, sizeof(*sqe));
+
+    sqe->user_data = index;
+
+    if (step->op == FS_BATCH_OPEN) {
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = parent_fd(step->parent);
+        sqe->addr = (uintptr_t)step->path;
+        sqe->len = 0666;
+        sqe->open_flags = (unsigned int)open_flags(step->flags);
+    } else {
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = step->file->fd;
+    }
+}
+
+/*!
+ * @brief
+ * Records the result of a completed open or close step.
+ */
+static void ring_complete(FsBatchStep *step, int res) {
+    int err = (res < 0) ? -res : 0;
+
+    if (step->op == FS_BATCH_CLOSE) {
+        step->file->fd = -1;
+    } else if (err == 0) {
+        step->file->fd = res;
+        step->file->path = step->path;
+        step->file->dirfd = parent_fd(step->parent);
+        step->file->path_only = false;
+        step->file->follow_symlinks = !(step->flags & FS_OPEN_NOFOLLOW);
+    } else if (needs_path_only(err)) {
+        // Rare enough to leave the retry to the blocking call
+        run_step(step);
+        return;
+    }
+
+    step->err = (FsError)err;
+}
+
+/*!
+ * @brief
+ * Runs up to one ring's worth of steps and waits for all of them.
+ *
+ * Opens and closes are submitted to the ring. Stats are run inline instead:
+ * the kernel always hands IORING_OP_STATX to its worker threads, and the
+ * hand-off measured slower than the plain statx() call it saves.
+ */
+static void ring_run(FsBatch *batch, FsBatchStep *steps, size_t count) {
+    unsigned int tail = *batch->sq_tail;
+    unsigned int mask = *batch->sq_mask;
+    unsigned int queued = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].op == FS_BATCH_STAT) {
+            run_step(&steps[i]);
+            continue;
+        }
+
+        unsigned int index = (tail + queued++) & mask;
+
+        // Marks the step as in flight until its completion arrives
+        steps[i].err = EINPROGRESS;
+
+        ring_prepare(&batch->sqes[index], &steps[i], i);
+        batch->sq_array[index] = index;
+    }
+
+    if (queued == 0) {
+        return;
+    }
+
+    __atomic_store_n(batch->sq_tail, tail + queued, __ATOMIC_RELEASE);
+
+    unsigned int submitted = 0;
+    unsigned int completed = 0;
+
+    while (completed < queued) {
+        int rc = (int)FS_SYSCALL(syscall(
+            __NR_io_uring_enter, batch->ring_fd,
+            queued - submitted, queued - completed,
+            IORING_ENTER_GETEVENTS, NULL, 0));
+
+        if (rc < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+
+            // The ring is unusable, and it can't be told which of the steps
+            // still in flight were carried out, so all of them fail
+            int err = errno;
+
+            for (size_t i = 0; i < count; i++) {
+                if (steps[i].op != FS_BATCH_STAT && steps[i].err == EINPROGRESS) {
+                    steps[i].err = (FsError)err;
+                }
+            }
+
+            return;
+        }
+
+        submitted += (unsigned int)rc;
+
+        unsigned int head = *batch->cq_head;
+        unsigned int cq_tail = __atomic_load_n(batch->cq_tail, __ATOMIC_ACQUIRE);
+
+        for (; head != cq_tail; head++) {
+            const struct io_uring_cqe *cqe = &batch->cqes[head & *batch->cq_mask];
+
+            ring_complete(&steps[cqe->user_data], cqe->res);
+            completed++;
+        }
+
+        __atomic_store_n(batch->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+#endif
+
+FsBatch *fs_batch_open(FsBatchMode mode) {
+    FsBatch *batch = calloc(1, sizeof(FsBatch));
+
+    if (!batch) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    batch->ring_fd = -1;
+
+#ifdef FS_HAVE_IO_URING
+    // The ring saves system calls, but the steps the kernel can't finish
+    // inline go to its worker threads, and bench/asyncbench has measured the
+    // hand-off as a break-even at best. Until it shows a win, the ring is only
+    // set up when asked for
+    if (mode == FS_BATCH_ASYNC) {
+        ring_setup(batch);
+    }
+#else
+    (void)mode;
+#endif
+
+    return batch;
+}
+
+bool fs_batch_is_async(const FsBatch *batch) {
+    return batch->ring_fd >= 0;
+}
+
+void fs_batch_run(FsBatch *batch, FsBatchStep *steps, size_t count) {
+#ifdef FS_HAVE_IO_URING
+    if (batch->ring_fd >= 0) {
+        for (size_t i = 0; i < count; i += batch->entries) {
+            size_t n = count - i;
+            ring_run(batch, &steps[i], (n < batch->entries) ? n : batch->entries);
+        }
+
+        return;
+    }
+#else
+    (void)batch;
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        run_step(&steps[i]);
+    }
+}
+
+void fs_batch_close(FsBatch *batch) {
+    if (!batch) {
+        return;
+    }
+
+#ifdef FS_HAVE_IO_URING
+    ring_teardown(batch);
+#endif
+
+    free(batch);
+}
+
+bool fs_map_file(const TCHAR *path, FsMapping *out) {
+    int fd = FS_SYSCALL(open(path, O_RDONLY | O_CLOEXEC));
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    void *data = NULL;
+    bool ok = FS_SYSCALL(fstat(fd, &st)) == 0;
+
+    // mmap() rejects empty mappings
+    if (ok && st.st_size > 0) {
+        data = FS_SYSCALL(mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+        ok = (data != MAP_FAILED);
+    }
+
+    // The mapping keeps its own reference to the file
+    int err = errno;
+    FS_SYSCALL(close(fd));
+    errno = err;
+
+    if (!ok) {
+        return false;
+    }
+
+    out->data = data;
+    out->size = (size_t)st.st_size;
+    return true;
+}
+
+void fs_unmap_file(FsMapping *map) {
+    if (map->data) {
+        FS_SYSCALL(munmap((void *)map->data, map->size));
+    }
+
+    map->data = NULL;
+    map->size = 0;
+}
+
+FsTime fs_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return from_timespec(now.tv_sec, now.tv_nsec);
+}
+
+bool fs_systemtime_to_time(const SYSTEMTIME *st, FsTime *out) {
+    // Same range checks as SystemTimeToFileTime()
+    if (st->wYear < 1601 || st->wYear > 30827 ||
+        st->wMonth < 1 || st->wMonth > 12 ||
+        st->wDay < 1 || st->wDay > cal_days_in_month(st->wYear, st->wMonth) ||
+        st->wHour > 23 || st->wMinute > 59 || st->wSecond > 59 ||
+        st->wMilliseconds > 999) {
+        errno = EINVAL;
+        return false;
+    }
+
+    int32_t days = cal_days_from_civil(st->wYear, st->wMonth, st->wDay);
+
+    *out = (FsTime)cal_ticks(days, st->wHour, st->wMinute, st->wSecond, st->wMilliseconds);
+    return true;
+}
+
+bool fs_time_to_systemtime(FsTime time, SYSTEMTIME *out) {
+    // Like FileTimeToSystemTime(), reject times that are negative as an int64_t
+    if (time > (FsTime)INT64_MAX) {
+        errno = EINVAL;
+        return false;
+    }
+
+    const FsTime ticks_per_day = (FsTime)CAL_SECONDS_PER_DAY * CAL_TICKS_PER_SECOND;
+
+    int32_t days = (int32_t)(time / ticks_per_day);
+    FsTime ticks_of_day = time % ticks_per_day;
+    int32_t seconds = (int32_t)(ticks_of_day / CAL_TICKS_PER_SECOND);
+
+    int32_t year, month, day;
+    cal_civil_from_days(days, &year, &month, &day);
+
+    out->wYear = (WORD)year;
+    out->wMonth = (WORD)month;
+    out->wDayOfWeek = (WORD)cal_day_of_week(days);
+    out->wDay = (WORD)day;
+    out->wHour = (WORD)(seconds / 3600);
+    out->wMinute = (WORD)(seconds / 60 % 60);
+    out->wSecond = (WORD)(seconds % 60);
+    out->wMilliseconds = (WORD)(ticks_of_day % CAL_TICKS_PER_SECOND / (CAL_TICKS_PER_SECOND / 1000));
+
+    return true;
+}
+
+bool fs_local_systemtime_to_time(const SYSTEMTIME *st, FsTime *out) {
+    struct tm tm = {
+        .tm_year = st->wYear - 1900,
+        .tm_mon = st->wMonth - 1,
+        .tm_mday = st->wDay,
+        .tm_hour = st->wHour,
+        .tm_min = st->wMinute,
+        .tm_sec = st->wSecond,
+        // Let the C library work out whether DST is in effect
+        .tm_isdst = -1
+    };
+
+    time_t t = mktime(&tm);
+
+    if (t == (time_t)-1) {
+        return false;
+    }
+
+    *out = from_timespec(t, (long)st->wMilliseconds * 1000000L);
+    return true;
+}
+
+#endif // !_WIN32
@@ -0,0 +1,985 @@
+/* fs_win32.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifdef _WIN32
+
+#include "fsbackend.h"
+
+#include <winternl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+// Maximum length of a path, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Number of volumes whose timestamp granularity is remembered
+#define GRANULARITY_CACHE_SIZE 16
+
+// Maximum length of a volume root remembered by the granularity cache,
+// including the terminating null character
+#define VOLUME_ROOT_CAPACITY 272
+
+#ifdef FS_COUNT_SYSCALLS
+thread_local unsigned long long fs_syscalls;
+#endif
+
+// Win32 has no asynchronous open, stat or close, so batch steps are always run
+// one at a time
+struct fs_batch {
+    FsBatchMode mode;
+};
+
+// NtCreateFile() is the only call that opens a file relative to a directory
+// handle. ntdll.dll is loaded into every process, but its import library isn't
+// part of the default link, so the functions are looked up at run time
+typedef NTSTATUS (NTAPI *NtCreateFileFn)(
+    PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK, PLARGE_INTEGER,
+    ULONG, ULONG, ULONG, ULONG, PVOID, ULONG);
+
+typedef ULONG (NTAPI *RtlNtStatusToDosErrorFn)(NTSTATUS);
+
+static struct nt_api {
+    NtCreateFileFn create_file;
+    RtlNtStatusToDosErrorFn status_to_error;
+} nt_api;
+
+static once_flag nt_api_once = ONCE_FLAG_INIT;
+
+struct fs_dir {
+    HANDLE find_handle;
+    WIN32_FIND_DATA data;
+    // Indicates that \c data holds an entry that has not been returned yet
+    bool has_data;
+};
+
+/*!
+ * @brief
+ * Timestamp granularity of the volumes seen so far, keyed by root path.
+ */
+static struct granularity_cache {
+    mtx_t lock;
+    TCHAR roots[GRANULARITY_CACHE_SIZE][VOLUME_ROOT_CAPACITY];
+    FsTimes granularity[GRANULARITY_CACHE_SIZE];
+    size_t count;
+    // Root of the current directory, which relative paths resolve against
+    TCHAR cwd_root[VOLUME_ROOT_CAPACITY];
+} granularity_cache;
+
+static once_flag granularity_once = ONCE_FLAG_INIT;
+
+// Specifies that a file's previous last access or write times should be preserved
+// when operating with file handles
+// https://learn.microsoft.com/en-us/windows/win32/api/minwinbase/ns-minwinbase-filetime
+// https://learn.microsoft.com/en-us/windows/win32/api/fileapi/nf-fileapi-setfiletime
+static const FILETIME ft_preserved = {
+    .dwLowDateTime = 0xFFFFFFFF,
+    .dwHighDateTime = 0xFFFFFFFF
+};
+
+static FsTime from_filetime(const FILETIME *ft) {
+    return ((FsTime)ft->dwHighDateTime << 32) | ft->dwLowDateTime;
+}
+
+static FILETIME to_filetime(FsTime time) {
+    FILETIME ft = {
+        .dwLowDateTime = (DWORD)(time & 0xFFFFFFFF),
+        .dwHighDateTime = (DWORD)(time >> 32)
+    };
+
+    return ft;
+}
+
+FsError fs_last_error(void) {
+    return GetLastError();
+}
+
+bool fs_error_is_missing(FsError err) {
+    return err == ERROR_FILE_NOT_FOUND ||
+           err == ERROR_PATH_NOT_FOUND;
+}
+
+static void init_nt_api(void) {
+    HMODULE ntdll = GetModuleHandle(_T("ntdll.dll"));
+
+    if (!ntdll) {
+        return;
+    }
+
+    // Going through void (*)(void) keeps compilers from warning about the
+    // mismatch with FARPROC
+    nt_api.create_file =
+        (NtCreateFileFn)(void (*)(void))GetProcAddress(ntdll, "NtCreateFile");
+    nt_api.status_to_error =
+        (RtlNtStatusToDosErrorFn)(void (*)(void))GetProcAddress(ntdll, "RtlNtStatusToDosError");
+}
+
+/*!
+ * @brief
+ * Opens a file by its name within an open directory, the way CreateFile()
+ * opens one with backup semantics.
+ *
+ * @param access
+ * Access rights to request, as for CreateFile().
+ *
+ * @param share
+ * Share mode, as for CreateFile().
+ *
+ * @param disposition
+ * FILE_OPEN to open an existing file, or FILE_OPEN_IF to create it if needed.
+ *
+ * @return
+ * The handle of the file, or INVALID_HANDLE_VALUE on failure, in which case
+ * the last error is set.
+ */
+static HANDLE open_relative(
+    const FsParent *parent, const TCHAR *name,
+    ACCESS_MASK access, ULONG share, ULONG disposition,
+    bool follow_symlinks) {
+
+    call_once(&nt_api_once, init_nt_api);
+
+    if (!nt_api.create_file || !nt_api.status_to_error) {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    // Object names are counted in bytes that must fit a USHORT
+    size_t size = _tcslen(name) * sizeof(WCHAR);
+
+    if (size > 0xFFFE) {
+        SetLastError(ERROR_FILENAME_EXCED_RANGE);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    UNICODE_STRING object_name = {
+        .Length = (USHORT)size,
+        .MaximumLength = (USHORT)size,
+        .Buffer = (PWSTR)name
+    };
+
+    OBJECT_ATTRIBUTES attrs;
+    InitializeObjectAttributes(&attrs, &object_name, OBJ_CASE_INSENSITIVE, parent->handle, NULL);
+
+    ULONG options = FILE_OPEN_FOR_BACKUP_INTENT | FILE_SYNCHRONOUS_IO_NONALERT;
+
+    if (!follow_symlinks) {
+        options |= FILE_OPEN_REPARSE_POINT;
+    }
+
+    HANDLE handle;
+    IO_STATUS_BLOCK io;
+
+    NTSTATUS status = FS_SYSCALL(nt_api.create_file(
+        &handle,                                                // FileHandle
+        access | SYNCHRONIZE,                                   // DesiredAccess
+        &attrs,                                                 // ObjectAttributes
+        &io,                                                    // IoStatusBlock
+        NULL,                                                   // AllocationSize
+        FILE_ATTRIBUTE_NORMAL,                                  // FileAttributes
+        share,                                                  // ShareAccess
+        disposition,                                            // CreateDisposition
+        options,                                                // CreateOptions
+        NULL,                                                   // EaBuffer
+        0                                                       // EaLength
+    ));
+
+    if (!NT_SUCCESS(status)) {
+        SetLastError(nt_api.status_to_error(status));
+        return INVALID_HANDLE_VALUE;
+    }
+
+    return handle;
+}
+
+bool fs_open(FsFile *file, const TCHAR *path, unsigned int flags) {
+    return fs_open_at(NULL, file, path, flags);
+}
+
+bool fs_open_at(const FsParent *parent, FsFile *file, const TCHAR *name, unsigned int flags) {
+    if (parent) {
+        file->handle = open_relative(
+            parent, name,
+            GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ,
+            (flags & FS_OPEN_CREATE) ? FILE_OPEN_IF : FILE_OPEN,
+            !(flags & FS_OPEN_NOFOLLOW));
+
+        return file->handle != INVALID_HANDLE_VALUE;
+    }
+
+    // Backup semantics are required to obtain a handle to a directory
+    DWORD cw_flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_BACKUP_SEMANTICS;
+
+    if (flags & FS_OPEN_NOFOLLOW) {
+        cw_flags |= FILE_FLAG_OPEN_REPARSE_POINT;
+    }
+
+    file->handle = FS_SYSCALL(CreateFile(
+        name,                                                   // lpFileName
+        GENERIC_READ | FILE_WRITE_ATTRIBUTES,                   // dwDesiredAccess
+        FILE_SHARE_READ,                                        // dwShareMode
+        NULL,                                                   // lpSecurityAttributes
+        (flags & FS_OPEN_CREATE) ? OPEN_ALWAYS : OPEN_EXISTING, // dwCreationDisposition
+        cw_flags,                                               // dwFlagsAndAttributes
+        NULL                                                    // hTemplateFile
+    ));
+
+    return file->handle != INVALID_HANDLE_VALUE;
+}
+
+void fs_close(FsFile *file) {
+    FS_SYSCALL(CloseHandle(file->handle));
+    file->handle = INVALID_HANDLE_VALUE;
+}
+
+bool fs_get_times(FsFile *file, FsTimes *out) {
+    FILETIME creation, access, write;
+
+    if (!FS_SYSCALL(GetFileTime(file->handle, &creation, &access, &write))) {
+        return false;
+    }
+
+    out->creation = from_filetime(&creation);
+    out->access = from_filetime(&access);
+    out->write = from_filetime(&write);
+
+    return true;
+}
+
+bool fs_set_times(FsFile *file, const FsTimes *times) {
+    FILETIME creation = to_filetime(times->creation);
+    FILETIME access = to_filetime(times->access);
+    FILETIME write = to_filetime(times->write);
+
+    // SetFileTime() has no value for the current time, and needs no more
+    // rights to set it than any other time
+    if (times->creation == FS_TIME_NOW || times->access == FS_TIME_NOW ||
+        times->write == FS_TIME_NOW) {
+
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+
+        creation = (times->creation == FS_TIME_NOW) ? now : creation;
+        access = (times->access == FS_TIME_NOW) ? now : access;
+        write = (times->write == FS_TIME_NOW) ? now : write;
+    }
+
+    // Passing ft_preserved rather than NULL for access and write keeps the
+    // system from stamping them itself when the handle is closed
+    return FS_SYSCALL(SetFileTime(
+        file->handle,
+        (times->creation != FS_TIME_OMIT) ? &creation : NULL,
+        (times->access != FS_TIME_OMIT) ? &access : &ft_preserved,
+        (times->write != FS_TIME_OMIT) ? &write : &ft_preserved));
+}
+
+bool fs_set_times_by_path(
+    const TCHAR *path, bool follow_symlinks,
+    const FsTimes *times) {
+
+    return fs_set_times_at(NULL, path, follow_symlinks, times);
+}
+
+bool fs_set_times_at(
+    const FsParent *parent, const TCHAR *name,
+    bool follow_symlinks, const FsTimes *times) {
+
+    // Win32 has no call that sets timestamps by name, so the cheapest option
+    // is a handle opened for attribute writes only. It shares everything, so it
+    // needs no read access, never hits a sharing violation and does not break
+    // oplocks that other processes hold on the file
+    DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE file_handle;
+
+    if (parent) {
+        file_handle = open_relative(
+            parent, name, FILE_WRITE_ATTRIBUTES, share, FILE_OPEN, follow_symlinks);
+    } else {
+        DWORD cw_flags = FILE_FLAG_BACKUP_SEMANTICS;
+
+        if (!follow_symlinks) {
+            cw_flags |= FILE_FLAG_OPEN_REPARSE_POINT;
+        }
+
+        file_handle = FS_SYSCALL(CreateFile(
+            name,                                                   // lpFileName
+            FILE_WRITE_ATTRIBUTES,                                  // dwDesiredAccess
+            share,                                                  // dwShareMode
+            NULL,                                                   // lpSecurityAttributes
+            OPEN_EXISTING,                                          // dwCreationDisposition
+            cw_flags,                                               // dwFlagsAndAttributes
+            NULL                                                    // hTemplateFile
+        ));
+    }
+
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    FsFile file = { .handle = file_handle };
+    bool ok = fs_set_times(&file, times);
+
+    FS_SYSCALL(CloseHandle(file_handle));
+
+    return ok;
+}
+
+bool fs_stat_times(const TCHAR *path, bool follow_symlinks, FsTimes *out) {
+    // GetFileAttributesEx() reports the times of a link itself, so following
+    // one requires a handle
+    if (follow_symlinks) {
+        HANDLE file_handle = FS_SYSCALL(CreateFile(
+            path,                                                   // lpFileName
+            FILE_READ_ATTRIBUTES,                                   // dwDesiredAccess
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, // dwShareMode
+            NULL,                                                   // lpSecurityAttributes
+            OPEN_EXISTING,                                          // dwCreationDisposition
+            FILE_FLAG_BACKUP_SEMANTICS,                             // dwFlagsAndAttributes
+            NULL                                                    // hTemplateFile
+        ));
+
+        if (file_handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        FsFile file = { .handle = file_handle };
+        bool ok = fs_get_times(&file, out);
+
+        FS_SYSCALL(CloseHandle(file_handle));
+
+        return ok;
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+
+    if (!FS_SYSCALL(GetFileAttributesEx(path, GetFileExInfoStandard, (void *)&attr))) {
+        return false;
+    }
+
+    out->creation = from_filetime(&attr.ftCreationTime);
+    out->access = from_filetime(&attr.ftLastAccessTime);
+    out->write = from_filetime(&attr.ftLastWriteTime);
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Gets the length of the root of an absolute path: "X:\", "\\server\share\"
+ * or either one behind a "\\?\" prefix.
+ *
+ * @return
+ * The length of the root, or 0 if \p path is relative or has no such root.
+ */
+static size_t volume_root_length(const TCHAR *path) {
+    size_t start = 0;
+    bool unc = false;
+
+    if (_tcsncmp(path, _T("\\\\?\\UNC\\"), 8) == 0) {
+        start = 8;
+        unc = true;
+    } else if (_tcsncmp(path, _T("\\\\?\\"), 4) == 0) {
+        start = 4;
+    } else if (path[0] == '\\' && path[1] == '\\') {
+        start = 2;
+        unc = true;
+    }
+
+    if (!unc) {
+        bool drive =
+            ((path[start] >= 'A' && path[start] <= 'Z') ||
+             (path[start] >= 'a' && path[start] <= 'z')) &&
+            path[start + 1] == ':';
+
+        return drive ? start + 2 : 0;
+    }
+
+    // Skip the server and share names
+    size_t i = start;
+
+    for (int part = 0; part < 2; part++) {
+        while (path[i] != '\0' && path[i] != '\\' && path[i] != '/') {
+            i++;
+        }
+
+        if (part == 0) {
+            if (path[i] == '\0' || i == start) {
+                return 0;
+            }
+
+            i++;
+        }
+    }
+
+    return i;
+}
+
+/*!
+ * @brief
+ * Copies the root of \p path into \p root with a trailing backslash, as
+ * GetVolumeInformation() expects. Relative paths get the root of the current
+ * directory.
+ *
+ * @return
+ * false if the root cannot be determined or is too long to be remembered.
+ */
+static bool volume_root(const TCHAR *path, TCHAR root[VOLUME_ROOT_CAPACITY]) {
+    size_t len = volume_root_length(path);
+
+    if (len == 0) {
+        _tcscpy(root, granularity_cache.cwd_root);
+        return root[0] != '\0';
+    }
+
+    if (len + 2 > VOLUME_ROOT_CAPACITY) {
+        return false;
+    }
+
+    memcpy(root, path, len * sizeof(TCHAR));
+    root[len] = '\\';
+    root[len + 1] = '\0';
+
+    return true;
+}
+
+static void init_granularity_cache(void) {
+    struct granularity_cache *cache = &granularity_cache;
+    TCHAR *cwd = malloc(PATH_CAPACITY * sizeof(TCHAR));
+
+    mtx_init(&cache->lock, mtx_plain);
+
+    // The program never changes directory, so this is only looked up once
+    if (cwd && GetCurrentDirectory(PATH_CAPACITY, cwd) != 0) {
+        TCHAR root[VOLUME_ROOT_CAPACITY];
+
+        if (volume_root_length(cwd) > 0 && volume_root(cwd, root)) {
+            _tcscpy(cache->cwd_root, root);
+        }
+    }
+
+    free(cwd);
+}
+
+/*!
+ * @brief
+ * Works out the timestamp granularity of a volume from its file system name.
+ * File systems that aren't known to be coarser than FsTime report 1 tick,
+ * which never makes two different times compare equal.
+ */
+static FsTimes query_granularity(const TCHAR *root) {
+    FsTimes granularity = { 1, 1, 1 };
+    TCHAR fs_name[MAX_PATH + 1];
+
+    if (!FS_SYSCALL(GetVolumeInformation(root, NULL, 0, NULL, NULL, NULL, fs_name, MAX_PATH + 1))) {
+        return granularity;
+    }
+
+    if (_tcsicmp(fs_name, _T("exFAT")) == 0) {
+        granularity.creation = FS_TICKS_PER_SECOND / 100;
+        granularity.access = FS_TICKS_PER_SECOND * 2;
+        granularity.write = FS_TICKS_PER_SECOND / 100;
+    } else if (_tcsnicmp(fs_name, _T("FAT"), 3) == 0) {
+        // Creation times in 10 ms, write times in 2 s, and access dates only
+        granularity.creation = FS_TICKS_PER_SECOND / 100;
+        granularity.access = FS_TICKS_PER_SECOND * 86400;
+        granularity.write = FS_TICKS_PER_SECOND * 2;
+    }
+
+    return granularity;
+}
+
+/*!
+ * @brief
+ * Looks up the timestamp granularity of the volume holding \p path, querying
+ * and remembering it on first use.
+ *
+ * Volumes are told apart by the root of the path, so one mounted into a
+ * folder is taken for the volume holding the folder. Only NTFS and ReFS can
+ * hold mount points, and both are as precise as FsTime, so such a volume is
+ * never thought to be coarser than it is.
+ */
+static FsTimes volume_granularity(const TCHAR *path) {
+    call_once(&granularity_once, init_granularity_cache);
+
+    struct granularity_cache *cache = &granularity_cache;
+    FsTimes granularity = { 1, 1, 1 };
+    TCHAR root[VOLUME_ROOT_CAPACITY];
+
+    if (!volume_root(path, root)) {
+        return granularity;
+    }
+
+    bool found = false;
+
+    mtx_lock(&cache->lock);
+
+    for (size_t i = 0; i < cache->count; i++) {
+        if (_tcsicmp(cache->roots[i], root) == 0) {
+            granularity = cache->granularity[i];
+            found = true;
+            break;
+        }
+    }
+
+    mtx_unlock(&cache->lock);
+
+    if (found) {
+        return granularity;
+    }
+
+    // Errors only cost precision, so they must not leak into the caller's
+    // error state
+    DWORD err = GetLastError();
+    granularity = query_granularity(root);
+    SetLastError(err);
+
+    mtx_lock(&cache->lock);
+
+    if (cache->count < GRANULARITY_CACHE_SIZE) {
+        _tcscpy(cache->roots[cache->count], root);
+        cache->granularity[cache->count] = granularity;
+        cache->count++;
+    }
+
+    mtx_unlock(&cache->lock);
+
+    return granularity;
+}
+
+bool fs_stat_times_granular(
+    const TCHAR *path, bool follow_symlinks,
+    FsTimes *out, FsTimes *granularity) {
+
+    if (!fs_stat_times(path, follow_symlinks, out)) {
+        return false;
+    }
+
+    *granularity = volume_granularity(path);
+    return true;
+}
+
+bool fs_is_directory(const TCHAR *path, bool follow_symlinks) {
+    DWORD attrs = FS_SYSCALL(GetFileAttributes(path));
+
+    if (attrs == INVALID_FILE_ATTRIBUTES ||
+        !(attrs & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+
+    return follow_symlinks || !(attrs & FILE_ATTRIBUTE_REPARSE_POINT);
+}
+
+FsDir *fs_dir_open(const TCHAR *path) {
+    size_t len = _tcslen(path);
+
+    if (len + 3 > PATH_CAPACITY) {
+        SetLastError(ERROR_FILENAME_EXCED_RANGE);
+        return NULL;
+    }
+
+    FsDir *dir = malloc(sizeof(FsDir));
+    TCHAR *pattern = malloc((len + 3) * sizeof(TCHAR));
+
+    if (!dir || !pattern) {
+        free(dir);
+        free(pattern);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    memcpy(pattern, path, len * sizeof(TCHAR));
+
+    // "C:" stands for the current directory of drive C, not its root
+    if (len > 0 && pattern[len - 1] != '\\' && pattern[len - 1] != '/' &&
+        !(len == 2 && pattern[1] == ':')) {
+        pattern[len++] = '\\';
+    }
+
+    pattern[len++] = '*';
+    pattern[len] = '\0';
+
+    // Skip short names and ask for large directory reads; both measurably cut
+    // enumeration time on big directories
+    dir->find_handle = FS_SYSCALL(FindFirstFileEx(
+        pattern, FindExInfoBasic, &dir->data,
+        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH));
+
+    free(pattern);
+
+    if (dir->find_handle == INVALID_HANDLE_VALUE) {
+        DWORD err = GetLastError();
+        free(dir);
+        SetLastError(err);
+        return NULL;
+    }
+
+    dir->has_data = true;
+
+    return dir;
+}
+
+bool fs_dir_next(FsDir *dir, FsDirEntry *out, FsError *err) {
+    *err = FS_OK;
+
+    while (true) {
+        if (!dir->has_data &&
+            !FindNextFile(dir->find_handle, &dir->data)) {
+            DWORD last = GetLastError();
+            *err = (last == ERROR_NO_MORE_FILES) ? FS_OK : last;
+            return false;
+        }
+
+        dir->has_data = false;
+
+        const TCHAR *name = dir->data.cFileName;
+
+        if (name[0] == '.' &&
+           (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        out->name = name;
+        out->is_dir = (dir->data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        out->is_link = (dir->data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+
+        return true;
+    }
+}
+
+void fs_dir_close(FsDir *dir) {
+    if (!dir) {
+        return;
+    }
+
+    FS_SYSCALL(FindClose(dir->find_handle));
+    free(dir);
+}
+
+/*!
+ * @brief
+ * Checks whether a name means the same when opened relative to its directory
+ * as it does at the end of a Win32 path. Win32 strips trailing dots and
+ * spaces, resolves "." and "..", and maps reserved device names like NUL to
+ * devices in any directory; NtCreateFile() does none of that.
+ */
+static bool is_plain_name(const TCHAR *name) {
+    static const TCHAR *const devices[] = {
+        _T("CON"), _T("PRN"), _T("AUX"), _T("NUL")
+    };
+
+    size_t len = _tcslen(name);
+
+    if (len == 0 || name[len - 1] == '.' || name[len - 1] == ' ' || _tcschr(name, ':')) {
+        return false;
+    }
+
+    // The device names are reserved with any extension, and so is a name
+    // whose base ends in spaces, like "NUL .txt"
+    size_t base = 0;
+
+    while (name[base] != '\0' && name[base] != '.') {
+        base++;
+    }
+
+    while (base > 0 && name[base - 1] == ' ') {
+        base--;
+    }
+
+    if (base == 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(devices) / sizeof(devices[0]); i++) {
+        if (base == 3 && _tcsnicmp(name, devices[i], 3) == 0) {
+            return false;
+        }
+    }
+
+    bool numbered =
+        base == 4 &&
+        (_tcsnicmp(name, _T("COM"), 3) == 0 || _tcsnicmp(name, _T("LPT"), 3) == 0) &&
+        name[3] >= '1' && name[3] <= '9';
+
+    return !numbered;
+}
+
+size_t fs_parent_length(const TCHAR *path) {
+    const TCHAR *name = NULL;
+
+    for (const TCHAR *p = path; *p != '\0'; p++) {
+        if (*p == '\\' || *p == '/') {
+            name = p + 1;
+        }
+    }
+
+    if (!name || !is_plain_name(name)) {
+        return 0;
+    }
+
+    return (size_t)(name - path);
+}
+
+bool fs_parent_open(FsParent *parent, const TCHAR *path) {
+    parent->handle = FS_SYSCALL(CreateFile(
+        path,                                                   // lpFileName
+        FILE_TRAVERSE,                                          // dwDesiredAccess
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, // dwShareMode
+        NULL,                                                   // lpSecurityAttributes
+        OPEN_EXISTING,                                          // dwCreationDisposition
+        FILE_FLAG_BACKUP_SEMANTICS,                             // dwFlagsAndAttributes
+        NULL                                                    // hTemplateFile
+    ));
+
+    if (parent->handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // CreateFile() opens files just as well, and names looked up relative to
+    // one would fail with a different error than the whole path does
+    FILE_BASIC_INFO info;
+    DWORD err = ERROR_SUCCESS;
+
+    if (!FS_SYSCALL(GetFileInformationByHandleEx(parent->handle, FileBasicInfo, &info, sizeof(info)))) {
+        err = GetLastError();
+    } else if (!(info.FileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        err = ERROR_DIRECTORY;
+    }
+
+    if (err != ERROR_SUCCESS) {
+        fs_parent_close(parent);
+        SetLastError(err);
+        return false;
+    }
+
+    return true;
+}
+
+void fs_parent_close(FsParent *parent) {
+    FS_SYSCALL(CloseHandle(parent->handle));
+    parent->handle = INVALID_HANDLE_VALUE;
+}
+
+/*!
+ * @brief
+ * Retrieves the timestamps and the identity of an open file with a single
+ * call.
+ */
+static bool get_times_and_id(HANDLE handle, FsTimes *out, FsFileId *id) {
+    BY_HANDLE_FILE_INFORMATION info;
+
+    if (!FS_SYSCALL(GetFileInformationByHandle(handle, &info))) {
+        return false;
+    }
+
+    out->creation = from_filetime(&info.ftCreationTime);
+    out->access = from_filetime(&info.ftLastAccessTime);
+    out->write = from_filetime(&info.ftLastWriteTime);
+
+    id->volume = info.dwVolumeSerialNumber;
+    id->index = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Retrieves the timestamps of a file by its name within an open directory,
+ * like fs_stat_times(), and its identity if \p id is not NULL.
+ */
+static bool stat_times_at(
+    const FsParent *parent, const TCHAR *name,
+    bool follow_symlinks, FsTimes *out, FsFileId *id) {
+
+    if (!parent && !id) {
+        return fs_stat_times(name, follow_symlinks, out);
+    }
+
+    DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE file_handle;
+
+    if (parent) {
+        file_handle = open_relative(
+            parent, name, FILE_READ_ATTRIBUTES, share, FILE_OPEN, follow_symlinks);
+    } else {
+        DWORD cw_flags = FILE_FLAG_BACKUP_SEMANTICS;
+
+        if (!follow_symlinks) {
+            cw_flags |= FILE_FLAG_OPEN_REPARSE_POINT;
+        }
+
+        file_handle = FS_SYSCALL(CreateFile(
+            name,                                                   // lpFileName
+            FILE_READ_ATTRIBUTES,                                   // dwDesiredAccess
+            share,                                                  // dwShareMode
+            NULL,                                                   // lpSecurityAttributes
+            OPEN_EXISTING,                                          // dwCreationDisposition
+            cw_flags,                                               // dwFlagsAndAttributes
+            NULL                                                    // hTemplateFile
+        ));
+    }
+
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    FsFile file = { .handle = file_handle };
+    bool ok = id ?
+        get_times_and_id(file_handle, out, id) :
+        fs_get_times(&file, out);
+
+    FS_SYSCALL(CloseHandle(file_handle));
+
+    return ok;
+}
+
+FsBatch *fs_batch_open(FsBatchMode mode) {
+    FsBatch *batch = calloc(1, sizeof(FsBatch));
+
+    if (!batch) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    batch->mode = mode;
+
+    return batch;
+}
+
+bool fs_batch_is_async(const FsBatch *batch) {
+    (void)batch;
+    return false;
+}
+
+void fs_batch_run(FsBatch *batch, FsBatchStep *steps, size_t count) {
+    (void)batch;
+
+    for (size_t i = 0; i < count; i++) {
+        FsBatchStep *step = &steps[i];
+        bool ok = true;
+
+        switch (step->op) {
+            case FS_BATCH_OPEN:
+                ok = fs_open_at(step->parent, step->file, step->path, step->flags);
+                break;
+            case FS_BATCH_STAT:
+                ok = step->file ?
+                    fs_get_times(step->file, step->times) :
+                    stat_times_at(
+                        step->parent, step->path,
+                        !(step->flags & FS_OPEN_NOFOLLOW), step->times, step->id);
+                break;
+            case FS_BATCH_CLOSE:
+                fs_close(step->file);
+                break;
+        }
+
+        step->err = ok ? FS_OK : fs_last_error();
+    }
+}
+
+void fs_batch_close(FsBatch *batch) {
+    free(batch);
+}
+
+bool fs_map_file(const TCHAR *path, FsMapping *out) {
+    HANDLE file_handle = FS_SYSCALL(CreateFile(
+        path,                                                   // lpFileName
+        GENERIC_READ,                                           // dwDesiredAccess
+        FILE_SHARE_READ | FILE_SHARE_DELETE,                    // dwShareMode
+        NULL,                                                   // lpSecurityAttributes
+        OPEN_EXISTING,                                          // dwCreationDisposition
+        FILE_FLAG_SEQUENTIAL_SCAN,                              // dwFlagsAndAttributes
+        NULL                                                    // hTemplateFile
+    ));
+
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    const void *data = NULL;
+    bool ok = FS_SYSCALL(GetFileSizeEx(file_handle, &size)) != 0;
+
+    if (ok && (ULONGLONG)size.QuadPart > SIZE_MAX) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        ok = false;
+    }
+
+    // CreateFileMapping() rejects empty files
+    if (ok && size.QuadPart > 0) {
+        HANDLE mapping = FS_SYSCALL(CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL));
+        ok = (mapping != NULL);
+
+        if (ok) {
+            data = FS_SYSCALL(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            ok = (data != NULL);
+
+            // The view keeps its own reference to the mapping and the file
+            DWORD err = GetLastError();
+            FS_SYSCALL(CloseHandle(mapping));
+            SetLastError(err);
+        }
+    }
+
+    DWORD err = GetLastError();
+    FS_SYSCALL(CloseHandle(file_handle));
+    SetLastError(err);
+
+    if (!ok) {
+        return false;
+    }
+
+    out->data = data;
+    out->size = (size_t)size.QuadPart;
+    return true;
+}
+
+void fs_unmap_file(FsMapping *map) {
+    if (map->data) {
+        FS_SYSCALL(UnmapViewOfFile(map->data));
+    }
+
+    map->data = NULL;
+    map->size = 0;
+}
+
+FsTime fs_now(void) {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+
+    return from_filetime(&now);
+}
+
+bool fs_systemtime_to_time(const SYSTEMTIME *st, FsTime *out) {
+    FILETIME ft;
+
+    if (!SystemTimeToFileTime(st, &ft)) {
+        return false;
+    }
+
+    *out = from_filetime(&ft);
+    return true;
+}
+
+bool fs_time_to_systemtime(FsTime time, SYSTEMTIME *out) {
+    FILETIME ft = to_filetime(time);
+    return FileTimeToSystemTime(&ft, out);
+}
+
+bool fs_local_systemtime_to_time(const SYSTEMTIME *st, FsTime *out) {
+    SYSTEMTIME utc;
+
+    // Interpret timestamp as the local civil time in the current Windows TZ
+    // configuration to properly handle TZ-related adjustments like DST transitions
+    if (!TzSpecificLocalTimeToSystemTime(NULL, st, &utc)) {
+        return false;
+    }
+
+    return fs_systemtime_to_time(&utc, out);
+}
+
+#endif // _WIN32
@@ -0,0 +1,651 @@
+/* fsbackend.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef FSBACKEND_H
+#define FSBACKEND_H
+
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief
+ * Point in time represented as the number of 100-nanosecond intervals since
+ * January 1, 1601 (UTC). This is the FILETIME representation, regardless of
+ * the backend in use.
+ */
+typedef uint64_t FsTime;
+
+// Leaves the corresponding timestamp unchanged when passed to fs_set_times()
+// or fs_set_times_by_path(). Also reported by fs_get_times() and
+// fs_stat_times() for timestamps the file system does not record
+#define FS_TIME_OMIT UINT64_MAX
+
+// Sets the corresponding timestamp to the current time when passed to
+// fs_set_times() or fs_set_times_by_path(). POSIX systems let any caller with
+// write access to a file set its times to the current time, but only its owner
+// set them to a given time, so "now" is not passed as an explicit value
+#define FS_TIME_NOW (UINT64_MAX - 1)
+
+// Number of FsTime ticks in one second
+#define FS_TICKS_PER_SECOND 10000000LL
+
+/*!
+ * @brief
+ * Backend-specific error code. This is a Win32 error code on Windows and an
+ * errno value elsewhere.
+ */
+typedef unsigned long FsError;
+
+#define FS_OK 0
+
+#ifdef _WIN32
+#define FS_ERR_NO_MEMORY ERROR_NOT_ENOUGH_MEMORY
+#define FS_ERR_NAME_TOO_LONG ERROR_FILENAME_EXCED_RANGE
+#else
+#include <errno.h>
+#define FS_ERR_NO_MEMORY ENOMEM
+#define FS_ERR_NAME_TOO_LONG ENAMETOOLONG
+#endif
+
+#ifdef FS_COUNT_SYSCALLS
+#include <threads.h>
+
+// Number of system calls issued by the backend on the calling thread. Calls
+// that are usually served from a user-mode buffer, like readdir(), are not
+// counted
+extern thread_local unsigned long long fs_syscalls;
+
+#define FS_SYSCALL(call) (fs_syscalls++, (call))
+#else
+#define FS_SYSCALL(call) (call)
+#endif
+
+/*!
+ * @brief
+ * The creation, last access and last write times of a file.
+ */
+typedef struct fs_times {
+    FsTime creation;
+    FsTime access;
+    FsTime write;
+} FsTimes;
+
+/*!
+ * @brief
+ * Flags controlling how fs_open() opens a file.
+ */
+typedef enum fs_open_flags {
+    // Create the file if it does not exist
+    FS_OPEN_CREATE = 1 << 0,
+    // Operate on a symbolic link itself rather than on the file it refers to
+    FS_OPEN_NOFOLLOW = 1 << 1
+} FsOpenFlags;
+
+/*!
+ * @brief
+ * A directory held open so that the files in it can be reached by name,
+ * without resolving the directory's own path again for each of them.
+ */
+typedef struct fs_parent {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+} FsParent;
+
+/*!
+ * @brief
+ * An open file whose timestamps can be read and changed.
+ */
+typedef struct fs_file {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+    // Directories, links and files that can't be opened for writing are held
+    // through a path-only descriptor, which cannot change timestamps. For those,
+    // times are set through the path instead, relative to dirfd
+    const char *path;
+    int dirfd;
+    bool path_only;
+    bool follow_symlinks;
+#endif
+} FsFile;
+
+/*!
+ * @brief
+ * An entry returned by fs_dir_next().
+ */
+typedef struct fs_dir_entry {
+    // Name of the entry. Only valid until the next call on the directory
+    const TCHAR *name;
+    bool is_dir;
+    // Symbolic link or other reparse point
+    bool is_link;
+} FsDirEntry;
+
+/*!
+ * @brief
+ * An open directory enumeration.
+ */
+typedef struct fs_dir FsDir;
+
+/*!
+ * @brief
+ * Identifies a file regardless of the path it was reached by, so that hard
+ * links and paths through symbolic links compare equal.
+ */
+typedef struct fs_file_id {
+    // Device number on POSIX; volume serial number on Windows
+    unsigned long long volume;
+    // Inode number on POSIX; file index on Windows
+    unsigned long long index;
+} FsFileId;
+
+/*!
+ * @brief
+ * Kind of step run by fs_batch_run().
+ */
+typedef enum fs_batch_op {
+    // Opens path into file, like fs_open()
+    FS_BATCH_OPEN,
+    // Retrieves the timestamps of file, like fs_get_times(), or of path if
+    // file is NULL, like fs_stat_times()
+    FS_BATCH_STAT,
+    // Closes file, like fs_close()
+    FS_BATCH_CLOSE
+} FsBatchOp;
+
+/*!
+ * @brief
+ * A single step of a batch run by fs_batch_run().
+ */
+typedef struct fs_batch_step {
+    FsBatchOp op;
+    // Directory that path is relative to, or NULL for the current directory
+    const FsParent *parent;
+    // Path to open or stat. Must remain valid until the file is closed
+    const TCHAR *path;
+    // FsOpenFlags. Only FS_OPEN_NOFOLLOW applies to stats by path
+    unsigned int flags;
+    FsFile *file;
+    // Receives the timestamps retrieved by FS_BATCH_STAT
+    FsTimes *times;
+    // Optionally receives the identity of the file of an FS_BATCH_STAT by path
+    FsFileId *id;
+    // Receives FS_OK if the step succeeded; the backend error code otherwise
+    FsError err;
+} FsBatchStep;
+
+/*!
+ * @brief
+ * Runs the steps of many files together. On Linux, opens and closes are
+ * submitted through io_uring, which takes one system call per batch instead
+ * of one per step and lets the kernel work on several files at once.
+ * Elsewhere, and on kernels without io_uring, steps are run one at a time.
+ */
+typedef struct fs_batch FsBatch;
+
+// Whether fs_set_times_at() changes timestamps without opening the file. If
+// so, reading times with an FS_BATCH_STAT by path and writing them back with
+// it takes fewer system calls than opening the file to do both, but Windows
+// has no way to change them other than through an open handle
+#ifdef _WIN32
+#define FS_SETS_TIMES_BY_NAME 0
+#else
+#define FS_SETS_TIMES_BY_NAME 1
+#endif
+
+/*!
+ * @brief
+ * Selects how an FsBatch runs its steps.
+ */
+typedef enum fs_batch_mode {
+    // Always one at a time, mainly useful as a baseline
+    FS_BATCH_BLOCKING,
+    // Asynchronously where that has been measured to pay off. No system has
+    // shown a win yet, so this runs the steps one at a time for now
+    FS_BATCH_AUTO,
+    // Asynchronously whenever the system allows it
+    FS_BATCH_ASYNC
+} FsBatchMode;
+
+/*!
+ * @brief
+ * The contents of a file mapped read-only into memory.
+ */
+typedef struct fs_mapping {
+    // NULL if the file is empty
+    const void *data;
+    size_t size;
+} FsMapping;
+
+/*!
+ * @brief
+ * Retrieves the calling thread's last backend error.
+ *
+ * @return
+ * The error code set by the most recent failing backend call.
+ */
+FsError fs_last_error(void);
+
+/*!
+ * @brief
+ * Checks whether an error code means that a file or one of its parent
+ * directories does not exist.
+ *
+ * @param err
+ * Error code to check.
+ *
+ * @return
+ * true if \p err indicates a missing file; false otherwise.
+ */
+bool fs_error_is_missing(FsError err);
+
+/*!
+ * @brief
+ * Opens a file for timestamp changes.
+ *
+ * @param file
+ * Pointer to an FsFile that receives the open file.
+ *
+ * @param path
+ * Path to the file. Must remain valid until the file is closed.
+ *
+ * @param flags
+ * Combination of FsOpenFlags.
+ *
+ * @return
+ * true if the file was opened; false otherwise.
+ */
+bool fs_open(FsFile *file, const TCHAR *path, unsigned int flags);
+
+/*!
+ * @brief
+ * Opens a file for timestamp changes like fs_open(), by its name within an
+ * open directory.
+ *
+ * @param parent
+ * Pointer to the directory \p name is relative to, or NULL for the current
+ * directory. Must remain open until the file is closed.
+ *
+ * @param file
+ * Pointer to an FsFile that receives the open file.
+ *
+ * @param name
+ * Name of the file, as split off by fs_parent_length(). Must remain valid
+ * until the file is closed.
+ *
+ * @param flags
+ * Combination of FsOpenFlags.
+ *
+ * @return
+ * true if the file was opened; false otherwise.
+ */
+bool fs_open_at(const FsParent *parent, FsFile *file, const TCHAR *name, unsigned int flags);
+
+/*!
+ * @brief
+ * Closes a file opened by fs_open().
+ *
+ * @param file
+ * Pointer to the file to close.
+ */
+void fs_close(FsFile *file);
+
+/*!
+ * @brief
+ * Retrieves the timestamps of an open file.
+ *
+ * @param file
+ * Pointer to an open file.
+ *
+ * @param out
+ * Pointer to an FsTimes struct that receives the timestamps.
+ *
+ * @return
+ * true if the timestamps were retrieved; false otherwise.
+ */
+bool fs_get_times(FsFile *file, FsTimes *out);
+
+/*!
+ * @brief
+ * Changes the timestamps of an open file. Members set to FS_TIME_OMIT are left
+ * unchanged, and those set to FS_TIME_NOW take the current time.
+ *
+ * @param file
+ * Pointer to an open file.
+ *
+ * @param times
+ * Pointer to the timestamps to set.
+ *
+ * @return
+ * true if the timestamps were changed; false otherwise. Backends that cannot
+ * set the creation time fail with a "not supported" error after applying the
+ * other timestamps.
+ */
+bool fs_set_times(FsFile *file, const FsTimes *times);
+
+/*!
+ * @brief
+ * Changes the last access and/or write time of an existing file with the
+ * fewest system calls the backend allows, without keeping it open.
+ *
+ * @param path
+ * Path to the file.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param times
+ * Pointer to the timestamps to set. The creation member must be FS_TIME_OMIT.
+ *
+ * @return
+ * true if the timestamps were changed; false otherwise.
+ */
+bool fs_set_times_by_path(
+    const TCHAR *path, bool follow_symlinks,
+    const FsTimes *times);
+
+/*!
+ * @brief
+ * Changes the last access and/or write time of an existing file like
+ * fs_set_times_by_path(), by its name within an open directory.
+ *
+ * @param parent
+ * Pointer to the directory \p name is relative to, or NULL for the current
+ * directory.
+ *
+ * @param name
+ * Name of the file, as split off by fs_parent_length().
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param times
+ * Pointer to the timestamps to set. The creation member must be FS_TIME_OMIT.
+ *
+ * @return
+ * true if the timestamps were changed; false otherwise.
+ */
+bool fs_set_times_at(
+    const FsParent *parent, const TCHAR *name,
+    bool follow_symlinks, const FsTimes *times);
+
+/*!
+ * @brief
+ * Retrieves the timestamps of a file without opening it for writing.
+ *
+ * @param path
+ * Path to the file.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or query the links themselves.
+ *
+ * @param out
+ * Pointer to an FsTimes struct that receives the timestamps.
+ *
+ * @return
+ * true if the timestamps were retrieved; false otherwise.
+ */
+bool fs_stat_times(const TCHAR *path, bool follow_symlinks, FsTimes *out);
+
+/*!
+ * @brief
+ * Retrieves the timestamps of a file like fs_stat_times(), along with the
+ * granularity at which its file system stores each of them. Granularity is
+ * looked up once per volume and remembered.
+ *
+ * @param path
+ * Path to the file.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or query the links themselves.
+ *
+ * @param out
+ * Pointer to an FsTimes struct that receives the timestamps.
+ *
+ * @param granularity
+ * Pointer to an FsTimes struct that receives, for each timestamp, the number
+ * of ticks the file system rounds it to. This is 1 for file systems that are
+ * as precise as FsTime and for those that cannot be identified.
+ *
+ * @return
+ * true if the timestamps were retrieved; false otherwise.
+ */
+bool fs_stat_times_granular(
+    const TCHAR *path, bool follow_symlinks,
+    FsTimes *out, FsTimes *granularity);
+
+/*!
+ * @brief
+ * Checks whether a path refers to a directory.
+ *
+ * @param path
+ * Path to check.
+ *
+ * @param follow_symlinks
+ * If true, a symbolic link to a directory counts as a directory.
+ *
+ * @return
+ * true if \p path is a directory; false otherwise.
+ */
+bool fs_is_directory(const TCHAR *path, bool follow_symlinks);
+
+/*!
+ * @brief
+ * Starts enumerating a directory.
+ *
+ * @param path
+ * Path to the directory.
+ *
+ * @return
+ * Pointer to a new FsDir, or NULL on failure.
+ */
+FsDir *fs_dir_open(const TCHAR *path);
+
+/*!
+ * @brief
+ * Retrieves the next entry of a directory, skipping "." and "..".
+ *
+ * @param dir
+ * Pointer to an open FsDir.
+ *
+ * @param out
+ * Pointer to an FsDirEntry that receives the entry.
+ *
+ * @param err
+ * Pointer to an FsError that receives FS_OK once the enumeration is exhausted,
+ * or the error code that ended it prematurely.
+ *
+ * @return
+ * true if an entry was retrieved; false if there are none left.
+ */
+bool fs_dir_next(FsDir *dir, FsDirEntry *out, FsError *err);
+
+/*!
+ * @brief
+ * Ends a directory enumeration and frees its resources.
+ *
+ * @param dir
+ * Enumeration to close. If NULL, no action is taken.
+ */
+void fs_dir_close(FsDir *dir);
+
+/*!
+ * @brief
+ * Finds where the name of a file starts within its path, so that the file can
+ * be reached through fs_parent_open() on the part before it and the *_at()
+ * functions on the name.
+ *
+ * @param path
+ * Path to split.
+ *
+ * @return
+ * The length of the directory part, including its trailing separator, or 0 if
+ * \p path has no directory part, or if its name would mean something else
+ * when looked up on its own (like a trailing separator, or a reserved device
+ * name on Windows). Such paths must be used whole.
+ */
+size_t fs_parent_length(const TCHAR *path);
+
+/*!
+ * @brief
+ * Opens a directory for use as the parent of the *_at() functions.
+ *
+ * @param parent
+ * Pointer to an FsParent that receives the open directory.
+ *
+ * @param path
+ * Path to the directory. Symbolic links are followed, as they are when the
+ * directory is part of a longer path.
+ *
+ * @return
+ * true if the directory was opened; false otherwise.
+ */
+bool fs_parent_open(FsParent *parent, const TCHAR *path);
+
+/*!
+ * @brief
+ * Closes a directory opened by fs_parent_open().
+ *
+ * @param parent
+ * Pointer to the directory to close.
+ */
+void fs_parent_close(FsParent *parent);
+
+/*!
+ * @brief
+ * Creates a batch executor.
+ *
+ * @param mode
+ * How the executor runs its steps.
+ *
+ * @return
+ * Pointer to a new FsBatch, or NULL if memory could not be allocated.
+ */
+FsBatch *fs_batch_open(FsBatchMode mode);
+
+/*!
+ * @brief
+ * Checks whether a batch executor runs steps asynchronously.
+ *
+ * @param batch
+ * Pointer to an open FsBatch.
+ */
+bool fs_batch_is_async(const FsBatch *batch);
+
+/*!
+ * @brief
+ * Runs a set of independent steps and waits for all of them to complete. The
+ * steps may run in any order and concurrently, so a step must not depend on
+ * another step of the same call.
+ *
+ * @param batch
+ * Pointer to an open FsBatch.
+ *
+ * @param steps
+ * Array of steps to run. The outcome of each is stored in its err member.
+ *
+ * @param count
+ * Number of elements in \p steps.
+ */
+void fs_batch_run(FsBatch *batch, FsBatchStep *steps, size_t count);
+
+/*!
+ * @brief
+ * Destroys a batch executor and frees its resources.
+ *
+ * @param batch
+ * Executor to close. If NULL, no action is taken.
+ */
+void fs_batch_close(FsBatch *batch);
+
+/*!
+ * @brief
+ * Maps the whole of an existing file into memory for reading.
+ *
+ * @param path
+ * Path to the file.
+ *
+ * @param out
+ * Pointer to an FsMapping that receives the mapping.
+ *
+ * @return
+ * true if the file was mapped; false otherwise.
+ */
+bool fs_map_file(const TCHAR *path, FsMapping *out);
+
+/*!
+ * @brief
+ * Unmaps a file mapped by fs_map_file().
+ *
+ * @param map
+ * Pointer to the mapping to release.
+ */
+void fs_unmap_file(FsMapping *map);
+
+/*!
+ * @brief
+ * Retrieves the current time of day.
+ *
+ * @return
+ * The current UTC time.
+ */
+FsTime fs_now(void);
+
+/*!
+ * @brief
+ * Converts a UTC calendar date and time to an FsTime.
+ *
+ * @param st
+ * Pointer to the UTC date and time to convert.
+ *
+ * @param out
+ * Pointer to an FsTime that receives the converted time.
+ *
+ * @return
+ * true if the conversion was successful; false otherwise.
+ */
+bool fs_systemtime_to_time(const SYSTEMTIME *st, FsTime *out);
+
+/*!
+ * @brief
+ * Converts an FsTime to a UTC calendar date and time.
+ *
+ * @param time
+ * The time to convert.
+ *
+ * @param out
+ * Pointer to a SYSTEMTIME that receives the converted date and time.
+ *
+ * @return
+ * true if the conversion was successful; false otherwise.
+ */
+bool fs_time_to_systemtime(FsTime time, SYSTEMTIME *out);
+
+/*!
+ * @brief
+ * Converts a date and time in the local time zone to an FsTime, honoring the
+ * daylight saving rules in effect at that time.
+ *
+ * @param st
+ * Pointer to the local date and time to convert.
+ *
+ * @param out
+ * Pointer to an FsTime that receives the UTC time.
+ *
+ * @return
+ * true if the conversion was successful; false otherwise.
+ */
+bool fs_local_systemtime_to_time(const SYSTEMTIME *st, FsTime *out);
+
+#endif // FSBACKEND_H
@@ -1,7 +1,7 @@
 ﻿#ifndef GETOPT_H
 #define GETOPT_H
 
-#include <tchar.h>
+#include "platform.h"
 
 #define GETOPT_ERR_OPT_UNKNOWN 1
 #define GETOPT_ERR_OPT_REQ_ARG 2
@@ -0,0 +1,121 @@
+/* ipc.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Local connections between processes of the same machine. An address is the
+// path of a Unix domain socket on POSIX systems, and the name of a pipe on
+// Windows, where "\\.\pipe\" is prepended unless the name already starts with
+// it. On failure, fs_last_error() describes the error.
+
+// How long the server's end of a connection waits on each read or write
+// before it fails, so that a client that stops sending or reading cannot hold
+// a thread of the server forever
+#ifndef IPC_SERVER_TIMEOUT_MS
+#define IPC_SERVER_TIMEOUT_MS 5000
+#endif
+
+/*!
+ * @brief
+ * An address that accepts connections.
+ */
+typedef struct ipc_server IpcServer;
+
+/*!
+ * @brief
+ * A connection between two processes, which carries a stream of bytes in
+ * both directions.
+ */
+typedef struct ipc_conn IpcConn;
+
+/*!
+ * @brief
+ * Starts accepting connections at an address. A Unix domain socket left
+ * behind by a server that is no longer running is replaced.
+ *
+ * @param address
+ * The address to accept connections at.
+ *
+ * @return
+ * Pointer to a new IpcServer, or NULL if another server uses the address or
+ * it could not be created.
+ */
+IpcServer *ipc_listen(const TCHAR *address);
+
+/*!
+ * @brief
+ * Waits for a client to connect. Several threads may wait on the same server
+ * at once, and each connection goes to one of them. Reads and writes on the
+ * connection fail once they wait longer than IPC_SERVER_TIMEOUT_MS.
+ *
+ * @return
+ * Pointer to the new connection, or NULL on error.
+ */
+IpcConn *ipc_accept(IpcServer *server);
+
+/*!
+ * @brief
+ * Stops accepting connections, removes the address and frees the server.
+ * Must not be called while other threads wait in ipc_accept().
+ *
+ * @param server
+ * Pointer to the server. If NULL, no action is taken.
+ */
+void ipc_server_close(IpcServer *server);
+
+/*!
+ * @brief
+ * Connects to a server.
+ *
+ * @param address
+ * The address of the server.
+ *
+ * @return
+ * Pointer to the new connection, or NULL if no server accepts connections
+ * at the address.
+ */
+IpcConn *ipc_connect(const TCHAR *address);
+
+/*!
+ * @brief
+ * Reads the next bytes sent by the other side, up to \p capacity of them.
+ *
+ * @param received
+ * Pointer to a size_t that receives the number of bytes read, which is 0 once
+ * the other side is done sending.
+ *
+ * @return
+ * true if the read succeeded; false otherwise.
+ */
+bool ipc_read(IpcConn *conn, void *buf, size_t capacity, size_t *received);
+
+/*!
+ * @brief
+ * Sends all of \p size bytes to the other side.
+ *
+ * @return
+ * true if every byte was sent; false otherwise.
+ */
+bool ipc_write(IpcConn *conn, const void *buf, size_t size);
+
+/*!
+ * @brief
+ * Closes a connection. What was written to it can still be read by the other
+ * side, which is not waited for.
+ *
+ * @param conn
+ * Pointer to the connection. If NULL, no action is taken.
+ */
+void ipc_close(IpcConn *conn);
+
+#endif // IPC_H
@@ -0,0 +1,264 @@
+/* ipc_posix.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef _WIN32
+
+#include "ipc.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A write to a connection the other side closed fails with EPIPE rather than
+// raising SIGPIPE, where the flag exists
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+struct ipc_server {
+    int fd;
+    struct sockaddr_un addr;
+};
+
+struct ipc_conn {
+    int fd;
+};
+
+/*!
+ * @brief
+ * Fills in the socket address of a path.
+ *
+ * @return
+ * true if the path fits in the address; false otherwise.
+ */
+static bool make_address(const char *path, struct sockaddr_un *addr) {
+    size_t len = strlen(path);
+
+    if (len == 0 || len >= sizeof(addr->sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    memcpy(addr->sun_path, path, len + 1);
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Checks whether a server accepts connections at a socket address.
+ */
+static bool address_is_live(const struct sockaddr_un *addr) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        // Assume the worst, so a running server is never unlinked
+        return true;
+    }
+
+    bool live = connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) == 0 ||
+        errno != ECONNREFUSED;
+
+    close(fd);
+
+    return live;
+}
+
+IpcServer *ipc_listen(const TCHAR *address) {
+    IpcServer *server = malloc(sizeof(IpcServer));
+
+    if (!server) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    if (!make_address(address, &server->addr)) {
+        free(server);
+        return NULL;
+    }
+
+    server->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    bool ok = server->fd >= 0;
+
+    if (ok && bind(server->fd, (struct sockaddr *)&server->addr, sizeof(server->addr)) != 0) {
+        ok = false;
+
+        // A socket whose server is gone refuses connections, and is replaced
+        if (errno == EADDRINUSE) {
+            if (address_is_live(&server->addr)) {
+                errno = EADDRINUSE;
+            } else {
+                ok = unlink(address) == 0 &&
+                    bind(server->fd, (struct sockaddr *)&server->addr, sizeof(server->addr)) == 0;
+            }
+        }
+    }
+
+    if (ok && listen(server->fd, SOMAXCONN) != 0) {
+        int err = errno;
+
+        unlink(address);
+        errno = err;
+        ok = false;
+    }
+
+    if (!ok) {
+        int err = errno;
+
+        if (server->fd >= 0) {
+            close(server->fd);
+        }
+
+        free(server);
+        errno = err;
+
+        return NULL;
+    }
+
+    return server;
+}
+
+IpcConn *ipc_accept(IpcServer *server) {
+    int fd;
+
+    do {
+        fd = accept(server->fd, NULL, NULL);
+    } while (fd < 0 && errno == EINTR);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    // A read or write that times out fails with EAGAIN
+    struct timeval timeout = {
+        .tv_sec = IPC_SERVER_TIMEOUT_MS / 1000,
+        .tv_usec = (IPC_SERVER_TIMEOUT_MS % 1000) * 1000
+    };
+
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+        int err = errno;
+
+        close(fd);
+        errno = err;
+
+        return NULL;
+    }
+
+    IpcConn *conn = malloc(sizeof(IpcConn));
+
+    if (!conn) {
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    conn->fd = fd;
+
+    return conn;
+}
+
+void ipc_server_close(IpcServer *server) {
+    if (!server) {
+        return;
+    }
+
+    close(server->fd);
+    unlink(server->addr.sun_path);
+    free(server);
+}
+
+IpcConn *ipc_connect(const TCHAR *address) {
+    struct sockaddr_un addr;
+
+    if (!make_address(address, &addr)) {
+        return NULL;
+    }
+
+    IpcConn *conn = malloc(sizeof(IpcConn));
+
+    if (!conn) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    conn->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    bool ok = conn->fd >= 0;
+
+    while (ok && connect(conn->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ok = errno == EINTR;
+    }
+
+    if (!ok) {
+        int err = errno;
+
+        if (conn->fd >= 0) {
+            close(conn->fd);
+        }
+
+        free(conn);
+        errno = err;
+
+        return NULL;
+    }
+
+    return conn;
+}
+
+bool ipc_read(IpcConn *conn, void *buf, size_t capacity, size_t *received) {
+    ssize_t n;
+
+    do {
+        n = read(conn->fd, buf, capacity);
+    } while (n < 0 && errno == EINTR);
+
+    *received = (n > 0) ? (size_t)n : 0;
+
+    return n >= 0;
+}
+
+bool ipc_write(IpcConn *conn, const void *buf, size_t size) {
+    const char *data = buf;
+
+    while (size > 0) {
+        ssize_t n = send(conn->fd, data, size, SEND_FLAGS);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            return false;
+        }
+
+        data += n;
+        size -= (size_t)n;
+    }
+
+    return true;
+}
+
+void ipc_close(IpcConn *conn) {
+    if (!conn) {
+        return;
+    }
+
+    close(conn->fd);
+    free(conn);
+}
+
+#endif // !_WIN32
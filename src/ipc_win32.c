@@ -0,0 +1,348 @@
+/* ipc_win32.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifdef _WIN32
+
+#include "ipc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#define PIPE_PREFIX _T("\\\\.\\pipe\\")
+
+// Size of the buffers the system keeps for each direction of a pipe instance
+#define PIPE_BUFFER_SIZE 65536
+
+// How long a client waits for a busy server to offer another pipe instance
+#define CONNECT_TIMEOUT_MS 5000
+
+struct ipc_server {
+    mtx_t lock;
+    // The first instance of the pipe, which ipc_listen() creates to claim the
+    // name, until a thread waits for a client on it
+    HANDLE first;
+    TCHAR *name;
+};
+
+struct ipc_conn {
+    HANDLE pipe;
+    // Event that overlapped operations on the server's end signal, so that
+    // they can be waited for with a timeout, or NULL on the client's end,
+    // whose operations block
+    HANDLE event;
+};
+
+/*!
+ * @brief
+ * Gets the full name of the pipe at an address.
+ *
+ * @return
+ * Pointer to the name, which must be freed, or NULL on allocation failure.
+ */
+static TCHAR *pipe_name(const TCHAR *address) {
+    size_t prefix_len = _tcslen(PIPE_PREFIX);
+    size_t len = _tcslen(address);
+    bool has_prefix = len >= prefix_len && _tcsnicmp(address, PIPE_PREFIX, prefix_len) == 0;
+
+    TCHAR *name = malloc((prefix_len + len + 1) * sizeof(TCHAR));
+
+    if (!name) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    size_t pos = 0;
+
+    if (!has_prefix) {
+        memcpy(name, PIPE_PREFIX, prefix_len * sizeof(TCHAR));
+        pos = prefix_len;
+    }
+
+    memcpy(&name[pos], address, (len + 1) * sizeof(TCHAR));
+
+    return name;
+}
+
+static HANDLE create_instance(const TCHAR *name, bool first) {
+    DWORD open_mode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED;
+
+    // Fails if the name is already taken by another server
+    if (first) {
+        open_mode |= FILE_FLAG_FIRST_PIPE_INSTANCE;
+    }
+
+    return CreateNamedPipe(
+        name, open_mode,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES,
+        PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, NULL);
+}
+
+/*!
+ * @brief
+ * Waits for an overlapped operation to complete, and cancels it once it has
+ * waited longer than \p timeout_ms.
+ *
+ * @param started
+ * The result of the call that started the operation.
+ *
+ * @return
+ * true if the operation succeeded; false otherwise.
+ */
+static bool finish_overlapped(
+    HANDLE pipe, OVERLAPPED *ov, BOOL started, DWORD timeout_ms, DWORD *transferred) {
+
+    if (!started && GetLastError() != ERROR_IO_PENDING) {
+        return false;
+    }
+
+    // The operation may still use its buffer until the cancellation is done,
+    // which is waited for below. It may also complete in the meantime
+    if (WaitForSingleObject(ov->hEvent, timeout_ms) == WAIT_TIMEOUT) {
+        CancelIoEx(pipe, ov);
+    }
+
+    return GetOverlappedResult(pipe, ov, transferred, TRUE);
+}
+
+IpcServer *ipc_listen(const TCHAR *address) {
+    IpcServer *server = calloc(1, sizeof(IpcServer));
+
+    if (!server) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    server->name = pipe_name(address);
+    server->first = INVALID_HANDLE_VALUE;
+
+    bool ok = server->name != NULL;
+
+    if (ok && mtx_init(&server->lock, mtx_plain) != thrd_success) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        ok = false;
+    }
+
+    if (ok) {
+        server->first = create_instance(server->name, true);
+
+        if (server->first == INVALID_HANDLE_VALUE) {
+            mtx_destroy(&server->lock);
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        DWORD err = GetLastError();
+
+        free(server->name);
+        free(server);
+
+        SetLastError(err);
+        return NULL;
+    }
+
+    return server;
+}
+
+IpcConn *ipc_accept(IpcServer *server) {
+    mtx_lock(&server->lock);
+
+    HANDLE pipe = server->first;
+    server->first = INVALID_HANDLE_VALUE;
+
+    mtx_unlock(&server->lock);
+
+    // Each waiting thread offers an instance of its own, so that as many
+    // clients are served at once as there are threads
+    if (pipe == INVALID_HANDLE_VALUE) {
+        pipe = create_instance(server->name, false);
+
+        if (pipe == INVALID_HANDLE_VALUE) {
+            return NULL;
+        }
+    }
+
+    HANDLE event = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    if (!event) {
+        DWORD err = GetLastError();
+
+        CloseHandle(pipe);
+
+        SetLastError(err);
+        return NULL;
+    }
+
+    OVERLAPPED ov = { .hEvent = event };
+    DWORD unused;
+
+    // A client that connected before the wait started is reported as an
+    // error, without signaling the event
+    if (!ConnectNamedPipe(pipe, &ov) && GetLastError() != ERROR_PIPE_CONNECTED &&
+        !finish_overlapped(pipe, &ov, FALSE, INFINITE, &unused)) {
+        DWORD err = GetLastError();
+
+        CloseHandle(event);
+        CloseHandle(pipe);
+
+        SetLastError(err);
+        return NULL;
+    }
+
+    IpcConn *conn = malloc(sizeof(IpcConn));
+
+    if (!conn) {
+        DisconnectNamedPipe(pipe);
+        CloseHandle(event);
+        CloseHandle(pipe);
+
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    conn->pipe = pipe;
+    conn->event = event;
+
+    return conn;
+}
+
+void ipc_server_close(IpcServer *server) {
+    if (!server) {
+        return;
+    }
+
+    // The name is released along with its last instance
+    if (server->first != INVALID_HANDLE_VALUE) {
+        CloseHandle(server->first);
+    }
+
+    mtx_destroy(&server->lock);
+    free(server->name);
+    free(server);
+}
+
+IpcConn *ipc_connect(const TCHAR *address) {
+    TCHAR *name = pipe_name(address);
+
+    if (!name) {
+        return NULL;
+    }
+
+    HANDLE pipe;
+
+    for (;;) {
+        pipe = CreateFile(
+            name, GENERIC_READ | GENERIC_WRITE,
+            0, NULL, OPEN_EXISTING, 0, NULL);
+
+        // Every instance is taken, so wait for the server to offer another
+        if (pipe != INVALID_HANDLE_VALUE || GetLastError() != ERROR_PIPE_BUSY ||
+            !WaitNamedPipe(name, CONNECT_TIMEOUT_MS)) {
+            break;
+        }
+    }
+
+    DWORD err = GetLastError();
+    free(name);
+
+    if (pipe == INVALID_HANDLE_VALUE) {
+        SetLastError(err);
+        return NULL;
+    }
+
+    IpcConn *conn = malloc(sizeof(IpcConn));
+
+    if (!conn) {
+        CloseHandle(pipe);
+
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    conn->pipe = pipe;
+    conn->event = NULL;
+
+    return conn;
+}
+
+bool ipc_read(IpcConn *conn, void *buf, size_t capacity, size_t *received) {
+    DWORD size = (capacity > MAXDWORD) ? MAXDWORD : (DWORD)capacity;
+    DWORD n = 0;
+
+    *received = 0;
+
+    bool ok;
+
+    if (conn->event) {
+        OVERLAPPED ov = { .hEvent = conn->event };
+
+        ok = finish_overlapped(
+            conn->pipe, &ov, ReadFile(conn->pipe, buf, size, NULL, &ov),
+            IPC_SERVER_TIMEOUT_MS, &n);
+    } else {
+        ok = ReadFile(conn->pipe, buf, size, &n, NULL);
+    }
+
+    if (!ok) {
+        // The other side closed its end, which ends the stream
+        return GetLastError() == ERROR_BROKEN_PIPE;
+    }
+
+    *received = n;
+
+    return true;
+}
+
+bool ipc_write(IpcConn *conn, const void *buf, size_t size) {
+    const char *data = buf;
+
+    while (size > 0) {
+        DWORD chunk = (size > MAXDWORD) ? MAXDWORD : (DWORD)size;
+        DWORD n;
+        bool ok;
+
+        if (conn->event) {
+            OVERLAPPED ov = { .hEvent = conn->event };
+
+            ok = finish_overlapped(
+                conn->pipe, &ov, WriteFile(conn->pipe, data, chunk, NULL, &ov),
+                IPC_SERVER_TIMEOUT_MS, &n);
+        } else {
+            ok = WriteFile(conn->pipe, data, chunk, &n, NULL);
+        }
+
+        if (!ok) {
+            return false;
+        }
+
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+void ipc_close(IpcConn *conn) {
+    if (!conn) {
+        return;
+    }
+
+    // Each instance of the pipe serves one connection, so the server's end is
+    // closed rather than disconnected, which would throw away a reply the
+    // client has yet to read. Nor does it wait for the client to read it with
+    // FlushFileBuffers(), which a client that never reads would block forever
+    if (conn->event) {
+        CloseHandle(conn->event);
+    }
+
+    CloseHandle(conn->pipe);
+    free(conn);
+}
+
+#endif // _WIN32
@@ -0,0 +1,185 @@
+/* libtouch.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "libtouch.h"
+#include "touchop.h"
+#include "timeparse.h"
+
+#include <stdlib.h>
+#include <threads.h>
+
+_Static_assert(
+    (int)TOUCH_TIME_CREATION == (int)FT_CREATION &&
+    (int)TOUCH_TIME_ACCESS == (int)FT_ACCESS &&
+    (int)TOUCH_TIME_WRITE == (int)FT_WRITE,
+    "TouchTimes must match FileTimeFlags");
+
+#define TOUCH_TIME_ALL (TOUCH_TIME_CREATION | TOUCH_TIME_ACCESS | TOUCH_TIME_WRITE)
+
+struct touch_op {
+    TimestampOperation op;
+    bool existing_only;
+    bool follow_symlinks;
+    // Opened by the first batch of more than one file, since a caller that
+    // touches one file at a time has no use for it
+    FsBatch *executor;
+    // Thread that opened executor. An io_uring ring only takes steps from the
+    // thread that set it up, so another thread opens an executor of its own
+    thrd_t owner;
+    TouchWorkspace *workspace;
+    // Outcomes of the files of a batch, as touch_many() reports them
+    TouchStatus *status;
+    size_t status_capacity;
+};
+
+static void fail_spec(TouchSpecError *why, TouchSpecError err) {
+    if (why) {
+        *why = err;
+    }
+}
+
+TouchOp *touch_op_open(const TouchSpec *spec, TouchSpecError *why) {
+    FileTimeFlags ft_flags = (FileTimeFlags)spec->times;
+
+    if (ft_flags & ~TOUCH_TIME_ALL) {
+        fail_spec(why, TOUCH_SPEC_BAD_TIMES);
+        return NULL;
+    }
+
+    // Same default as the command line
+    if (ft_flags == 0) {
+        ft_flags = FT_ACCESS | FT_WRITE;
+    }
+
+    FsTime stamp, *stamp_ptr = NULL;
+    FsTimes ref_stamps, *ref_stamps_ptr = NULL;
+    int adjustment_seconds = 0;
+
+    if (spec->stamp) {
+        if (!parse_timestamp_string(spec->stamp, &stamp)) {
+            fail_spec(why, TOUCH_SPEC_BAD_STAMP);
+            return NULL;
+        }
+
+        stamp_ptr = &stamp;
+    }
+
+    if (spec->adjust && !parse_hhmmss(spec->adjust, &adjustment_seconds)) {
+        fail_spec(why, TOUCH_SPEC_BAD_ADJUST);
+        return NULL;
+    }
+
+    if (spec->ref_path) {
+        if (!get_ref_timestamps(spec->ref_path, &ref_stamps)) {
+            fail_spec(why, TOUCH_SPEC_BAD_REF);
+            return NULL;
+        }
+
+        ref_stamps_ptr = &ref_stamps;
+    }
+
+    TouchOp *op = calloc(1, sizeof(TouchOp));
+
+    if (!op) {
+        fail_spec(why, TOUCH_SPEC_NO_MEMORY);
+        return NULL;
+    }
+
+    op->op = prepare_timestamp(stamp_ptr, ref_stamps_ptr, ft_flags, adjustment_seconds);
+    op->existing_only = spec->no_create;
+    op->follow_symlinks = !spec->no_dereference;
+
+    fail_spec(why, TOUCH_SPEC_OK);
+
+    return op;
+}
+
+/*!
+ * @brief
+ * Gets what touch_many() needs for a batch of \p count files, opening or
+ * growing it if needed.
+ *
+ * @return
+ * false if memory could not be allocated, in which case the files are to be
+ * touched one at a time.
+ */
+static bool prepare_batch(TouchOp *op, size_t count) {
+    thrd_t self = thrd_current();
+
+    if (op->executor && !thrd_equal(op->owner, self)) {
+        fs_batch_close(op->executor);
+        op->executor = NULL;
+    }
+
+    if (!op->executor) {
+        op->executor = fs_batch_open(FS_BATCH_AUTO);
+        op->owner = self;
+    }
+
+    if (!op->workspace) {
+        op->workspace = touch_workspace_open();
+    }
+
+    if (!op->executor || !op->workspace) {
+        return false;
+    }
+
+    if (count > op->status_capacity) {
+        TouchStatus *status = realloc(op->status, count * sizeof(TouchStatus));
+
+        if (!status) {
+            return false;
+        }
+
+        op->status = status;
+        op->status_capacity = count;
+    }
+
+    return true;
+}
+
+size_t touch_batch(
+    const TCHAR *const *paths, size_t count,
+    TouchOp *op, TouchResult *results) {
+
+    size_t failed = 0;
+
+    if (count > 1 && prepare_batch(op, count)) {
+        touch_many(
+            op->executor, op->workspace,
+            paths, count,
+            op->existing_only, op->follow_symlinks,
+            &op->op, NULL, op->status);
+
+        for (size_t i = 0; i < count; i++) {
+            results[i] = (TouchResult) { op->status[i].ok, op->status[i].err };
+            failed += !results[i].ok;
+        }
+
+        return failed;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        bool ok = touch(paths[i], op->existing_only, op->follow_symlinks, &op->op);
+
+        results[i] = (TouchResult) { ok, ok ? FS_OK : fs_last_error() };
+        failed += !ok;
+    }
+
+    return failed;
+}
+
+void touch_op_close(TouchOp *op) {
+    if (!op) {
+        return;
+    }
+
+    fs_batch_close(op->executor);
+    touch_workspace_close(op->workspace);
+    free(op->status);
+    free(op);
+}
@@ -0,0 +1,148 @@
+/* libtouch.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef LIBTOUCH_H
+#define LIBTOUCH_H
+
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The library interface to touch, for programs that touch files themselves
+// rather than start a touch process for it. An operation is built once from
+// a TouchSpec, which takes the same arguments as the options of the command,
+// and then applied to batch after batch of files with touch_batch(). Nothing
+// is printed, and the outcome of each file is returned to the caller.
+//
+// Everything declared here is kept compatible from one release to the next.
+// Other headers of the source tree are internal to it.
+
+#define LIBTOUCH_VERSION_MAJOR 1
+#define LIBTOUCH_VERSION_MINOR 0
+
+/*!
+ * @brief
+ * Selects the file timestamps an operation changes.
+ */
+typedef enum touch_times {
+    // As -C
+    TOUCH_TIME_CREATION = 1 << 0,
+    // As -a
+    TOUCH_TIME_ACCESS = 1 << 1,
+    // As -m
+    TOUCH_TIME_WRITE = 1 << 2
+} TouchTimes;
+
+/*!
+ * @brief
+ * Describes an operation, the way the command line options do. A zeroed
+ * TouchSpec describes touch with no options: files are created if missing,
+ * and their access and modification times are set to the current time.
+ */
+typedef struct touch_spec {
+    // Any of the TouchTimes flags, or 0 for access and modification times
+    unsigned int times;
+    // Arguments of the -t, -r and -A options, or NULL
+    const TCHAR *stamp;
+    const TCHAR *ref_path;
+    const TCHAR *adjust;
+    // As -c
+    bool no_create;
+    // As -d
+    bool no_dereference;
+} TouchSpec;
+
+/*!
+ * @brief
+ * Reasons touch_op_open() rejects a TouchSpec.
+ */
+typedef enum touch_spec_error {
+    TOUCH_SPEC_OK,
+    // times has flags other than the TouchTimes ones
+    TOUCH_SPEC_BAD_TIMES,
+    // stamp is not a valid timestamp
+    TOUCH_SPEC_BAD_STAMP,
+    // adjust is not a valid offset
+    TOUCH_SPEC_BAD_ADJUST,
+    // The timestamps of ref_path could not be read
+    TOUCH_SPEC_BAD_REF,
+    TOUCH_SPEC_NO_MEMORY
+} TouchSpecError;
+
+/*!
+ * @brief
+ * Outcome of touching a single file.
+ */
+typedef struct touch_result {
+    // Whether the file was touched, or is missing and no_create is set
+    bool ok;
+    // Why the file could not be touched, if ok is false. This is a Win32 error
+    // code on Windows and an errno value elsewhere
+    unsigned long error;
+} TouchResult;
+
+typedef struct touch_op TouchOp;
+
+/*!
+ * @brief
+ * Builds an operation. The timestamps of \c ref_path, and \c stamp, are read
+ * here once, while an operation without either takes the current time at each
+ * touch_batch().
+ *
+ * @param spec
+ * Pointer to the TouchSpec describing the operation. It is not referred to
+ * once this returns.
+ *
+ * @param why
+ * Optional pointer to a TouchSpecError that receives the reason for a failure.
+ *
+ * @return
+ * Pointer to the operation, or NULL on failure.
+ */
+TouchOp *touch_op_open(const TouchSpec *spec, TouchSpecError *why);
+
+/*!
+ * @brief
+ * Touches files with an operation. The files of a directory are opened and
+ * closed together, as touch -j 1 does with its operands.
+ *
+ * An operation keeps the memory this needs for the next call, so that calls
+ * with no more files than the largest one before allocate nothing. It can be
+ * used by one thread at a time, and passed from one thread to another between
+ * calls; threads that touch files at the same time each need an operation of
+ * their own.
+ *
+ * @param paths
+ * Array of paths to the files to touch.
+ *
+ * @param count
+ * Number of elements in \p paths.
+ *
+ * @param op
+ * Pointer to the operation to apply to every file.
+ *
+ * @param results
+ * Array that receives the outcome of each file, indexed like \p paths.
+ *
+ * @return
+ * Number of files that could not be touched.
+ */
+size_t touch_batch(
+    const TCHAR *const *paths, size_t count,
+    TouchOp *op, TouchResult *results);
+
+/*!
+ * @brief
+ * Frees an operation built by touch_op_open().
+ *
+ * @param op
+ * The operation to free. If NULL, no action is taken.
+ */
+void touch_op_close(TouchOp *op);
+
+#endif // LIBTOUCH_H
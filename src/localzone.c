@@ -0,0 +1,770 @@
+/* localzone.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "localzone.h"
+#include "caltime.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#ifndef _WIN32
+#include <stdio.h>
+#endif
+
+// Recurring DST rules are expanded into transitions up to the end of this
+// year. Later times are converted by the backend
+#define RULE_YEAR_MAX 2100
+
+/*!
+ * @brief
+ * A change of the UTC offset of the local time zone.
+ */
+typedef struct transition {
+    // Time of the change, in ticks since 1601 (UTC)
+    int64_t at;
+    // Local time at the moment of the change, read with the offset before it
+    int64_t local_at;
+    // Offsets from UTC before and after the change, in ticks
+    int64_t offset_before;
+    int64_t offset;
+} Transition;
+
+/*!
+ * @brief
+ * The transitions of the local time zone, sorted by time.
+ */
+typedef struct zone_table {
+    Transition *items;
+    size_t count;
+    size_t capacity;
+    // Offset in effect before the first transition
+    int64_t initial_offset;
+    // Range of UTC times the table covers, [from, until)
+    int64_t from;
+    int64_t until;
+    bool loaded;
+} ZoneTable;
+
+static ZoneTable zone;
+static once_flag zone_once = ONCE_FLAG_INIT;
+
+static bool table_add(ZoneTable *table, int64_t at, int64_t offset) {
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 256;
+        Transition *items = realloc(table->items, capacity * sizeof(Transition));
+
+        if (!items) {
+            return false;
+        }
+
+        table->items = items;
+        table->capacity = capacity;
+    }
+
+    table->items[table->count++] = (Transition) {
+        .at = at,
+        .offset = offset
+    };
+
+    return true;
+}
+
+static int compare_transitions(const void *a, const void *b) {
+    int64_t at_a = ((const Transition *)a)->at;
+    int64_t at_b = ((const Transition *)b)->at;
+
+    return (at_a > at_b) - (at_a < at_b);
+}
+
+/*!
+ * @brief
+ * Sorts the transitions, drops those that don't change the offset and fills
+ * in the fields derived from the previous transition.
+ */
+static void table_finish(ZoneTable *table) {
+    // Zones without transitions never allocate the table
+    if (table->count > 0) {
+        qsort(table->items, table->count, sizeof(Transition), compare_transitions);
+    }
+
+    int64_t offset = table->initial_offset;
+    size_t kept = 0;
+
+    for (size_t i = 0; i < table->count; i++) {
+        Transition t = table->items[i];
+
+        if (t.offset == offset) {
+            continue;
+        }
+
+        t.offset_before = offset;
+        t.local_at = t.at + offset;
+        table->items[kept++] = t;
+
+        offset = t.offset;
+    }
+
+    table->count = kept;
+    table->loaded = true;
+}
+
+/*!
+ * @brief
+ * Finds the n-th occurrence of a day of the week in a month, the way both
+ * POSIX TZ rules and Windows time zone information describe transitions.
+ *
+ * @param week
+ * Occurrence of the day in the month (1-5), where 5 means the last one.
+ *
+ * @param weekday
+ * Day of the week, where Sunday=0, Monday=1, ..., Saturday=6.
+ *
+ * @return
+ * The number of days since January 1, 1601.
+ */
+static int32_t nth_weekday(int32_t year, int32_t month, int32_t week, int32_t weekday) {
+    int32_t first = cal_days_from_civil(year, month, 1);
+    int32_t days = first + (weekday - cal_day_of_week(first) + 7) % 7 + (week - 1) * 7;
+
+    while (days - first >= cal_days_in_month(year, month)) {
+        days -= 7;
+    }
+
+    return days;
+}
+
+#ifdef _WIN32
+// Windows only records the DST rules of past years back to 1970 or so
+#define RULE_YEAR_MIN 1970
+
+/*!
+ * @brief
+ * Resolves the date of a transition from TIME_ZONE_INFORMATION to local time.
+ */
+static int64_t rule_date_to_local(int32_t year, const SYSTEMTIME *rule) {
+    int32_t days = (rule->wYear != 0) ?
+        cal_days_from_civil(rule->wYear, rule->wMonth, rule->wDay) :
+        nth_weekday(year, rule->wMonth, rule->wDay, rule->wDayOfWeek);
+
+    return cal_ticks(days, rule->wHour, rule->wMinute, rule->wSecond, rule->wMilliseconds);
+}
+
+static bool zone_load_system(ZoneTable *table) {
+    DYNAMIC_TIME_ZONE_INFORMATION dtzi;
+
+    if (GetDynamicTimeZoneInformation(&dtzi) == TIME_ZONE_ID_INVALID) {
+        return false;
+    }
+
+    for (int32_t year = RULE_YEAR_MIN; year <= RULE_YEAR_MAX; year++) {
+        TIME_ZONE_INFORMATION tzi;
+
+        if (!GetTimeZoneInformationForYear((USHORT)year, &dtzi, &tzi)) {
+            return false;
+        }
+
+        // Biases are in minutes, and added to local time to get UTC
+        int64_t std_offset = -(int64_t)(tzi.Bias + tzi.StandardBias) * 60 * CAL_TICKS_PER_SECOND;
+        int64_t dst_offset = -(int64_t)(tzi.Bias + tzi.DaylightBias) * 60 * CAL_TICKS_PER_SECOND;
+        int64_t jan1 = cal_ticks(cal_days_from_civil(year, 1, 1), 0, 0, 0, 0);
+
+        if (tzi.StandardDate.wMonth == 0 || tzi.DaylightDate.wMonth == 0) {
+            if (!table_add(table, jan1 - std_offset, std_offset)) {
+                return false;
+            }
+
+            continue;
+        }
+
+        // DaylightDate is given in standard time and StandardDate in daylight
+        // time. When DST ends before it starts in the calendar year, as in the
+        // southern hemisphere, the year begins in DST
+        int64_t dst_start = rule_date_to_local(year, &tzi.DaylightDate);
+        int64_t dst_end = rule_date_to_local(year, &tzi.StandardDate);
+        int64_t jan1_offset = (dst_end < dst_start) ? dst_offset : std_offset;
+
+        if (!table_add(table, jan1 - jan1_offset, jan1_offset) ||
+            !table_add(table, dst_start - std_offset, dst_offset) ||
+            !table_add(table, dst_end - dst_offset, std_offset)) {
+            return false;
+        }
+    }
+
+    // Everything before 1970 goes through the backend, so this only affects
+    // the first transition
+    table->initial_offset = table->items[0].offset;
+    table->from = table->items[0].at;
+    table->until = cal_ticks(cal_days_from_civil(RULE_YEAR_MAX + 1, 1, 1), 0, 0, 0, 0);
+
+    return true;
+}
+#else
+// Seconds between the FsTime epoch (1601-01-01) and the Unix epoch (1970-01-01)
+#define UNIX_EPOCH_OFFSET 11644473600LL
+
+// Default directory of the time zone database
+#define TZDIR_DEFAULT "/usr/share/zoneinfo"
+
+// Largest TZif file accepted. The biggest in the database are around 4 KiB
+#define TZIF_SIZE_MAX (256 * 1024)
+
+/*!
+ * @brief
+ * Date of a DST transition in a POSIX TZ rule.
+ */
+typedef struct rule_date {
+    // 'J' for Jn, 'D' for n, 'M' for Mm.w.d
+    char kind;
+    int32_t day;
+    int32_t week;
+    int32_t month;
+    // Local time of the transition, in seconds
+    int32_t time;
+} RuleDate;
+
+/*!
+ * @brief
+ * POSIX TZ rule, as found in the TZ variable and at the end of TZif files.
+ */
+typedef struct zone_rule {
+    // Offsets from UTC, in seconds east
+    int32_t std_offset;
+    int32_t dst_offset;
+    bool has_dst;
+    RuleDate start;
+    RuleDate end;
+} ZoneRule;
+
+static bool parse_number(const char **str, int32_t min, int32_t max, int32_t *out) {
+    const char *p = *str;
+    int32_t value = 0;
+
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+
+        if (value > max) {
+            return false;
+        }
+    }
+
+    if (value < min) {
+        return false;
+    }
+
+    *str = p;
+    *out = value;
+    return true;
+}
+
+/*!
+ * @brief
+ * Parses [+|-]hh[:mm[:ss]] into seconds.
+ */
+static bool parse_hms(const char **str, int32_t hours_max, int32_t *out) {
+    const char *p = *str;
+    int32_t sign = 1;
+    int32_t hours, minutes = 0, seconds = 0;
+
+    if (*p == '+' || *p == '-') {
+        sign = (*p++ == '-') ? -1 : 1;
+    }
+
+    if (!parse_number(&p, 0, hours_max, &hours)) {
+        return false;
+    }
+
+    if (*p == ':') {
+        p++;
+
+        if (!parse_number(&p, 0, 59, &minutes)) {
+            return false;
+        }
+
+        if (*p == ':') {
+            p++;
+
+            if (!parse_number(&p, 0, 59, &seconds)) {
+                return false;
+            }
+        }
+    }
+
+    *str = p;
+    *out = sign * (hours * 3600 + minutes * 60 + seconds);
+    return true;
+}
+
+static bool skip_zone_name(const char **str) {
+    const char *p = *str;
+
+    if (*p == '<') {
+        p = strchr(p, '>');
+
+        if (!p) {
+            return false;
+        }
+
+        p++;
+    } else {
+        while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+            p++;
+        }
+    }
+
+    // Names are at least three characters long
+    if (p - *str < 3) {
+        return false;
+    }
+
+    *str = p;
+    return true;
+}
+
+static bool parse_rule_date(const char **str, RuleDate *out) {
+    const char *p = *str;
+
+    if (*p == 'J') {
+        p++;
+        out->kind = 'J';
+
+        if (!parse_number(&p, 1, 365, &out->day)) {
+            return false;
+        }
+    } else if (*p == 'M') {
+        p++;
+        out->kind = 'M';
+
+        if (!parse_number(&p, 1, 12, &out->month) || *p++ != '.' ||
+            !parse_number(&p, 1, 5, &out->week) || *p++ != '.' ||
+            !parse_number(&p, 0, 6, &out->day)) {
+            return false;
+        }
+    } else {
+        out->kind = 'D';
+
+        if (!parse_number(&p, 0, 365, &out->day)) {
+            return false;
+        }
+    }
+
+    out->time = 2 * 3600;
+
+    // RFC 8536 extends the time to -167 through 167 hours
+    if (*p == '/' && (p++, !parse_hms(&p, 167, &out->time))) {
+        return false;
+    }
+
+    *str = p;
+    return true;
+}
+
+/*!
+ * @brief
+ * Parses a POSIX TZ rule such as "CET-1CEST,M3.5.0,M10.5.0/3".
+ */
+static bool parse_rule(const char *str, ZoneRule *out) {
+    const char *p = str;
+    int32_t offset;
+
+    if (!skip_zone_name(&p) || !parse_hms(&p, 24, &offset)) {
+        return false;
+    }
+
+    // POSIX offsets are positive west of Greenwich
+    out->std_offset = -offset;
+    out->has_dst = false;
+
+    if (*p == '\0') {
+        return true;
+    }
+
+    if (!skip_zone_name(&p)) {
+        return false;
+    }
+
+    out->has_dst = true;
+    out->dst_offset = out->std_offset + 3600;
+
+    if (*p != ',' && *p != '\0') {
+        if (!parse_hms(&p, 24, &offset)) {
+            return false;
+        }
+
+        out->dst_offset = -offset;
+    }
+
+    // Without dates, fall back to the current US rules like other libraries do
+    if (*p == '\0') {
+        p = ",M3.2.0,M11.1.0";
+    }
+
+    if (*p++ != ',' || !parse_rule_date(&p, &out->start) ||
+        *p++ != ',' || !parse_rule_date(&p, &out->end)) {
+        return false;
+    }
+
+    return *p == '\0';
+}
+
+/*!
+ * @brief
+ * Resolves the date of a transition from a POSIX TZ rule to local time.
+ */
+static int64_t rule_date_to_local(int32_t year, const RuleDate *date) {
+    int32_t jan1 = cal_days_from_civil(year, 1, 1);
+    int32_t days;
+
+    switch (date->kind) {
+        case 'J':
+            // February 29 is never counted
+            days = jan1 + date->day - 1 + (cal_is_leap_year(year) && date->day >= 60);
+            break;
+        case 'D':
+            days = jan1 + date->day;
+            break;
+        default:
+            days = nth_weekday(year, date->month, date->week, date->day);
+            break;
+    }
+
+    return cal_ticks(days, 0, 0, 0, 0) + (int64_t)date->time * CAL_TICKS_PER_SECOND;
+}
+
+/*!
+ * @brief
+ * Adds the transitions of a rule for the years from \p first_year through
+ * RULE_YEAR_MAX, skipping those at or before \p after.
+ */
+static bool add_rule_years(ZoneTable *table, const ZoneRule *rule, int32_t first_year, int64_t after) {
+    int64_t std_offset = (int64_t)rule->std_offset * CAL_TICKS_PER_SECOND;
+    int64_t dst_offset = (int64_t)rule->dst_offset * CAL_TICKS_PER_SECOND;
+
+    if (!rule->has_dst) {
+        table->until = INT64_MAX;
+        return after == INT64_MIN || table_add(table, after + 1, std_offset);
+    }
+
+    for (int32_t year = first_year; year <= RULE_YEAR_MAX; year++) {
+        // The start is given in standard time and the end in daylight time
+        int64_t start = rule_date_to_local(year, &rule->start) - std_offset;
+        int64_t end = rule_date_to_local(year, &rule->end) - dst_offset;
+
+        if ((start > after && !table_add(table, start, dst_offset)) ||
+            (end > after && !table_add(table, end, std_offset))) {
+            return false;
+        }
+    }
+
+    table->until = cal_ticks(cal_days_from_civil(RULE_YEAR_MAX + 1, 1, 1), 0, 0, 0, 0);
+    return true;
+}
+
+static uint32_t read_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int64_t read_be64(const unsigned char *p) {
+    return (int64_t)(((uint64_t)read_be32(p) << 32) | read_be32(p + 4));
+}
+
+/*!
+ * @brief
+ * Loads the transitions of a TZif file (RFC 8536), followed by those of the
+ * rule at its end.
+ */
+static bool parse_tzif(const unsigned char *data, size_t size, ZoneTable *table) {
+    const size_t header_size = 44;
+
+    if (size < header_size || memcmp(data, "TZif", 4) != 0) {
+        return false;
+    }
+
+    // Version 1 files only have 32-bit times. Later versions repeat the data
+    // with 64-bit times, followed by a rule for times past the last transition
+    int version = data[4];
+    size_t time_size = 4;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t isutcnt = read_be32(data + 20);
+        uint32_t isstdcnt = read_be32(data + 24);
+        uint32_t leapcnt = read_be32(data + 28);
+        uint32_t timecnt = read_be32(data + 32);
+        uint32_t typecnt = read_be32(data + 36);
+        uint32_t charcnt = read_be32(data + 40);
+
+        size_t block_size =
+            (size_t)timecnt * time_size + timecnt +
+            (size_t)typecnt * 6 + charcnt +
+            (size_t)leapcnt * (time_size + 4) +
+            isstdcnt + isutcnt;
+
+        if (typecnt == 0 || size < header_size + block_size) {
+            return false;
+        }
+
+        if (pass == 0 && version >= '2') {
+            // Skip to the 64-bit data
+            data += header_size + block_size;
+            size -= header_size + block_size;
+            time_size = 8;
+
+            if (size < header_size || memcmp(data, "TZif", 4) != 0) {
+                return false;
+            }
+
+            continue;
+        }
+
+        const unsigned char *times = data + header_size;
+        const unsigned char *indices = times + (size_t)timecnt * time_size;
+        const unsigned char *types = indices + timecnt;
+
+        // Local time type 0 applies before the first transition
+        table->initial_offset = (int64_t)(int32_t)read_be32(types) * CAL_TICKS_PER_SECOND;
+
+        int64_t last = INT64_MIN;
+
+        for (uint32_t i = 0; i < timecnt; i++) {
+            int64_t unix_time = (time_size == 8) ?
+                read_be64(times + (size_t)i * 8) :
+                (int32_t)read_be32(times + (size_t)i * 4);
+
+            if (indices[i] >= typecnt) {
+                return false;
+            }
+
+            int64_t offset = (int64_t)(int32_t)read_be32(types + (size_t)indices[i] * 6) * CAL_TICKS_PER_SECOND;
+
+            // Times before 1601 can't be represented, but the offset they
+            // switch to is the one in effect at the epoch
+            if (unix_time < -UNIX_EPOCH_OFFSET) {
+                table->initial_offset = offset;
+                continue;
+            }
+
+            // Nor can times past what cal_ticks() covers for the years
+            // FsTime is used with
+            if (unix_time > 1000000000000LL) {
+                break;
+            }
+
+            last = (unix_time + UNIX_EPOCH_OFFSET) * CAL_TICKS_PER_SECOND;
+
+            if (!table_add(table, last, offset)) {
+                return false;
+            }
+        }
+
+        table->from = 0;
+        // Without a rule, the last offset stays in effect forever
+        table->until = INT64_MAX;
+
+        const char *footer = (const char *)(data + header_size + block_size);
+        size_t footer_size = size - header_size - block_size;
+
+        if (time_size != 8 || footer_size < 2 || footer[0] != '\n') {
+            return true;
+        }
+
+        const char *end = memchr(footer + 1, '\n', footer_size - 1);
+
+        if (!end || end == footer + 1) {
+            return true;
+        }
+
+        char rule_str[128];
+        size_t rule_len = (size_t)(end - footer - 1);
+
+        if (rule_len >= sizeof(rule_str)) {
+            return false;
+        }
+
+        memcpy(rule_str, footer + 1, rule_len);
+        rule_str[rule_len] = '\0';
+
+        ZoneRule rule;
+
+        if (!parse_rule(rule_str, &rule)) {
+            return false;
+        }
+
+        int32_t first_year = 1601;
+
+        if (last != INT64_MIN) {
+            int32_t month, day;
+            cal_civil_from_days((int32_t)(last / CAL_TICKS_PER_SECOND / CAL_SECONDS_PER_DAY), &first_year, &month, &day);
+        }
+
+        return add_rule_years(table, &rule, first_year, last);
+    }
+
+    return false;
+}
+
+static unsigned char *read_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+
+    if (!fp) {
+        return NULL;
+    }
+
+    unsigned char *data = malloc(TZIF_SIZE_MAX);
+    size_t len = data ? fread(data, 1, TZIF_SIZE_MAX, fp) : 0;
+
+    fclose(fp);
+
+    // Files that fill the whole buffer may have been cut short
+    if (!data || len == 0 || len == TZIF_SIZE_MAX) {
+        free(data);
+        return NULL;
+    }
+
+    *size = len;
+    return data;
+}
+
+static bool zone_load_system(ZoneTable *table) {
+    const char *tz = getenv("TZ");
+    char path[4096];
+
+    if (!tz) {
+        tz = "/etc/localtime";
+    } else if (*tz == ':') {
+        tz++;
+    }
+
+    // An empty TZ means UTC
+    if (*tz == '\0') {
+        table->initial_offset = 0;
+        table->from = 0;
+        table->until = INT64_MAX;
+        return true;
+    }
+
+    if (*tz == '/') {
+        snprintf(path, sizeof(path), "%s", tz);
+    } else {
+        const char *dir = getenv("TZDIR");
+        snprintf(path, sizeof(path), "%s/%s", dir ? dir : TZDIR_DEFAULT, tz);
+    }
+
+    size_t size;
+    unsigned char *data = read_file(path, &size);
+
+    if (data) {
+        bool ok = parse_tzif(data, size, table);
+        free(data);
+
+        return ok;
+    }
+
+    // Not a file, so it may be a rule itself
+    ZoneRule rule;
+
+    if (!parse_rule(tz, &rule)) {
+        return false;
+    }
+
+    table->initial_offset = (int64_t)rule.std_offset * CAL_TICKS_PER_SECOND;
+    table->from = 0;
+
+    return add_rule_years(table, &rule, 1601, INT64_MIN);
+}
+#endif
+
+static void zone_load(void) {
+    ZoneTable table = { 0 };
+
+    if (!zone_load_system(&table)) {
+        free(table.items);
+        return;
+    }
+
+    table_finish(&table);
+    zone = table;
+}
+
+/*!
+ * @brief
+ * Converts a local time the table does not cover through the backend.
+ */
+static bool to_utc_by_backend(int64_t local, FsTime *out) {
+    if (local < 0) {
+        return false;
+    }
+
+    int64_t ticks_per_day = (int64_t)CAL_SECONDS_PER_DAY * CAL_TICKS_PER_SECOND;
+    int64_t ticks_of_day = local % ticks_per_day;
+    int32_t seconds = (int32_t)(ticks_of_day / CAL_TICKS_PER_SECOND);
+    int32_t year, month, day;
+
+    cal_civil_from_days((int32_t)(local / ticks_per_day), &year, &month, &day);
+
+    SYSTEMTIME st = {
+        .wYear = (WORD)year,
+        .wMonth = (WORD)month,
+        .wDay = (WORD)day,
+        .wHour = (WORD)(seconds / 3600),
+        .wMinute = (WORD)(seconds / 60 % 60),
+        .wSecond = (WORD)(seconds % 60),
+        .wMilliseconds = (WORD)(ticks_of_day % CAL_TICKS_PER_SECOND / (CAL_TICKS_PER_SECOND / 1000))
+    };
+
+    return fs_local_systemtime_to_time(&st, out);
+}
+
+bool localzone_to_utc(int64_t local, FsTime *out) {
+    call_once(&zone_once, zone_load);
+
+    if (!zone.loaded) {
+        return to_utc_by_backend(local, out);
+    }
+
+    // Find the last transition that happened by the given local time
+    size_t lo = 0;
+    size_t hi = zone.count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (zone.items[mid].local_at <= local) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    int64_t utc;
+
+    if (lo == 0) {
+        utc = local - zone.initial_offset;
+    } else {
+        const Transition *t = &zone.items[lo - 1];
+        utc = local - t->offset;
+
+        // The local time was skipped when clocks moved forward
+        if (utc < t->at) {
+            utc = local - t->offset_before;
+        }
+    }
+
+    if (utc < zone.from || utc >= zone.until) {
+        return to_utc_by_backend(local, out);
+    }
+
+    if (utc < 0) {
+        return false;
+    }
+
+    *out = (FsTime)utc;
+    return true;
+}
@@ -0,0 +1,43 @@
+/* localzone.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef LOCALZONE_H
+#define LOCALZONE_H
+
+#include "fsbackend.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ * @brief
+ * Converts a local date and time in the current time zone to UTC.
+ *
+ * The first call loads the UTC offset changes of the zone into a table: from
+ * the TZif file named by TZ or /etc/localtime, or the POSIX rule in TZ, on
+ * POSIX systems, and from the dynamic time zone information on Windows. Every
+ * call after that is a binary search. Times the table does not cover, and all
+ * times if the zone could not be loaded, are converted by the backend instead.
+ *
+ * A local time that is skipped when clocks move forward is read with the
+ * offset in effect before the change, so it lands as far after the change as
+ * it is into the gap. A local time that occurs twice when clocks move back
+ * resolves to the earlier of the two instants.
+ *
+ * @param local
+ * The local date and time, as the number of ticks from 1601-01-01T00:00:00 to
+ * it on the local clock.
+ *
+ * @param out
+ * Pointer to an FsTime that will receive the UTC time.
+ *
+ * @return
+ * true if the conversion succeeded; false otherwise.
+ */
+bool localzone_to_utc(int64_t local, FsTime *out);
+
+#endif // LOCALZONE_H
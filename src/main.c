@@ -5,28 +5,38 @@
  * of the MIT license. See the LICENSE file for details.
  */
 
-#define WIN32_LEAN_AND_MEAN
-
+#include "platform.h"
+#include "fsbackend.h"
 #include "errmsg.h"
 #include "getopt.h"
 #include "console.h"
 #include "version.h"
 #include "timeparse.h"
+#include "touchop.h"
+#include "pathstream.h"
+#include "treewalk.h"
+#include "workpool.h"
+#include "snapshot.h"
+#include "mirror.h"
+#include "wildcard.h"
+#include "stats.h"
+#include "errlog.h"
+#include "daemon.h"
+#include "probes.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdnoreturn.h>
-#include <windows.h>
 #include <limits.h>
-#include <tchar.h>
 #include <assert.h>
+#include <threads.h>
 
-#if defined(_M_ARM64)
+#if defined(_M_ARM64) || defined(__aarch64__)
 #define BUILD_PLAT "arm64"
-#elif defined(_WIN64)
+#elif defined(_WIN64) || defined(__x86_64__)
 #define BUILD_PLAT "x64"
-#elif (defined(_WIN32) && !defined(_WIN64))
+#elif (defined(_WIN32) && !defined(_WIN64)) || defined(__i386__)
 #define BUILD_PLAT "x86"
 #else
 #error "Unsupported architecture"
@@ -34,7 +44,13 @@
 
 #define PROGRAM_USAGE_SUMMARY \
 "SYNTAX\n\
-    touch [OPTION]... FILE...\n\n\
+    touch [OPTION]... FILE...\n\
+    touch [OPTION]... -i LISTFILE [FILE]...\n\
+    touch [OPTION]... -M MANIFEST\n\
+    touch [OPTION]... -S SNAPSHOT FILE...\n\
+    touch [OPTION]... -L SNAPSHOT\n\
+    touch [OPTION]... -T SOURCE FILE...\n\
+    touch -D ADDRESS [-j COUNT]\n\n\
 DESCRIPTION\n\
     Updates the access and modification timestamps of each file specified by the\n\
     FILE argument to the current time of day.\n\n\
@@ -53,6 +69,20 @@ OPTIONS\n\
     -d          Do not dereference symbolic links. If FILE is a symbolic link,\n\
                 its timestamp will be changed rather than that of the file it\n\
                 refers to.\n\n\
+    -g          Expand the wildcards \"*\", \"?\", \"[...]\" and \"**\" in FILE\n\
+                operands. A FILE that matches nothing is taken as it is. On\n\
+                Windows, where the shell leaves them alone, \"*\", \"?\" and\n\
+                \"**\" are expanded by default, and -g is only needed for\n\
+                \"[...]\", since brackets are legal in file names there.\n\n\
+    -u          Skip files whose selected timestamps already have the requested\n\
+                values, to within the precision their file system stores, so\n\
+                that they are not written at all. The number of updated and\n\
+                unchanged files is printed at the end. -T always does this.\n\n\
+    -R          Recursively touch the contents of each FILE that is a\n\
+                directory. Entries found during the walk are never created,\n\
+                and directories that are symbolic links or junctions are\n\
+                touched but not descended into. Use -j to walk with multiple\n\
+                threads.\n\n\
     -A OFFSET   Adjust the timestamps of FILE by OFFSET, which must be in the\n\
                 format \"[-][[hh]mm]ss\". The parts of the argument represent the\n\
                 following:\n\n\
@@ -99,62 +129,177 @@ OPTIONS\n\
                 \"DDD\" must not exceed 365 in non-leap years; and \"ww\" must not\n\
                 exceed the number of ISO weeks in the specified year.\n\n\
                 If the time is omitted, midnight local time is assumed.\n\n\
+    -i LISTFILE Also touch each file listed in LISTFILE, one path per line. If\n\
+                LISTFILE is \"-\", the list is read from standard input. The list\n\
+                must be UTF-8 encoded and is read as a stream, so there is no\n\
+                limit on the number of files it may contain.\n\n\
+    -M MANIFEST Touch each file listed in MANIFEST with a timestamp of its own.\n\
+                Every line has the form \"PATH<TAB>STAMP[<TAB>FLAGS]\", where\n\
+                STAMP is in one of the formats accepted by -t, and FLAGS is any\n\
+                combination of the letters C, a and m, which select the\n\
+                timestamps to change for that file in place of the -C, -a and\n\
+                -m options. Paths cannot contain tabs. Like LISTFILE, MANIFEST\n\
+                may be \"-\" for standard input, must be UTF-8 encoded and is\n\
+                read as a stream. This option cannot be combined with -t, -r,\n\
+                -R, -i or FILE operands.\n\n\
+    -S SNAPSHOT Record the creation, last access and last write timestamps of\n\
+                each FILE, and of everything below each FILE that is a\n\
+                directory, into the binary file SNAPSHOT. Nothing is touched.\n\
+                Paths are recorded as they were given, so relative FILE\n\
+                operands make a snapshot that can be restored from another\n\
+                directory. Use -j to walk with multiple threads.\n\n\
+    -L SNAPSHOT Restore the timestamps recorded in SNAPSHOT by -S. Only the\n\
+                timestamps selected by -C, -a and -m are restored, files that\n\
+                no longer exist are skipped, and no file is created. Use -j to\n\
+                restore with multiple threads.\n\n\
+                Neither -S nor -L can be combined with -t, -r, -A, -R, -i, -M\n\
+                or -u.\n\n\
+    -T SOURCE   Copy the timestamps of SOURCE onto each FILE and, if both are\n\
+                directories, those of every entry below SOURCE onto the entry\n\
+                at the same relative path below FILE. Only the timestamps\n\
+                selected by -C, -a and -m are copied, and only where they\n\
+                differ. Entries found on one side only are left alone, and no\n\
+                file is created. The number of matched, updated and missing\n\
+                entries is printed at the end. Use -j to process directories\n\
+                with multiple threads. This option cannot be combined with -t,\n\
+                -r, -A, -R, -i, -M, -S or -L.\n\n\
+    -s FORMAT   Time each phase of the work and print the results at the end,\n\
+                either as a table or as JSON when FORMAT is \"table\" or\n\
+                \"json\". For each phase, such as opening files or setting\n\
+                their timestamps, the number of calls, total time, system\n\
+                calls and a histogram of latencies are shown, followed by the\n\
+                slowest paths. Latencies fall in power of two buckets, so\n\
+                percentiles are bucket bounds. This option cannot be combined\n\
+                with -S, -L or -T.\n\n\
+    -e          Summarize failures instead of reporting each one as it happens.\n\
+                Once the work is done, failures are grouped by their cause,\n\
+                and each cause is printed once with the number of files it\n\
+                affected and the first few of their paths.\n\n\
+    -E FAILLIST Write the path of every file that could not be touched to\n\
+                FAILLIST, one per line, so that it can be retried with -i.\n\
+                Implies -e.\n\n\
+    -D ADDRESS  Run as a server that touches files for the clients that\n\
+                connect to ADDRESS with -F, until it is interrupted. ADDRESS\n\
+                is the path of a Unix domain socket, or the name of a pipe on\n\
+                Windows. Use -j to serve multiple clients at once. This option\n\
+                cannot be combined with other options or FILE operands.\n\n\
+    -F ADDRESS  Send each FILE to the server at ADDRESS, to be touched by its\n\
+                threads that are already running. Relative paths are taken\n\
+                from the current directory, and errors are reported as\n\
+                usual. Wildcards are not expanded. This option cannot be\n\
+                combined with -R, -i, -M, -S, -L, -T, -u, -s or -j.\n\n\
+    -0          Lines of LISTFILE or MANIFEST are separated by null characters\n\
+                instead of newlines, such as the output of \"find -print0\".\n\
+                With -E, FAILLIST is written the same way.\n\n\
+    -j COUNT    Touch files using COUNT worker threads (1-256). The default is\n\
+                1. Errors are still reported in the order the files were\n\
+                specified.\n\n\
     -h          Display this help information and exit.\n\n\
     -v          Display version information and exit.\n\n\
 Source code:\n\
 https://github.com/xv/touch-cmd-windows"
 
-typedef enum timestamp_zone {
-    TS_ZONE_LOCAL,
-    TS_ZONE_UTC
-} TimestampZone;
-
-typedef enum timestamp_source {
-    TS_SOURCE_NOW,
-    TS_SOURCE_EXPLICIT,
-    TS_SOURCE_RELATIVE
-} TimestampSource;
-
-typedef enum file_time_flags
-{
-    FT_CREATION = 1 << 0,
-    FT_ACCESS = 1 << 1,
-    FT_WRITE = 1 << 2
-} FileTimeFlags;
-
-typedef struct reference_timestamps {
-    FILETIME creation;
-    FILETIME access;
-    FILETIME write;
-} ReferenceTimestamps;
-
-typedef struct timestamp_operation {
-    TimestampSource source;
-    FileTimeFlags ft_flags;
-    FILETIME creation;
-    FILETIME access;
-    FILETIME write;
-    int adjustment_seconds;
-} TimestampOperation;
-
-// Specifies that a file's previous last access or write times should be preserved
-// when operating with file handles
-// https://learn.microsoft.com/en-us/windows/win32/api/minwinbase/ns-minwinbase-filetime
-// https://learn.microsoft.com/en-us/windows/win32/api/fileapi/nf-fileapi-setfiletime
-const FILETIME ft_preserved = {
-    .dwLowDateTime = 0xFFFFFFFF,
-    .dwHighDateTime = 0xFFFFFFFF
-};
+/*!
+ * @brief
+ * Counts the files written and skipped by -u. Shared by all threads.
+ */
+typedef struct touch_tally {
+    mtx_t lock;
+    unsigned long long updated;
+    unsigned long long unchanged;
+} TouchTally;
+
+/*!
+ * @brief
+ * Describes a set of file operands to be touched with the same operation.
+ */
+typedef struct touch_batch {
+    TCHAR *const *paths;
+    bool existing_only;
+    bool follow_symlinks;
+    const TimestampOperation *op;
+    // Optional operation for each operand, indexed like paths. Overrides op
+    const TimestampOperation *ops;
+    // Receives the outcome of each operand, indexed like paths
+    TouchStatus *results;
+    // Runs the opens, stats and closes of operands touched on one thread. If
+    // NULL, operands are touched one at a time
+    FsBatch *executor;
+    // Memory the executor's batches are planned in, kept from one to the next
+    TouchWorkspace *workspace;
+    // If set, files that already have the requested timestamps are skipped
+    // and counted here
+    TouchTally *tally;
+} TouchBatch;
+
+// Maximum number of streamed operands that are touched as one batch
+#define STREAM_BATCH_PATHS 4096
+
+// Number of characters reserved for the paths of a streamed batch
+#define STREAM_BATCH_CHARS (1 << 20)
+
+/*!
+ * @brief
+ * Rows of a manifest that are parsed and touched as one batch.
+ */
+typedef struct manifest_batch {
+    TCHAR *paths[STREAM_BATCH_PATHS];
+    const TCHAR *stamps[STREAM_BATCH_PATHS];
+    // Timestamps selected by each row, or 0 to use the command line flags
+    FileTimeFlags ft_flags[STREAM_BATCH_PATHS];
+    // Line number of each row, for error messages
+    size_t lines[STREAM_BATCH_PATHS];
+    FsTime times[STREAM_BATCH_PATHS];
+    TimestampStatus status[STREAM_BATCH_PATHS];
+    TimestampOperation ops[STREAM_BATCH_PATHS];
+    size_t count;
+
+    // Storage for the rows, which are split into fields in place
+    TCHAR chars[STREAM_BATCH_CHARS];
+    size_t used;
+} ManifestBatch;
+
+// Number of paths shown for each cause of failure by -e
+#define ERROR_SUMMARY_SAMPLES 5
 
 static const TCHAR *prog_name;
+// Opened by get_console() when there is first something to print, so that a
+// run that prints nothing never sets up the console
 static Console *console;
+static once_flag console_once = ONCE_FLAG_INIT;
+// Collects failures when they are summarized rather than reported one by one
+static ErrorLog *error_log;
+
+static void open_console(void) {
+#ifdef _WIN32
+    SetConsoleOutputCP(1252);
+#endif
+
+    console = console_open();
+}
+
+/*!
+ * @brief
+ * Gets the console, opening it on first use. Anything printed must go through
+ * the console, or follow a call to this, for the code page to be set.
+ *
+ * @return
+ * Pointer to the console, or NULL if it could not be opened, in which case
+ * output is written without colors or buffering.
+ */
+static Console *get_console(void) {
+    call_once(&console_once, open_console);
+    return console;
+}
 
 /*!
  * @brief
  * Prints program usage information.
  */
 static void print_usage_info(void) {
-    _putts(_T(PROGRAM_USAGE_SUMMARY));
+    console_fprintf_color(get_console(),
+        CONSOLE_COLOR_NONE, CONSOLE_COLOR_NONE,
+        stdout, _T("%s\n"), _T(PROGRAM_USAGE_SUMMARY));
 }
 
 /*!
@@ -162,7 +307,9 @@ static void print_usage_info(void) {
  * Prints program version information.
  */
 static void print_version_info(void) {
-    _tprintf(_T("touch %s (%s)\n"), _T(VERSION_STR), _T(BUILD_PLAT));
+    console_fprintf_color(get_console(),
+        CONSOLE_COLOR_NONE, CONSOLE_COLOR_NONE,
+        stdout, _T("touch %s (%s)\n"), _T(VERSION_STR), _T(BUILD_PLAT));
 }
 
 /*!
@@ -179,437 +326,1162 @@ static void print_version_info(void) {
  * File name without a path.
  */
 static const TCHAR *get_name(const TCHAR *path) {
-    const TCHAR *name = _tcsrchr(path, '\\');
+    const TCHAR *name = _tcsrchr(path, PATH_SEP);
     return name ? (name + 1) : path;
 }
 
 /*!
  * @brief
- * Adjusts the given file time by the given offset. If the offset is negative,
- * time is moved backward. Otherwise, forward.
+ * Gets the operation to apply to an operand of a TouchBatch.
+ */
+static const TimestampOperation *batch_op(const TouchBatch *batch, size_t index) {
+    return batch->ops ? &batch->ops[index] : batch->op;
+}
+
+/*!
+ * @brief
+ * Adds the outcome of touching a file to a tally.
+ */
+static void tally_outcome(TouchTally *tally, TouchOutcome outcome) {
+    if (outcome != TOUCH_UPDATED && outcome != TOUCH_UNCHANGED) {
+        return;
+    }
+
+    mtx_lock(&tally->lock);
+
+    if (outcome == TOUCH_UPDATED) {
+        tally->updated++;
+    } else {
+        tally->unchanged++;
+    }
+
+    mtx_unlock(&tally->lock);
+}
+
+/*!
+ * @brief
+ * Touches a file with the options of a TouchBatch, skipping it if it is
+ * unchanged and the batch keeps a tally.
  *
- * @param ft
- * Pointer to a FILETIME structure containing the time to adjust.
+ * @return
+ * true if the file was touched, skipped or, if \p existing_only is set, found
+ * missing; false otherwise, in which case fs_last_error() describes the
+ * failure.
+ */
+static bool touch_with_batch(
+    const TouchBatch *batch, const TCHAR *path,
+    bool existing_only, const TimestampOperation *op) {
+
+    if (!batch->tally) {
+        return touch(path, existing_only, batch->follow_symlinks, op);
+    }
+
+    TouchOutcome outcome = touch_if_changed(path, existing_only, batch->follow_symlinks, op);
+    tally_outcome(batch->tally, outcome);
+
+    return outcome != TOUCH_FAILED;
+}
+
+/*!
+ * @brief
+ * Work pool callback that touches a single operand of a TouchBatch and records
+ * its outcome.
  *
- * @param offset
- * Time represented in seconds.
+ * @param ctx
+ * Pointer to the TouchBatch being processed.
+ *
+ * @param index
+ * Index of the operand to touch.
  */
-static void adjust_time_offset(FILETIME *ft, int offset) {
-    assert(ft);
+static void touch_batch_item(void *ctx, size_t index) {
+    const TouchBatch *batch = ctx;
+    TouchStatus *result = &batch->results[index];
 
-    ULARGE_INTEGER uli = { 0 };
-    uli.LowPart = ft->dwLowDateTime;
-    uli.HighPart = ft->dwHighDateTime;
+    result->ok = touch_with_batch(
+        batch, batch->paths[index],
+        batch->existing_only, batch_op(batch, index));
 
-    LONGLONG ticks = (LONGLONG)uli.QuadPart;
-    LONGLONG delta = (LONGLONG)offset * 10000000LL;
+    // The last error is per-thread, so capture it before the worker moves on
+    result->err = result->ok ? FS_OK : fs_last_error();
+}
 
-    if ((delta > 0 && ticks > (MAXLONGLONG - delta)) ||
-        (delta < 0 && ticks < -delta)) {
-        return;
+/*!
+ * @brief
+ * Tree walk callback that touches an entry found below a directory operand.
+ * Entries are never created, so one that disappears during the walk is skipped.
+ *
+ * @param ctx
+ * Pointer to the TouchBatch describing the operation.
+ *
+ * @param path
+ * Path to the entry to touch.
+ *
+ * @return
+ * FS_OK if the entry was touched; a backend error code otherwise.
+ */
+static FsError touch_tree_entry(void *ctx, const TCHAR *path) {
+    const TouchBatch *batch = ctx;
+
+    if (touch_with_batch(batch, path, true, batch->op)) {
+        return FS_OK;
+    }
+
+    return fs_last_error();
+}
+
+/*!
+ * @brief
+ * Prints an error message to stderr and exits the program with a failure status.
+ * 
+ * @param print_help_hint
+ * Specifies whether to print a help hint.
+ * 
+ * @param fmt
+ * Format string for the error message.
+ * 
+ * @param ...
+ * Arguments for the format string.
+ */
+static noreturn void die(bool print_help_hint, const TCHAR *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+
+    console_vfprintf_color(get_console(),
+        CONSOLE_COLOR_NONE, CONSOLE_COLOR_RED,
+        stderr, fmt, args);
+
+    va_end(args);
+
+    if (print_help_hint) {
+        console_flush(console);
+        _tprintf(_T("Try '%s -h' to show help information.\n"), prog_name);
+    }
+
+    console_close(console);
+
+    exit(EXIT_FAILURE);
+}
+
+/*!
+ * @brief
+ * Prints an error message describing why a file could not be touched.
+ *
+ * @param path
+ * Path to the file that could not be touched.
+ *
+ * @param err
+ * The backend error code of the failure.
+ */
+static void report_touch_error(const TCHAR *path, FsError err) {
+    PROBE_RESULT(error, path, err);
+
+    StatsMark start = stats_start();
+
+    if (error_log) {
+        error_log_add(error_log, path, err);
+    } else {
+        TCHAR *err_msg = get_error_msg(err);
+        console_printf_error(get_console(), _T("%s: Could not open '%s' - %s"), prog_name, path, err_msg);
+        free_error_msg(err_msg);
+    }
+
+    stats_stop(STATS_REPORT, start, NULL);
+}
+
+/*!
+ * @brief
+ * Prints the failures collected by -e, each cause once followed by the first
+ * paths it affected, and closes the error log. Does nothing without -e.
+ *
+ * @param list_path
+ * Path to the list of failed paths written by -E, or NULL.
+ *
+ * @return
+ * true if the list of failed paths, if any, was written in full; false
+ * otherwise.
+ */
+static bool print_error_summary(const TCHAR *list_path) {
+    if (!error_log) {
+        return true;
+    }
+
+    size_t count;
+    const ErrorGroup *groups = error_log_groups(error_log, &count);
+
+    for (size_t i = 0; i < count; i++) {
+        const ErrorGroup *group = &groups[i];
+        TCHAR *err_msg = get_error_msg(group->err);
+
+        console_printf_error(get_console(), _T("%s: Could not open %llu %s - %s"),
+            prog_name, group->count, (group->count == 1) ? _T("file") : _T("files"), err_msg);
+
+        free_error_msg(err_msg);
+
+        for (size_t j = 0; j < group->sample_count; j++) {
+            console_fprintf_color(get_console(),
+                CONSOLE_COLOR_NONE, CONSOLE_COLOR_NONE,
+                stderr, _T("    %s\n"), group->samples[j]);
+        }
+
+        if (group->count > group->sample_count) {
+            console_fprintf_color(get_console(),
+                CONSOLE_COLOR_NONE, CONSOLE_COLOR_NONE,
+                stderr, _T("    ... and %llu more\n"),
+                group->count - (unsigned long long)group->sample_count);
+        }
     }
 
-    ticks += delta;
+    bool ok = error_log_close(error_log);
+    error_log = NULL;
 
-    uli.QuadPart = (ULONGLONG)ticks;
+    if (!ok) {
+        console_printf_error(get_console(), _T("%s: Failure list '%s' could not be written.\n"), prog_name, list_path);
+    }
+
+    return ok;
+}
 
-    ft->dwLowDateTime = uli.LowPart;
-    ft->dwHighDateTime = uli.HighPart;
+/*!
+ * @brief
+ * Tree walk callback that reports an entry that could not be touched.
+ */
+static void report_tree_error(void *ctx, const TCHAR *path, FsError err) {
+    (void)ctx;
+    report_touch_error(path, err);
 }
 
 /*!
  * @brief
- * Converts a Timestamp struct to a FILETIME struct.
+ * Parses the argument of the -j option.
  *
- * @param ts
- * Pointer to a Timestamp struct to convert.
+ * @param input
+ * String containing a decimal thread count.
  *
  * @param out
- * Pointer to a FILETIME struct that will receive the converted Timestamp.
+ * Pointer to an unsigned int that receives the thread count.
  *
  * @return
- * true if the conversion was successful; false otherwise.
+ * true if \p input is a valid thread count; false otherwise.
  */
-static bool timestamp_to_filetime(const Timestamp *ts, FILETIME *out) {
-    assert(ts && out);
+static bool parse_job_count(const TCHAR *input, unsigned int *out) {
+    unsigned int count = 0;
+
+    if (!input || *input == '\0') {
+        return false;
+    }
+
+    for (const TCHAR *p = input; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
 
-    if (ts->utc_offset.specified) {
-        FILETIME ft;
+        count = (count * 10) + (unsigned int)(*p - '0');
 
-        if (!SystemTimeToFileTime(&ts->st, &ft)) {
+        if (count > WORKPOOL_THREADS_MAX) {
             return false;
         }
+    }
+
+    if (count == 0) {
+        return false;
+    }
 
-        ULARGE_INTEGER ticks = { 0 };
+    *out = count;
+    return true;
+}
 
-        ticks.LowPart = ft.dwLowDateTime;
-        ticks.HighPart = ft.dwHighDateTime;
+/*!
+ * @brief
+ * Reports the operands of \p batch that failed, in the order they were given,
+ * and releases the results.
+ *
+ * @return
+ * true if every operand was touched successfully; false otherwise.
+ */
+static bool report_results(TouchBatch *batch, size_t count) {
+    bool all_ok = true;
 
-        LONGLONG delta =
-            (LONGLONG)ts->utc_offset.minutes *
-            60LL *
-            10000000LL;
+    for (size_t i = 0; i < count; i++) {
+        const TouchStatus *result = &batch->results[i];
 
-        // Prevent underflow if UTC conversion moves time before the FILETIME
-        // epoch (Jan 1, 1601). E.g., 1601-01-01T00:00:00+01:00
-        //
-        // No need to worry about overflow here since the ISO 8601 timestamp
-        // parser doesn't allow more than four digits for the year field anyway.
-        // An overflow would require the resulting FILETIME to be greater than
-        // 0x7FFFFFFFFFFFFFFF, which is equivalent to 30828-09-14T02:48:05.4775807
-        // when converted to a timestamp
-        if ((delta > 0) && (ticks.QuadPart < (ULONGLONG)delta)) {
-            return false;
+        if (!result->ok) {
+            all_ok = false;
+            report_touch_error(batch->paths[i], result->err);
         }
+    }
 
-        ticks.QuadPart -= delta;
+    free(batch->results);
+    batch->results = NULL;
 
-        // If the converted timestamp is equivalent to the FILETIME epoch, that
-        // is 1601-01-01T00:00:00.000Z, the resulting FILETIME value is {0, 0}.
-        // Per SetFileTime() documentation, passing a FILETIME whose members are
-        // {0, 0} indicates that the application intends to leave the
-        // corresponding timestamp unchanged!
-        //
-        // I'm going to treat that as "expected behavior" until someone complains :D
-        out->dwLowDateTime = ticks.LowPart;
-        out->dwHighDateTime = ticks.HighPart;
+    return all_ok;
+}
 
-        return true;
+/*!
+ * @brief
+ * Touches every operand of \p batch using a pool of \p jobs threads, then
+ * reports failures in the order the operands were given.
+ *
+ * @param batch
+ * Pointer to a TouchBatch whose results member is NULL. Storage for the results
+ * is allocated and released by this function.
+ *
+ * @param count
+ * Number of operands in the batch.
+ *
+ * @param jobs
+ * Number of threads to use.
+ *
+ * @return
+ * true if every operand was touched successfully; false otherwise.
+ */
+static bool touch_parallel(TouchBatch *batch, size_t count, unsigned int jobs) {
+    batch->results = calloc(count, sizeof(TouchStatus));
+
+    if (!batch->results) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
     }
 
-    SYSTEMTIME utc;
+    workpool_run(jobs, count, touch_batch_item, batch);
 
-    // Interpret timestamp as the local civil time in the current Windows TZ
-    // configuration to properly handle TZ-related adjustments like DST transitions
-    if (!TzSpecificLocalTimeToSystemTime(NULL, &ts->st, &utc)) {
-        return false;
+    return report_results(batch, count);
+}
+
+/*!
+ * @brief
+ * Touches every operand of \p batch on the calling thread through its
+ * executor, then reports failures in the order the operands were given.
+ *
+ * @param batch
+ * Pointer to a TouchBatch whose results member is NULL and whose executor
+ * member is set. Storage for the results is allocated and released by this
+ * function.
+ *
+ * @param count
+ * Number of operands in the batch.
+ *
+ * @return
+ * true if every operand was touched successfully; false otherwise.
+ */
+static bool touch_batched(TouchBatch *batch, size_t count) {
+    batch->results = calloc(count, sizeof(TouchStatus));
+
+    if (!batch->results) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
     }
 
-    return SystemTimeToFileTime(&utc, out);
+    touch_many(
+        batch->executor, batch->workspace,
+        (const TCHAR *const *)batch->paths, count,
+        batch->existing_only, batch->follow_symlinks,
+        batch->op, batch->ops,
+        batch->results);
+
+    return report_results(batch, count);
 }
 
- /*!
-  * @brief
-  * Parses a given timestamp string and translates it into a FILETIME struct.
-  *
-  * @param stamp
-  * The string to parse, which must follow ISO 8601 basic or extended format.
-  *
-  * @param out
-  * Pointer to a FILETIME struct to receive the parsed timestamp.
-  *
-  * @returns
-  * true if the timestamp was successfully parsed and translated; false otherwise.
-  */
-static bool parse_timestamp_string(const TCHAR *stamp, FILETIME *out) {
-    Timestamp ts;
+/*!
+ * @brief
+ * Recursively touches the contents of every operand that is a directory.
+ *
+ * @param batch
+ * Pointer to a TouchBatch holding the operands and the operation to apply.
+ *
+ * @param count
+ * Number of operands in the batch.
+ *
+ * @param jobs
+ * Number of threads to walk the directories with.
+ *
+ * @return
+ * true if every entry was touched successfully; false otherwise.
+ */
+static bool touch_recursive(const TouchBatch *batch, size_t count, unsigned int jobs) {
+    const TCHAR **dirs = malloc(count * sizeof(TCHAR *));
 
-    if (!parse_timestamp(stamp, &ts)) {
-        return false;
+    if (!dirs) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
     }
 
-    return timestamp_to_filetime(&ts, out);
+    size_t dir_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (tree_is_walkable_dir(batch->paths[i], batch->follow_symlinks)) {
+            dirs[dir_count++] = batch->paths[i];
+        }
+    }
+
+    TreeWalk walk = {
+        .visit = touch_tree_entry,
+        .report = report_tree_error,
+        .ctx = (void *)batch,
+        .threads = jobs
+    };
+
+    bool ok = tree_walk(&walk, dirs, dir_count);
+
+    free(dirs);
+
+    return ok;
 }
 
 /*!
  * @brief
- * Retrieves timestamps from the specified file.
+ * Touches every operand of \p batch, in parallel if requested, and then the
+ * contents of directory operands if \p recursive is set.
  *
- * @param filename
- * Path to the file to retrieve timestamps from.
+ * @param batch
+ * Pointer to a TouchBatch holding the operands and the operation to apply.
  *
- * @param out
- * Pointer to a reference_timestamps struct to store the retrieved timestamps.
+ * @param count
+ * Number of operands in the batch.
+ *
+ * @param jobs
+ * Number of threads to use.
+ *
+ * @param recursive
+ * Specifies whether to recurse into directory operands.
  *
  * @return
- * true if the timestamps were successfully retrieved; false otherwise.
+ * true if every operand was touched successfully; false otherwise.
  */
-static bool get_ref_timestamps(const TCHAR *filename, ReferenceTimestamps *out) {
-    assert(filename && out);
+static bool touch_operands(
+    TouchBatch *batch, size_t count,
+    unsigned int jobs, bool recursive) {
 
-    WIN32_FILE_ATTRIBUTE_DATA attr;
+    bool all_ok = true;
 
-    if (!GetFileAttributesEx(filename, GetFileExInfoStandard, (void *)&attr)) {
-        return false;
+    if (count == 0) {
+        return true;
     }
 
-    out->creation = attr.ftCreationTime;
-    out->access = attr.ftLastAccessTime;
-    out->write = attr.ftLastWriteTime;
+    if (jobs > 1 && count > 1) {
+        all_ok = touch_parallel(batch, count, jobs);
+    } else if (count > 1 && batch->executor && !batch->tally) {
+        all_ok = touch_batched(batch, count);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            bool ok = touch_with_batch(
+                batch, batch->paths[i],
+                batch->existing_only, batch_op(batch, i));
 
-    return true;
+            all_ok &= ok;
+
+            if (!ok) {
+                report_touch_error(batch->paths[i], fs_last_error());
+            }
+        }
+    }
+
+    if (recursive) {
+        all_ok &= touch_recursive(batch, count, jobs);
+    }
+
+    return all_ok;
+}
+
+/*!
+ * @brief
+ * Operands gathered one at a time, from a list file or the matches of a
+ * pattern, and touched in fixed-size batches, so memory use does not grow
+ * with their number.
+ */
+typedef struct operand_queue {
+    TouchBatch batch;
+    TCHAR **paths;
+    TCHAR *chars;
+    size_t count;
+    size_t used;
+    unsigned int jobs;
+    bool recursive;
+    bool all_ok;
+} OperandQueue;
+
+static void queue_open(
+    OperandQueue *queue, const TouchBatch *tmpl,
+    unsigned int jobs, bool recursive) {
+
+    *queue = (OperandQueue) {
+        .batch = *tmpl,
+        .paths = malloc(STREAM_BATCH_PATHS * sizeof(TCHAR *)),
+        .chars = malloc(STREAM_BATCH_CHARS * sizeof(TCHAR)),
+        .jobs = jobs,
+        .recursive = recursive,
+        .all_ok = true
+    };
+
+    if (!queue->paths || !queue->chars) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
+    }
+
+    queue->batch.paths = queue->paths;
+}
+
+/*!
+ * @brief
+ * Touches the operands gathered so far.
+ */
+static void queue_flush(OperandQueue *queue) {
+    if (queue->count > 0) {
+        queue->all_ok &= touch_operands(&queue->batch, queue->count, queue->jobs, queue->recursive);
+        queue->count = 0;
+        queue->used = 0;
+    }
+}
+
+/*!
+ * @brief
+ * Adds an operand, touching those gathered so far first if the batch is full.
+ */
+static void queue_push(OperandQueue *queue, const TCHAR *path) {
+    size_t len = _tcslen(path) + 1;
+
+    if (queue->count == STREAM_BATCH_PATHS || queue->used + len > STREAM_BATCH_CHARS) {
+        queue_flush(queue);
+    }
+
+    // A path never exceeds the arena; streams and patterns cap it well below
+    queue->paths[queue->count++] = memcpy(&queue->chars[queue->used], path, len * sizeof(TCHAR));
+    queue->used += len;
 }
 
 /*!
  * @brief
- * Adjusts a file's timestamps.
+ * Touches the remaining operands and frees the queue.
  *
- * @param file_handle
- * Handle to the file whose timestamps are to be adjusted.
+ * @return
+ * true if every operand was touched successfully; false otherwise.
+ */
+static bool queue_close(OperandQueue *queue) {
+    queue_flush(queue);
+
+    free(queue->chars);
+    free(queue->paths);
+
+    return queue->all_ok;
+}
+
+/*!
+ * @brief
+ * Touches every operand read from a list file or stdin.
+ *
+ * @param list_path
+ * Path to the list file, or "-" for stdin.
+ *
+ * @param nul_delimited
+ * Specifies whether operands are separated by null characters instead of
+ * newlines.
+ *
+ * @param tmpl
+ * Pointer to a TouchBatch whose options are applied to every operand.
  *
- * @param op
- * Pointer to a TimestampOperation struct containing operation details.
+ * @param jobs
+ * Number of threads to use.
+ *
+ * @param recursive
+ * Specifies whether to recurse into directory operands.
  *
  * @return
- * true if the timestamps were successfully adjusted; false otherwise.
+ * true if every operand was read and touched successfully; false otherwise.
  */
-static bool adjust_file_time(HANDLE file_handle, const TimestampOperation *op) {
-    assert(op);
+static bool touch_stream(
+    const TCHAR *list_path, bool nul_delimited,
+    const TouchBatch *tmpl, unsigned int jobs, bool recursive) {
 
-    FILETIME creation;
-    FILETIME access;
-    FILETIME write;
+    PathStream *ps = path_stream_open(list_path, nul_delimited);
 
-    if (!GetFileTime(file_handle, &creation, &access, &write)) {
-        return false;
+    if (!ps) {
+        die(false, _T("%s: List file '%s' could not be opened.\n"), prog_name, list_path);
     }
 
-    const FILETIME *ptr_creation = NULL;
-    const FILETIME *ptr_access = &ft_preserved;
-    const FILETIME *ptr_write = &ft_preserved;
+    OperandQueue queue;
+    queue_open(&queue, tmpl, jobs, recursive);
+
+    while (true) {
+        const TCHAR *path;
+        PathStreamStatus status = path_stream_next(ps, &path);
+
+        if (status == PATH_STREAM_OK) {
+            queue_push(&queue, path);
+            continue;
+        }
+
+        if (status == PATH_STREAM_TOO_LONG) {
+            console_printf_error(get_console(), _T("%s: Skipped a list entry that is too long.\n"), prog_name);
+            queue.all_ok = false;
+            continue;
+        }
 
-    if (op->ft_flags & FT_CREATION) {
-        adjust_time_offset(&creation, op->adjustment_seconds);
-        ptr_creation = &creation;
+        if (status == PATH_STREAM_BAD_ENCODING) {
+            console_printf_error(get_console(), _T("%s: Skipped a list entry that is not valid UTF-8.\n"), prog_name);
+            queue.all_ok = false;
+            continue;
+        }
+
+        if (status == PATH_STREAM_IO_ERROR) {
+            console_printf_error(get_console(), _T("%s: List file '%s' could not be read.\n"), prog_name, list_path);
+            queue.all_ok = false;
+        }
+
+        break;
     }
 
-    if (op->ft_flags & FT_ACCESS) {
-        adjust_time_offset(&access, op->adjustment_seconds);
-        ptr_access = &access;
+    path_stream_close(ps);
+
+    return queue_close(&queue);
+}
+
+/*!
+ * @brief
+ * Checks whether any of the operands contains a wildcard, counting "[...]"
+ * sets only if \p sets is true.
+ */
+static bool has_pattern(TCHAR *const *paths, size_t count, bool sets) {
+    for (size_t i = 0; i < count; i++) {
+        if (wildcard_is_pattern(paths[i], sets)) {
+            return true;
+        }
     }
 
-    if (op->ft_flags & FT_WRITE) {
-        adjust_time_offset(&write, op->adjustment_seconds);
-        ptr_write = &write;
+    return false;
+}
+
+/*!
+ * @brief
+ * Wildcard callback that queues a matching path to be touched.
+ */
+static void queue_match(void *ctx, const TCHAR *path) {
+    queue_push(ctx, path);
+}
+
+/*!
+ * @brief
+ * Touches the operands after expanding their wildcards. Matches are queued as
+ * they are found, so an expansion is never held in memory as a whole.
+ *
+ * @param paths
+ * The operands, in the order they were specified.
+ *
+ * @param count
+ * Number of operands.
+ *
+ * @param tmpl
+ * Pointer to a TouchBatch whose options are applied to every operand.
+ *
+ * @param jobs
+ * Number of threads to use.
+ *
+ * @param recursive
+ * Specifies whether to recurse into directory operands.
+ *
+ * @param sets
+ * Specifies whether "[...]" is a set, or part of a name.
+ *
+ * @return
+ * true if every directory the patterns reach could be listed and every
+ * operand was touched successfully; false otherwise.
+ */
+static bool touch_expanded(
+    TCHAR *const *paths, size_t count,
+    const TouchBatch *tmpl, unsigned int jobs, bool recursive, bool sets) {
+
+    OperandQueue queue;
+    queue_open(&queue, tmpl, jobs, recursive);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!wildcard_is_pattern(paths[i], sets)) {
+            queue_push(&queue, paths[i]);
+            continue;
+        }
+
+        Wildcard *wc = wildcard_compile(paths[i], sets);
+
+        if (!wc) {
+            die(false, _T("%s: Out of memory.\n"), prog_name);
+        }
+
+        size_t matches;
+        queue.all_ok &= wildcard_expand(wc, queue_match, report_tree_error, &queue, &matches);
+
+        wildcard_free(wc);
+
+        // Like the shell, a pattern that matches nothing is taken as a name
+        if (matches == 0) {
+            queue_push(&queue, paths[i]);
+        }
     }
 
-    return SetFileTime(file_handle, ptr_creation, ptr_access, ptr_write);
+    return queue_close(&queue);
 }
 
 /*!
  * @brief
- * Sets the timestamps of the file based on details provide by \p op.
+ * Splits a manifest row of the form "PATH<TAB>STAMP[<TAB>FLAGS]" in place.
  *
- * @param op
- * Pointer to a TimestampOperation struct containing operation details.
+ * @param row
+ * The row to split. Tabs between fields are replaced with null characters.
  *
- * @param file_handle
- * An open handle to the file to set its timestamp.
+ * @param batch
+ * Pointer to the ManifestBatch that receives the fields at index count.
  *
  * @return
- * true if the timestamps were successfully set; false otherwise.
+ * true if the row is well-formed; false otherwise.
  */
-static bool set_file_time(HANDLE file_handle, const TimestampOperation *op) {
-    assert(op);
+static bool split_manifest_row(TCHAR *row, ManifestBatch *batch) {
+    TCHAR *stamp = _tcschr(row, '\t');
 
-    if (!(op->ft_flags & (FT_CREATION | FT_ACCESS | FT_WRITE))) {
-        return true;
+    if (!stamp || stamp == row) {
+        return false;
     }
 
-    // If there's an adjustment but no explicit timestamp via a reference file
-    // or timestamp input, adjust the current file time only
-    if (op->source == TS_SOURCE_RELATIVE && op->adjustment_seconds != 0) {
-        return adjust_file_time(file_handle, op);
+    *stamp++ = '\0';
+
+    FileTimeFlags ft_flags = 0;
+    TCHAR *flags = _tcschr(stamp, '\t');
+
+    if (flags) {
+        *flags++ = '\0';
+
+        for (; *flags; flags++) {
+            switch (*flags) {
+                case 'C':
+                    ft_flags |= FT_CREATION;
+                    break;
+                case 'a':
+                    ft_flags |= FT_ACCESS;
+                    break;
+                case 'm':
+                    ft_flags |= FT_WRITE;
+                    break;
+                default:
+                    return false;
+            }
+        }
     }
 
-    return SetFileTime(
-        file_handle,
-        (op->ft_flags & FT_CREATION) ? &op->creation : NULL,
-        (op->ft_flags & FT_ACCESS) ? &op->access : &ft_preserved,
-        (op->ft_flags & FT_WRITE) ? &op->write : &ft_preserved);
+    batch->paths[batch->count] = row;
+    batch->stamps[batch->count] = stamp;
+    batch->ft_flags[batch->count] = ft_flags;
+
+    return true;
 }
 
 /*!
  * @brief
- * Constructs a TimestampOperation struct based on the given parameters.
+ * Converts the timestamps of a batch of manifest rows in one pass, then
+ * touches each file with its own timestamp. Rows whose timestamp is invalid
+ * are reported and skipped. The batch is emptied afterwards.
  *
- * @param ft_stamp
- * Optional pointer to a FILETIME struct containing the timestamp to work with.
- * If specified, then \p ref_stamps should be NULL.
+ * @param batch
+ * Pointer to the ManifestBatch to process.
  *
- * @param ref_stamps
- * Optional pointer to ReferenceTimestamps struct containing the timestamps to
- * work with. If specified, then \p ft_stamp should be NULL.
+ * @param tmpl
+ * Pointer to a TouchBatch whose options are applied to every row.
  *
  * @param ft_flags
- * Flags indicating which file timestamps are affected.
- * 
+ * Timestamps to change for rows that don't select their own.
+ *
  * @param adjustment_seconds
- * Seconds to add to or subtract (if negative) from the target timestamp.
+ * Seconds to add to or subtract (if negative) from every timestamp.
+ *
+ * @param jobs
+ * Number of threads to use.
  *
  * @return
- * A TimestampOperation describing the requested operation.
- * 
- * If both \p ft_stamp and \p ref_stamps are NULL, and \p adjustment_seconds is
- * zero, the current time of day will be used as the base timestamp. However, if
- * \p adjustment_seconds is non-zero, the \c source member of the returned struct
- * will be set to \c TS_SOURCE_RELATIVE, indicating that time adjustment is
- * applied relative to an existing file's timestamps.
- */
-static TimestampOperation prepare_timestamp(
-    const FILETIME *ft_stamp,
-    const ReferenceTimestamps *ref_stamps,
-    FileTimeFlags ft_flags, int adjustment_seconds) {
-
-    TimestampOperation op = { 0 };
-
-    op.ft_flags = ft_flags;
-    op.adjustment_seconds = adjustment_seconds;
-
-    if (!(ft_stamp || ref_stamps) && adjustment_seconds != 0) {
-        op.source = TS_SOURCE_RELATIVE;
-        // Nothing to do here since relative adjustment is handled in
-        // set_file_time()
-        return op;
-    }
-
-    if (ref_stamps) {
-        op.source = TS_SOURCE_EXPLICIT;
-
-        op.creation = ref_stamps->creation;
-        op.access = ref_stamps->access;
-        op.write = ref_stamps->write;
-    } else if (ft_stamp) {
-        op.source = TS_SOURCE_EXPLICIT;
-        op.creation = op.access = op.write = *ft_stamp;
-    } else {
-        FILETIME now;
-        GetSystemTimeAsFileTime(&now);
+ * true if every row was touched successfully; false otherwise.
+ */
+static bool touch_manifest_batch(
+    ManifestBatch *batch, const TouchBatch *tmpl,
+    FileTimeFlags ft_flags, int adjustment_seconds, unsigned int jobs) {
+
+    bool all_ok = true;
+    size_t kept = 0;
+
+    parse_timestamps(batch->stamps, batch->count, batch->times, batch->status);
 
-        op.source = TS_SOURCE_NOW;
-        op.creation = op.access = op.write = now;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (batch->status[i] != TS_STATUS_OK) {
+            console_printf_error(get_console(),
+                _T("%s: Skipped manifest line %llu - Timestamp is invalid or not in the expected format.\n"),
+                prog_name, (unsigned long long)batch->lines[i]);
+
+            all_ok = false;
+            continue;
+        }
+
+        FileTimeFlags row_flags = batch->ft_flags[i] ? batch->ft_flags[i] : ft_flags;
+
+        batch->paths[kept] = batch->paths[i];
+        batch->ops[kept] = prepare_timestamp(
+            &batch->times[i], NULL,
+            row_flags, adjustment_seconds);
+
+        kept++;
     }
 
-    if (op.adjustment_seconds != 0) {
-        if (op.ft_flags & FT_CREATION) {
-            adjust_time_offset(&op.creation, op.adjustment_seconds);
+    TouchBatch touch_batch = *tmpl;
+    touch_batch.paths = batch->paths;
+    touch_batch.ops = batch->ops;
+
+    all_ok &= touch_operands(&touch_batch, kept, jobs, false);
+
+    batch->count = 0;
+    batch->used = 0;
+
+    return all_ok;
+}
+
+/*!
+ * @brief
+ * Touches every file listed in a manifest, each with the timestamp given on
+ * its row. Rows are buffered into fixed-size batches, so memory use does not
+ * grow with the input.
+ *
+ * @param manifest_path
+ * Path to the manifest, or "-" for stdin.
+ *
+ * @param nul_delimited
+ * Specifies whether rows are separated by null characters instead of
+ * newlines.
+ *
+ * @param tmpl
+ * Pointer to a TouchBatch whose options are applied to every row.
+ *
+ * @param ft_flags
+ * Timestamps to change for rows that don't select their own.
+ *
+ * @param adjustment_seconds
+ * Seconds to add to or subtract (if negative) from every timestamp.
+ *
+ * @param jobs
+ * Number of threads to use.
+ *
+ * @return
+ * true if every row was read and touched successfully; false otherwise.
+ */
+static bool touch_manifest(
+    const TCHAR *manifest_path, bool nul_delimited,
+    const TouchBatch *tmpl, FileTimeFlags ft_flags,
+    int adjustment_seconds, unsigned int jobs) {
+
+    PathStream *ps = path_stream_open(manifest_path, nul_delimited);
+
+    if (!ps) {
+        die(false, _T("%s: Manifest '%s' could not be opened.\n"), prog_name, manifest_path);
+    }
+
+    ManifestBatch *batch = malloc(sizeof(ManifestBatch));
+
+    if (!batch) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
+    }
+
+    batch->count = 0;
+    batch->used = 0;
+
+    bool all_ok = true;
+
+    while (true) {
+        const TCHAR *row;
+        PathStreamStatus status = path_stream_next(ps, &row);
+        unsigned long long line = path_stream_record_count(ps);
+
+        if (status == PATH_STREAM_TOO_LONG) {
+            console_printf_error(get_console(), _T("%s: Skipped manifest line %llu - Line is too long.\n"), prog_name, line);
+            all_ok = false;
+            continue;
+        }
+
+        if (status == PATH_STREAM_BAD_ENCODING) {
+            console_printf_error(get_console(), _T("%s: Skipped manifest line %llu - Line is not valid UTF-8.\n"), prog_name, line);
+            all_ok = false;
+            continue;
+        }
+
+        if (status == PATH_STREAM_IO_ERROR) {
+            console_printf_error(get_console(), _T("%s: Manifest '%s' could not be read.\n"), prog_name, manifest_path);
+            all_ok = false;
         }
 
-        if (op.ft_flags & FT_ACCESS) {
-            adjust_time_offset(&op.access, op.adjustment_seconds);
+        bool done = (status != PATH_STREAM_OK);
+        size_t len = done ? 0 : (_tcslen(row) + 1);
+
+        if (batch->count > 0 &&
+           (done || batch->count == STREAM_BATCH_PATHS || batch->used + len > STREAM_BATCH_CHARS)) {
+            all_ok &= touch_manifest_batch(batch, tmpl, ft_flags, adjustment_seconds, jobs);
+        }
+
+        if (done) {
+            break;
         }
 
-        if (op.ft_flags & FT_WRITE) {
-            adjust_time_offset(&op.write, op.adjustment_seconds);
+        TCHAR *copy = memcpy(&batch->chars[batch->used], row, len * sizeof(TCHAR));
+
+        if (!split_manifest_row(copy, batch)) {
+            console_printf_error(get_console(),
+                _T("%s: Skipped manifest line %llu - Expected PATH<TAB>STAMP[<TAB>FLAGS].\n"),
+                prog_name, line);
+
+            all_ok = false;
+            continue;
         }
+
+        batch->lines[batch->count++] = (size_t)line;
+        batch->used += len;
     }
 
-    return op;
+    free(batch);
+    path_stream_close(ps);
+
+    return all_ok;
+}
+
+/*!
+ * @brief
+ * Snapshot callback that reports an entry that could not be captured or
+ * restored.
+ */
+static void report_snapshot_error(void *ctx, const TCHAR *path, FsError err) {
+    (void)ctx;
+    report_touch_error(path, err);
 }
 
 /*!
  * @brief
- * Changes the timestamp of the given file.
+ * Captures a snapshot of the given files, or restores one, and exits.
  *
- * @param path
- * Path to the file to touch.
+ * @param save_path
+ * Path to the snapshot to capture, or NULL to restore \p load_path.
  *
- * @param existing_only
- * Specifies whether to operate on an existing file only, or create the file if
- * it does not exist.
- * 
- * @param follow_symlinks
- * Specifies whether to follow symbolic links, or operate on the links themselves.
+ * @param load_path
+ * Path to the snapshot to restore.
+ *
+ * @param roots
+ * Array of paths to capture.
+ *
+ * @param count
+ * Number of elements in \p roots.
+ *
+ * @param list_path
+ * Path to the list of failed paths written by -E, or NULL.
  *
  * @return
- * true if the timestamps were successfully changed; false otherwise.
+ * The exit status of the program.
  */
-static bool touch(
-    const TCHAR *path,
-    bool existing_only, bool follow_symlinks,
-    const TimestampOperation *op) {
+static int run_snapshot(
+    const TCHAR *save_path, const TCHAR *load_path,
+    const TCHAR *const *roots, size_t count,
+    FileTimeFlags ft_flags, bool follow_symlinks, unsigned int jobs,
+    const TCHAR *list_path) {
+
+    SnapshotOptions opts = {
+        .follow_symlinks = follow_symlinks,
+        .ft_flags = ft_flags,
+        .threads = jobs,
+        .report = report_snapshot_error
+    };
+
+    SnapshotStatus status = save_path ?
+        snapshot_capture(save_path, roots, count, &opts) :
+        snapshot_restore(load_path, &opts);
+
+    const TCHAR *snapshot_path = save_path ? save_path : load_path;
+
+    switch (status) {
+        case SNAPSHOT_IO_ERROR:
+            die(false, save_path ?
+                _T("%s: Snapshot '%s' could not be written.\n") :
+                _T("%s: Snapshot '%s' could not be read.\n"),
+                prog_name, snapshot_path);
+        case SNAPSHOT_BAD_FORMAT:
+            die(false, _T("%s: Snapshot '%s' is damaged or not a snapshot.\n"), prog_name, snapshot_path);
+        case SNAPSHOT_NO_MEMORY:
+            die(false, _T("%s: Out of memory.\n"), prog_name);
+        default:
+            break;
+    }
 
-    assert(path && op);
+    bool all_ok = print_error_summary(list_path) && status == SNAPSHOT_OK;
 
-    DWORD cw_flags = FILE_ATTRIBUTE_NORMAL;
+    console_close(console);
 
-    if (!follow_symlinks) {
-        cw_flags |= FILE_FLAG_OPEN_REPARSE_POINT;
-    }
+    return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-    HANDLE file_handle = CreateFile(
-        path,                                        // lpFileName
-        GENERIC_READ | FILE_WRITE_ATTRIBUTES,        // dwDesiredAccess
-        FILE_SHARE_READ,                             // dwShareMode
-        NULL,                                        // lpSecurityAttributes
-        existing_only ? OPEN_EXISTING : OPEN_ALWAYS, // dwCreationDisposition
-        cw_flags,                                    // dwFlagsAndAttributes
-        NULL                                         // hTemplateFile
-    );
+/*!
+ * @brief
+ * Mirrors the timestamps of a tree onto each target, prints the totals and
+ * exits.
+ *
+ * @param source
+ * Path to the file or directory to copy timestamps from.
+ *
+ * @param targets
+ * Array of paths to copy timestamps to.
+ *
+ * @param count
+ * Number of elements in \p targets.
+ *
+ * @param list_path
+ * Path to the list of failed paths written by -E, or NULL.
+ *
+ * @return
+ * The exit status of the program.
+ */
+static int run_mirror(
+    const TCHAR *source,
+    const TCHAR *const *targets, size_t count,
+    FileTimeFlags ft_flags, bool follow_symlinks, unsigned int jobs,
+    const TCHAR *list_path) {
+
+    MirrorOptions opts = {
+        .ft_flags = ft_flags,
+        .follow_symlinks = follow_symlinks,
+        .threads = jobs,
+        .report = report_tree_error
+    };
+
+    MirrorStats stats = { 0 };
+    bool all_ok = true;
 
-    if (file_handle == INVALID_HANDLE_VALUE) {
-        DWORD err = GetLastError();
+    for (size_t i = 0; i < count; i++) {
+        all_ok &= mirror_tree(source, targets[i], &opts, &stats);
+    }
 
-        bool missing_file =
-            (err == ERROR_FILE_NOT_FOUND ||
-             err == ERROR_PATH_NOT_FOUND);
+    all_ok &= print_error_summary(list_path);
 
-        return (existing_only && missing_file);
-    }
+    // Errors are buffered by the console, while the totals are not
+    console_flush(console);
 
-    bool ok = set_file_time(file_handle, op);
-    CloseHandle(file_handle);
+    _tprintf(_T("%llu matched, %llu updated, %llu missing\n"),
+        stats.matched, stats.updated, stats.missing);
 
-    return ok;
+    console_close(console);
+
+    return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 /*!
  * @brief
- * Prints an error message to stderr and exits the program with a failure status.
- * 
- * @param print_help_hint
- * Specifies whether to print a help hint.
- * 
- * @param fmt
- * Format string for the error message.
- * 
- * @param ...
- * Arguments for the format string.
+ * Serves requests from -F until the process is ended.
+ *
+ * @return
+ * The exit status of the program, if the server could not be started.
  */
-static noreturn void die(bool print_help_hint, const TCHAR *fmt, ...) {
-    va_list args;
+static int run_server(const TCHAR *address, unsigned int jobs) {
+    daemon_serve(address, jobs);
 
-    va_start(args, fmt);
+    TCHAR *err_msg = get_error_msg(fs_last_error());
+    console_printf_error(get_console(), _T("%s: Could not serve at '%s' - %s"), prog_name, address, err_msg);
+    free_error_msg(err_msg);
 
-    console_vfprintf_color(console,
-        CONSOLE_COLOR_NONE, CONSOLE_COLOR_RED,
-        stderr, fmt, args);
+    console_close(console);
 
-    va_end(args);
+    return EXIT_FAILURE;
+}
 
-    if (print_help_hint) {
-        _tprintf(_T("Try '%s -h' to show help information.\n"), prog_name);
+/*!
+ * @brief
+ * Has the server of -F touch the given files and exits.
+ *
+ * @param address
+ * The address of the server.
+ *
+ * @param req
+ * Pointer to the request to send.
+ *
+ * @param list_path
+ * Path to the list of failed paths written by -E, or NULL.
+ *
+ * @return
+ * The exit status of the program.
+ */
+static int run_forward(const TCHAR *address, const DaemonRequest *req, const TCHAR *list_path) {
+    DaemonStatus status = daemon_forward(address, req, report_tree_error, NULL);
+
+    switch (status) {
+        case DAEMON_UNREACHABLE: {
+            TCHAR *err_msg = get_error_msg(fs_last_error());
+            die(false, _T("%s: Could not connect to '%s' - %s"), prog_name, address, err_msg);
+        }
+        case DAEMON_IO_ERROR:
+            die(false, _T("%s: Connection to '%s' was lost.\n"), prog_name, address);
+        case DAEMON_REJECTED:
+            die(false, _T("%s: Request was rejected by '%s'.\n"), prog_name, address);
+        case DAEMON_NO_MEMORY:
+            die(false, _T("%s: Out of memory.\n"), prog_name);
+        default:
+            break;
     }
 
+    bool all_ok = print_error_summary(list_path) && status == DAEMON_OK;
+
     console_close(console);
 
-    exit(EXIT_FAILURE);
+    return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-int _tmain(int argc, TCHAR **argv) {
-    SetConsoleOutputCP(1252);
+/*!
+ * @brief
+ * Prints the number of files updated and skipped by -u.
+ */
+static void print_tally(const TouchTally *tally) {
+    _tprintf(_T("%llu updated, %llu unchanged\n"), tally->updated, tally->unchanged);
+}
 
-    console = console_open();
+int _tmain(int argc, TCHAR **argv) {
     prog_name = get_name(argv[0]);
 
     // Store option arguments to process later before touching
     TCHAR *offset_input = NULL;
     TCHAR *stamp_input = NULL;
     TCHAR *stamp_ref_file_input = NULL;
+    TCHAR *jobs_input = NULL;
+    TCHAR *list_input = NULL;
+    TCHAR *manifest_input = NULL;
+    TCHAR *snapshot_save_input = NULL;
+    TCHAR *snapshot_load_input = NULL;
+    TCHAR *mirror_source_input = NULL;
+    TCHAR *stats_input = NULL;
+    TCHAR *fail_list_input = NULL;
+    TCHAR *serve_input = NULL;
+    TCHAR *forward_input = NULL;
 
     FileTimeFlags ft_flags = 0;
     int adjustment_seconds = 0;
+    unsigned int jobs = 1;
 
     int file_must_exist = false;
     int follow_symlinks = true;
+    int recursive = false;
+    int nul_delimited = false;
+    int skip_unchanged = false;
+    int summarize_errors = false;
+    // Number of options given, to tell whether -D comes with others
+    int option_count = 0;
+
+#ifdef _WIN32
+    // Windows shells pass wildcards through as they are. "*" and "?" cannot
+    // be part of a file name there, but brackets can, so "[...]" sets wait
+    // for -g
+    int expand_wildcards = true;
+#else
+    int expand_wildcards = false;
+#endif
+    int expand_sets = false;
 
     if (argc < 2) {
         die(true, _T("%s: No argument is supplied.\n"), prog_name);
     }
 
     int option;
-    while ((option = get_opt(argc, argv, _T("A:aCcdhmr:t:v"))) != -1) {
+    while ((option = get_opt(argc, argv, _T("0A:aCcD:dE:eF:ghi:j:L:M:mRr:S:s:T:t:uv"))) != -1) {
+        option_count++;
+
         switch (option) {
+            case '0':
+                nul_delimited = true;
+                break;
             case 'A':
                 offset_input = opt_arg;
                 break;
@@ -622,22 +1494,66 @@ int _tmain(int argc, TCHAR **argv) {
             case 'c':
                 file_must_exist = true;
                 break;
+            case 'D':
+                serve_input = opt_arg;
+                break;
             case 'd':
                 follow_symlinks = false;
                 break;
+            case 'E':
+                fail_list_input = opt_arg;
+                summarize_errors = true;
+                break;
+            case 'e':
+                summarize_errors = true;
+                break;
+            case 'F':
+                forward_input = opt_arg;
+                break;
+            case 'g':
+                expand_wildcards = true;
+                expand_sets = true;
+                break;
             case 'h':
                 print_usage_info();
                 console_close(console);
                 exit(EXIT_SUCCESS);
+            case 'i':
+                list_input = opt_arg;
+                break;
+            case 'j':
+                jobs_input = opt_arg;
+                break;
+            case 'L':
+                snapshot_load_input = opt_arg;
+                break;
+            case 'M':
+                manifest_input = opt_arg;
+                break;
             case 'm':
                 ft_flags |= FT_WRITE;
                 break;
+            case 'R':
+                recursive = true;
+                break;
             case 'r':
                 stamp_ref_file_input = opt_arg;
                 break;
+            case 'S':
+                snapshot_save_input = opt_arg;
+                break;
+            case 's':
+                stats_input = opt_arg;
+                break;
+            case 'T':
+                mirror_source_input = opt_arg;
+                break;
             case 't':
                 stamp_input = opt_arg;
                 break;
+            case 'u':
+                skip_unchanged = true;
+                break;
             case 'v':
                 print_version_info();
                 console_close(console);
@@ -659,7 +1575,7 @@ int _tmain(int argc, TCHAR **argv) {
     }
 
     // Didn't receive any files to touch
-    if (opt_index == argc) {
+    if (opt_index == argc && !list_input && !manifest_input && !snapshot_load_input && !serve_input) {
         die(true, _T("%s: Missing file operand.\n"), prog_name);
     }
 
@@ -674,13 +1590,99 @@ int _tmain(int argc, TCHAR **argv) {
         adjustment_seconds = offset;
     }
 
+    if (jobs_input && !parse_job_count(jobs_input, &jobs)) {
+        die(true, _T("%s: Thread count must be between 1 and %d.\n"), prog_name, WORKPOOL_THREADS_MAX);
+    }
+
+    if (serve_input) {
+        if (option_count != (jobs_input ? 2 : 1) || opt_index != argc) {
+            die(true, _T("%s: Option -D cannot be combined with options other than -j, or with FILE operands.\n"), prog_name);
+        }
+
+        return run_server(serve_input, jobs);
+    }
+
+    if (forward_input) {
+        if (recursive || list_input || manifest_input ||
+            snapshot_save_input || snapshot_load_input || mirror_source_input ||
+            skip_unchanged || stats_input || jobs_input) {
+            die(true, _T("%s: Option -F cannot be combined with -R, -i, -M, -S, -L, -T, -u, -s or -j.\n"), prog_name);
+        }
+
+        if (expand_wildcards && has_pattern(&argv[opt_index], (size_t)(argc - opt_index), expand_sets)) {
+            die(true, _T("%s: Wildcards in FILE operands cannot be used with -F.\n"), prog_name);
+        }
+    }
+
+    if (summarize_errors) {
+        error_log = error_log_open(ERROR_SUMMARY_SAMPLES, fail_list_input, nul_delimited);
+
+        if (!error_log) {
+            if (fail_list_input) {
+                die(false, _T("%s: Failure list '%s' could not be created.\n"), prog_name, fail_list_input);
+            } else {
+                die(false, _T("%s: Out of memory.\n"), prog_name);
+            }
+        }
+    }
+
     // Disallow timestamp inputs for multiple sources as it makes no sense
-    if (stamp_input && stamp_ref_file_input) {
+    if ((stamp_input && stamp_ref_file_input) ||
+        (manifest_input && (stamp_input || stamp_ref_file_input))) {
         die(false, _T("%s: Cannot set timestamp from multiple sources.\n"), prog_name);
     }
 
-    FILETIME ft_stamp, *ft_stamp_ptr = NULL;
-    ReferenceTimestamps ref_stamps, *ref_stamps_ptr = NULL;
+    if (mirror_source_input) {
+        if (stamp_input || stamp_ref_file_input || offset_input ||
+            recursive || list_input || manifest_input ||
+            snapshot_save_input || snapshot_load_input || stats_input) {
+            die(true, _T("%s: Option -T cannot be combined with -t, -r, -A, -R, -i, -M, -S, -L or -s.\n"), prog_name);
+        }
+
+        return run_mirror(
+            mirror_source_input,
+            (const TCHAR *const *)&argv[opt_index], (size_t)(argc - opt_index),
+            ft_flags, follow_symlinks, jobs, fail_list_input);
+    }
+
+    if (snapshot_save_input || snapshot_load_input) {
+        if (stamp_input || stamp_ref_file_input || offset_input ||
+            recursive || list_input || manifest_input || skip_unchanged || stats_input ||
+           (snapshot_save_input && snapshot_load_input)) {
+            die(true, _T("%s: Options -S and -L cannot be combined with -t, -r, -A, -R, -i, -M, -u, -s or each other.\n"), prog_name);
+        }
+
+        if (snapshot_load_input && opt_index != argc) {
+            die(true, _T("%s: Option -L does not take FILE operands.\n"), prog_name);
+        }
+
+        return run_snapshot(
+            snapshot_save_input, snapshot_load_input,
+            (const TCHAR *const *)&argv[opt_index], (size_t)(argc - opt_index),
+            ft_flags, follow_symlinks, jobs, fail_list_input);
+    }
+
+    // Every file touched in manifest mode must come with its own timestamp
+    if (manifest_input && (recursive || list_input || opt_index != argc)) {
+        die(true, _T("%s: Option -M cannot be combined with -R, -i or FILE operands.\n"), prog_name);
+    }
+
+    StatsFormat stats_format = STATS_FORMAT_TABLE;
+
+    if (stats_input) {
+        if (_tcscmp(stats_input, _T("json")) == 0) {
+            stats_format = STATS_FORMAT_JSON;
+        } else if (_tcscmp(stats_input, _T("table")) != 0) {
+            die(true, _T("%s: Statistics format must be \"table\" or \"json\".\n"), prog_name);
+        }
+
+        if (!stats_enable()) {
+            die(false, _T("%s: Out of memory.\n"), prog_name);
+        }
+    }
+
+    FsTime ft_stamp, *ft_stamp_ptr = NULL;
+    FsTimes ref_stamps, *ref_stamps_ptr = NULL;
 
     if (stamp_input) {
         if (!parse_timestamp_string(stamp_input, &ft_stamp)) {
@@ -692,9 +1694,7 @@ int _tmain(int argc, TCHAR **argv) {
 
     if (stamp_ref_file_input) {
         if (!get_ref_timestamps(stamp_ref_file_input, &ref_stamps)) {
-            DWORD err = GetLastError();
-
-            if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) {
+            if (fs_error_is_missing(fs_last_error())) {
                 die(false, _T("%s: Reference file does not exist.\n"), prog_name);
             } else {
                 die(false, _T("%s: Reference timestamp could not be retrieved.\n"), prog_name);
@@ -704,24 +1704,90 @@ int _tmain(int argc, TCHAR **argv) {
         ref_stamps_ptr = &ref_stamps;
     }
 
+    if (forward_input) {
+        // The server parses the options again, so only what was given is sent
+        DaemonRequest req = {
+            .paths = (const TCHAR *const *)&argv[opt_index],
+            .count = (size_t)(argc - opt_index),
+            .ft_flags = ft_flags,
+            .stamp = stamp_input,
+            .ref_path = stamp_ref_file_input,
+            .offset = offset_input,
+            .existing_only = file_must_exist,
+            .follow_symlinks = follow_symlinks
+        };
+
+        return run_forward(forward_input, &req, fail_list_input);
+    }
+
     TimestampOperation op = prepare_timestamp(
         ft_stamp_ptr, ref_stamps_ptr,
         ft_flags, adjustment_seconds);
 
-    bool all_ok = true;
+    TouchTally tally = { 0 };
 
-    for (; opt_index < argc; opt_index++) {
-        bool ok = touch(argv[opt_index], file_must_exist, follow_symlinks, &op);
+    if (skip_unchanged && mtx_init(&tally.lock, mtx_plain) != thrd_success) {
+        die(false, _T("%s: Out of memory.\n"), prog_name);
+    }
+
+    TouchBatch batch = {
+        .paths = &argv[opt_index],
+        .existing_only = file_must_exist,
+        .follow_symlinks = follow_symlinks,
+        .op = &op,
+        .tally = skip_unchanged ? &tally : NULL
+    };
+
+    size_t operand_count = (size_t)(argc - opt_index);
+    bool expand = expand_wildcards && has_pattern(&argv[opt_index], operand_count, expand_sets);
+
+    // Worker threads touch one operand at a time, so only a single thread
+    // needs an executor. Without one, operands are simply not batched, which
+    // is all a run with a single file needs, and it starts faster without
+    // setting up the executor's ring
+    if (jobs == 1 && (operand_count > 1 || expand || list_input || manifest_input)) {
+        batch.executor = fs_batch_open(FS_BATCH_AUTO);
+        batch.workspace = touch_workspace_open();
+    }
 
-        all_ok &= ok;
+    bool all_ok;
 
-        if (!ok) {
-            TCHAR *err_msg = get_win32_last_error_msg();
-            console_printf_error(console, _T("%s: Could not open '%s' - %s"), prog_name, argv[opt_index], err_msg);
-            HeapFree(GetProcessHeap(), 0, err_msg);
-        };
+    if (manifest_input) {
+        all_ok = touch_manifest(
+            manifest_input, nul_delimited,
+            &batch, ft_flags, adjustment_seconds, jobs);
+    } else {
+        if (expand) {
+            all_ok = touch_expanded(&argv[opt_index], operand_count, &batch, jobs, recursive, expand_sets);
+        } else {
+            all_ok = touch_operands(&batch, operand_count, jobs, recursive);
+        }
+
+        if (list_input) {
+            all_ok &= touch_stream(list_input, nul_delimited, &batch, jobs, recursive);
+        }
     }
 
+    all_ok &= print_error_summary(fail_list_input);
+
+    // Errors are buffered by the console, while the totals and statistics
+    // are not
+    console_flush(console);
+
+    if (skip_unchanged) {
+        print_tally(&tally);
+        mtx_destroy(&tally.lock);
+    }
+
+    if (stats_input) {
+        // The slowest paths are among the statistics
+        get_console();
+        stats_print(stats_format);
+    }
+
+    touch_workspace_close(batch.workspace);
+    fs_batch_close(batch.executor);
+
     console_close(console);
 
     return all_ok ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -0,0 +1,441 @@
+/* mirror.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "mirror.h"
+#include "workpool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+// Maximum length of a path, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Names are matched the way the file system looks them up
+#ifdef _WIN32
+#define compare_names _tcsicmp
+#else
+#define compare_names strcmp
+#endif
+
+/*!
+ * @brief
+ * A directory of the source tree and its counterpart in the target tree.
+ */
+typedef struct dir_pair {
+    TCHAR *source;
+    TCHAR *target;
+} DirPair;
+
+/*!
+ * @brief
+ * The sorted entries of a directory.
+ */
+typedef struct listing {
+    FsDirEntry *entries;
+    size_t count;
+    size_t capacity;
+    // Storage for the names of the entries
+    TCHAR *chars;
+    size_t used;
+    size_t chars_capacity;
+} Listing;
+
+/*!
+ * @brief
+ * State shared by all threads of a mirror.
+ */
+typedef struct mirror {
+    const MirrorOptions *opts;
+
+    // Directory pairs of the level being processed
+    DirPair *level;
+
+    // Guards the members below
+    mtx_t lock;
+    // Directory pairs of the next level
+    DirPair *next;
+    size_t next_count;
+    size_t next_capacity;
+    MirrorStats stats;
+    bool all_ok;
+} Mirror;
+
+static void report(Mirror *m, const TCHAR *path, FsError err) {
+    mtx_lock(&m->lock);
+
+    m->all_ok = false;
+
+    if (m->opts->report) {
+        m->opts->report(m->opts->ctx, path, err);
+    }
+
+    mtx_unlock(&m->lock);
+}
+
+/*!
+ * @brief
+ * Joins a directory path and an entry name into a newly allocated path.
+ *
+ * @return
+ * The joined path, or NULL if it is too long or memory could not be allocated.
+ */
+static TCHAR *join_path(const TCHAR *dir, const TCHAR *name) {
+    size_t dir_len = _tcslen(dir);
+    size_t name_len = _tcslen(name);
+    bool needs_sep =
+        dir_len > 0 &&
+        dir[dir_len - 1] != PATH_SEP &&
+        dir[dir_len - 1] != '/';
+
+    size_t len = dir_len + (needs_sep ? 1 : 0) + name_len;
+
+    if (len + 1 > PATH_CAPACITY) {
+        return NULL;
+    }
+
+    TCHAR *path = malloc((len + 1) * sizeof(TCHAR));
+
+    if (path) {
+        memcpy(path, dir, dir_len * sizeof(TCHAR));
+
+        if (needs_sep) {
+            path[dir_len] = PATH_SEP;
+        }
+
+        memcpy(&path[len - name_len], name, (name_len + 1) * sizeof(TCHAR));
+    }
+
+    return path;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return compare_names(((const FsDirEntry *)a)->name, ((const FsDirEntry *)b)->name);
+}
+
+static void listing_free(Listing *list) {
+    free(list->entries);
+    free(list->chars);
+}
+
+/*!
+ * @brief
+ * Reads all entries of a directory and sorts them by name.
+ *
+ * @return
+ * FS_OK if the directory was listed; a backend error code otherwise.
+ */
+static FsError list_dir(const TCHAR *path, Listing *out) {
+    Listing list = { 0 };
+    FsDir *dir = fs_dir_open(path);
+
+    if (!dir) {
+        return fs_last_error();
+    }
+
+    FsDirEntry entry;
+    FsError err = FS_OK;
+
+    while (fs_dir_next(dir, &entry, &err)) {
+        size_t size = _tcslen(entry.name) + 1;
+
+        if (list.count == list.capacity) {
+            size_t capacity = list.capacity ? list.capacity * 2 : 64;
+            FsDirEntry *entries = realloc(list.entries, capacity * sizeof(FsDirEntry));
+
+            if (!entries) {
+                err = FS_ERR_NO_MEMORY;
+                break;
+            }
+
+            list.entries = entries;
+            list.capacity = capacity;
+        }
+
+        if (list.used + size > list.chars_capacity) {
+            size_t capacity = list.chars_capacity ? list.chars_capacity * 2 : 4096;
+
+            while (capacity < list.used + size) {
+                capacity *= 2;
+            }
+
+            TCHAR *chars = realloc(list.chars, capacity * sizeof(TCHAR));
+
+            if (!chars) {
+                err = FS_ERR_NO_MEMORY;
+                break;
+            }
+
+            list.chars = chars;
+            list.chars_capacity = capacity;
+        }
+
+        memcpy(&list.chars[list.used], entry.name, size * sizeof(TCHAR));
+
+        // Names are stored as offsets until the buffer is done growing
+        entry.name = (const TCHAR *)(uintptr_t)list.used;
+        list.entries[list.count++] = entry;
+        list.used += size;
+    }
+
+    fs_dir_close(dir);
+
+    if (err != FS_OK) {
+        listing_free(&list);
+        return err;
+    }
+
+    for (size_t i = 0; i < list.count; i++) {
+        list.entries[i].name = &list.chars[(uintptr_t)list.entries[i].name];
+    }
+
+    qsort(list.entries, list.count, sizeof(FsDirEntry), compare_entries);
+
+    *out = list;
+    return FS_OK;
+}
+
+/*!
+ * @brief
+ * Copies the selected timestamps of a source entry onto its counterpart, if
+ * any of them differ.
+ *
+ * @param updated
+ * Pointer to a bool that receives whether the target was changed.
+ *
+ * @return
+ * FS_OK on success; the backend error code of the failure and the path it
+ * concerns otherwise.
+ */
+static FsError mirror_entry(
+    Mirror *m, const TCHAR *source, const TCHAR *target,
+    bool *updated, const TCHAR **failed_path) {
+
+    const MirrorOptions *opts = m->opts;
+    FsTimes from, to, granularity;
+
+    *updated = false;
+
+    if (!fs_stat_times(source, opts->follow_symlinks, &from)) {
+        *failed_path = source;
+        return fs_last_error();
+    }
+
+    if (!fs_stat_times_granular(target, opts->follow_symlinks, &to, &granularity)) {
+        *failed_path = target;
+        return fs_last_error();
+    }
+
+    // Only write the timestamps that are recorded and would actually change
+    // on the target's file system
+    FileTimeFlags ft_flags = changed_times(&to, &from, &granularity, opts->ft_flags);
+
+    if (!ft_flags) {
+        return FS_OK;
+    }
+
+    TimestampOperation op = prepare_timestamp(NULL, &from, ft_flags, 0);
+
+    if (!touch(target, true, opts->follow_symlinks, &op)) {
+        *failed_path = target;
+        return fs_last_error();
+    }
+
+    *updated = true;
+    return FS_OK;
+}
+
+/*!
+ * @brief
+ * Compares and updates a matched pair of entries, reporting any failure.
+ */
+static void mirror_pair(Mirror *m, const TCHAR *source, const TCHAR *target, MirrorStats *stats) {
+    const TCHAR *failed_path = NULL;
+    bool updated;
+
+    FsError err = mirror_entry(m, source, target, &updated, &failed_path);
+
+    // A source that can't be read doesn't make a match
+    stats->matched += (err == FS_OK || failed_path == target);
+    stats->updated += updated;
+
+    if (err != FS_OK) {
+        report(m, failed_path, err);
+    }
+}
+
+/*!
+ * @brief
+ * Queues a pair of subdirectories for the next level.
+ */
+static bool push_pair(Mirror *m, TCHAR *source, TCHAR *target) {
+    bool ok = true;
+
+    mtx_lock(&m->lock);
+
+    if (m->next_count == m->next_capacity) {
+        size_t capacity = m->next_capacity ? m->next_capacity * 2 : 64;
+        DirPair *next = realloc(m->next, capacity * sizeof(DirPair));
+
+        if (next) {
+            m->next = next;
+            m->next_capacity = capacity;
+        } else {
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        m->next[m->next_count++] = (DirPair) { source, target };
+    }
+
+    mtx_unlock(&m->lock);
+
+    return ok;
+}
+
+/*!
+ * @brief
+ * Work pool callback that merges the listings of a pair of directories,
+ * mirrors every matched entry and queues matched subdirectories.
+ */
+static void mirror_dir(void *ctx, size_t index) {
+    Mirror *m = ctx;
+    const DirPair *pair = &m->level[index];
+    Listing src, dst;
+    FsError err;
+
+    if ((err = list_dir(pair->source, &src)) != FS_OK) {
+        report(m, pair->source, err);
+        return;
+    }
+
+    if ((err = list_dir(pair->target, &dst)) != FS_OK) {
+        report(m, pair->target, err);
+        listing_free(&src);
+        return;
+    }
+
+    MirrorStats stats = { 0 };
+    size_t i = 0, j = 0;
+
+    while (j < dst.count) {
+        int cmp = (i < src.count) ?
+            compare_names(src.entries[i].name, dst.entries[j].name) :
+            1;
+
+        // Entries only found in the source are left alone
+        if (cmp < 0) {
+            i++;
+            continue;
+        }
+
+        if (cmp > 0) {
+            stats.missing++;
+            j++;
+            continue;
+        }
+
+        const FsDirEntry *s = &src.entries[i++];
+        const FsDirEntry *d = &dst.entries[j++];
+
+        TCHAR *source = join_path(pair->source, s->name);
+        TCHAR *target = join_path(pair->target, d->name);
+
+        if (!source || !target) {
+            report(m, target ? target : pair->target, FS_ERR_NAME_TOO_LONG);
+            free(source);
+            free(target);
+            continue;
+        }
+
+        mirror_pair(m, source, target, &stats);
+
+        if (s->is_dir && !s->is_link && d->is_dir && !d->is_link) {
+            if (push_pair(m, source, target)) {
+                continue;
+            }
+
+            report(m, target, FS_ERR_NO_MEMORY);
+        }
+
+        free(source);
+        free(target);
+    }
+
+    listing_free(&src);
+    listing_free(&dst);
+
+    mtx_lock(&m->lock);
+    m->stats.matched += stats.matched;
+    m->stats.updated += stats.updated;
+    m->stats.missing += stats.missing;
+    mtx_unlock(&m->lock);
+}
+
+bool mirror_tree(
+    const TCHAR *source, const TCHAR *target,
+    const MirrorOptions *opts, MirrorStats *stats) {
+
+    Mirror m = {
+        .opts = opts,
+        .all_ok = true
+    };
+
+    if (mtx_init(&m.lock, mtx_plain) != thrd_success) {
+        if (opts->report) {
+            opts->report(opts->ctx, target, FS_ERR_NO_MEMORY);
+        }
+
+        return false;
+    }
+
+    // The roots are a matched pair of their own, so mirroring a file onto
+    // another works too
+    mirror_pair(&m, source, target, &m.stats);
+
+    if (tree_is_walkable_dir(source, opts->follow_symlinks) &&
+        tree_is_walkable_dir(target, opts->follow_symlinks)) {
+        TCHAR *root_source = _tcsdup(source);
+        TCHAR *root_target = _tcsdup(target);
+
+        if (!root_source || !root_target || !push_pair(&m, root_source, root_target)) {
+            report(&m, target, FS_ERR_NO_MEMORY);
+            free(root_source);
+            free(root_target);
+        }
+    }
+
+    // Process the trees one level at a time. Every pair of a level is
+    // independent of the others, so a level is spread over the pool
+    while (m.next_count > 0) {
+        DirPair *level = m.next;
+        size_t count = m.next_count;
+
+        m.level = level;
+        m.next = NULL;
+        m.next_count = 0;
+        m.next_capacity = 0;
+
+        workpool_run(opts->threads, count, mirror_dir, &m);
+
+        for (size_t i = 0; i < count; i++) {
+            free(level[i].source);
+            free(level[i].target);
+        }
+
+        free(level);
+    }
+
+    mtx_destroy(&m.lock);
+
+    stats->matched += m.stats.matched;
+    stats->updated += m.stats.updated;
+    stats->missing += m.stats.missing;
+
+    return m.all_ok;
+}
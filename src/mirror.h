@@ -0,0 +1,79 @@
+/* mirror.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef MIRROR_H
+#define MIRROR_H
+
+#include "fsbackend.h"
+#include "touchop.h"
+#include "treewalk.h"
+
+#include <stdbool.h>
+
+/*!
+ * @brief
+ * Describes how a tree is mirrored onto another.
+ */
+typedef struct mirror_options {
+    // Timestamps to copy
+    FileTimeFlags ft_flags;
+    // Specifies whether to follow symbolic links, or operate on the links themselves
+    bool follow_symlinks;
+    // Number of threads to use, including the calling thread
+    unsigned int threads;
+    // Invoked for every entry that could not be compared or updated. Calls
+    // are serialized
+    TreeReportFn report;
+    void *ctx;
+} MirrorOptions;
+
+/*!
+ * @brief
+ * Counts of the entries processed by mirror_tree().
+ */
+typedef struct mirror_stats {
+    // Target entries that have a counterpart in the source tree
+    unsigned long long matched;
+    // Matched entries whose timestamps differed and were changed
+    unsigned long long updated;
+    // Target entries without a counterpart in the source tree
+    unsigned long long missing;
+} MirrorStats;
+
+/*!
+ * @brief
+ * Copies the timestamps of every entry below \p source onto the entry at the
+ * same relative path below \p target, and those of \p source onto \p target.
+ *
+ * Both trees are walked in lockstep: the listings of each pair of directories
+ * are sorted and merged, so every name is looked up once. Timestamps are only
+ * written where they differ at the granularity of the target's file system,
+ * and nothing is created or deleted. Pairs of
+ * directories at the same depth are processed in parallel. Like -R, the walk
+ * does not descend into symbolic links or junctions.
+ *
+ * @param source
+ * Path to the directory to copy timestamps from.
+ *
+ * @param target
+ * Path to the directory to copy timestamps to.
+ *
+ * @param opts
+ * Pointer to the options of the operation.
+ *
+ * @param stats
+ * Pointer to a MirrorStats struct to which the counts of this call are added.
+ *
+ * @return
+ * true if every matched entry was compared and, if needed, updated
+ * successfully; false otherwise.
+ */
+bool mirror_tree(
+    const TCHAR *source, const TCHAR *target,
+    const MirrorOptions *opts, MirrorStats *stats);
+
+#endif // MIRROR_H
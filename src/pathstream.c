@@ -0,0 +1,207 @@
+/* pathstream.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "pathstream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Size of each read from the underlying file
+#define READ_CHUNK 65536
+
+// Maximum length of a path, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Maximum size of a single record in bytes. A UTF-8 sequence takes at most
+// three bytes per UTF-16 code unit
+#define RECORD_CAPACITY (PATH_CAPACITY * 3)
+
+struct path_stream {
+    FILE *fp;
+    bool owns_fp;
+    char delim;
+
+    // Read buffer and the unconsumed range within it
+    char buf[READ_CHUNK];
+    size_t pos;
+    size_t len;
+    bool eof;
+
+    // Bytes of the record being assembled
+    char record[RECORD_CAPACITY];
+    size_t record_len;
+    // Set when the current record overflowed and is being skipped
+    bool record_overflow;
+    // Number of records completed so far, including empty and skipped ones
+    size_t record_count;
+
+    TCHAR path[PATH_CAPACITY];
+};
+
+PathStream *path_stream_open(const TCHAR *path, bool nul_delimited) {
+    PathStream *ps = calloc(1, sizeof(PathStream));
+
+    if (!ps) {
+        return NULL;
+    }
+
+    ps->delim = nul_delimited ? '\0' : '\n';
+
+    if (_tcscmp(path, _T("-")) == 0) {
+#ifdef _WIN32
+        // Keep the CRT from translating CRLF or stopping at ^Z
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+        ps->fp = stdin;
+        ps->owns_fp = false;
+    } else {
+        ps->fp = _tfopen(path, _T("rb"));
+        ps->owns_fp = true;
+    }
+
+    if (!ps->fp) {
+        free(ps);
+        return NULL;
+    }
+
+    return ps;
+}
+
+/*!
+ * @brief
+ * Converts the assembled record to a null-terminated TCHAR string.
+ *
+ * @return
+ * PATH_STREAM_OK if the record was converted; PATH_STREAM_TOO_LONG or
+ * PATH_STREAM_BAD_ENCODING otherwise.
+ */
+static PathStreamStatus convert_record(PathStream *ps) {
+    size_t len = ps->record_len;
+
+#ifdef UNICODE
+    int wlen = MultiByteToWideChar(
+        CP_UTF8, MB_ERR_INVALID_CHARS,
+        ps->record, (int)len,
+        ps->path, PATH_CAPACITY - 1);
+
+    if (wlen <= 0) {
+        return (GetLastError() == ERROR_INSUFFICIENT_BUFFER) ?
+            PATH_STREAM_TOO_LONG :
+            PATH_STREAM_BAD_ENCODING;
+    }
+
+    ps->path[wlen] = '\0';
+#else
+    if (len >= PATH_CAPACITY) {
+        return PATH_STREAM_TOO_LONG;
+    }
+
+    memcpy(ps->path, ps->record, len);
+    ps->path[len] = '\0';
+#endif
+
+    return PATH_STREAM_OK;
+}
+
+PathStreamStatus path_stream_next(PathStream *ps, const TCHAR **out) {
+    while (true) {
+        if (ps->pos == ps->len) {
+            if (ps->eof) {
+                return PATH_STREAM_END;
+            }
+
+            ps->len = fread(ps->buf, 1, READ_CHUNK, ps->fp);
+            ps->pos = 0;
+
+            if (ps->len < READ_CHUNK) {
+                if (ferror(ps->fp)) {
+                    return PATH_STREAM_IO_ERROR;
+                }
+
+                ps->eof = true;
+            }
+
+            // A final record without a trailing delimiter still counts
+            if (ps->len == 0 && ps->record_len == 0 && !ps->record_overflow) {
+                return PATH_STREAM_END;
+            }
+        }
+
+        const char *start = &ps->buf[ps->pos];
+        size_t avail = ps->len - ps->pos;
+        const char *delim = memchr(start, ps->delim, avail);
+        size_t take = delim ? (size_t)(delim - start) : avail;
+        bool complete = delim || (ps->eof && ps->pos + take == ps->len);
+
+        if (!ps->record_overflow) {
+            if (ps->record_len + take > RECORD_CAPACITY) {
+                ps->record_overflow = true;
+            } else {
+                memcpy(&ps->record[ps->record_len], start, take);
+                ps->record_len += take;
+            }
+        }
+
+        ps->pos += take + (delim ? 1 : 0);
+
+        if (!complete) {
+            continue;
+        }
+
+        bool overflow = ps->record_overflow;
+
+        ps->record_overflow = false;
+        ps->record_count++;
+
+        if (overflow) {
+            ps->record_len = 0;
+            return PATH_STREAM_TOO_LONG;
+        }
+
+        if (ps->delim == '\n' &&
+            ps->record_len > 0 &&
+            ps->record[ps->record_len - 1] == '\r') {
+            ps->record_len--;
+        }
+
+        if (ps->record_len == 0) {
+            continue;
+        }
+
+        PathStreamStatus status = convert_record(ps);
+        ps->record_len = 0;
+
+        if (status == PATH_STREAM_OK) {
+            *out = ps->path;
+        }
+
+        return status;
+    }
+}
+
+size_t path_stream_record_count(const PathStream *ps) {
+    return ps->record_count;
+}
+
+void path_stream_close(PathStream *ps) {
+    if (!ps) {
+        return;
+    }
+
+    if (ps->owns_fp) {
+        fclose(ps->fp);
+    }
+
+    free(ps);
+}
@@ -0,0 +1,94 @@
+/* pathstream.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef PATHSTREAM_H
+#define PATHSTREAM_H
+
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*!
+ * @brief
+ * Reads delimited paths from a file or stdin using a fixed amount of memory,
+ * regardless of how many paths the input contains.
+ */
+typedef struct path_stream PathStream;
+
+/*!
+ * @brief
+ * Result of reading the next path from a PathStream.
+ */
+typedef enum path_stream_status {
+    // A path was read
+    PATH_STREAM_OK,
+    // The input is exhausted
+    PATH_STREAM_END,
+    // The record exceeded the maximum path length and was skipped
+    PATH_STREAM_TOO_LONG,
+    // The record was not valid UTF-8 and was skipped
+    PATH_STREAM_BAD_ENCODING,
+    // Reading the input failed; no further records can be read
+    PATH_STREAM_IO_ERROR
+} PathStreamStatus;
+
+/*!
+ * @brief
+ * Opens a path stream.
+ *
+ * @param path
+ * Path to the list file to read, or "-" to read from stdin.
+ *
+ * @param nul_delimited
+ * If true, records are separated by null characters. Otherwise, they are
+ * separated by newlines, and a carriage return preceding a newline is dropped.
+ *
+ * @return
+ * Pointer to a new PathStream, or NULL if the file could not be opened or
+ * memory could not be allocated.
+ */
+PathStream *path_stream_open(const TCHAR *path, bool nul_delimited);
+
+/*!
+ * @brief
+ * Reads the next non-empty path from the stream. Input is expected to be UTF-8
+ * encoded.
+ *
+ * @param ps
+ * Pointer to an open PathStream.
+ *
+ * @param out
+ * Pointer that receives the path when PATH_STREAM_OK is returned. The string
+ * is owned by the stream and remains valid until the next call.
+ *
+ * @return
+ * A PathStreamStatus describing the result.
+ */
+PathStreamStatus path_stream_next(PathStream *ps, const TCHAR **out);
+
+/*!
+ * @brief
+ * Gets the number of records read from the stream so far, including empty
+ * records and those that were skipped. After path_stream_next() returns a
+ * record, this is its 1-based line number.
+ *
+ * @param ps
+ * Pointer to an open PathStream.
+ */
+size_t path_stream_record_count(const PathStream *ps);
+
+/*!
+ * @brief
+ * Closes a path stream and frees its resources.
+ *
+ * @param ps
+ * Stream to close. If NULL, no action is taken.
+ */
+void path_stream_close(PathStream *ps);
+
+#endif // PATHSTREAM_H
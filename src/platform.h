@@ -0,0 +1,70 @@
+/* platform.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+
+#include <windows.h>
+#include <tchar.h>
+
+#define PATH_SEP '\\'
+
+#else
+
+// POSIX builds work on narrow UTF-8 strings. Map the subset of the generic-text
+// routines from tchar.h and the Win32 types the program relies on, so that the
+// sources don't need to be littered with conditionals
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef char TCHAR;
+typedef uint16_t WORD;
+
+typedef struct _SYSTEMTIME {
+    WORD wYear;
+    WORD wMonth;
+    WORD wDayOfWeek;
+    WORD wDay;
+    WORD wHour;
+    WORD wMinute;
+    WORD wSecond;
+    WORD wMilliseconds;
+} SYSTEMTIME;
+
+#define _T(x) x
+#define _TEOF EOF
+
+#define _tmain main
+#define _tcslen strlen
+#define _tcschr strchr
+#define _tcsrchr strrchr
+#define _tcscmp strcmp
+#define _tcsdup strdup
+#define _tfopen fopen
+#define _tprintf printf
+#define _putts puts
+#define _puttc putc
+#define _vftprintf vfprintf
+#define _vsntprintf vsnprintf
+#define _fputts fputs
+#define _sntprintf snprintf
+#define _tremove remove
+
+// MSVC source annotation language
+#define _Printf_format_string_
+
+#define PATH_SEP '/'
+
+#endif
+
+#endif // PLATFORM_H
@@ -0,0 +1,76 @@
+/* probes.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef PROBES_H
+#define PROBES_H
+
+// Static tracepoints for perf, bpftrace and other tools that read SystemTap
+// SDT notes, such as:
+//
+//   bpftrace -e 'usdt:./touch:touch:touch_end { @[arg1] = count(); }'
+//
+// Each probe is a single nop at its site, described by an ELF note that names
+// it and tells the tracer where its arguments live. The notes are written out
+// here rather than through <sys/sdt.h>, so no SystemTap headers are needed to
+// build. Builds without TOUCH_PROBES, or for other platforms, compile every
+// probe to nothing and never evaluate its arguments.
+//
+// Probes of the "touch" provider, all taking the path or stamp they act on:
+//
+//   touch_start, touch_end          touch() of one file
+//   open_start, open_end            Opening the file to set its times
+//   set_times_start, set_times_end  Setting the times of the file
+//   parse_start, parse_end          Parsing a timestamp, whose text is passed
+//   error                           Reporting an error
+//
+// The *_end probes also take the result: 1 for success and 0 for failure.
+// The error probe takes the error code instead.
+
+#if defined(TOUCH_PROBES) && defined(__linux__) && defined(__GNUC__) && \
+   (defined(__x86_64__) || defined(__aarch64__))
+
+#define PROBE_NOTE(name, args) \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f, 994f-993f, 3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: .8byte 990b\n" \
+    ".8byte _.stapsdt.base\n" \
+    ".8byte 0\n" \
+    ".asciz \"touch\"\n" \
+    ".asciz \"" name "\"\n" \
+    ".asciz \"" args "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base, 1\n" \
+    ".popsection\n" \
+    ".endif\n"
+
+// Arguments are passed as an unsigned 64-bit pointer and a signed 64-bit
+// result, described to the tracer as "8@REG" and "-8@REG"
+#define PROBE(name, path) \
+    __asm__ __volatile__(PROBE_NOTE(#name, "8@%0") :: "r"((const void *)(path)))
+
+#define PROBE_RESULT(name, path, result) \
+    __asm__ __volatile__(PROBE_NOTE(#name, "8@%0 -8@%1") :: \
+        "r"((const void *)(path)), "r"((long long)(result)))
+
+#else
+
+#define PROBE(name, path) ((void)0)
+#define PROBE_RESULT(name, path, result) ((void)0)
+
+#endif
+
+#endif // PROBES_H
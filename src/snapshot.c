@@ -0,0 +1,669 @@
+/* snapshot.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Layout of a snapshot file. All integers are little-endian.
+//
+//   Header   "TOUCHSNP", u32 version, u32 entries per block, u64 entry count,
+//            u64 offset of the block index
+//   Blocks   The entries, sorted by path
+//   Index    u64 offset of each block from the start of the file
+//
+// Every entry of a block is made up of
+//
+//   varint   Length of the prefix shared with the previous path of the block
+//   varint   Length of the rest of the path
+//   bytes    Rest of the path, in UTF-8
+//   varint   Creation, last access and last write times, each as the
+//   x3       zigzag-encoded difference from the same time of the previous
+//            entry of the block
+//
+// The first entry of a block is stored against an empty path and zero times,
+// so that each block decodes on its own.
+
+#include "snapshot.h"
+#include "treewalk.h"
+#include "workpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#define SNAPSHOT_MAGIC "TOUCHSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 32
+
+// Number of entries per block
+#define SNAPSHOT_BLOCK_ENTRIES 64
+
+// Maximum size of a path in bytes, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Maximum size of a path in UTF-8. A UTF-16 code unit takes at most three bytes
+#define PATH_BYTES_CAPACITY (PATH_CAPACITY * 3)
+
+// Maximum size of an encoded varint
+#define VARINT_MAX 10
+
+/*!
+ * @brief
+ * A file recorded during a capture.
+ */
+typedef struct capture_entry {
+    // Offset of the UTF-8 path in the capture's character buffer, later
+    // resolved to a pointer for sorting
+    size_t offset;
+    const char *path;
+    size_t len;
+    FsTimes times;
+} CaptureEntry;
+
+/*!
+ * @brief
+ * State shared by all threads of a capture.
+ */
+typedef struct capture {
+    const SnapshotOptions *opts;
+
+    // Guards the members below
+    mtx_t lock;
+    CaptureEntry *entries;
+    size_t count;
+    size_t capacity;
+    char *chars;
+    size_t used;
+    size_t chars_capacity;
+} Capture;
+
+/*!
+ * @brief
+ * Outcome of restoring a block of a snapshot.
+ */
+typedef struct block_result {
+    bool corrupt;
+    bool no_memory;
+    // Entries that could not be restored, in the order they were stored
+    size_t failure_count;
+    TCHAR **failed_paths;
+    FsError *failed_errors;
+} BlockResult;
+
+/*!
+ * @brief
+ * State shared by all threads of a restore.
+ */
+typedef struct restore {
+    const SnapshotOptions *opts;
+    const unsigned char *data;
+    uint64_t index_offset;
+    uint64_t entry_count;
+    uint32_t block_entries;
+    uint64_t block_count;
+    BlockResult *results;
+} Restore;
+
+static void put_u32(unsigned char *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    uint32_t value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)p[i] << (i * 8);
+    }
+
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)p[i] << (i * 8);
+    }
+
+    return value;
+}
+
+/*!
+ * @return
+ * The number of bytes written to \p p, at most VARINT_MAX.
+ */
+static size_t put_varint(unsigned char *p, uint64_t value) {
+    size_t n = 0;
+
+    while (value >= 0x80) {
+        p[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    p[n++] = (unsigned char)value;
+    return n;
+}
+
+/*!
+ * @brief
+ * Reads a varint from [*p, end) and advances *p past it.
+ *
+ * @return
+ * false if the varint is truncated or too long.
+ */
+static bool get_varint(const unsigned char **p, const unsigned char *end, uint64_t *out) {
+    uint64_t value = 0;
+
+    for (unsigned int shift = 0; shift < 64 && *p < end; shift += 7) {
+        unsigned char byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80)) {
+            *out = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Differences between times wrap around, so that FS_TIME_OMIT and times
+// before a previous one take no special handling
+static uint64_t zigzag_encode(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t)-(int64_t)(delta >> 63);
+}
+
+static uint64_t zigzag_decode(uint64_t value) {
+    return (value >> 1) ^ (uint64_t)-(int64_t)(value & 1);
+}
+
+/*!
+ * @brief
+ * Appends a file and its timestamps to a capture.
+ *
+ * @return
+ * FS_OK if the file was added; a backend error code otherwise.
+ */
+static FsError capture_add(Capture *cap, const TCHAR *path, const FsTimes *times) {
+#ifdef UNICODE
+    char utf8[PATH_BYTES_CAPACITY];
+    int len = WideCharToMultiByte(CP_UTF8, 0, path, -1, utf8, PATH_BYTES_CAPACITY, NULL, NULL);
+
+    if (len <= 0) {
+        return FS_ERR_NAME_TOO_LONG;
+    }
+
+    // The length includes the terminating null character
+    size_t size = (size_t)len;
+#else
+    const char *utf8 = path;
+    size_t size = strlen(path) + 1;
+#endif
+
+    FsError err = FS_OK;
+
+    mtx_lock(&cap->lock);
+
+    if (cap->count == cap->capacity) {
+        size_t capacity = cap->capacity ? cap->capacity * 2 : 4096;
+        CaptureEntry *entries = realloc(cap->entries, capacity * sizeof(CaptureEntry));
+
+        if (entries) {
+            cap->entries = entries;
+            cap->capacity = capacity;
+        } else {
+            err = FS_ERR_NO_MEMORY;
+        }
+    }
+
+    if (err == FS_OK && cap->used + size > cap->chars_capacity) {
+        size_t capacity = cap->chars_capacity ? cap->chars_capacity * 2 : (1 << 20);
+
+        while (capacity < cap->used + size) {
+            capacity *= 2;
+        }
+
+        char *chars = realloc(cap->chars, capacity);
+
+        if (chars) {
+            cap->chars = chars;
+            cap->chars_capacity = capacity;
+        } else {
+            err = FS_ERR_NO_MEMORY;
+        }
+    }
+
+    if (err == FS_OK) {
+        memcpy(&cap->chars[cap->used], utf8, size);
+
+        cap->entries[cap->count++] = (CaptureEntry) {
+            .offset = cap->used,
+            .len = size - 1,
+            .times = *times
+        };
+
+        cap->used += size;
+    }
+
+    mtx_unlock(&cap->lock);
+
+    return err;
+}
+
+/*!
+ * @brief
+ * Tree walk callback that records an entry found below a root.
+ */
+static FsError capture_visit(void *ctx, const TCHAR *path) {
+    Capture *cap = ctx;
+    FsTimes times;
+
+    if (!fs_stat_times(path, cap->opts->follow_symlinks, &times)) {
+        return fs_last_error();
+    }
+
+    return capture_add(cap, path, &times);
+}
+
+/*!
+ * @brief
+ * Tree walk callback that passes failures on to the caller's report callback.
+ */
+static void capture_report(void *ctx, const TCHAR *path, FsError err) {
+    const Capture *cap = ctx;
+    cap->opts->report(cap->opts->ctx, path, err);
+}
+
+static int compare_entries(const void *a, const void *b) {
+    return strcmp(((const CaptureEntry *)a)->path, ((const CaptureEntry *)b)->path);
+}
+
+/*!
+ * @brief
+ * Writes the sorted entries of a capture to a snapshot file.
+ *
+ * @return
+ * true if the whole file was written; false otherwise.
+ */
+static bool write_snapshot(const TCHAR *snapshot_path, const Capture *cap) {
+    FILE *fp = _tfopen(snapshot_path, _T("wb"));
+
+    if (!fp) {
+        return false;
+    }
+
+    uint64_t block_count = (cap->count + SNAPSHOT_BLOCK_ENTRIES - 1) / SNAPSHOT_BLOCK_ENTRIES;
+    unsigned char *index = malloc((size_t)block_count * 8 + 1);
+    unsigned char header[SNAPSHOT_HEADER_SIZE] = { 0 };
+    // Room for the largest encoded entry, save for its path
+    unsigned char buf[VARINT_MAX * 5];
+
+    bool ok = index && fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+    uint64_t offset = SNAPSHOT_HEADER_SIZE;
+
+    const CaptureEntry *prev = NULL;
+
+    for (size_t i = 0; ok && i < cap->count; i++) {
+        const CaptureEntry *entry = &cap->entries[i];
+
+        if (i % SNAPSHOT_BLOCK_ENTRIES == 0) {
+            put_u64(&index[(i / SNAPSHOT_BLOCK_ENTRIES) * 8], offset);
+            prev = NULL;
+        }
+
+        size_t prefix = 0;
+        FsTimes base = { 0 };
+
+        if (prev) {
+            while (prefix < prev->len && prefix < entry->len &&
+                   prev->path[prefix] == entry->path[prefix]) {
+                prefix++;
+            }
+
+            base = prev->times;
+        }
+
+        size_t suffix = entry->len - prefix;
+        size_t n = put_varint(buf, prefix);
+        n += put_varint(buf + n, suffix);
+
+        ok = fwrite(buf, 1, n, fp) == n &&
+             fwrite(entry->path + prefix, 1, suffix, fp) == suffix;
+
+        offset += n + suffix;
+
+        n = put_varint(buf, zigzag_encode(entry->times.creation - base.creation));
+        n += put_varint(buf + n, zigzag_encode(entry->times.access - base.access));
+        n += put_varint(buf + n, zigzag_encode(entry->times.write - base.write));
+
+        ok = ok && fwrite(buf, 1, n, fp) == n;
+        offset += n;
+
+        prev = entry;
+    }
+
+    if (ok) {
+        ok = fwrite(index, 1, (size_t)block_count * 8, fp) == (size_t)block_count * 8;
+    }
+
+    // The header goes last, so that an interrupted capture leaves no valid
+    // snapshot behind
+    memcpy(header, SNAPSHOT_MAGIC, 8);
+    put_u32(header + 8, SNAPSHOT_VERSION);
+    put_u32(header + 12, SNAPSHOT_BLOCK_ENTRIES);
+    put_u64(header + 16, cap->count);
+    put_u64(header + 24, offset);
+
+    ok = ok &&
+         fseek(fp, 0, SEEK_SET) == 0 &&
+         fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+
+    ok &= (fclose(fp) == 0);
+    free(index);
+
+    return ok;
+}
+
+SnapshotStatus snapshot_capture(
+    const TCHAR *snapshot_path,
+    const TCHAR *const *roots, size_t count,
+    const SnapshotOptions *opts) {
+
+    Capture cap = { .opts = opts };
+    const TCHAR **dirs = malloc((count + 1) * sizeof(TCHAR *));
+
+    if (!dirs || mtx_init(&cap.lock, mtx_plain) != thrd_success) {
+        free(dirs);
+        return SNAPSHOT_NO_MEMORY;
+    }
+
+    bool all_ok = true;
+    bool out_of_memory = false;
+    size_t dir_count = 0;
+
+    // The roots themselves are recorded too, unlike in a recursive touch
+    for (size_t i = 0; i < count; i++) {
+        FsError err = capture_visit(&cap, roots[i]);
+
+        if (err != FS_OK) {
+            opts->report(opts->ctx, roots[i], err);
+            out_of_memory |= (err == FS_ERR_NO_MEMORY);
+            all_ok = false;
+            continue;
+        }
+
+        if (tree_is_walkable_dir(roots[i], opts->follow_symlinks)) {
+            dirs[dir_count++] = roots[i];
+        }
+    }
+
+    TreeWalk walk = {
+        .visit = capture_visit,
+        .report = capture_report,
+        .ctx = &cap,
+        .threads = opts->threads
+    };
+
+    all_ok &= tree_walk(&walk, dirs, dir_count);
+
+    // Pointers are only stable now that the character buffer is done growing
+    for (size_t i = 0; i < cap.count; i++) {
+        cap.entries[i].path = &cap.chars[cap.entries[i].offset];
+    }
+
+    qsort(cap.entries, cap.count, sizeof(CaptureEntry), compare_entries);
+
+    SnapshotStatus status = out_of_memory ? SNAPSHOT_NO_MEMORY :
+                            !write_snapshot(snapshot_path, &cap) ? SNAPSHOT_IO_ERROR :
+                            all_ok ? SNAPSHOT_OK : SNAPSHOT_ENTRY_ERRORS;
+
+    mtx_destroy(&cap.lock);
+    free(cap.entries);
+    free(cap.chars);
+    free(dirs);
+
+    return status;
+}
+
+/*!
+ * @brief
+ * Records a file that could not be restored.
+ *
+ * @return
+ * false if memory could not be allocated.
+ */
+static bool add_failure(BlockResult *result, const TCHAR *path, FsError err) {
+    if (!result->failed_paths) {
+        result->failed_paths = malloc(SNAPSHOT_BLOCK_ENTRIES * sizeof(TCHAR *));
+        result->failed_errors = malloc(SNAPSHOT_BLOCK_ENTRIES * sizeof(FsError));
+
+        if (!result->failed_paths || !result->failed_errors) {
+            return false;
+        }
+    }
+
+    TCHAR *copy = _tcsdup(path);
+
+    if (!copy) {
+        return false;
+    }
+
+    result->failed_paths[result->failure_count] = copy;
+    result->failed_errors[result->failure_count] = err;
+    result->failure_count++;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Work pool callback that decodes a block of a snapshot straight from the
+ * mapped file and restores the timestamps of its entries.
+ */
+static void restore_block(void *ctx, size_t index) {
+    Restore *rs = ctx;
+    BlockResult *result = &rs->results[index];
+    const SnapshotOptions *opts = rs->opts;
+
+    uint64_t start = get_u64(rs->data + rs->index_offset + index * 8);
+    uint64_t end = (index + 1 < rs->block_count) ?
+        get_u64(rs->data + rs->index_offset + (index + 1) * 8) :
+        rs->index_offset;
+
+    if (start < SNAPSHOT_HEADER_SIZE || start > end || end > rs->index_offset) {
+        result->corrupt = true;
+        return;
+    }
+
+    char *path = malloc(PATH_BYTES_CAPACITY);
+
+#ifdef UNICODE
+    TCHAR *tpath = malloc(PATH_CAPACITY * sizeof(TCHAR));
+#else
+    TCHAR *tpath = path;
+#endif
+
+    if (!path || !tpath) {
+        result->no_memory = true;
+        free(path);
+#ifdef UNICODE
+        free(tpath);
+#endif
+        return;
+    }
+
+    const unsigned char *p = rs->data + start;
+    const unsigned char *p_end = rs->data + end;
+
+    uint64_t first = (uint64_t)index * rs->block_entries;
+    uint64_t entries = rs->entry_count - first;
+
+    if (entries > rs->block_entries) {
+        entries = rs->block_entries;
+    }
+
+    size_t len = 0;
+    FsTimes times = { 0 };
+
+    for (uint64_t i = 0; i < entries; i++) {
+        uint64_t prefix, suffix, creation, access, write;
+
+        if (!get_varint(&p, p_end, &prefix) ||
+            !get_varint(&p, p_end, &suffix) ||
+            prefix > len || suffix > (uint64_t)(p_end - p) ||
+            prefix + suffix >= PATH_BYTES_CAPACITY) {
+            result->corrupt = true;
+            break;
+        }
+
+        memcpy(path + prefix, p, (size_t)suffix);
+        p += suffix;
+        len = (size_t)(prefix + suffix);
+        path[len] = '\0';
+
+        if (!get_varint(&p, p_end, &creation) ||
+            !get_varint(&p, p_end, &access) ||
+            !get_varint(&p, p_end, &write)) {
+            result->corrupt = true;
+            break;
+        }
+
+        times.creation += zigzag_decode(creation);
+        times.access += zigzag_decode(access);
+        times.write += zigzag_decode(write);
+
+#ifdef UNICODE
+        if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path, -1, tpath, PATH_CAPACITY) <= 0) {
+            result->corrupt = true;
+            break;
+        }
+#endif
+
+        // Only restore what was recorded; creation times are unknown on some
+        // file systems
+        FileTimeFlags ft_flags = opts->ft_flags;
+
+        if (times.creation == FS_TIME_OMIT) {
+            ft_flags &= ~FT_CREATION;
+        }
+
+        if (times.access == FS_TIME_OMIT) {
+            ft_flags &= ~FT_ACCESS;
+        }
+
+        if (times.write == FS_TIME_OMIT) {
+            ft_flags &= ~FT_WRITE;
+        }
+
+        if (!ft_flags) {
+            continue;
+        }
+
+        TimestampOperation op = prepare_timestamp(NULL, &times, ft_flags, 0);
+
+        if (!touch(tpath, true, opts->follow_symlinks, &op) &&
+            !add_failure(result, tpath, fs_last_error())) {
+            result->no_memory = true;
+            break;
+        }
+    }
+
+    free(path);
+#ifdef UNICODE
+    free(tpath);
+#endif
+}
+
+SnapshotStatus snapshot_restore(const TCHAR *snapshot_path, const SnapshotOptions *opts) {
+    FsMapping map;
+
+    if (!fs_map_file(snapshot_path, &map)) {
+        return SNAPSHOT_IO_ERROR;
+    }
+
+    const unsigned char *data = map.data;
+
+    if (map.size < SNAPSHOT_HEADER_SIZE ||
+        memcmp(data, SNAPSHOT_MAGIC, 8) != 0 ||
+        get_u32(data + 8) != SNAPSHOT_VERSION) {
+        fs_unmap_file(&map);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+
+    Restore rs = {
+        .opts = opts,
+        .data = data,
+        .block_entries = get_u32(data + 12),
+        .entry_count = get_u64(data + 16),
+        .index_offset = get_u64(data + 24)
+    };
+
+    // Blocks are always written SNAPSHOT_BLOCK_ENTRIES entries long, which
+    // is also what the failures of a block are sized for
+    if (rs.block_entries != SNAPSHOT_BLOCK_ENTRIES ||
+        rs.index_offset < SNAPSHOT_HEADER_SIZE ||
+        rs.index_offset > map.size) {
+        fs_unmap_file(&map);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+
+    rs.block_count = rs.entry_count / rs.block_entries +
+                     (rs.entry_count % rs.block_entries != 0);
+
+    if (rs.block_count > (map.size - rs.index_offset) / 8) {
+        fs_unmap_file(&map);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+
+    rs.results = calloc((size_t)rs.block_count + 1, sizeof(BlockResult));
+
+    if (!rs.results) {
+        fs_unmap_file(&map);
+        return SNAPSHOT_NO_MEMORY;
+    }
+
+    workpool_run(opts->threads, (size_t)rs.block_count, restore_block, &rs);
+
+    SnapshotStatus status = SNAPSHOT_OK;
+
+    // Report failures in the order the entries are stored, regardless of the
+    // order the blocks were processed in
+    for (uint64_t i = 0; i < rs.block_count; i++) {
+        BlockResult *result = &rs.results[i];
+
+        for (size_t j = 0; j < result->failure_count; j++) {
+            opts->report(opts->ctx, result->failed_paths[j], result->failed_errors[j]);
+            free(result->failed_paths[j]);
+
+            if (status == SNAPSHOT_OK) {
+                status = SNAPSHOT_ENTRY_ERRORS;
+            }
+        }
+
+        if (result->corrupt && status != SNAPSHOT_NO_MEMORY) {
+            status = SNAPSHOT_BAD_FORMAT;
+        }
+
+        if (result->no_memory) {
+            status = SNAPSHOT_NO_MEMORY;
+        }
+
+        free(result->failed_paths);
+        free(result->failed_errors);
+    }
+
+    free(rs.results);
+    fs_unmap_file(&map);
+
+    return status;
+}
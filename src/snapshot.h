@@ -0,0 +1,113 @@
+/* snapshot.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "fsbackend.h"
+#include "touchop.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*!
+ * @brief
+ * Result of capturing or restoring a snapshot.
+ */
+typedef enum snapshot_status {
+    SNAPSHOT_OK,
+    // Some entries could not be captured or restored; each one was reported
+    SNAPSHOT_ENTRY_ERRORS,
+    // The snapshot file could not be opened, read or written
+    SNAPSHOT_IO_ERROR,
+    // The file is not a snapshot, or it is damaged
+    SNAPSHOT_BAD_FORMAT,
+    SNAPSHOT_NO_MEMORY
+} SnapshotStatus;
+
+/*!
+ * @brief
+ * Callback invoked for every entry that could not be captured or restored.
+ * Calls are serialized.
+ *
+ * @param ctx
+ * Context pointer of the operation.
+ *
+ * @param path
+ * Path to the entry that failed.
+ *
+ * @param err
+ * The backend error code of the failure.
+ */
+typedef void (*SnapshotReportFn)(void *ctx, const TCHAR *path, FsError err);
+
+/*!
+ * @brief
+ * Options shared by snapshot_capture() and snapshot_restore().
+ */
+typedef struct snapshot_options {
+    // Specifies whether to follow symbolic links, or operate on the links themselves
+    bool follow_symlinks;
+    // Timestamps to restore. Ignored by snapshot_capture(), which records all
+    FileTimeFlags ft_flags;
+    // Number of threads to use, including the calling thread
+    unsigned int threads;
+    SnapshotReportFn report;
+    void *ctx;
+} SnapshotOptions;
+
+/*!
+ * @brief
+ * Records the timestamps of the given files, and of everything below those
+ * that are directories, into a snapshot file.
+ *
+ * Entries are sorted by path and stored in blocks of fixed entry count. Paths
+ * are front-coded against the previous path of their block, and timestamps
+ * are stored as variable-length differences from the previous entry, so that
+ * a snapshot takes a few bytes per file. Every block can be decoded on its
+ * own, which lets snapshot_restore() process blocks in parallel.
+ *
+ * @param snapshot_path
+ * Path to the snapshot file to create. An existing file is replaced.
+ *
+ * @param roots
+ * Array of paths to record. Paths are stored as given and as reached from
+ * them, so relative roots make a snapshot that can be restored elsewhere.
+ *
+ * @param count
+ * Number of elements in \p roots.
+ *
+ * @param opts
+ * Pointer to the options of the operation.
+ *
+ * @return
+ * A SnapshotStatus describing the result. The snapshot is written unless
+ * SNAPSHOT_IO_ERROR or SNAPSHOT_NO_MEMORY is returned.
+ */
+SnapshotStatus snapshot_capture(
+    const TCHAR *snapshot_path,
+    const TCHAR *const *roots, size_t count,
+    const SnapshotOptions *opts);
+
+/*!
+ * @brief
+ * Restores the timestamps recorded in a snapshot file. The file is mapped
+ * into memory and its blocks are decoded in place by a pool of threads.
+ * Files that no longer exist are skipped, and no file is created.
+ *
+ * @param snapshot_path
+ * Path to the snapshot file.
+ *
+ * @param opts
+ * Pointer to the options of the operation.
+ *
+ * @return
+ * A SnapshotStatus describing the result.
+ */
+SnapshotStatus snapshot_restore(const TCHAR *snapshot_path, const SnapshotOptions *opts);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,507 @@
+/* stats.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "stats.h"
+#include "fsbackend.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <time.h>
+#endif
+
+// Number of latency buckets. Bucket i counts latencies of at least 2^i and
+// less than 2^(i+1) nanoseconds; the last one also takes anything longer
+#define STATS_BUCKETS 40
+
+// Number of slowest paths that are kept
+#define STATS_SLOWEST 10
+
+// Size of the padding around the counters of each thread
+#define STATS_CACHE_LINE 64
+
+// Width of the longest bar of a printed histogram
+#define STATS_BAR_WIDTH 40
+
+#ifdef FS_COUNT_SYSCALLS
+#define SYSCALLS() fs_syscalls
+#else
+#define SYSCALLS() 0ULL
+#endif
+
+typedef struct phase_stats {
+    unsigned long long calls;
+    unsigned long long syscalls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    unsigned long long buckets[STATS_BUCKETS];
+} PhaseStats;
+
+typedef struct slow_path {
+    TCHAR *path;
+    uint64_t ns;
+    StatsPhase phase;
+} SlowPath;
+
+/*!
+ * @brief
+ * The counters of one thread. A slot outlives its thread and is handed to the
+ * next thread that starts, so short-lived worker pools don't pile them up.
+ */
+typedef struct stats_slot {
+    // Keeps the counters off cache lines shared with neighbouring allocations,
+    // which may be written by other threads
+    char lead[STATS_CACHE_LINE];
+
+    PhaseStats phases[STATS_PHASE_COUNT];
+    // The slowest paths seen, in no particular order
+    SlowPath slowest[STATS_SLOWEST];
+    size_t slowest_count;
+
+    // Links every slot, and separately those not owned by a thread
+    struct stats_slot *next;
+    struct stats_slot *next_free;
+
+    char trail[STATS_CACHE_LINE];
+} StatsSlot;
+
+static const TCHAR *const phase_names[STATS_PHASE_COUNT] = {
+    _T("parse"),
+    _T("touch"),
+    _T("set_by_path"),
+    _T("stat"),
+    _T("open"),
+    _T("set_file_time"),
+    _T("adjust_file_time"),
+    _T("close"),
+    _T("batch_run"),
+    _T("report")
+};
+
+static bool enabled;
+static mtx_t slots_lock;
+// Set for every thread that owns a slot, so it is released when the thread ends
+static tss_t slot_key;
+static StatsSlot *all_slots;
+static StatsSlot *free_slots;
+static thread_local StatsSlot *local_slot;
+
+#ifdef _WIN32
+static uint64_t ticks_per_second;
+
+static uint64_t clock_ns(void) {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+
+    // Split to keep the multiplication from overflowing
+    return (ticks / ticks_per_second) * 1000000000 +
+           (ticks % ticks_per_second) * 1000000000 / ticks_per_second;
+}
+#else
+static uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+static void release_slot(void *ptr) {
+    StatsSlot *slot = ptr;
+
+    mtx_lock(&slots_lock);
+    slot->next_free = free_slots;
+    free_slots = slot;
+    mtx_unlock(&slots_lock);
+}
+
+static StatsSlot *acquire_slot(void) {
+    mtx_lock(&slots_lock);
+
+    StatsSlot *slot = free_slots;
+
+    if (slot) {
+        free_slots = slot->next_free;
+    } else if ((slot = calloc(1, sizeof(StatsSlot)))) {
+        slot->next = all_slots;
+        all_slots = slot;
+    }
+
+    mtx_unlock(&slots_lock);
+
+    if (slot) {
+        tss_set(slot_key, slot);
+    }
+
+    return slot;
+}
+
+bool stats_enable(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    ticks_per_second = (uint64_t)freq.QuadPart;
+#endif
+
+    if (mtx_init(&slots_lock, mtx_plain) != thrd_success) {
+        return false;
+    }
+
+    if (tss_create(&slot_key, release_slot) != thrd_success) {
+        mtx_destroy(&slots_lock);
+        return false;
+    }
+
+    enabled = true;
+    return true;
+}
+
+StatsMark stats_start(void) {
+    StatsMark mark = { 0, 0 };
+
+    if (enabled) {
+        mark.ns = clock_ns();
+        mark.syscalls = SYSCALLS();
+    }
+
+    return mark;
+}
+
+static size_t bucket_of(uint64_t ns) {
+    size_t bucket = 0;
+
+    while (ns > 1 && bucket < STATS_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/*!
+ * @brief
+ * Finds where a path taking \p ns would go among the slowest ones.
+ *
+ * @return
+ * The index to store it at, or STATS_SLOWEST if it is not slow enough.
+ */
+static size_t rank_of(const SlowPath *slowest, size_t count, uint64_t ns) {
+    if (count < STATS_SLOWEST) {
+        return count;
+    }
+
+    size_t fastest = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        if (slowest[i].ns < slowest[fastest].ns) {
+            fastest = i;
+        }
+    }
+
+    return (ns > slowest[fastest].ns) ? fastest : STATS_SLOWEST;
+}
+
+static void rank_path(StatsSlot *slot, StatsPhase phase, const TCHAR *path, uint64_t ns) {
+    size_t rank = rank_of(slot->slowest, slot->slowest_count, ns);
+
+    if (rank == STATS_SLOWEST) {
+        return;
+    }
+
+    TCHAR *copy = _tcsdup(path);
+
+    if (!copy) {
+        return;
+    }
+
+    if (rank < slot->slowest_count) {
+        free(slot->slowest[rank].path);
+    } else {
+        slot->slowest_count++;
+    }
+
+    slot->slowest[rank] = (SlowPath) { copy, ns, phase };
+}
+
+/*!
+ * @brief
+ * Adds a sample to the counters of a thread.
+ */
+static void record(
+    StatsSlot *slot, StatsPhase phase,
+    uint64_t ns, unsigned long long syscalls, const TCHAR *path) {
+
+    PhaseStats *ps = &slot->phases[phase];
+
+    ps->calls++;
+    ps->syscalls += syscalls;
+    ps->total_ns += ns;
+    ps->buckets[bucket_of(ns)]++;
+
+    if (ns > ps->max_ns) {
+        ps->max_ns = ns;
+    }
+
+    if (path) {
+        rank_path(slot, phase, path, ns);
+    }
+}
+
+void stats_stop(StatsPhase phase, StatsMark start, const TCHAR *path) {
+    if (!enabled) {
+        return;
+    }
+
+    uint64_t ns = clock_ns() - start.ns;
+    unsigned long long syscalls = SYSCALLS() - start.syscalls;
+
+    // Callers report the error of the phase after it is recorded
+#ifdef _WIN32
+    DWORD saved_error = GetLastError();
+#else
+    int saved_error = errno;
+#endif
+
+    StatsSlot *slot = local_slot;
+
+    // The sample is dropped if the thread has no memory for its counters
+    if (slot || (slot = local_slot = acquire_slot())) {
+        record(slot, phase, ns, syscalls, path);
+    }
+
+#ifdef _WIN32
+    SetLastError(saved_error);
+#else
+    errno = saved_error;
+#endif
+}
+
+static int compare_slow_paths(const void *a, const void *b) {
+    const SlowPath *pa = a;
+    const SlowPath *pb = b;
+
+    return (pa->ns < pb->ns) - (pa->ns > pb->ns);
+}
+
+/*!
+ * @brief
+ * Estimates a latency percentile from a histogram, as the upper bound of the
+ * bucket it falls in, or the slowest latency seen if that is lower.
+ */
+static uint64_t percentile_ns(const PhaseStats *ps, double q) {
+    unsigned long long target = (unsigned long long)((double)ps->calls * q);
+    unsigned long long seen = 0;
+
+    for (size_t b = 0; b < STATS_BUCKETS - 1; b++) {
+        seen += ps->buckets[b];
+
+        if (seen > target) {
+            uint64_t bound = (uint64_t)1 << (b + 1);
+            return (bound < ps->max_ns) ? bound : ps->max_ns;
+        }
+    }
+
+    return ps->max_ns;
+}
+
+static void print_table(const PhaseStats *totals, const SlowPath *slowest, size_t slowest_count) {
+    _tprintf(_T("%-17s %10s %12s %10s %10s %10s %10s %10s\n"),
+        _T("phase"), _T("calls"), _T("total ms"), _T("syscalls"),
+        _T("mean us"), _T("p50 us"), _T("p99 us"), _T("max us"));
+
+    for (size_t p = 0; p < STATS_PHASE_COUNT; p++) {
+        const PhaseStats *ps = &totals[p];
+
+        if (ps->calls == 0) {
+            continue;
+        }
+
+        _tprintf(_T("%-17s %10llu %12.3f %10llu %10.2f %10.2f %10.2f %10.2f\n"),
+            phase_names[p], ps->calls,
+            (double)ps->total_ns / 1e6,
+            ps->syscalls,
+            (double)ps->total_ns / (double)ps->calls / 1e3,
+            (double)percentile_ns(ps, 0.50) / 1e3,
+            (double)percentile_ns(ps, 0.99) / 1e3,
+            (double)ps->max_ns / 1e3);
+    }
+
+    // Percentiles are bucket bounds, so the buckets are shown as well
+    for (size_t p = 0; p < STATS_PHASE_COUNT; p++) {
+        const PhaseStats *ps = &totals[p];
+        unsigned long long peak = 0;
+
+        if (ps->calls == 0) {
+            continue;
+        }
+
+        for (size_t b = 0; b < STATS_BUCKETS; b++) {
+            if (ps->buckets[b] > peak) {
+                peak = ps->buckets[b];
+            }
+        }
+
+        _tprintf(_T("\n%s latency\n"), phase_names[p]);
+
+        for (size_t b = 0; b < STATS_BUCKETS; b++) {
+            if (ps->buckets[b] == 0) {
+                continue;
+            }
+
+            size_t bar = (size_t)(ps->buckets[b] * STATS_BAR_WIDTH / peak);
+
+            _tprintf(_T("    < %12.2f us %10llu "),
+                (double)((uint64_t)1 << (b + 1)) / 1e3, ps->buckets[b]);
+
+            for (size_t i = 0; i < bar || i == 0; i++) {
+                _puttc('#', stdout);
+            }
+
+            _puttc('\n', stdout);
+        }
+    }
+
+    if (slowest_count > 0) {
+        _tprintf(_T("\nslowest paths\n"));
+    }
+
+    for (size_t i = 0; i < slowest_count; i++) {
+        _tprintf(_T("    %12.3f ms  %-17s %s\n"),
+            (double)slowest[i].ns / 1e6, phase_names[slowest[i].phase], slowest[i].path);
+    }
+}
+
+static void print_json_string(const TCHAR *str) {
+    _puttc('"', stdout);
+
+    for (; *str; str++) {
+        TCHAR c = *str;
+
+        if (c == '"' || c == '\\') {
+            _puttc('\\', stdout);
+            _puttc(c, stdout);
+#ifdef _WIN32
+        // Code units are escaped, since the console code page can't hold them
+        } else if (c < 0x20 || c > 0x7E) {
+#else
+        // Other bytes are passed through, as paths are UTF-8
+        } else if ((unsigned char)c < 0x20) {
+#endif
+            _tprintf(_T("\\u%04x"), (unsigned int)(c & 0xFFFF));
+        } else {
+            _puttc(c, stdout);
+        }
+    }
+
+    _puttc('"', stdout);
+}
+
+static void print_json(const PhaseStats *totals, const SlowPath *slowest, size_t slowest_count) {
+    bool first = true;
+
+    _tprintf(_T("{\n  \"phases\": ["));
+
+    for (size_t p = 0; p < STATS_PHASE_COUNT; p++) {
+        const PhaseStats *ps = &totals[p];
+        bool first_bucket = true;
+
+        if (ps->calls == 0) {
+            continue;
+        }
+
+        _tprintf(_T("%s\n    {\"name\": \"%s\", \"calls\": %llu, \"total_ns\": %llu, ")
+                 _T("\"syscalls\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, ")
+                 _T("\"histogram\": ["),
+            first ? _T("") : _T(","),
+            phase_names[p], ps->calls,
+            (unsigned long long)ps->total_ns,
+            ps->syscalls,
+            (unsigned long long)percentile_ns(ps, 0.50),
+            (unsigned long long)percentile_ns(ps, 0.99),
+            (unsigned long long)ps->max_ns);
+
+        for (size_t b = 0; b < STATS_BUCKETS; b++) {
+            if (ps->buckets[b] == 0) {
+                continue;
+            }
+
+            _tprintf(_T("%s{\"lt_ns\": %llu, \"count\": %llu}"),
+                first_bucket ? _T("") : _T(", "),
+                (unsigned long long)1 << (b + 1), ps->buckets[b]);
+
+            first_bucket = false;
+        }
+
+        _tprintf(_T("]}"));
+        first = false;
+    }
+
+    _tprintf(_T("\n  ],\n  \"slowest\": ["));
+
+    for (size_t i = 0; i < slowest_count; i++) {
+        _tprintf(_T("%s\n    {\"phase\": \"%s\", \"ns\": %llu, \"path\": "),
+            (i > 0) ? _T(",") : _T(""),
+            phase_names[slowest[i].phase],
+            (unsigned long long)slowest[i].ns);
+
+        print_json_string(slowest[i].path);
+        _puttc('}', stdout);
+    }
+
+    _tprintf(_T("\n  ]\n}\n"));
+}
+
+void stats_print(StatsFormat format) {
+    PhaseStats totals[STATS_PHASE_COUNT] = { 0 };
+    SlowPath slowest[STATS_SLOWEST];
+    size_t slowest_count = 0;
+
+    for (const StatsSlot *slot = all_slots; slot; slot = slot->next) {
+        for (size_t p = 0; p < STATS_PHASE_COUNT; p++) {
+            const PhaseStats *ps = &slot->phases[p];
+
+            totals[p].calls += ps->calls;
+            totals[p].syscalls += ps->syscalls;
+            totals[p].total_ns += ps->total_ns;
+
+            if (ps->max_ns > totals[p].max_ns) {
+                totals[p].max_ns = ps->max_ns;
+            }
+
+            for (size_t b = 0; b < STATS_BUCKETS; b++) {
+                totals[p].buckets[b] += ps->buckets[b];
+            }
+        }
+
+        for (size_t i = 0; i < slot->slowest_count; i++) {
+            size_t rank = rank_of(slowest, slowest_count, slot->slowest[i].ns);
+
+            if (rank == STATS_SLOWEST) {
+                continue;
+            }
+
+            if (rank == slowest_count) {
+                slowest_count++;
+            }
+
+            slowest[rank] = slot->slowest[i];
+        }
+    }
+
+    qsort(slowest, slowest_count, sizeof(SlowPath), compare_slow_paths);
+
+    if (format == STATS_FORMAT_JSON) {
+        print_json(totals, slowest, slowest_count);
+    } else {
+        print_table(totals, slowest, slowest_count);
+    }
+}
@@ -0,0 +1,105 @@
+/* stats.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "platform.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ * @brief
+ * The phases of a run that are timed when statistics are enabled.
+ */
+typedef enum stats_phase {
+    // Parsing a timestamp given by -t or a manifest row
+    STATS_PARSE,
+    // touch() of one file, from start to finish
+    STATS_TOUCH,
+    // Setting times by path, without opening the file: fixed ones, and ones
+    // adjusted by -A once they have been read
+    STATS_SET_BY_PATH,
+    // Reading the times of a file by path, for -u
+    STATS_STAT,
+    STATS_OPEN,
+    STATS_SET_FILE_TIME,
+    // Reading and writing back times that are adjusted by -A
+    STATS_ADJUST_FILE_TIME,
+    STATS_CLOSE,
+    // A set of opens, closes or stats handed to the batch executor as one
+    STATS_BATCH_RUN,
+    // Formatting and printing an error message
+    STATS_REPORT,
+    STATS_PHASE_COUNT
+} StatsPhase;
+
+typedef enum stats_format {
+    STATS_FORMAT_TABLE,
+    STATS_FORMAT_JSON
+} StatsFormat;
+
+/*!
+ * @brief
+ * The point a timed phase started at, as returned by stats_start().
+ */
+typedef struct stats_mark {
+    uint64_t ns;
+    unsigned long long syscalls;
+} StatsMark;
+
+/*!
+ * @brief
+ * Starts collecting statistics. Until this is called, timing a phase costs a
+ * single branch.
+ *
+ * @return
+ * true if statistics are collected; false if memory could not be allocated.
+ */
+bool stats_enable(void);
+
+/*!
+ * @brief
+ * Marks the start of a phase on the calling thread.
+ *
+ * @return
+ * The mark to pass to stats_stop(), which is empty if statistics are not
+ * collected.
+ */
+StatsMark stats_start(void);
+
+/*!
+ * @brief
+ * Records a phase that started at \p start. Each thread records into
+ * counters of its own, so threads never contend or share cache lines.
+ *
+ * @param phase
+ * The phase that ended.
+ *
+ * @param start
+ * The mark returned by stats_start() when the phase began.
+ *
+ * @param path
+ * The file the phase worked on, which is ranked among the slowest, or NULL if
+ * the phase is part of a larger one that is ranked instead.
+ */
+void stats_stop(StatsPhase phase, StatsMark start, const TCHAR *path);
+
+/*!
+ * @brief
+ * Prints the statistics of every thread to standard output: the number of
+ * calls, cumulative time, system calls and latency distribution of each
+ * phase, and the slowest paths. Must be called once all threads that record
+ * are done.
+ *
+ * @param format
+ * Whether to print a table or a JSON document.
+ */
+void stats_print(StatsFormat format);
+
+#endif // STATS_H
@@ -5,17 +5,30 @@
  * of the MIT license. See the LICENSE file for details.
  */
 
-#define WIN32_LEAN_AND_MEAN
-
 #include <limits.h>
-#include <windows.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "timeparse.h"
+#include "fsbackend.h"
+#include "caltime.h"
+#include "localzone.h"
+
+// The fixed-width fast path loads characters into 64-bit words and relies on
+// the first character landing in the lowest byte
+#if !defined(TIMEPARSE_NO_SWAR) && \
+    (defined(_WIN32) || \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define TIMEPARSE_SWAR
+#endif
 
  // Win32 epoch is January 1, 1601
 #define SYSTIME_YEAR_MIN 1601
 #define SYSTIME_YEAR_MAX 30827
 
+// Number of timestamps that parse_timestamps() takes through each stage at once
+#define BATCH_BLOCK_SIZE 64
+
 /*!
  * @brief
  * Specifies the format style for parsing timestamps.
@@ -53,75 +66,6 @@ static inline bool is_digit(TCHAR ch) {
     return ch >= '0' && ch <= '9';
 }
 
-/*!
- * @brief
- * Checks if the given year is a leap year.
- * 
- * @param year
- * The year to check.
- * 
- * @return
- * true if the year is a leap year; false otherwise.
- */
-static bool is_leap_year(WORD year) {
-    // Appendix C https://www.rfc-editor.org/rfc/rfc3339
-    return (year % 400 == 0) || ((year % 4 == 0) && (year % 100 != 0));
-}
-
-/*!
- * @brief
- * Determines the number of days in the given year and month.
- * 
- * @param year
- * The year.
- * 
- * @param month
- * The month (1-12).
- * 
- * @return
- * The number of days in the month, accounting for leap years if necessary.
- */
-static WORD days_in_month(WORD year, WORD month) {
-    static const WORD days[] = {
-        31, 28, 31, 30, 31, 30,
-        31, 31, 30, 31, 30, 31
-    };
-
-    if (month == 2 && is_leap_year(year)) {
-        return 29;
-    }
-
-    return days[month - 1];
-}
-
-/*!
- * @brief
- * Determines the day of the week for a given date.
- * 
- * @param year
- * The year of the date.
- * 
- * @param month
- * The month of the date (1-12).
- * 
- * @param day
- * The day of the date (1-31).
- * 
- * @return
- * The day of the week, where Sunday=0, Monday=1, ..., Saturday=6.
- */
-static WORD day_of_week(WORD year, WORD month, WORD day) {
-    // https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week#Sakamoto's_methods
-    static const WORD t[] = {
-        0, 3, 2, 5, 0, 3,
-        5, 1, 4, 6, 2, 4
-    };
-
-    year -= (month < 3);
-
-    return (year + (year / 4) - (year / 100) + (year / 400) + t[month - 1] + day) % 7;
-}
-
 /*!
  * @brief
  * Determines the number of ISO weeks in the specified year.
@@ -133,12 +77,12 @@ static WORD day_of_week(WORD year, WORD month, WORD day) {
  * 53 if the ISO week-based year contains 53 weeks; otherwise 52.
  */
 static WORD iso_weeks_in_year(WORD year) {
-    WORD jan1_wday = day_of_week(year, 1, 1);
+    int32_t jan1_wday = cal_day_of_week(cal_days_from_civil(year, 1, 1));
 
     // 53-week years occur on all years that have Thursday as 1 January and on
     // leap years that start on Wednesday
     if (jan1_wday == 4 ||
-       (jan1_wday == 3 && is_leap_year(year))) {
+       (jan1_wday == 3 && cal_is_leap_year(year))) {
         return 53;
     }
 
@@ -165,28 +109,17 @@ static WORD iso_weeks_in_year(WORD year) {
 static bool iso_ordinal_date_to_systemtime(
     WORD year, WORD ordinal_day, SYSTEMTIME *out) {
 
-    WORD max_days = is_leap_year(year) ? 366 : 365;
-
-    if (ordinal_day < 1 || ordinal_day > max_days) {
+    if (ordinal_day < 1 ||
+        ordinal_day > cal_days_before_month[cal_is_leap_year(year)][12]) {
         return false;
     }
 
-    WORD month = 1;
-
-    while (true) {
-        WORD dim = days_in_month(year, month);
-
-        if (ordinal_day <= dim) {
-            break;
-        }
-
-        ordinal_day -= dim;
-        month++;
-    }
+    int32_t month, day;
+    cal_month_from_ordinal(year, ordinal_day, &month, &day);
 
     out->wYear = year;
-    out->wMonth = month;
-    out->wDay = ordinal_day;
+    out->wMonth = (WORD)month;
+    out->wDay = (WORD)day;
 
     return true;
 }
@@ -215,38 +148,27 @@ static bool iso_week_date_to_systemtime(
     WORD year, WORD iso_week, WORD iso_weekday,
     SYSTEMTIME *out) {
 
-    SYSTEMTIME jan4 = {
-        .wYear = year,
-        .wMonth = 1,
-        .wDay = 4
-    };
+    // Week 1 is the week containing January 4
+    int32_t jan4 = cal_days_from_civil(year, 1, 4);
+    int32_t weekday = cal_day_of_week(jan4);
+    weekday = (weekday == 0) ? 7 : weekday;
 
-    FILETIME ft;
+    int32_t days = jan4 - (weekday - 1) + ((iso_week - 1) * 7) + (iso_weekday - 1);
 
-    if (!SystemTimeToFileTime(&jan4, &ft)) {
+    // The first days of week 1 may fall before the epoch
+    if (days < 0) {
         return false;
     }
 
-    ULARGE_INTEGER uli = { 0 };
-    uli.LowPart = ft.dwLowDateTime;
-    uli.HighPart = ft.dwHighDateTime;
+    int32_t y, m, d;
+    cal_civil_from_days(days, &y, &m, &d);
 
-    WORD weekday = day_of_week(year, 1, 4);
-    weekday = (weekday == 0) ? 7 : weekday;
-
-    LONG day_offset = -(weekday - 1) + ((iso_week - 1) * 7) + (iso_weekday - 1);
-
-    LONGLONG ticks = (LONGLONG)uli.QuadPart;
-    LONGLONG day_ticks = 24LL * 60 * 60 * 10000000;
-
-    ticks += day_offset * day_ticks;
+    out->wYear = (WORD)y;
+    out->wMonth = (WORD)m;
+    out->wDay = (WORD)d;
+    out->wDayOfWeek = (WORD)cal_day_of_week(days);
 
-    uli.QuadPart = (ULONGLONG)ticks;
-
-    ft.dwLowDateTime = uli.LowPart;
-    ft.dwHighDateTime = uli.HighPart;
-
-    return FileTimeToSystemTime(&ft, out);
+    return true;
 }
 
 /*!
@@ -274,7 +196,7 @@ static bool validate_systemtime(const SYSTEMTIME *st) {
         return false;
     }
 
-    WORD max_day = days_in_month(st->wYear, st->wMonth);
+    WORD max_day = (WORD)cal_days_in_month(st->wYear, st->wMonth);
 
     if (st->wDay < 1 ||
         st->wDay > max_day) {
@@ -425,6 +347,160 @@ static bool consume_u16(ParseContext *ctx, size_t digits, WORD *out) {
     return true;
 }
 
+#ifdef TIMEPARSE_SWAR
+// Repeats a byte in all eight bytes of a 64-bit word
+#define SWAR_BYTES(b) (0x0101010101010101ULL * (uint8_t)(b))
+
+/*!
+ * @brief
+ * Narrows four UTF-16 code units, each known to be below 0x100, to the four
+ * low bytes of a word.
+ */
+static inline uint64_t swar_pack4(uint64_t x) {
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    return (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+}
+
+/*!
+ * @brief
+ * Loads eight characters into a 64-bit word, the first character in the
+ * lowest byte.
+ *
+ * @return
+ * true if every character fits in a byte; false otherwise, in which case the
+ * characters can't be part of a fixed-width timestamp.
+ */
+static inline bool swar_load8(const TCHAR *str, uint64_t *out) {
+    if (sizeof(TCHAR) == 1) {
+        memcpy(out, str, 8);
+        return true;
+    }
+
+    uint64_t lo, hi;
+    memcpy(&lo, str, 8);
+    memcpy(&hi, str + 4, 8);
+
+    if ((lo | hi) & 0xFF00FF00FF00FF00ULL) {
+        return false;
+    }
+
+    *out = swar_pack4(lo) | (swar_pack4(hi) << 32);
+    return true;
+}
+
+/*!
+ * @brief
+ * Checks that all eight bytes of a word are ASCII digits: the high nibble of
+ * each byte must be 3, and must stay 3 after adding 6 to the byte.
+ */
+static inline bool swar_all_digits(uint64_t x) {
+    uint64_t hi = x & SWAR_BYTES(0xF0);
+    uint64_t hi_plus6 = (x + SWAR_BYTES(0x06)) & SWAR_BYTES(0xF0);
+
+    return (hi | (hi_plus6 >> 4)) == SWAR_BYTES(0x33);
+}
+
+/*!
+ * @brief
+ * Converts eight ASCII digits to the four two-digit values they form. Value n
+ * is stored in the low byte of the n-th 16-bit lane.
+ */
+static inline uint64_t swar_digit_pairs(uint64_t x) {
+    x -= SWAR_BYTES('0');
+
+    // Digits are at most 9, so no lane overflows into the next one
+    return ((x * 10) + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+}
+
+/*!
+ * @brief
+ * Parses a complete calendar date and time down to the second in one of the
+ * fixed-width forms, YYYYMMDDThhmmss or YYYY-MM-DDThh:mm:ss, validating and
+ * converting all digits with a handful of word operations.
+ *
+ * Anything else, including reduced precision, ordinal and week dates, is left
+ * to the general parser. When this function succeeds, the general parser would
+ * have consumed exactly the same characters with the same result.
+ *
+ * @param ctx
+ * Pointer to the current parse context. Only advanced on success.
+ *
+ * @param st
+ * Pointer to a SYSTEMTIME structure that will receive the date and time.
+ *
+ * @return
+ * true if the fixed-width prefix was parsed; false otherwise.
+ */
+static bool parse_fixed_date_time(ParseContext *ctx, SYSTEMTIME *st) {
+    const TCHAR *p = ctx->ptr;
+    size_t width;
+    uint64_t date, time;
+
+    if (ctx->fmt_style == FORMAT_STYLE_BASIC) {
+        // YYYYMMDDThhmmss
+        uint64_t tail;
+        width = 15;
+
+        if (ctx->len < width || p[8] != 'T' ||
+           !swar_load8(p, &date) ||
+           !swar_load8(p + 7, &tail)) {
+            return false;
+        }
+
+        // Drop the last day digit and 'T' preceding hhmmss, then pad with
+        // two zero digits
+        time = (tail >> 16) | (SWAR_BYTES('0') << 48);
+    } else {
+        // YYYY-MM-DDThh:mm:ss
+        uint64_t head, mid, tail;
+        width = 19;
+
+        if (ctx->len < width ||
+           !swar_load8(p, &head) ||      // YYYY-MM-
+           !swar_load8(p + 8, &mid) ||   // DDThh:mm
+           !swar_load8(p + 11, &tail)) { // hh:mm:ss
+            return false;
+        }
+
+        if ((head & 0xFF0000FF00000000ULL) != 0x2D00002D00000000ULL || // '-'
+            (mid & 0x0000000000FF0000ULL) != 0x0000000000540000ULL ||  // 'T'
+            (tail & 0x0000FF0000FF0000ULL) != 0x00003A00003A0000ULL) { // ':'
+            return false;
+        }
+
+        date =
+            (head & 0xFFFFFFFFULL) |
+            (((head >> 40) & 0xFFFF) << 32) |
+            ((mid & 0xFFFF) << 48);
+
+        time =
+            (tail & 0xFFFF) |
+            (((tail >> 24) & 0xFFFF) << 16) |
+            (((tail >> 48) & 0xFFFF) << 32) |
+            (SWAR_BYTES('0') << 48);
+    }
+
+    if (!swar_all_digits(date) || !swar_all_digits(time)) {
+        return false;
+    }
+
+    date = swar_digit_pairs(date);
+    time = swar_digit_pairs(time);
+
+    st->wYear = (WORD)((date & 0xFF) * 100 + ((date >> 16) & 0xFF));
+    st->wMonth = (WORD)((date >> 32) & 0xFF);
+    st->wDay = (WORD)((date >> 48) & 0xFF);
+    st->wHour = (WORD)(time & 0xFF);
+    st->wMinute = (WORD)((time >> 16) & 0xFF);
+    st->wSecond = (WORD)((time >> 32) & 0xFF);
+
+    ctx->ptr += width;
+    ctx->len -= width;
+
+    return true;
+}
+#endif
+
 /*!
  * @brief
  * Parses an ISO 8601-formatted calendar date from the parse context and writes
@@ -600,6 +676,29 @@ static bool parse_date(ParseContext *ctx, SYSTEMTIME *st) {
         parse_ordinal_date(ctx, st);
 }
 
+/*!
+ * @brief
+ * Parses the optional fraction of a second that follows the seconds and, if
+ * present, writes it to \p st.
+ *
+ * @param ctx
+ * Pointer to the current parse context.
+ *
+ * @param st
+ * Pointer to a SYSTEMTIME structure that will receive the milliseconds.
+ *
+ * @return
+ * true if there is no fraction or it was successfully parsed; false otherwise.
+ */
+static bool parse_fraction(ParseContext *ctx, SYSTEMTIME *st) {
+    if (consume_char(ctx, '.') &&
+       !consume_u16(ctx, 3, &st->wMilliseconds)) {
+        return false;
+    }
+
+    return true;
+}
+
 /*!
  * @brief
  * Parses time from the parse context and, if present and valid, writes the
@@ -652,12 +751,7 @@ static bool parse_time(ParseContext *ctx, SYSTEMTIME *st) {
         return false;
     }
 
-    if (consume_char(ctx, '.') &&
-       !consume_u16(ctx, 3, &st->wMilliseconds)) {
-        return false;
-    }
-
-    return true;
+    return parse_fraction(ctx, st);
 }
 
 /*!
@@ -744,7 +838,62 @@ static bool parse_utc_offset(ParseContext *ctx, UtcOffset *out) {
     return true;
 }
 
-bool parse_timestamp(const TCHAR *stamp, Timestamp *out) {
+/*!
+ * @brief
+ * Parses a date and its optional time from the parse context and writes them
+ * to \p st.
+ *
+ * @param ctx
+ * Pointer to the current parse context.
+ *
+ * @param st
+ * Pointer to a SYSTEMTIME structure that will receive the date and time.
+ *
+ * @return
+ * true if the date and time were successfully parsed; false otherwise.
+ */
+static bool parse_date_time(ParseContext *ctx, SYSTEMTIME *st) {
+#ifdef TIMEPARSE_SWAR
+    // Complete timestamps down to the second are by far the most common input,
+    // so take the fixed-width path whenever the input has that shape
+    if (parse_fixed_date_time(ctx, st)) {
+        return parse_fraction(ctx, st);
+    }
+#endif
+
+    if (!parse_date(ctx, st)) {
+        return false;
+    }
+
+    // Optional time component
+    if (ctx->len == 0) {
+        return true;
+    }
+
+    // ISO 8601-1:2019§5.3.2: "T" is always present in basic format, but for
+    // extended format, it may be omitted in time-only expressions
+    if (!consume_char(ctx, 'T')) {
+        return false;
+    }
+
+    return parse_time(ctx, st);
+}
+
+/*!
+ * @brief
+ * Parses a timestamp string without checking that the resulting calendar date
+ * and time of day exist, which is left to the caller.
+ *
+ * @param stamp
+ * Timestamp string in one of the formats accepted by parse_timestamp().
+ *
+ * @param out
+ * Pointer to a Timestamp struct that will receive the parsed timestamp.
+ *
+ * @return
+ * true if the timestamp is well-formed; false otherwise.
+ */
+static bool parse_timestamp_fields(const TCHAR *stamp, Timestamp *out) {
     if (!stamp || *stamp == '\0' || !out) {
         return false; 
     }
@@ -764,28 +913,11 @@ bool parse_timestamp(const TCHAR *stamp, Timestamp *out) {
 
     ctx.fmt_style = extended ? FORMAT_STYLE_EXTENDED : FORMAT_STYLE_BASIC;
 
-    if (!parse_date(&ctx, &st)) {
+    if (!parse_date_time(&ctx, &st)) {
         return false;
     }
 
-    // Optional time component
-    if (ctx.len != 0) {
-        // ISO 8601-1:2019§5.3.2: "T" is always present in basic format, but for
-        // extended format, it may be omitted in time-only expressions
-        if (!consume_char(&ctx, 'T')) {
-            return false;
-        }
-
-        if (!parse_time(&ctx, &st)) {
-            return false;   
-        }
-
-        if (!parse_utc_offset(&ctx, &utc_offset)) {
-            return false;
-        }
-    }
-
-    if (!validate_systemtime(&st)) {
+    if (!parse_utc_offset(&ctx, &utc_offset)) {
         return false;
     }
 
@@ -797,6 +929,199 @@ bool parse_timestamp(const TCHAR *stamp, Timestamp *out) {
     return true;
 }
 
+bool parse_timestamp(const TCHAR *stamp, Timestamp *out) {
+    Timestamp ts;
+
+    if (!parse_timestamp_fields(stamp, &ts) ||
+        !validate_systemtime(&ts.st)) {
+        return false;
+    }
+
+    *out = ts;
+    return true;
+}
+
+/*!
+ * @brief
+ * Timestamps being converted by parse_timestamps(), stored one array per
+ * field so that the stages that work on all of them at once are plain loops
+ * over arrays, which compilers turn into vector code.
+ */
+typedef struct timestamp_block {
+    int32_t year[BATCH_BLOCK_SIZE];
+    int32_t month[BATCH_BLOCK_SIZE];
+    int32_t day[BATCH_BLOCK_SIZE];
+    int32_t hour[BATCH_BLOCK_SIZE];
+    int32_t minute[BATCH_BLOCK_SIZE];
+    int32_t second[BATCH_BLOCK_SIZE];
+    int32_t millisecond[BATCH_BLOCK_SIZE];
+    // UTC offset in minutes; zero for local timestamps
+    int32_t offset[BATCH_BLOCK_SIZE];
+    // Nonzero if the timestamp carries a UTC designator or offset
+    int32_t utc[BATCH_BLOCK_SIZE];
+    // Nonzero if the timestamp is well-formed
+    int32_t parsed[BATCH_BLOCK_SIZE];
+    // Nonzero if the timestamp is well-formed and names an existing date and time
+    int32_t valid[BATCH_BLOCK_SIZE];
+    // Time since the FsTime epoch, as if the timestamp were in UTC
+    int64_t ticks[BATCH_BLOCK_SIZE];
+} TimestampBlock;
+
+/*!
+ * @brief
+ * Parses the timestamp strings of a block into its field arrays.
+ */
+static void block_parse(TimestampBlock *block, const TCHAR *const *stamps, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        Timestamp ts = { 0 };
+
+        block->parsed[i] = parse_timestamp_fields(stamps[i], &ts);
+        block->year[i] = ts.st.wYear;
+        block->month[i] = ts.st.wMonth;
+        block->day[i] = ts.st.wDay;
+        block->hour[i] = ts.st.wHour;
+        block->minute[i] = ts.st.wMinute;
+        block->second[i] = ts.st.wSecond;
+        block->millisecond[i] = ts.st.wMilliseconds;
+        block->offset[i] = ts.utc_offset.minutes;
+        block->utc[i] = ts.utc_offset.specified;
+    }
+}
+
+/*!
+ * @brief
+ * Branch-free equivalent of validate_systemtime() over a whole block.
+ */
+static void block_validate(TimestampBlock *block, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int32_t year = block->year[i];
+        int32_t month = block->month[i];
+        int32_t day = block->day[i];
+        int32_t max_day = cal_days_in_month(year, month);
+
+        block->valid[i] =
+            block->parsed[i] &
+            (year >= SYSTIME_YEAR_MIN) & (year <= SYSTIME_YEAR_MAX) &
+            (month >= 1) & (month <= 12) &
+            (day >= 1) & (day <= max_day) &
+            (block->hour[i] <= 23) &
+            (block->minute[i] <= 59) &
+            (block->second[i] <= 59) &
+            (block->millisecond[i] <= 999);
+    }
+}
+
+/*!
+ * @brief
+ * Converts the fields of a whole block to ticks, applying UTC offsets. Fields
+ * of invalid timestamps produce meaningless values that are never used.
+ */
+static void block_to_ticks(TimestampBlock *block, size_t n) {
+    int32_t days[BATCH_BLOCK_SIZE];
+
+    for (size_t i = 0; i < n; i++) {
+        days[i] = cal_days_from_civil(block->year[i], block->month[i], block->day[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        block->ticks[i] =
+            cal_ticks(
+                days[i],
+                block->hour[i], block->minute[i], block->second[i],
+                block->millisecond[i]) -
+            (int64_t)block->offset[i] * 60 * CAL_TICKS_PER_SECOND;
+    }
+}
+
+/*!
+ * @brief
+ * Writes the result of each timestamp of a block. Timestamps without a UTC
+ * offset are converted from local time here, through the cached time zone
+ * table.
+ *
+ * @return
+ * The number of timestamps that were converted.
+ */
+static size_t block_store(
+    const TimestampBlock *block, size_t n,
+    FsTime *out, TimestampStatus *status) {
+
+    size_t converted = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = FS_TIME_OMIT;
+
+        if (!block->parsed[i]) {
+            status[i] = TS_STATUS_MALFORMED;
+            continue;
+        }
+
+        status[i] = TS_STATUS_OUT_OF_RANGE;
+
+        if (!block->valid[i]) {
+            continue;
+        }
+
+        if (block->utc[i]) {
+            // A UTC offset can move the time before the FsTime epoch, e.g.,
+            // 1601-01-01T00:00:00+01:00
+            //
+            // There is no need to worry about overflow since the year can't
+            // exceed four digits. An overflow would require a time beyond
+            // 30828-09-14T02:48:05.4775807
+            if (block->ticks[i] < 0) {
+                continue;
+            }
+
+            // If the converted timestamp is equivalent to the FILETIME epoch,
+            // that is 1601-01-01T00:00:00.000Z, the resulting FILETIME value is
+            // {0, 0}. Per SetFileTime() documentation, passing a FILETIME whose
+            // members are {0, 0} indicates that the application intends to
+            // leave the corresponding timestamp unchanged!
+            //
+            // I'm going to treat that as "expected behavior" until someone complains :D
+            out[i] = (FsTime)block->ticks[i];
+        } else {
+            // Interpret timestamp as the local civil time in the current TZ
+            // configuration to properly handle TZ-related adjustments like DST
+            // transitions. Without an offset, the ticks are the local time
+            if (!localzone_to_utc(block->ticks[i], &out[i])) {
+                out[i] = FS_TIME_OMIT;
+                continue;
+            }
+        }
+
+        status[i] = TS_STATUS_OK;
+        converted++;
+    }
+
+    return converted;
+}
+
+size_t parse_timestamps(
+    const TCHAR *const *stamps, size_t count,
+    FsTime *out, TimestampStatus *status) {
+
+    TimestampBlock block;
+    size_t converted = 0;
+
+    for (size_t start = 0; start < count; start += BATCH_BLOCK_SIZE) {
+        size_t n = count - start;
+
+        if (n > BATCH_BLOCK_SIZE) {
+            n = BATCH_BLOCK_SIZE;
+        }
+
+        block_parse(&block, stamps + start, n);
+        block_validate(&block, n);
+        block_to_ticks(&block, n);
+
+        converted += block_store(&block, n, out + start, status + start);
+    }
+
+    return converted;
+}
+
 bool parse_hhmmss(const TCHAR *hhmmss, int *out) {
     if (!hhmmss || *hhmmss == '\0' || !out) {
         return false;
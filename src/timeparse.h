@@ -8,8 +8,11 @@
 #ifndef TIMEPARSE_H
 #define TIMEPARSE_H
 
+#include "platform.h"
+#include "fsbackend.h"
+
 #include <stdbool.h>
-#include <tchar.h>
+#include <stddef.h>
 
 typedef struct utc_offset {
     bool specified;
@@ -25,6 +28,19 @@ typedef struct timestamp {
     UtcOffset utc_offset;
 } Timestamp;
 
+/*!
+ * @brief
+ * Outcome of converting one timestamp string with parse_timestamps().
+ */
+typedef enum timestamp_status {
+    TS_STATUS_OK,
+    // The string is not a timestamp in any of the accepted formats
+    TS_STATUS_MALFORMED,
+    // The timestamp names a date or time that does not exist, or one that can't
+    // be represented as an FsTime
+    TS_STATUS_OUT_OF_RANGE
+} TimestampStatus;
+
  /*!
   * @brief
   * Translates a timestamp string to a Timestamp struct.
@@ -55,6 +71,36 @@ typedef struct timestamp {
   */
 bool parse_timestamp(const TCHAR *stamp, Timestamp *out);
 
+/*!
+ * @brief
+ * Translates many timestamp strings to FsTime values at once. Timestamps with
+ * a UTC designator or offset are converted to UTC accordingly, and the others
+ * are interpreted as local time.
+ *
+ * Converting a batch is faster than converting each timestamp on its own since
+ * the range checks and calendar arithmetic run over many timestamps at a time.
+ *
+ * @param stamps
+ * Array of \p count timestamp strings in any of the formats accepted by
+ * parse_timestamp().
+ *
+ * @param count
+ * Number of timestamps to translate.
+ *
+ * @param out
+ * Array of \p count FsTime values that will receive the translated timestamps.
+ * Timestamps that fail to translate receive FS_TIME_OMIT.
+ *
+ * @param status
+ * Array of \p count values that will receive the outcome for each timestamp.
+ *
+ * @return
+ * The number of timestamps that were successfully translated.
+ */
+size_t parse_timestamps(
+    const TCHAR *const *stamps, size_t count,
+    FsTime *out, TimestampStatus *status);
+
 /*!
  * @brief
  * Parses a time string representing hours, minutes and seconds.
@@ -0,0 +1,1039 @@
+/* touchop.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "touchop.h"
+#include "timeparse.h"
+#include "stats.h"
+#include "probes.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Number of files touch_many() moves through each stage together
+#define TOUCH_MANY_CHUNK 256
+
+// Smallest number of files in a directory for touch_many() to open the
+// directory and reach them by name. Opening and closing it costs two system
+// calls, which a handful of files saves back even in a shallow tree
+#define TOUCH_MANY_MIN_GROUP 4
+
+/*!
+ * @brief
+ * An operand of touch_many(), as grouped by its directory.
+ */
+typedef struct planned_path {
+    const TCHAR *path;
+    // Length of the directory part of path, or 0 if it must be used whole
+    size_t parent_len;
+    // Position of the operand among those given to touch_many()
+    size_t index;
+} PlannedPath;
+
+/*!
+ * @brief
+ * The times of a file of a chunk as read before they are adjusted, and the
+ * identity of the file they were read from.
+ */
+typedef struct current_times {
+    FsTimes times;
+    FsFileId id;
+    // Position of the file in the chunk
+    size_t index;
+} CurrentTimes;
+
+/*!
+ * @brief
+ * Per-file state of a chunk of touch_many().
+ */
+typedef struct touch_chunk {
+    // Directory the names are relative to, or NULL if they are whole paths
+    const FsParent *parent;
+    const TCHAR *names[TOUCH_MANY_CHUNK];
+    // Whole path of each file, which statistics are kept by
+    const TCHAR *paths[TOUCH_MANY_CHUNK];
+    const TimestampOperation *ops[TOUCH_MANY_CHUNK];
+    TouchStatus status[TOUCH_MANY_CHUNK];
+    FsFile files[TOUCH_MANY_CHUNK];
+    bool opened[TOUCH_MANY_CHUNK];
+    // Whether the times of the file were adjusted by name, without opening it
+    bool adjusted[TOUCH_MANY_CHUNK];
+    CurrentTimes current[TOUCH_MANY_CHUNK];
+    FsBatchStep steps[TOUCH_MANY_CHUNK];
+    // File of each step, or of each file left to open, as an index into the
+    // chunk
+    size_t owners[TOUCH_MANY_CHUNK];
+} TouchChunk;
+
+struct touch_workspace {
+    TouchChunk chunk;
+    PlannedPath *plan;
+    size_t plan_capacity;
+    // Path of the directory being opened for a group
+    TCHAR *dir;
+    size_t dir_capacity;
+};
+
+/*!
+ * @brief
+ * Adjusts the given file time by the given offset. If the offset is negative,
+ * time is moved backward. Otherwise, forward.
+ *
+ * @param time
+ * Pointer to the time to adjust.
+ *
+ * @param offset
+ * Time represented in seconds.
+ */
+static void adjust_time_offset(FsTime *time, int offset) {
+    assert(time);
+
+    // Nothing to adjust if the file system does not record this timestamp
+    if (*time == FS_TIME_OMIT) {
+        return;
+    }
+
+    int64_t ticks = (int64_t)*time;
+    int64_t delta = (int64_t)offset * FS_TICKS_PER_SECOND;
+
+    if ((delta > 0 && ticks > (INT64_MAX - delta)) ||
+        (delta < 0 && ticks < -delta)) {
+        return;
+    }
+
+    *time = (FsTime)(ticks + delta);
+}
+
+
+bool parse_timestamp_string(const TCHAR *stamp, FsTime *out) {
+    TimestampStatus status;
+    FsTime time;
+
+    PROBE(parse_start, stamp);
+
+    StatsMark start = stats_start();
+    size_t parsed = parse_timestamps(&stamp, 1, &time, &status);
+    stats_stop(STATS_PARSE, start, NULL);
+
+    PROBE_RESULT(parse_end, stamp, parsed == 1);
+
+    if (parsed != 1) {
+        return false;
+    }
+
+    *out = time;
+    return true;
+}
+
+
+bool get_ref_timestamps(const TCHAR *filename, FsTimes *out) {
+    assert(filename && out);
+
+    return fs_stat_times(filename, false, out);
+}
+
+
+/*!
+ * @brief
+ * Builds the FsTimes to pass to the backend for the timestamps selected by
+ * \p ft_flags. Timestamps that are not selected are left unchanged.
+ */
+static FsTimes select_times(
+    FileTimeFlags ft_flags,
+    FsTime creation, FsTime access, FsTime write) {
+
+    FsTimes times = {
+        .creation = (ft_flags & FT_CREATION) ? creation : FS_TIME_OMIT,
+        .access = (ft_flags & FT_ACCESS) ? access : FS_TIME_OMIT,
+        .write = (ft_flags & FT_WRITE) ? write : FS_TIME_OMIT
+    };
+
+    return times;
+}
+
+
+/*!
+ * @brief
+ * Adjusts a file's timestamps.
+ *
+ * @param file
+ * Pointer to the open file whose timestamps are to be adjusted.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * true if the timestamps were successfully adjusted; false otherwise.
+ */
+static bool adjust_file_time(FsFile *file, const TimestampOperation *op) {
+    assert(file && op);
+
+    FsTimes current;
+
+    if (!fs_get_times(file, &current)) {
+        return false;
+    }
+
+    if (op->ft_flags & FT_CREATION) {
+        adjust_time_offset(&current.creation, op->adjustment_seconds);
+    }
+
+    if (op->ft_flags & FT_ACCESS) {
+        adjust_time_offset(&current.access, op->adjustment_seconds);
+    }
+
+    if (op->ft_flags & FT_WRITE) {
+        adjust_time_offset(&current.write, op->adjustment_seconds);
+    }
+
+    FsTimes times = select_times(
+        op->ft_flags,
+        current.creation, current.access, current.write);
+
+    return fs_set_times(file, &times);
+}
+
+
+/*!
+ * @brief
+ * Checks whether an operation derives its timestamps from the file's own.
+ */
+static bool needs_current_times(const TimestampOperation *op) {
+    return op->source == TS_SOURCE_RELATIVE && op->adjustment_seconds != 0;
+}
+
+
+/*!
+ * @brief
+ * Sets the timestamps of the file based on details provide by \p op.
+ *
+ * @param file
+ * Pointer to the open file to set its timestamp.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * true if the timestamps were successfully set; false otherwise.
+ */
+static bool set_file_time(FsFile *file, const TimestampOperation *op) {
+    assert(file && op);
+
+    if (!(op->ft_flags & (FT_CREATION | FT_ACCESS | FT_WRITE))) {
+        return true;
+    }
+
+    // If there's an adjustment but no explicit timestamp via a reference file
+    // or timestamp input, adjust the current file time only
+    if (needs_current_times(op)) {
+        StatsMark start = stats_start();
+        bool ok = adjust_file_time(file, op);
+        stats_stop(STATS_ADJUST_FILE_TIME, start, NULL);
+
+        return ok;
+    }
+
+    FsTimes times = select_times(
+        op->ft_flags,
+        op->creation, op->access, op->write);
+
+    return fs_set_times(file, &times);
+}
+
+
+/*!
+ * @brief
+ * Determines whether the operation can be applied to an existing file through
+ * set_file_time_by_path() rather than the regular handle-based flow.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * true if the operation sets fixed last access and/or write times only; false
+ * if it adjusts the file's own times or changes its creation time.
+ */
+static bool can_set_file_time_by_path(const TimestampOperation *op) {
+    assert(op);
+
+    return op->source != TS_SOURCE_RELATIVE &&
+         !(op->ft_flags & FT_CREATION);
+}
+
+
+/*!
+ * @brief
+ * Determines whether the operation adjusts times that can be read and written
+ * back by name, without opening the file.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * true if the operation adjusts last access and/or write times only, and the
+ * backend sets them by name; false otherwise.
+ */
+static bool can_adjust_file_time_by_path(const TimestampOperation *op) {
+    assert(op);
+
+    return FS_SETS_TIMES_BY_NAME &&
+        needs_current_times(op) &&
+        (op->ft_flags & (FT_ACCESS | FT_WRITE)) &&
+        !(op->ft_flags & FT_CREATION);
+}
+
+
+/*!
+ * @brief
+ * Sets the last access and/or write times of an existing file with the
+ * cheapest call the backend offers: a single utimensat() on POSIX, and an
+ * attribute-only open that shares everything on Windows.
+ *
+ * @param parent
+ * Pointer to the directory \p name is relative to, or NULL for the current
+ * directory.
+ *
+ * @param name
+ * Path to the file.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct for which can_set_file_time_by_path()
+ * returns true.
+ *
+ * @return
+ * true if the timestamps were successfully set; false otherwise, in which case
+ * fs_last_error() describes the failure.
+ */
+static bool set_file_time_by_path(
+    const FsParent *parent, const TCHAR *name,
+    bool follow_symlinks, const TimestampOperation *op) {
+
+    assert(name && op);
+
+    FsTimes times = select_times(
+        op->ft_flags & (FT_ACCESS | FT_WRITE),
+        op->creation, op->access, op->write);
+
+    return fs_set_times_at(parent, name, follow_symlinks, &times);
+}
+
+
+TimestampOperation prepare_timestamp(
+    const FsTime *ft_stamp,
+    const FsTimes *ref_stamps,
+    FileTimeFlags ft_flags, int adjustment_seconds) {
+
+    TimestampOperation op = { 0 };
+
+    op.ft_flags = ft_flags;
+    op.adjustment_seconds = adjustment_seconds;
+
+    if (!(ft_stamp || ref_stamps) && adjustment_seconds != 0) {
+        op.source = TS_SOURCE_RELATIVE;
+        // Nothing to do here since relative adjustment is handled in
+        // set_file_time()
+        return op;
+    }
+
+    if (ref_stamps) {
+        op.source = TS_SOURCE_EXPLICIT;
+
+        op.creation = ref_stamps->creation;
+        op.access = ref_stamps->access;
+        op.write = ref_stamps->write;
+    } else if (ft_stamp) {
+        op.source = TS_SOURCE_EXPLICIT;
+        op.creation = op.access = op.write = *ft_stamp;
+    } else {
+        // Left to the backend, which may set the current time with fewer
+        // rights than a given one
+        op.source = TS_SOURCE_NOW;
+        op.creation = op.access = op.write = FS_TIME_NOW;
+    }
+
+    if (op.adjustment_seconds != 0) {
+        if (op.ft_flags & FT_CREATION) {
+            adjust_time_offset(&op.creation, op.adjustment_seconds);
+        }
+
+        if (op.ft_flags & FT_ACCESS) {
+            adjust_time_offset(&op.access, op.adjustment_seconds);
+        }
+
+        if (op.ft_flags & FT_WRITE) {
+            adjust_time_offset(&op.write, op.adjustment_seconds);
+        }
+    }
+
+    return op;
+}
+
+
+/*!
+ * @brief
+ * Does the work of touch(), whose phases are timed separately from the whole.
+ */
+static bool touch_file(
+    const TCHAR *path,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op) {
+
+    // Most operands already exist, so try the single-call fast path first and
+    // only fall back to the creating open when the file turns out missing
+    if (can_set_file_time_by_path(op)) {
+        PROBE(set_times_start, path);
+
+        StatsMark start = stats_start();
+        bool ok = set_file_time_by_path(NULL, path, follow_symlinks, op);
+        stats_stop(STATS_SET_BY_PATH, start, NULL);
+
+        PROBE_RESULT(set_times_end, path, ok);
+
+        if (ok) {
+            return true;
+        }
+
+        bool missing_file = fs_error_is_missing(fs_last_error());
+
+        if (!missing_file || existing_only) {
+            return missing_file;
+        }
+    }
+
+    unsigned int open_flags = 0;
+
+    if (!existing_only) {
+        open_flags |= FS_OPEN_CREATE;
+    }
+
+    if (!follow_symlinks) {
+        open_flags |= FS_OPEN_NOFOLLOW;
+    }
+
+    PROBE(open_start, path);
+
+    FsFile file;
+    StatsMark start = stats_start();
+    bool opened = fs_open(&file, path, open_flags);
+
+    stats_stop(STATS_OPEN, start, NULL);
+    PROBE_RESULT(open_end, path, opened);
+
+    if (!opened) {
+        bool missing_file = fs_error_is_missing(fs_last_error());
+        return (existing_only && missing_file);
+    }
+
+    PROBE(set_times_start, path);
+
+    start = stats_start();
+    bool ok = set_file_time(&file, op);
+    stats_stop(STATS_SET_FILE_TIME, start, NULL);
+
+    PROBE_RESULT(set_times_end, path, ok);
+
+    start = stats_start();
+    fs_close(&file);
+    stats_stop(STATS_CLOSE, start, NULL);
+
+    return ok;
+}
+
+
+bool touch(
+    const TCHAR *path,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op) {
+
+    assert(path && op);
+
+    PROBE(touch_start, path);
+
+    StatsMark start = stats_start();
+    bool ok = touch_file(path, existing_only, follow_symlinks, op);
+    stats_stop(STATS_TOUCH, start, path);
+
+    PROBE_RESULT(touch_end, path, ok);
+
+    return ok;
+}
+
+
+/*!
+ * @brief
+ * Checks whether writing \p wanted over \p current would change a timestamp
+ * stored at the given granularity.
+ */
+static bool time_changed(FsTime current, FsTime wanted, FsTime granularity) {
+    if (wanted == FS_TIME_OMIT) {
+        return false;
+    }
+
+    // Let the write report whether a timestamp that isn't recorded can be set
+    if (current == FS_TIME_OMIT) {
+        return true;
+    }
+
+    FsTime diff = (wanted > current) ? (wanted - current) : (current - wanted);
+    return diff >= granularity;
+}
+
+
+FileTimeFlags changed_times(
+    const FsTimes *current, const FsTimes *wanted,
+    const FsTimes *granularity, FileTimeFlags ft_flags) {
+
+    assert(current && wanted && granularity);
+
+    FileTimeFlags changed = 0;
+
+    if ((ft_flags & FT_CREATION) &&
+        time_changed(current->creation, wanted->creation, granularity->creation)) {
+        changed |= FT_CREATION;
+    }
+
+    if ((ft_flags & FT_ACCESS) &&
+        time_changed(current->access, wanted->access, granularity->access)) {
+        changed |= FT_ACCESS;
+    }
+
+    if ((ft_flags & FT_WRITE) &&
+        time_changed(current->write, wanted->write, granularity->write)) {
+        changed |= FT_WRITE;
+    }
+
+    return changed;
+}
+
+
+TouchOutcome touch_if_changed(
+    const TCHAR *path,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op) {
+
+    assert(path && op);
+
+    FsTimes current, granularity;
+    StatsMark start = stats_start();
+    bool found = fs_stat_times_granular(path, follow_symlinks, &current, &granularity);
+
+    stats_stop(STATS_STAT, start, path);
+
+    if (!found) {
+        if (!fs_error_is_missing(fs_last_error())) {
+            return TOUCH_FAILED;
+        }
+
+        if (existing_only) {
+            return TOUCH_MISSING;
+        }
+
+        return touch(path, false, follow_symlinks, op) ? TOUCH_UPDATED : TOUCH_FAILED;
+    }
+
+    FsTimes wanted;
+
+    if (needs_current_times(op)) {
+        wanted = current;
+        adjust_time_offset(&wanted.creation, op->adjustment_seconds);
+        adjust_time_offset(&wanted.access, op->adjustment_seconds);
+        adjust_time_offset(&wanted.write, op->adjustment_seconds);
+    } else if (op->source == TS_SOURCE_NOW) {
+        FsTime now = fs_now();
+
+        wanted.creation = wanted.access = wanted.write = now;
+    } else {
+        wanted.creation = op->creation;
+        wanted.access = op->access;
+        wanted.write = op->write;
+    }
+
+    TimestampOperation changed_op = *op;
+    changed_op.ft_flags = changed_times(&current, &wanted, &granularity, op->ft_flags);
+
+    if (!changed_op.ft_flags) {
+        return TOUCH_UNCHANGED;
+    }
+
+    // The file was just seen, so it is not created if it vanished since
+    return touch(path, true, follow_symlinks, &changed_op) ? TOUCH_UPDATED : TOUCH_FAILED;
+}
+
+
+static int compare_current(const void *a, const void *b) {
+    const CurrentTimes *ca = a;
+    const CurrentTimes *cb = b;
+
+    if (ca->id.volume != cb->id.volume) {
+        return (ca->id.volume > cb->id.volume) - (ca->id.volume < cb->id.volume);
+    }
+
+    if (ca->id.index != cb->id.index) {
+        return (ca->id.index > cb->id.index) - (ca->id.index < cb->id.index);
+    }
+
+    // Keeps the operands of a file in the order they were given
+    return (ca->index > cb->index) - (ca->index < cb->index);
+}
+
+
+static bool same_file(const FsFileId *a, const FsFileId *b) {
+    return a->volume == b->volume && a->index == b->index;
+}
+
+
+/*!
+ * @brief
+ * Adjusts the times of the files of a chunk that are left to open, for those
+ * whose operation allows it, without opening them: their current times are
+ * read with one batch of stats, the adjusted times are computed together, and
+ * only the writes are issued one by one. That is two system calls per file
+ * where opening it takes four.
+ *
+ * A file is adjusted this way once. Other operands that reach the same file,
+ * by the same name, a link or a hard link, are left to the regular flow, which
+ * runs afterwards and reads the times written here, so the file is adjusted
+ * once per operand as touch() would. So are files that cannot be read or
+ * written, so that they are created or reported the way they always are.
+ *
+ * @return
+ * Number of files left to open, whose indexes remain at the start of the
+ * owners member.
+ */
+static size_t adjust_chunk_by_path(
+    FsBatch *batch, TouchChunk *chunk, size_t left,
+    bool follow_symlinks) {
+
+    size_t step_count = 0;
+
+    for (size_t s = 0; s < left; s++) {
+        size_t i = chunk->owners[s];
+
+        if (!can_adjust_file_time_by_path(chunk->ops[i])) {
+            continue;
+        }
+
+        CurrentTimes *cur = &chunk->current[step_count];
+
+        cur->index = i;
+        chunk->steps[step_count++] = (FsBatchStep) {
+            .op = FS_BATCH_STAT,
+            .parent = chunk->parent,
+            .path = chunk->names[i],
+            .flags = follow_symlinks ? 0 : FS_OPEN_NOFOLLOW,
+            .times = &cur->times,
+            .id = &cur->id
+        };
+    }
+
+    if (step_count == 0) {
+        return left;
+    }
+
+    StatsMark start = stats_start();
+    fs_batch_run(batch, chunk->steps, step_count);
+    stats_stop(STATS_BATCH_RUN, start, NULL);
+
+    size_t read = 0;
+
+    for (size_t s = 0; s < step_count; s++) {
+        if (chunk->steps[s].err == FS_OK) {
+            chunk->current[read++] = chunk->current[s];
+        }
+    }
+
+    // Sorting by identity brings the operands of each file together, and
+    // only the first of them is adjusted here
+    qsort(chunk->current, read, sizeof(CurrentTimes), compare_current);
+
+    size_t unique = 0;
+
+    for (size_t k = 0; k < read; k++) {
+        CurrentTimes cur = chunk->current[k];
+
+        if (unique > 0 && same_file(&cur.id, &chunk->current[unique - 1].id)) {
+            continue;
+        }
+
+        const TimestampOperation *file_op = chunk->ops[cur.index];
+
+        adjust_time_offset(&cur.times.access, file_op->adjustment_seconds);
+        adjust_time_offset(&cur.times.write, file_op->adjustment_seconds);
+
+        cur.times = select_times(
+            file_op->ft_flags & (FT_ACCESS | FT_WRITE),
+            FS_TIME_OMIT, cur.times.access, cur.times.write);
+
+        chunk->current[unique++] = cur;
+    }
+
+    for (size_t k = 0; k < unique; k++) {
+        size_t i = chunk->current[k].index;
+
+        PROBE(set_times_start, chunk->paths[i]);
+
+        start = stats_start();
+        bool ok = fs_set_times_at(chunk->parent, chunk->names[i], follow_symlinks, &chunk->current[k].times);
+        stats_stop(STATS_SET_BY_PATH, start, chunk->paths[i]);
+
+        PROBE_RESULT(set_times_end, chunk->paths[i], ok);
+
+        chunk->adjusted[i] = ok;
+    }
+
+    size_t kept = 0;
+
+    for (size_t s = 0; s < left; s++) {
+        if (!chunk->adjusted[chunk->owners[s]]) {
+            chunk->owners[kept++] = chunk->owners[s];
+        }
+    }
+
+    return kept;
+}
+
+
+/*!
+ * @brief
+ * Touches the files named in a chunk and stores their outcomes in its status
+ * member.
+ */
+static void touch_chunk(
+    FsBatch *batch, TouchChunk *chunk, size_t count,
+    bool existing_only, bool follow_symlinks) {
+
+    unsigned int open_flags = 0;
+
+    if (!existing_only) {
+        open_flags |= FS_OPEN_CREATE;
+    }
+
+    if (!follow_symlinks) {
+        open_flags |= FS_OPEN_NOFOLLOW;
+    }
+
+    TouchStatus *out = chunk->status;
+
+    // As in touch(), fixed times go through the single-call path first, and
+    // only the files that turn out missing are opened to be created
+    size_t left = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const TimestampOperation *file_op = chunk->ops[i];
+
+        out[i] = (TouchStatus) { true, FS_OK };
+        chunk->opened[i] = false;
+        chunk->adjusted[i] = false;
+
+        if (can_set_file_time_by_path(file_op)) {
+            PROBE(set_times_start, chunk->paths[i]);
+
+            StatsMark start = stats_start();
+            bool ok = set_file_time_by_path(chunk->parent, chunk->names[i], follow_symlinks, file_op);
+
+            stats_stop(STATS_SET_BY_PATH, start, chunk->paths[i]);
+            PROBE_RESULT(set_times_end, chunk->paths[i], ok);
+
+            if (ok) {
+                continue;
+            }
+
+            FsError err = fs_last_error();
+            bool missing_file = fs_error_is_missing(err);
+
+            if (!missing_file || existing_only) {
+                out[i] = (TouchStatus) { missing_file, err };
+                continue;
+            }
+        }
+
+        chunk->owners[left++] = i;
+    }
+
+    size_t step_count = adjust_chunk_by_path(batch, chunk, left, follow_symlinks);
+
+    for (size_t s = 0; s < step_count; s++) {
+        size_t i = chunk->owners[s];
+
+        chunk->steps[s] = (FsBatchStep) {
+            .op = FS_BATCH_OPEN,
+            .parent = chunk->parent,
+            .path = chunk->names[i],
+            .flags = open_flags,
+            .file = &chunk->files[i]
+        };
+
+        PROBE(open_start, chunk->paths[i]);
+    }
+
+    StatsMark start;
+
+    if (step_count > 0) {
+        start = stats_start();
+        fs_batch_run(batch, chunk->steps, step_count);
+        stats_stop(STATS_BATCH_RUN, start, NULL);
+    }
+
+    for (size_t s = 0; s < step_count; s++) {
+        size_t i = chunk->owners[s];
+        FsError err = chunk->steps[s].err;
+
+        PROBE_RESULT(open_end, chunk->paths[i], err == FS_OK);
+
+        if (err != FS_OK) {
+            out[i] = (TouchStatus) { existing_only && fs_error_is_missing(err), err };
+        } else {
+            chunk->opened[i] = true;
+        }
+    }
+
+    // The timestamps themselves are set synchronously, then every open file
+    // is closed in one go. Times that are adjusted here are read right before
+    // they are written, so that a file given more than once is adjusted once
+    // per operand, as touch() would
+    step_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!chunk->opened[i]) {
+            continue;
+        }
+
+        PROBE(set_times_start, chunk->paths[i]);
+
+        start = stats_start();
+        bool ok = set_file_time(&chunk->files[i], chunk->ops[i]);
+        stats_stop(STATS_SET_FILE_TIME, start, chunk->paths[i]);
+
+        PROBE_RESULT(set_times_end, chunk->paths[i], ok);
+
+        if (!ok) {
+            out[i] = (TouchStatus) { false, fs_last_error() };
+        }
+
+        chunk->steps[step_count++] = (FsBatchStep) {
+            .op = FS_BATCH_CLOSE,
+            .file = &chunk->files[i]
+        };
+    }
+
+    if (step_count > 0) {
+        start = stats_start();
+        fs_batch_run(batch, chunk->steps, step_count);
+        stats_stop(STATS_BATCH_RUN, start, NULL);
+    }
+}
+
+
+static int compare_planned(const void *a, const void *b) {
+    const PlannedPath *pa = a;
+    const PlannedPath *pb = b;
+
+    if (pa->parent_len != pb->parent_len) {
+        return (pa->parent_len > pb->parent_len) - (pa->parent_len < pb->parent_len);
+    }
+
+    int cmp = memcmp(pa->path, pb->path, pa->parent_len * sizeof(TCHAR));
+
+    if (cmp != 0) {
+        return cmp;
+    }
+
+    // Keeps the operands of a directory in the order they were given
+    return (pa->index > pb->index) - (pa->index < pb->index);
+}
+
+
+static bool same_parent(const PlannedPath *a, const PlannedPath *b) {
+    return a->parent_len == b->parent_len &&
+        memcmp(a->path, b->path, a->parent_len * sizeof(TCHAR)) == 0;
+}
+
+
+/*!
+ * @brief
+ * Opens the directory shared by a group of planned paths.
+ */
+static bool open_group_parent(TouchWorkspace *work, const PlannedPath *first, FsParent *parent) {
+    size_t capacity = first->parent_len + 1;
+
+    if (capacity > work->dir_capacity) {
+        TCHAR *dir = realloc(work->dir, capacity * sizeof(TCHAR));
+
+        if (!dir) {
+            return false;
+        }
+
+        work->dir = dir;
+        work->dir_capacity = capacity;
+    }
+
+    memcpy(work->dir, first->path, first->parent_len * sizeof(TCHAR));
+    work->dir[first->parent_len] = '\0';
+
+    return fs_parent_open(parent, work->dir);
+}
+
+
+/*!
+ * @brief
+ * Touches a group of files that share a directory, by name within that
+ * directory if there are enough of them, and by their whole paths otherwise.
+ */
+static void touch_group(
+    FsBatch *batch, TouchWorkspace *work,
+    const PlannedPath *group, size_t count,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op, const TimestampOperation *ops,
+    TouchStatus *out) {
+
+    FsParent parent;
+
+    // Should the directory fail to open, its files are touched by their whole
+    // paths, which reports the failure against each of them as touch() would
+    bool relative =
+        group[0].parent_len > 0 &&
+        count >= TOUCH_MANY_MIN_GROUP &&
+        open_group_parent(work, &group[0], &parent);
+
+    size_t skip = relative ? group[0].parent_len : 0;
+    TouchChunk *chunk = &work->chunk;
+
+    chunk->parent = relative ? &parent : NULL;
+
+    for (size_t base = 0; base < count; base += TOUCH_MANY_CHUNK) {
+        size_t n = count - base;
+
+        if (n > TOUCH_MANY_CHUNK) {
+            n = TOUCH_MANY_CHUNK;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            const PlannedPath *planned = &group[base + i];
+
+            chunk->paths[i] = planned->path;
+            chunk->names[i] = planned->path + skip;
+            chunk->ops[i] = ops ? &ops[planned->index] : op;
+        }
+
+        touch_chunk(batch, chunk, n, existing_only, follow_symlinks);
+
+        for (size_t i = 0; i < n; i++) {
+            out[group[base + i].index] = chunk->status[i];
+        }
+    }
+
+    if (relative) {
+        fs_parent_close(&parent);
+    }
+}
+
+
+TouchWorkspace *touch_workspace_open(void) {
+    return calloc(1, sizeof(TouchWorkspace));
+}
+
+
+void touch_workspace_close(TouchWorkspace *work) {
+    if (!work) {
+        return;
+    }
+
+    free(work->plan);
+    free(work->dir);
+    free(work);
+}
+
+
+/*!
+ * @brief
+ * Makes room in a workspace for the plan of \p count operands.
+ */
+static bool reserve_plan(TouchWorkspace *work, size_t count) {
+    if (count <= work->plan_capacity) {
+        return true;
+    }
+
+    PlannedPath *plan = realloc(work->plan, count * sizeof(PlannedPath));
+
+    if (!plan) {
+        return false;
+    }
+
+    work->plan = plan;
+    work->plan_capacity = count;
+
+    return true;
+}
+
+
+void touch_many(
+    FsBatch *batch, TouchWorkspace *work,
+    const TCHAR *const *paths, size_t count,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op, const TimestampOperation *ops,
+    TouchStatus *out) {
+
+    assert(batch && paths && (op || ops) && out);
+
+    TouchWorkspace *own = work ? NULL : touch_workspace_open();
+
+    if (!work) {
+        work = own;
+    }
+
+    if (!work || !reserve_plan(work, count)) {
+        // Without memory for the plan, fall back to one file at a time
+        for (size_t i = 0; i < count; i++) {
+            out[i].ok = touch(paths[i], existing_only, follow_symlinks, ops ? &ops[i] : op);
+            out[i].err = out[i].ok ? FS_OK : fs_last_error();
+        }
+
+        touch_workspace_close(own);
+        return;
+    }
+
+    PlannedPath *plan = work->plan;
+
+    // Siblings are grouped so that their directory is looked up once rather
+    // than once per file, which adds up in deep trees
+    for (size_t i = 0; i < count; i++) {
+        plan[i] = (PlannedPath) {
+            .path = paths[i],
+            .parent_len = fs_parent_length(paths[i]),
+            .index = i
+        };
+    }
+
+    // Rows of a manifest carry times of their own, and of two rows for the
+    // same file the later one must win, even when they spell its directory
+    // differently. Their order is kept, and only runs of siblings are grouped
+    if (!ops) {
+        qsort(plan, count, sizeof(PlannedPath), compare_planned);
+    }
+
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+
+        while (end < count && same_parent(&plan[start], &plan[end])) {
+            end++;
+        }
+
+        touch_group(
+            batch, work,
+            &plan[start], end - start,
+            existing_only, follow_symlinks,
+            op, ops, out);
+
+        start = end;
+    }
+
+    touch_workspace_close(own);
+}
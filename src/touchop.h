@@ -0,0 +1,302 @@
+/* touchop.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef TOUCHOP_H
+#define TOUCHOP_H
+
+#include "fsbackend.h"
+
+#include <stdbool.h>
+
+typedef enum timestamp_zone {
+    TS_ZONE_LOCAL,
+    TS_ZONE_UTC
+} TimestampZone;
+
+/*!
+ * @brief
+ * Where the timestamps of a TimestampOperation come from.
+ */
+typedef enum timestamp_source {
+    TS_SOURCE_NOW,
+    TS_SOURCE_EXPLICIT,
+    TS_SOURCE_RELATIVE
+} TimestampSource;
+
+/*!
+ * @brief
+ * Selects the file timestamps an operation changes.
+ */
+typedef enum file_time_flags
+{
+    FT_CREATION = 1 << 0,
+    FT_ACCESS = 1 << 1,
+    FT_WRITE = 1 << 2
+} FileTimeFlags;
+
+/*!
+ * @brief
+ * Outcome of touch_if_changed().
+ */
+typedef enum touch_outcome {
+    TOUCH_FAILED,
+    // The timestamps were written, or the file was created
+    TOUCH_UPDATED,
+    // The file already had the requested timestamps and was not written
+    TOUCH_UNCHANGED,
+    // The file does not exist and was not created
+    TOUCH_MISSING
+} TouchOutcome;
+
+/*!
+ * @brief
+ * Outcome of touching a single file with touch_many().
+ */
+typedef struct touch_status {
+    // Same as the return value of touch()
+    bool ok;
+    // The backend error code of the failure, if ok is false
+    FsError err;
+} TouchStatus;
+
+/*!
+ * @brief
+ * Memory that touch_many() plans its work in, which can be kept from one call
+ * to the next so that a caller touching batch after batch allocates it once.
+ * A workspace is used by one call at a time.
+ */
+typedef struct touch_workspace TouchWorkspace;
+
+/*!
+ * @brief
+ * Describes how the timestamps of each touched file are changed.
+ */
+typedef struct timestamp_operation {
+    TimestampSource source;
+    FileTimeFlags ft_flags;
+    FsTime creation;
+    FsTime access;
+    FsTime write;
+    int adjustment_seconds;
+} TimestampOperation;
+
+/*!
+ * @brief
+ * Parses a given timestamp string and translates it into an FsTime.
+ *
+ * @param stamp
+ * The string to parse, which must follow ISO 8601 basic or extended format.
+ *
+ * @param out
+ * Pointer to an FsTime to receive the parsed timestamp.
+ *
+ * @returns
+ * true if the timestamp was successfully parsed and translated; false otherwise.
+ */
+bool parse_timestamp_string(const TCHAR *stamp, FsTime *out);
+
+/*!
+ * @brief
+ * Retrieves timestamps from the specified file.
+ *
+ * @param filename
+ * Path to the file to retrieve timestamps from.
+ *
+ * @param out
+ * Pointer to an FsTimes struct to store the retrieved timestamps.
+ *
+ * @return
+ * true if the timestamps were successfully retrieved; false otherwise.
+ */
+bool get_ref_timestamps(const TCHAR *filename, FsTimes *out);
+
+/*!
+ * @brief
+ * Constructs a TimestampOperation struct based on the given parameters.
+ *
+ * @param ft_stamp
+ * Optional pointer to an FsTime containing the timestamp to work with.
+ * If specified, then \p ref_stamps should be NULL.
+ *
+ * @param ref_stamps
+ * Optional pointer to an FsTimes struct containing the timestamps to
+ * work with. If specified, then \p ft_stamp should be NULL.
+ *
+ * @param ft_flags
+ * Flags indicating which file timestamps are affected.
+ * 
+ * @param adjustment_seconds
+ * Seconds to add to or subtract (if negative) from the target timestamp.
+ *
+ * @return
+ * A TimestampOperation describing the requested operation.
+ * 
+ * If both \p ft_stamp and \p ref_stamps are NULL, and \p adjustment_seconds is
+ * zero, the timestamps are set to FS_TIME_NOW, so that each file takes the
+ * current time of day when it is written. However, if
+ * \p adjustment_seconds is non-zero, the \c source member of the returned struct
+ * will be set to \c TS_SOURCE_RELATIVE, indicating that time adjustment is
+ * applied relative to an existing file's timestamps.
+ */
+TimestampOperation prepare_timestamp(
+    const FsTime *ft_stamp,
+    const FsTimes *ref_stamps,
+    FileTimeFlags ft_flags, int adjustment_seconds);
+
+/*!
+ * @brief
+ * Changes the timestamp of the given file.
+ *
+ * @param path
+ * Path to the file to touch.
+ *
+ * @param existing_only
+ * Specifies whether to operate on an existing file only, or create the file if
+ * it does not exist.
+ * 
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * true if the timestamps were successfully changed, or if the file does not
+ * exist and \p existing_only is set; false otherwise, in which case
+ * fs_last_error() describes the failure.
+ */
+bool touch(
+    const TCHAR *path,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op);
+
+/*!
+ * @brief
+ * Touches many files, with the same outcome as calling touch() on each, but
+ * moves them through each stage together: files that need to be opened are
+ * all opened through one fs_batch_run(), and all are closed through another.
+ * Only the timestamp changes themselves, and the reads of the times that are
+ * adjusted, are made one file at a time.
+ *
+ * Files are first grouped by the directory that holds them. The directory of
+ * a group with more than a few files is opened once, and its files are then
+ * reached by name within it, so that the system resolves the directory's path
+ * once rather than once per file.
+ *
+ * @param batch
+ * Pointer to the FsBatch that runs the opens and closes.
+ *
+ * @param work
+ * Optional pointer to a workspace to plan in. If NULL, one is allocated for
+ * the call.
+ *
+ * @param paths
+ * Array of paths to the files to touch.
+ *
+ * @param count
+ * Number of elements in \p paths.
+ *
+ * @param existing_only
+ * Specifies whether to operate on existing files only, or create the files
+ * that do not exist.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param op
+ * Pointer to the operation to apply to every file. Ignored if \p ops is set.
+ *
+ * @param ops
+ * Optional array of operations, indexed like \p paths.
+ *
+ * @param out
+ * Array that receives the outcome of each file, indexed like \p paths.
+ */
+void touch_many(
+    FsBatch *batch, TouchWorkspace *work,
+    const TCHAR *const *paths, size_t count,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op, const TimestampOperation *ops,
+    TouchStatus *out);
+
+/*!
+ * @brief
+ * Allocates a workspace for touch_many().
+ *
+ * @return
+ * Pointer to a new TouchWorkspace, or NULL if memory could not be allocated.
+ */
+TouchWorkspace *touch_workspace_open(void);
+
+/*!
+ * @brief
+ * Frees a workspace allocated by touch_workspace_open().
+ *
+ * @param work
+ * The workspace to free. If NULL, no action is taken.
+ */
+void touch_workspace_close(TouchWorkspace *work);
+
+/*!
+ * @brief
+ * Compares the current timestamps of a file with the wanted ones at the
+ * granularity of its file system. Two times that are less than one unit of
+ * granularity apart are stored the same, so writing one over the other would
+ * change nothing.
+ *
+ * @param current
+ * Pointer to the timestamps the file has.
+ *
+ * @param wanted
+ * Pointer to the timestamps to compare against. Members set to FS_TIME_OMIT
+ * are never reported as changed.
+ *
+ * @param granularity
+ * Pointer to the granularity of each timestamp, as reported by
+ * fs_stat_times_granular().
+ *
+ * @param ft_flags
+ * Timestamps to compare.
+ *
+ * @return
+ * The subset of \p ft_flags whose timestamps would change if written.
+ */
+FileTimeFlags changed_times(
+    const FsTimes *current, const FsTimes *wanted,
+    const FsTimes *granularity, FileTimeFlags ft_flags);
+
+/*!
+ * @brief
+ * Changes the timestamp of the given file like touch(), unless the file already
+ * has the requested timestamps at the granularity of its file system. Only the
+ * timestamps that differ are written. This costs one extra stat for files that
+ * need changing, and saves the write, with its journal entry, change time
+ * update and file system notification, for those that don't.
+ *
+ * @param path
+ * Path to the file to touch.
+ *
+ * @param existing_only
+ * Specifies whether to operate on an existing file only, or create the file if
+ * it does not exist.
+ *
+ * @param follow_symlinks
+ * Specifies whether to follow symbolic links, or operate on the links themselves.
+ *
+ * @param op
+ * Pointer to a TimestampOperation struct containing operation details.
+ *
+ * @return
+ * A TouchOutcome describing the result. If TOUCH_FAILED is returned,
+ * fs_last_error() describes the failure.
+ */
+TouchOutcome touch_if_changed(
+    const TCHAR *path,
+    bool existing_only, bool follow_symlinks,
+    const TimestampOperation *op);
+
+#endif // TOUCHOP_H
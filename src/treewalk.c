@@ -0,0 +1,491 @@
+/* treewalk.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "treewalk.h"
+#include "workpool.h"
+#include "fsbackend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+// Maximum number of directories each thread keeps queued for others to steal.
+// Once a queue is full, its owner descends into new subdirectories itself, so
+// the memory used by the walk is bounded by the thread count and the depth of
+// the tree rather than by its fan-out
+#define DEQUE_CAPACITY 1024
+
+// Maximum length of a path, including the terminating null character
+#define PATH_CAPACITY 32768
+
+/*!
+ * @brief
+ * Bounded double-ended queue of directory paths owned by a single thread. The
+ * owner pushes and pops at the bottom, other threads steal from the top.
+ */
+typedef struct task_deque {
+    mtx_t lock;
+    TCHAR *items[DEQUE_CAPACITY];
+    size_t head;
+    size_t count;
+} TaskDeque;
+
+/*!
+ * @brief
+ * State shared by all threads of a walk.
+ */
+typedef struct walker {
+    const TreeWalk *walk;
+    unsigned int threads;
+    TaskDeque *deques;
+
+    const TCHAR *const *roots;
+    size_t root_count;
+
+    // Guards the members below
+    mtx_t state_lock;
+    cnd_t state_cond;
+    // Number of root directories not yet claimed by a thread
+    size_t next_root;
+    // Number of directories queued or being walked
+    size_t pending;
+    // Number of directories sitting in deques
+    size_t queued;
+
+    // Serializes report callbacks
+    mtx_t report_lock;
+    bool all_ok;
+} Walker;
+
+/*!
+ * @brief
+ * Per-thread walk state.
+ */
+typedef struct worker {
+    Walker *walker;
+    unsigned int id;
+    // Scratch buffer for building entry paths
+    TCHAR *path_buf;
+} Worker;
+
+/*!
+ * @brief
+ * An open directory enumeration.
+ */
+typedef struct dir_cursor {
+    TCHAR *path;
+    size_t path_len;
+    FsDir *dir;
+} DirCursor;
+
+static bool deque_push(TaskDeque *dq, Walker *w, TCHAR *path) {
+    mtx_lock(&dq->lock);
+
+    if (dq->count == DEQUE_CAPACITY) {
+        mtx_unlock(&dq->lock);
+        return false;
+    }
+
+    dq->items[(dq->head + dq->count) % DEQUE_CAPACITY] = path;
+    dq->count++;
+
+    // Account for the task while still holding the deque lock so a thief can
+    // never observe the item before the counters do
+    mtx_lock(&w->state_lock);
+    w->pending++;
+    w->queued++;
+    cnd_signal(&w->state_cond);
+    mtx_unlock(&w->state_lock);
+
+    mtx_unlock(&dq->lock);
+
+    return true;
+}
+
+static TCHAR *deque_pop(TaskDeque *dq) {
+    TCHAR *path = NULL;
+
+    mtx_lock(&dq->lock);
+
+    if (dq->count > 0) {
+        dq->count--;
+        path = dq->items[(dq->head + dq->count) % DEQUE_CAPACITY];
+    }
+
+    mtx_unlock(&dq->lock);
+
+    return path;
+}
+
+static TCHAR *deque_steal(TaskDeque *dq) {
+    TCHAR *path = NULL;
+
+    mtx_lock(&dq->lock);
+
+    if (dq->count > 0) {
+        path = dq->items[dq->head];
+        dq->head = (dq->head + 1) % DEQUE_CAPACITY;
+        dq->count--;
+    }
+
+    mtx_unlock(&dq->lock);
+
+    return path;
+}
+
+static TCHAR *dup_path(const TCHAR *path, size_t len) {
+    TCHAR *copy = malloc((len + 1) * sizeof(TCHAR));
+
+    if (copy) {
+        memcpy(copy, path, len * sizeof(TCHAR));
+        copy[len] = '\0';
+    }
+
+    return copy;
+}
+
+static void report(Walker *w, const TCHAR *path, FsError err) {
+    mtx_lock(&w->report_lock);
+
+    w->all_ok = false;
+
+    if (w->walk->report) {
+        w->walk->report(w->walk->ctx, path, err);
+    }
+
+    mtx_unlock(&w->report_lock);
+}
+
+/*!
+ * @brief
+ * Starts enumerating the directory at the given path.
+ *
+ * @param cursor
+ * Pointer to a DirCursor that receives the enumeration. Takes ownership of
+ * \p path, even on failure.
+ *
+ * @param path
+ * Heap-allocated path of the directory to enumerate.
+ *
+ * @return
+ * FS_OK if the enumeration was started; a backend error code otherwise.
+ */
+static FsError cursor_open(DirCursor *cursor, TCHAR *path) {
+    cursor->path = path;
+    cursor->path_len = _tcslen(path);
+    cursor->dir = fs_dir_open(path);
+
+    return cursor->dir ? FS_OK : fs_last_error();
+}
+
+static void cursor_close(DirCursor *cursor) {
+    fs_dir_close(cursor->dir);
+    cursor->dir = NULL;
+
+    free(cursor->path);
+    cursor->path = NULL;
+}
+
+/*!
+ * @brief
+ * Walks a directory. Subdirectories are offered to other threads through the
+ * worker's deque; if it is full, they are walked depth-first in place.
+ *
+ * @param self
+ * Pointer to the calling worker.
+ *
+ * @param path
+ * Heap-allocated path of the directory to walk. Ownership is transferred.
+ */
+static void walk_dir(Worker *self, TCHAR *path) {
+    Walker *w = self->walker;
+    TaskDeque *own = &w->deques[self->id];
+
+    DirCursor *stack = NULL;
+    size_t depth = 0;
+    size_t stack_capacity = 0;
+
+    TCHAR *next_path = path;
+
+    while (true) {
+        if (next_path) {
+            if (depth == stack_capacity) {
+                size_t new_capacity = stack_capacity ? (stack_capacity * 2) : 16;
+                DirCursor *grown = realloc(stack, new_capacity * sizeof(DirCursor));
+
+                if (!grown) {
+                    report(w, next_path, FS_ERR_NO_MEMORY);
+                    free(next_path);
+                    next_path = NULL;
+                    continue;
+                }
+
+                stack = grown;
+                stack_capacity = new_capacity;
+            }
+
+            FsError err = cursor_open(&stack[depth], next_path);
+            next_path = NULL;
+
+            if (err != FS_OK) {
+                report(w, stack[depth].path, err);
+                cursor_close(&stack[depth]);
+            } else {
+                depth++;
+            }
+        }
+
+        if (depth == 0) {
+            break;
+        }
+
+        DirCursor *cursor = &stack[depth - 1];
+        FsDirEntry entry;
+        FsError err;
+
+        if (!fs_dir_next(cursor->dir, &entry, &err)) {
+            if (err != FS_OK) {
+                report(w, cursor->path, err);
+            }
+
+            cursor_close(cursor);
+            depth--;
+            continue;
+        }
+
+        size_t dir_len = cursor->path_len;
+        size_t name_len = _tcslen(entry.name);
+        bool needs_sep =
+            dir_len > 0 &&
+            cursor->path[dir_len - 1] != PATH_SEP &&
+            cursor->path[dir_len - 1] != '/';
+
+        size_t len = dir_len + (needs_sep ? 1 : 0) + name_len;
+
+        if (len + 1 > PATH_CAPACITY) {
+            report(w, cursor->path, FS_ERR_NAME_TOO_LONG);
+            continue;
+        }
+
+        TCHAR *buf = self->path_buf;
+        memcpy(buf, cursor->path, dir_len * sizeof(TCHAR));
+
+        if (needs_sep) {
+            buf[dir_len] = PATH_SEP;
+        }
+
+        memcpy(&buf[len - name_len], entry.name, (name_len + 1) * sizeof(TCHAR));
+
+        FsError visit_err = w->walk->visit(w->walk->ctx, buf);
+
+        if (visit_err != FS_OK) {
+            report(w, buf, visit_err);
+        }
+
+        if (!entry.is_dir || entry.is_link) {
+            continue;
+        }
+
+        TCHAR *sub = dup_path(buf, len);
+
+        if (!sub) {
+            report(w, buf, FS_ERR_NO_MEMORY);
+        } else if (!deque_push(own, w, sub)) {
+            next_path = sub;
+        }
+    }
+
+    free(stack);
+}
+
+/*!
+ * @brief
+ * Retrieves the next directory to walk: an unclaimed root, then the worker's
+ * own deque, then any other worker's deque. Blocks while other threads are
+ * still walking and may produce more work.
+ *
+ * @return
+ * Heap-allocated path of the directory to walk, or NULL if the walk is done.
+ */
+static TCHAR *take_task(Worker *self) {
+    Walker *w = self->walker;
+
+    while (true) {
+        TCHAR *path = NULL;
+
+        mtx_lock(&w->state_lock);
+
+        if (w->next_root < w->root_count) {
+            const TCHAR *root = w->roots[w->next_root++];
+            mtx_unlock(&w->state_lock);
+
+            path = dup_path(root, _tcslen(root));
+
+            if (!path) {
+                report(w, root, FS_ERR_NO_MEMORY);
+
+                mtx_lock(&w->state_lock);
+                if (--w->pending == 0) {
+                    cnd_broadcast(&w->state_cond);
+                }
+                mtx_unlock(&w->state_lock);
+
+                continue;
+            }
+
+            return path;
+        }
+
+        mtx_unlock(&w->state_lock);
+
+        path = deque_pop(&w->deques[self->id]);
+
+        for (unsigned int i = 1; !path && i < w->threads; i++) {
+            path = deque_steal(&w->deques[(self->id + i) % w->threads]);
+        }
+
+        mtx_lock(&w->state_lock);
+
+        if (path) {
+            w->queued--;
+            mtx_unlock(&w->state_lock);
+            return path;
+        }
+
+        while (w->queued == 0 && w->pending > 0) {
+            cnd_wait(&w->state_cond, &w->state_lock);
+        }
+
+        bool done = (w->pending == 0);
+
+        mtx_unlock(&w->state_lock);
+
+        if (done) {
+            return NULL;
+        }
+    }
+}
+
+static int worker_main(void *arg) {
+    Worker *self = arg;
+    Walker *w = self->walker;
+    TCHAR *path;
+
+    while ((path = take_task(self)) != NULL) {
+        walk_dir(self, path);
+
+        mtx_lock(&w->state_lock);
+
+        if (--w->pending == 0) {
+            cnd_broadcast(&w->state_cond);
+        }
+
+        mtx_unlock(&w->state_lock);
+    }
+
+    return 0;
+}
+
+bool tree_walk(const TreeWalk *walk, const TCHAR *const *roots, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+
+    unsigned int threads = walk->threads;
+
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > WORKPOOL_THREADS_MAX) {
+        threads = WORKPOOL_THREADS_MAX;
+    }
+
+    Walker w = {
+        .walk = walk,
+        .threads = threads,
+        .roots = roots,
+        .root_count = count,
+        .next_root = 0,
+        .pending = count,
+        .queued = 0,
+        .all_ok = true
+    };
+
+    w.deques = calloc(threads, sizeof(TaskDeque));
+    Worker *workers = calloc(threads, sizeof(Worker));
+
+    if (!w.deques || !workers) {
+        free(w.deques);
+        free(workers);
+        return false;
+    }
+
+    mtx_init(&w.state_lock, mtx_plain);
+    mtx_init(&w.report_lock, mtx_plain);
+    cnd_init(&w.state_cond);
+
+    unsigned int ready = 0;
+
+    for (; ready < threads; ready++) {
+        workers[ready].walker = &w;
+        workers[ready].id = ready;
+        workers[ready].path_buf = malloc(PATH_CAPACITY * sizeof(TCHAR));
+
+        if (!workers[ready].path_buf) {
+            break;
+        }
+
+        mtx_init(&w.deques[ready].lock, mtx_plain);
+    }
+
+    // Deques past the last ready worker are never stolen from
+    w.threads = ready;
+
+    thrd_t *handles = NULL;
+    unsigned int started = 0;
+
+    if (ready > 1) {
+        handles = calloc(ready - 1, sizeof(thrd_t));
+    }
+
+    // The calling thread is worker 0
+    for (unsigned int i = 1; handles && i < ready; i++) {
+        if (thrd_create(&handles[started], worker_main, &workers[i]) != thrd_success) {
+            break;
+        }
+
+        started++;
+    }
+
+    if (ready > 0) {
+        worker_main(&workers[0]);
+    } else {
+        w.all_ok = false;
+    }
+
+    for (unsigned int i = 0; i < started; i++) {
+        thrd_join(handles[i], NULL);
+    }
+
+    for (unsigned int i = 0; i < ready; i++) {
+        mtx_destroy(&w.deques[i].lock);
+        free(workers[i].path_buf);
+    }
+
+    cnd_destroy(&w.state_cond);
+    mtx_destroy(&w.report_lock);
+    mtx_destroy(&w.state_lock);
+
+    free(handles);
+    free(workers);
+    free(w.deques);
+
+    return w.all_ok;
+}
+
+bool tree_is_walkable_dir(const TCHAR *path, bool follow_symlinks) {
+    return fs_is_directory(path, follow_symlinks);
+}
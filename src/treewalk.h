@@ -0,0 +1,101 @@
+/* treewalk.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef TREEWALK_H
+#define TREEWALK_H
+
+#include "fsbackend.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*!
+ * @brief
+ * Callback invoked for every entry found below the walked directories.
+ *
+ * @param ctx
+ * Context pointer of the walk.
+ *
+ * @param path
+ * Full path to the entry. Only valid for the duration of the call.
+ *
+ * @return
+ * FS_OK if the entry was processed successfully; otherwise, a backend error
+ * code that will be passed on to the report callback.
+ */
+typedef FsError (*TreeVisitFn)(void *ctx, const TCHAR *path);
+
+/*!
+ * @brief
+ * Callback invoked for every entry that could not be visited or every directory
+ * that could not be enumerated. Calls are serialized by the walker.
+ *
+ * @param ctx
+ * Context pointer of the walk.
+ *
+ * @param path
+ * Full path to the entry that failed.
+ *
+ * @param err
+ * The backend error code of the failure.
+ */
+typedef void (*TreeReportFn)(void *ctx, const TCHAR *path, FsError err);
+
+/*!
+ * @brief
+ * Describes a recursive directory walk.
+ */
+typedef struct tree_walk {
+    TreeVisitFn visit;
+    TreeReportFn report;
+    void *ctx;
+    // Number of threads to walk with, including the calling thread
+    unsigned int threads;
+} TreeWalk;
+
+/*!
+ * @brief
+ * Recursively walks the given directories and invokes the visit callback for
+ * every file and directory below them. The directories themselves are not
+ * visited.
+ *
+ * Subdirectories are distributed over per-thread work queues; idle threads
+ * steal pending directories from busy ones. Directories that are reparse points
+ * (symbolic links, junctions) are visited but never descended into.
+ *
+ * @param walk
+ * Pointer to a TreeWalk struct describing the walk.
+ *
+ * @param roots
+ * Array of paths to the directories to walk.
+ *
+ * @param count
+ * Number of elements in \p roots.
+ *
+ * @return
+ * true if every entry was visited successfully and every directory could be
+ * enumerated; false otherwise.
+ */
+bool tree_walk(const TreeWalk *walk, const TCHAR *const *roots, size_t count);
+
+/*!
+ * @brief
+ * Determines whether the given path is a directory that tree_walk() would
+ * descend into.
+ *
+ * @param path
+ * Path to check.
+ *
+ * @param follow_symlinks
+ * If true, a symbolic link to a directory counts as a directory.
+ *
+ * @return
+ * true if \p path refers to a walkable directory; false otherwise.
+ */
+bool tree_is_walkable_dir(const TCHAR *path, bool follow_symlinks);
+
+#endif // TREEWALK_H
@@ -0,0 +1,942 @@
+/* wildcard.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "wildcard.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <wctype.h>
+#endif
+
+// Maximum length of a path, including the terminating null character
+#define PATH_CAPACITY 32768
+
+// Marks the absence of a position
+#define NO_POSITION SIZE_MAX
+
+typedef enum token_kind {
+    // A run of characters that must match exactly
+    TOKEN_LITERAL,
+    // "?"
+    TOKEN_ANY,
+    // "*"
+    TOKEN_STAR,
+    // "[...]"
+    TOKEN_SET
+} TokenKind;
+
+/*!
+ * @brief
+ * An element of a compiled name pattern.
+ */
+typedef struct token {
+    TokenKind kind;
+    // Start of a literal in the text of the pattern, or index of a set
+    size_t index;
+    // Number of code units in a literal
+    size_t len;
+} Token;
+
+/*!
+ * @brief
+ * The characters matched by a "[...]" set.
+ */
+typedef struct char_set {
+    bool negated;
+    // ASCII members, one bit per character
+    uint32_t ascii[4];
+    // Other members, as a run of the ranges of the pattern
+    size_t first_range;
+    size_t range_count;
+} CharSet;
+
+typedef struct char_range {
+    uint32_t lo;
+    uint32_t hi;
+} CharRange;
+
+typedef enum segment_kind {
+    // A name without wildcards, which is looked up rather than listed
+    SEGMENT_NAME,
+    // A name with wildcards, matched against each entry of a directory
+    SEGMENT_PATTERN,
+    // "**"
+    SEGMENT_GLOBSTAR
+} SegmentKind;
+
+/*!
+ * @brief
+ * One name of a pattern, between two separators.
+ */
+typedef struct segment {
+    SegmentKind kind;
+    // The name of a SEGMENT_NAME, as it was given, in the text of the pattern
+    size_t text;
+    size_t len;
+    // The tokens of a SEGMENT_PATTERN
+    size_t first_token;
+    size_t token_count;
+    // Literal every match ends with, checked before the tokens are run so
+    // that most names are turned down by a single comparison. Empty if none
+    size_t suffix;
+    size_t suffix_len;
+    // Specifies whether names that begin with "." can match
+    bool matches_hidden;
+} Segment;
+
+struct wildcard {
+    // The pattern as given. Its part up to base_len has no wildcards and is
+    // used as is
+    TCHAR *pattern;
+    size_t base_len;
+    // The pattern ends with a separator, so only directories match
+    bool dirs_only;
+    // Whether "[...]" is a set, rather than part of a name
+    bool sets_enabled;
+
+    Segment *segments;
+    size_t segment_count;
+    Token *tokens;
+    size_t token_count;
+    CharSet *sets;
+    size_t set_count;
+    CharRange *ranges;
+    size_t range_count;
+    // Names and literals of the segments. Literals are stored case-folded on
+    // Windows
+    TCHAR *text;
+    size_t text_len;
+};
+
+/*!
+ * @brief
+ * State of a wildcard_expand() call.
+ */
+typedef struct expansion {
+    const Wildcard *wc;
+    WildcardMatchFn match;
+    TreeReportFn report;
+    void *ctx;
+    // The path being built, always null-terminated at the length in use
+    TCHAR *path;
+    size_t matches;
+    bool ok;
+} Expansion;
+
+/*!
+ * @brief
+ * Names of the subdirectories "**" descends into once a listing is done.
+ */
+typedef struct name_list {
+    TCHAR *chars;
+    size_t used;
+    size_t capacity;
+} NameList;
+
+static void expand(Expansion *ex, size_t seg, size_t len);
+
+static bool is_separator(TCHAR c) {
+#ifdef _WIN32
+    return c == '\\' || c == '/';
+#else
+    return c == '/';
+#endif
+}
+
+static bool is_hidden(const TCHAR *name) {
+#ifdef _WIN32
+    // Explorer and the shells show these like any other
+    (void)name;
+    return false;
+#else
+    return name[0] == '.';
+#endif
+}
+
+#ifdef _WIN32
+static TCHAR fold_case(TCHAR c) {
+    return (TCHAR)towlower(c);
+}
+#endif
+
+/*!
+ * @brief
+ * Compares a run of a name with a literal of the pattern, which is stored
+ * case-folded on Windows.
+ */
+static bool equal_units(const TCHAR *name, const TCHAR *literal, size_t len) {
+#ifdef _WIN32
+    for (size_t i = 0; i < len; i++) {
+        if (fold_case(name[i]) != literal[i]) {
+            return false;
+        }
+    }
+
+    return true;
+#else
+    return memcmp(name, literal, len) == 0;
+#endif
+}
+
+/*!
+ * @brief
+ * Decodes the character at the start of a string, which is UTF-16 on Windows
+ * and UTF-8 elsewhere. Malformed sequences are taken one code unit at a time.
+ *
+ * @param len
+ * Number of code units available, which must be at least 1.
+ *
+ * @param units
+ * Pointer to a size_t that receives the number of code units decoded.
+ */
+static uint32_t decode_char(const TCHAR *s, size_t len, size_t *units) {
+#ifdef _WIN32
+    uint32_t c = s[0];
+
+    if (c >= 0xD800 && c <= 0xDBFF && len > 1 && s[1] >= 0xDC00 && s[1] <= 0xDFFF) {
+        *units = 2;
+        return 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)s[1] - 0xDC00);
+    }
+
+    *units = 1;
+    return c;
+#else
+    const unsigned char *b = (const unsigned char *)s;
+    size_t n = (b[0] >= 0xF0 && b[0] <= 0xF4) ? 4 :
+               (b[0] >= 0xE0) ? 3 :
+               (b[0] >= 0xC2 && b[0] < 0xE0) ? 2 : 1;
+
+    uint32_t c = (n == 1) ? b[0] : (b[0] & (0x7F >> n));
+
+    for (size_t i = 1; i < n; i++) {
+        if (i >= len || (b[i] & 0xC0) != 0x80) {
+            *units = 1;
+            return b[0];
+        }
+
+        c = (c << 6) | (b[i] & 0x3F);
+    }
+
+    *units = n;
+    return c;
+#endif
+}
+
+/*!
+ * @brief
+ * Finds the "]" that closes the set opening at \p start, if any. A "]" right
+ * after the opening bracket, or after its negation, is a member of the set.
+ *
+ * @return
+ * The position of the closing bracket, or NO_POSITION if there is none.
+ */
+static size_t find_set_end(const TCHAR *s, size_t len, size_t start) {
+    size_t i = start + 1;
+
+    if (i < len && (s[i] == '!' || s[i] == '^')) {
+        i++;
+    }
+
+    if (i < len && s[i] == ']') {
+        i++;
+    }
+
+    while (i < len && s[i] != ']') {
+        i++;
+    }
+
+    return (i < len) ? i : NO_POSITION;
+}
+
+static bool name_is_pattern(const TCHAR *s, size_t len, bool sets) {
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '*' || s[i] == '?' ||
+           (sets && s[i] == '[' && find_set_end(s, len, i) != NO_POSITION)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * @brief
+ * Gets the length of the drive of a drive-relative path like "C:file", which
+ * belongs to the part of a pattern that is used as is.
+ */
+static size_t drive_length(const TCHAR *path) {
+#ifdef _WIN32
+    bool drive =
+        ((path[0] >= 'A' && path[0] <= 'Z') || (path[0] >= 'a' && path[0] <= 'z')) &&
+        path[1] == ':';
+
+    return drive ? 2 : 0;
+#else
+    (void)path;
+    return 0;
+#endif
+}
+
+bool wildcard_is_pattern(const TCHAR *path, bool sets) {
+    size_t start = 0;
+
+    while (path[start] != '\0') {
+        size_t end = start;
+
+        while (path[end] != '\0' && !is_separator(path[end])) {
+            end++;
+        }
+
+        if (name_is_pattern(&path[start], end - start, sets)) {
+            return true;
+        }
+
+        start = (path[end] != '\0') ? end + 1 : end;
+    }
+
+    return false;
+}
+
+static void add_range(Wildcard *wc, CharSet *set, uint32_t lo, uint32_t hi) {
+    for (uint32_t c = lo; c <= hi && c < 128; c++) {
+        set->ascii[c / 32] |= (uint32_t)1 << (c % 32);
+    }
+
+    if (hi >= 128) {
+        wc->ranges[wc->range_count++] = (CharRange) { (lo < 128) ? 128 : lo, hi };
+        set->range_count++;
+    }
+}
+
+/*!
+ * @brief
+ * Compiles the members of a set, given without its brackets.
+ *
+ * @return
+ * The index of the set.
+ */
+static size_t compile_set(Wildcard *wc, const TCHAR *s, size_t len) {
+    size_t index = wc->set_count++;
+    CharSet *set = &wc->sets[index];
+    size_t i = 0;
+
+    *set = (CharSet) { .first_range = wc->range_count };
+
+    if (len > 0 && (s[0] == '!' || s[0] == '^')) {
+        set->negated = true;
+        i++;
+    }
+
+    while (i < len) {
+        size_t units;
+        uint32_t lo = decode_char(&s[i], len - i, &units);
+        uint32_t hi = lo;
+
+        i += units;
+
+        // A "-" that ends the set is a member of its own
+        if (i + 1 < len && s[i] == '-') {
+            hi = decode_char(&s[i + 1], len - i - 1, &units);
+            i += 1 + units;
+        }
+
+        if (lo <= hi) {
+            add_range(wc, set, lo, hi);
+        }
+    }
+
+    return index;
+}
+
+static bool set_has(const Wildcard *wc, const CharSet *set, uint32_t c) {
+    if (c < 128) {
+        return (set->ascii[c / 32] >> (c % 32)) & 1;
+    }
+
+    for (size_t i = 0; i < set->range_count; i++) {
+        const CharRange *range = &wc->ranges[set->first_range + i];
+
+        if (c >= range->lo && c <= range->hi) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool set_matches(const Wildcard *wc, const CharSet *set, uint32_t c) {
+    bool found = set_has(wc, set, c);
+
+#ifdef _WIN32
+    // Sets are kept as written, so both cases of the character are tried
+    if (!found && c <= 0xFFFF) {
+        found =
+            set_has(wc, set, (uint32_t)towlower((wint_t)c)) ||
+            set_has(wc, set, (uint32_t)towupper((wint_t)c));
+    }
+#endif
+
+    return found != set->negated;
+}
+
+static void add_token(Wildcard *wc, TokenKind kind, size_t index, size_t len) {
+    wc->tokens[wc->token_count++] = (Token) { kind, index, len };
+}
+
+/*!
+ * @brief
+ * Compiles a name that contains wildcards into the tokens of a segment.
+ */
+static void compile_name(Wildcard *wc, const TCHAR *s, size_t len, Segment *seg) {
+    seg->kind = SEGMENT_PATTERN;
+    seg->first_token = wc->token_count;
+
+#ifdef _WIN32
+    seg->matches_hidden = true;
+#else
+    seg->matches_hidden = (s[0] == '.');
+#endif
+
+    for (size_t i = 0; i < len; i++) {
+        Token *last = (wc->token_count > seg->first_token) ? &wc->tokens[wc->token_count - 1] : NULL;
+
+        if (s[i] == '*') {
+            // Consecutive stars match the same as one
+            if (!last || last->kind != TOKEN_STAR) {
+                add_token(wc, TOKEN_STAR, 0, 0);
+            }
+
+            continue;
+        }
+
+        if (s[i] == '?') {
+            add_token(wc, TOKEN_ANY, 0, 0);
+            continue;
+        }
+
+        if (s[i] == '[' && wc->sets_enabled) {
+            size_t end = find_set_end(s, len, i);
+
+            if (end != NO_POSITION) {
+                add_token(wc, TOKEN_SET, compile_set(wc, &s[i + 1], end - i - 1), 0);
+                i = end;
+                continue;
+            }
+        }
+
+#ifdef _WIN32
+        wc->text[wc->text_len] = fold_case(s[i]);
+#else
+        wc->text[wc->text_len] = s[i];
+#endif
+
+        if (last && last->kind == TOKEN_LITERAL) {
+            last->len++;
+        } else {
+            add_token(wc, TOKEN_LITERAL, wc->text_len, 1);
+        }
+
+        wc->text_len++;
+    }
+
+    seg->token_count = wc->token_count - seg->first_token;
+
+    const Token *tokens = &wc->tokens[seg->first_token];
+    const Token *tail = &tokens[seg->token_count - 1];
+    bool has_star = false;
+
+    for (size_t t = 0; t < seg->token_count; t++) {
+        has_star |= (tokens[t].kind == TOKEN_STAR);
+    }
+
+    // Without a star, the tokens check the end of the name soon enough
+    if (has_star && tail->kind == TOKEN_LITERAL) {
+        seg->suffix = tail->index;
+        seg->suffix_len = tail->len;
+    }
+}
+
+void wildcard_free(Wildcard *wc) {
+    if (!wc) {
+        return;
+    }
+
+    free(wc->pattern);
+    free(wc->segments);
+    free(wc->tokens);
+    free(wc->sets);
+    free(wc->ranges);
+    free(wc->text);
+    free(wc);
+}
+
+Wildcard *wildcard_compile(const TCHAR *pattern, bool sets) {
+    size_t len = _tcslen(pattern);
+    Wildcard *wc = calloc(1, sizeof(Wildcard));
+
+    if (!wc) {
+        return NULL;
+    }
+
+    // Every segment, token, set, range and character of text takes at least
+    // one character of the pattern
+    wc->pattern = malloc((len + 1) * sizeof(TCHAR));
+    wc->segments = malloc((len + 1) * sizeof(Segment));
+    wc->tokens = malloc((len + 1) * sizeof(Token));
+    wc->sets = malloc((len + 1) * sizeof(CharSet));
+    wc->ranges = malloc((len + 1) * sizeof(CharRange));
+    wc->text = malloc((len + 1) * sizeof(TCHAR));
+
+    if (!wc->pattern || !wc->segments || !wc->tokens ||
+        !wc->sets || !wc->ranges || !wc->text) {
+        wildcard_free(wc);
+        return NULL;
+    }
+
+    memcpy(wc->pattern, pattern, (len + 1) * sizeof(TCHAR));
+    wc->sets_enabled = sets;
+
+    // The names before the first one with wildcards are used as is
+    size_t start = drive_length(pattern);
+    wc->base_len = start;
+
+    while (true) {
+        while (is_separator(pattern[start])) {
+            start++;
+        }
+
+        size_t end = start;
+
+        while (pattern[end] != '\0' && !is_separator(pattern[end])) {
+            end++;
+        }
+
+        if (end == start || name_is_pattern(&pattern[start], end - start, sets)) {
+            break;
+        }
+
+        wc->base_len = end;
+        start = end;
+    }
+
+    // A pattern without wildcards is matched by the path it names, so it
+    // keeps a separator of its own
+    if (pattern[start] == '\0') {
+        wc->base_len = len;
+        return wc;
+    }
+
+    wc->base_len = start;
+    wc->dirs_only = (len > 0 && is_separator(pattern[len - 1]));
+
+    while (pattern[start] != '\0') {
+        size_t end = start;
+
+        while (pattern[end] != '\0' && !is_separator(pattern[end])) {
+            end++;
+        }
+
+        const TCHAR *name = &pattern[start];
+        size_t name_len = end - start;
+
+        while (is_separator(pattern[end])) {
+            end++;
+        }
+
+        start = end;
+
+        if (name_len == 2 && name[0] == '*' && name[1] == '*') {
+            Segment *prev = (wc->segment_count > 0) ? &wc->segments[wc->segment_count - 1] : NULL;
+
+            // Consecutive globstars match the same as one
+            if (!prev || prev->kind != SEGMENT_GLOBSTAR) {
+                wc->segments[wc->segment_count++] = (Segment) { .kind = SEGMENT_GLOBSTAR };
+            }
+
+            continue;
+        }
+
+        Segment *seg = &wc->segments[wc->segment_count++];
+        *seg = (Segment) { .kind = SEGMENT_NAME };
+
+        if (name_is_pattern(name, name_len, sets)) {
+            compile_name(wc, name, name_len, seg);
+            continue;
+        }
+
+        seg->text = wc->text_len;
+        seg->len = name_len;
+
+        memcpy(&wc->text[wc->text_len], name, name_len * sizeof(TCHAR));
+        wc->text_len += name_len;
+    }
+
+    return wc;
+}
+
+/*!
+ * @brief
+ * Matches a name against a segment with wildcards. Stars are handled by
+ * backtracking to the last one only, which bounds the work by the product of
+ * the lengths of the name and the pattern.
+ */
+static bool match_name(const Wildcard *wc, const Segment *seg, const TCHAR *name, size_t len) {
+    if (!seg->matches_hidden && is_hidden(name)) {
+        return false;
+    }
+
+    if (seg->suffix_len > 0 &&
+       (len < seg->suffix_len ||
+        !equal_units(&name[len - seg->suffix_len], &wc->text[seg->suffix], seg->suffix_len))) {
+        return false;
+    }
+
+    const Token *tokens = &wc->tokens[seg->first_token];
+    size_t count = seg->token_count;
+    size_t t = 0, n = 0;
+    size_t star_t = NO_POSITION, star_n = 0;
+
+    while (true) {
+        if (t < count) {
+            const Token *tok = &tokens[t];
+            size_t units = 0;
+            bool ok = false;
+
+            switch (tok->kind) {
+                case TOKEN_STAR:
+                    // A trailing star matches whatever is left
+                    if (++t == count) {
+                        return true;
+                    }
+
+                    star_t = t;
+                    star_n = n;
+                    continue;
+                case TOKEN_LITERAL:
+                    units = tok->len;
+                    ok = (len - n >= units) && equal_units(&name[n], &wc->text[tok->index], units);
+                    break;
+                case TOKEN_ANY:
+                    if (n < len) {
+                        decode_char(&name[n], len - n, &units);
+                        ok = true;
+                    }
+                    break;
+                case TOKEN_SET:
+                    if (n < len) {
+                        uint32_t c = decode_char(&name[n], len - n, &units);
+                        ok = set_matches(wc, &wc->sets[tok->index], c);
+                    }
+                    break;
+            }
+
+            if (ok) {
+                n += units;
+                t++;
+                continue;
+            }
+        } else if (n == len) {
+            return true;
+        }
+
+        // Let the last star take one more character and try again
+        if (star_t == NO_POSITION || star_n == len) {
+            return false;
+        }
+
+        size_t units;
+        decode_char(&name[star_n], len - star_n, &units);
+
+        star_n += units;
+        n = star_n;
+        t = star_t;
+    }
+}
+
+static bool needs_separator(const TCHAR *path, size_t len) {
+    if (len == 0 || is_separator(path[len - 1])) {
+        return false;
+    }
+
+#ifdef _WIN32
+    // "C:name" is relative to the current directory of drive C
+    if (len == 2 && path[1] == ':') {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Appends a name to the path being built.
+ *
+ * @return
+ * The new length of the path, or 0 if it would be too long, which is reported.
+ */
+static size_t append_name(Expansion *ex, size_t len, const TCHAR *name, size_t name_len) {
+    bool sep = needs_separator(ex->path, len);
+    size_t total = len + (sep ? 1 : 0) + name_len;
+
+    // Leaves room for the separator a directory match gets
+    if (total + 2 > PATH_CAPACITY) {
+        ex->report(ex->ctx, ex->path, FS_ERR_NAME_TOO_LONG);
+        ex->ok = false;
+        return 0;
+    }
+
+    if (sep) {
+        ex->path[len++] = PATH_SEP;
+    }
+
+    memcpy(&ex->path[len], name, name_len * sizeof(TCHAR));
+    ex->path[total] = '\0';
+
+    return total;
+}
+
+static void emit(Expansion *ex, size_t len) {
+    // Like the shell, a pattern that ends with a separator keeps it
+    if (ex->wc->dirs_only && needs_separator(ex->path, len)) {
+        ex->path[len++] = PATH_SEP;
+        ex->path[len] = '\0';
+    }
+
+    ex->match(ex->ctx, ex->path);
+    ex->matches++;
+}
+
+/*!
+ * @brief
+ * Checks whether the path being built names something that matches.
+ */
+static bool path_matches(const Expansion *ex) {
+    if (ex->wc->dirs_only) {
+        return fs_is_directory(ex->path, true);
+    }
+
+    FsTimes times;
+    return fs_stat_times(ex->path, false, &times);
+}
+
+/*!
+ * @brief
+ * Goes on with a directory entry that matched segment \p seg.
+ */
+static void entry_matched(
+    Expansion *ex, size_t seg, size_t len,
+    const FsDirEntry *entry, size_t name_len) {
+
+    size_t child = append_name(ex, len, entry->name, name_len);
+
+    if (child == 0) {
+        return;
+    }
+
+    if (seg + 1 == ex->wc->segment_count) {
+        if (!ex->wc->dirs_only || entry->is_dir ||
+            (entry->is_link && fs_is_directory(ex->path, true))) {
+            emit(ex, child);
+        }
+
+        return;
+    }
+
+    // Links may lead to directories; those that don't fail to list quietly
+    if (entry->is_dir || entry->is_link) {
+        expand(ex, seg + 1, child);
+    }
+}
+
+static bool push_name(NameList *list, const TCHAR *name, size_t name_len) {
+    if (list->used + name_len + 1 > list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+
+        while (capacity < list->used + name_len + 1) {
+            capacity *= 2;
+        }
+
+        TCHAR *chars = realloc(list->chars, capacity * sizeof(TCHAR));
+
+        if (!chars) {
+            return false;
+        }
+
+        list->chars = chars;
+        list->capacity = capacity;
+    }
+
+    memcpy(&list->chars[list->used], name, (name_len + 1) * sizeof(TCHAR));
+    list->used += name_len + 1;
+
+    return true;
+}
+
+/*!
+ * @brief
+ * Lists the directory at the path being built and matches its entries
+ * against segment \p seg, which has wildcards or is "**".
+ */
+static void expand_listing(Expansion *ex, size_t seg, size_t len) {
+    const Wildcard *wc = ex->wc;
+    bool globstar = (wc->segments[seg].kind == SEGMENT_GLOBSTAR);
+    bool last = (seg + 1 == wc->segment_count);
+
+    // "**" may stand for no directory at all, so entries are matched against
+    // the segment after it. A name without wildcards is simply looked up
+    size_t target = (globstar && !last) ? seg + 1 : seg;
+    const Segment *s = &wc->segments[target];
+
+    if (globstar && !last && s->kind == SEGMENT_NAME) {
+        expand(ex, target, len);
+        ex->path[len] = '\0';
+    }
+
+    FsDir *dir = fs_dir_open((len > 0) ? ex->path : _T("."));
+
+    if (!dir) {
+        FsError err = fs_last_error();
+
+        // Paths that lead nowhere are no different from names that don't match
+        if (!fs_error_is_missing(err)) {
+            ex->report(ex->ctx, (len > 0) ? ex->path : _T("."), err);
+            ex->ok = false;
+        }
+
+        return;
+    }
+
+    NameList subdirs = { 0 };
+    FsDirEntry entry;
+    FsError err;
+
+    while (fs_dir_next(dir, &entry, &err)) {
+        size_t name_len = _tcslen(entry.name);
+        bool hidden = is_hidden(entry.name);
+
+        if (!globstar) {
+            if (match_name(wc, s, entry.name, name_len)) {
+                entry_matched(ex, seg, len, &entry, name_len);
+            }
+
+            continue;
+        }
+
+        if (last) {
+            if (!hidden) {
+                entry_matched(ex, seg, len, &entry, name_len);
+            }
+        } else if (s->kind == SEGMENT_PATTERN && match_name(wc, s, entry.name, name_len)) {
+            entry_matched(ex, target, len, &entry, name_len);
+        }
+
+        // Subdirectories are descended into once the listing is closed, so
+        // deep trees don't hold a listing open for every level
+        if (!hidden && entry.is_dir && !entry.is_link &&
+            !push_name(&subdirs, entry.name, name_len)) {
+            err = FS_ERR_NO_MEMORY;
+            break;
+        }
+    }
+
+    fs_dir_close(dir);
+    ex->path[len] = '\0';
+
+    if (err != FS_OK) {
+        ex->report(ex->ctx, (len > 0) ? ex->path : _T("."), err);
+        ex->ok = false;
+    }
+
+    for (size_t i = 0; i < subdirs.used;) {
+        const TCHAR *name = &subdirs.chars[i];
+        size_t name_len = _tcslen(name);
+        size_t child = append_name(ex, len, name, name_len);
+
+        if (child > 0) {
+            expand_listing(ex, seg, child);
+        }
+
+        ex->path[len] = '\0';
+        i += name_len + 1;
+    }
+
+    free(subdirs.chars);
+}
+
+/*!
+ * @brief
+ * Matches the segments from \p seg onwards below the path being built, which
+ * is \p len characters long.
+ */
+static void expand(Expansion *ex, size_t seg, size_t len) {
+    const Wildcard *wc = ex->wc;
+
+    ex->path[len] = '\0';
+
+    if (seg == wc->segment_count) {
+        if (path_matches(ex)) {
+            emit(ex, len);
+        }
+
+        return;
+    }
+
+    const Segment *s = &wc->segments[seg];
+
+    if (s->kind != SEGMENT_NAME) {
+        // Like the shell, a trailing "**" also matches the directory it starts in
+        if (s->kind == SEGMENT_GLOBSTAR && seg + 1 == wc->segment_count &&
+            len > 0 && fs_is_directory(ex->path, true)) {
+            emit(ex, len);
+            ex->path[len] = '\0';
+        }
+
+        expand_listing(ex, seg, len);
+        return;
+    }
+
+    size_t child = append_name(ex, len, &wc->text[s->text], s->len);
+
+    if (child > 0) {
+        expand(ex, seg + 1, child);
+    }
+}
+
+bool wildcard_expand(
+    const Wildcard *wc,
+    WildcardMatchFn match, TreeReportFn report, void *ctx,
+    size_t *matches) {
+
+    Expansion ex = {
+        .wc = wc,
+        .match = match,
+        .report = report,
+        .ctx = ctx,
+        .path = malloc(PATH_CAPACITY * sizeof(TCHAR)),
+        .ok = true
+    };
+
+    *matches = 0;
+
+    if (!ex.path || wc->base_len + 2 > PATH_CAPACITY) {
+        report(ctx, wc->pattern, ex.path ? FS_ERR_NAME_TOO_LONG : FS_ERR_NO_MEMORY);
+        free(ex.path);
+        return false;
+    }
+
+    memcpy(ex.path, wc->pattern, wc->base_len * sizeof(TCHAR));
+    expand(&ex, 0, wc->base_len);
+
+    free(ex.path);
+
+    *matches = ex.matches;
+    return ex.ok;
+}
@@ -0,0 +1,121 @@
+/* wildcard.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef WILDCARD_H
+#define WILDCARD_H
+
+#include "fsbackend.h"
+#include "treewalk.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*!
+ * @brief
+ * A path pattern compiled by wildcard_compile().
+ */
+typedef struct wildcard Wildcard;
+
+/*!
+ * @brief
+ * Callback invoked for every path a pattern matches.
+ *
+ * @param ctx
+ * Context pointer of the expansion.
+ *
+ * @param path
+ * The matching path. Only valid for the duration of the call.
+ */
+typedef void (*WildcardMatchFn)(void *ctx, const TCHAR *path);
+
+/*!
+ * @brief
+ * Checks whether a path contains any wildcard: "*", "?" or a "[...]" set.
+ *
+ * @param path
+ * Path to check.
+ *
+ * @param sets
+ * Specifies whether "[...]" is a set. If false, brackets are taken literally,
+ * as they are legal in file names on Windows.
+ *
+ * @return
+ * true if \p path is a pattern that wildcard_compile() would expand; false if
+ * it names a single file.
+ */
+bool wildcard_is_pattern(const TCHAR *path, bool sets);
+
+/*!
+ * @brief
+ * Compiles a path pattern. Within a name, "*" matches any run of characters,
+ * "?" matches one character, and "[...]" matches one character of a set, which
+ * may hold ranges like "a-z" and is negated by a leading "!" or "^". A name
+ * that is just "**" matches any number of directories, including none. A
+ * wildcard character is matched literally by enclosing it in brackets, like
+ * "[*]", where sets are enabled.
+ *
+ * On Windows, names are matched case-insensitively. Elsewhere, they are
+ * matched case-sensitively, and names that begin with "." are only matched by
+ * patterns that spell out the leading ".", as in the shell.
+ *
+ * @param pattern
+ * The pattern to compile.
+ *
+ * @param sets
+ * Specifies whether "[...]" is a set, as in wildcard_is_pattern().
+ *
+ * @return
+ * Pointer to a new Wildcard, or NULL if memory could not be allocated.
+ */
+Wildcard *wildcard_compile(const TCHAR *pattern, bool sets);
+
+/*!
+ * @brief
+ * Finds every existing path that a pattern matches and passes each one to a
+ * callback as it is found, so that no expansion is ever held in memory.
+ *
+ * Only the directories the pattern can reach are listed, each with a single
+ * enumeration. The part of the pattern before its first wildcard is used as
+ * is, and names without wildcards after it are looked up directly. Matches
+ * come in the order the file system lists them. Like the shell, "**" does not
+ * descend into symbolic links or junctions, and a pattern that ends with a
+ * separator only matches directories.
+ *
+ * @param wc
+ * Pointer to the compiled pattern.
+ *
+ * @param match
+ * Invoked for every matching path.
+ *
+ * @param report
+ * Invoked for every directory that exists but could not be listed.
+ *
+ * @param ctx
+ * Context pointer passed to the callbacks.
+ *
+ * @param matches
+ * Pointer to a size_t that receives the number of matching paths.
+ *
+ * @return
+ * true if every directory the pattern reaches could be listed; false
+ * otherwise.
+ */
+bool wildcard_expand(
+    const Wildcard *wc,
+    WildcardMatchFn match, TreeReportFn report, void *ctx,
+    size_t *matches);
+
+/*!
+ * @brief
+ * Frees a pattern compiled by wildcard_compile().
+ *
+ * @param wc
+ * Pattern to free. If NULL, no action is taken.
+ */
+void wildcard_free(Wildcard *wc);
+
+#endif // WILDCARD_H
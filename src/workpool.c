@@ -0,0 +1,156 @@
+/* workpool.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#include "workpool.h"
+
+#include <stdbool.h>
+#include <threads.h>
+
+// Largest number of items a thread claims at once. Claiming in chunks keeps
+// the shared counter cold while still balancing uneven per-item latency
+#define CHUNK_MAX 64
+
+/*!
+ * @brief
+ * State shared by all threads of a single pool run.
+ */
+typedef struct work_pool {
+    mtx_t lock;
+    // Index of the next unclaimed item
+    size_t next;
+    size_t count;
+    size_t chunk;
+    WorkItemFn fn;
+    void *ctx;
+} WorkPool;
+
+/*!
+ * @brief
+ * Claims the next range of unprocessed items.
+ *
+ * @param pool
+ * Pointer to the shared pool state.
+ *
+ * @param begin
+ * Pointer to a size_t that receives the first index of the claimed range.
+ *
+ * @param end
+ * Pointer to a size_t that receives one past the last index of the range.
+ *
+ * @return
+ * true if a non-empty range was claimed; false if all items are taken.
+ */
+static bool claim_range(WorkPool *pool, size_t *begin, size_t *end) {
+    mtx_lock(&pool->lock);
+
+    size_t first = pool->next;
+    size_t last = first + pool->chunk;
+
+    if (last > pool->count) {
+        last = pool->count;
+    }
+
+    pool->next = last;
+
+    mtx_unlock(&pool->lock);
+
+    *begin = first;
+    *end = last;
+
+    return first < last;
+}
+
+/*!
+ * @brief
+ * Thread entry point. Processes claimed ranges until no items are left.
+ */
+static int worker_main(void *arg) {
+    WorkPool *pool = arg;
+    size_t begin, end;
+
+    while (claim_range(pool, &begin, &end)) {
+        for (size_t i = begin; i < end; i++) {
+            pool->fn(pool->ctx, i);
+        }
+    }
+
+    return 0;
+}
+
+unsigned int workpool_run(
+    unsigned int threads, size_t count,
+    WorkItemFn fn, void *ctx) {
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (threads > count) {
+        threads = (unsigned int)count;
+    }
+
+    if (threads > WORKPOOL_THREADS_MAX) {
+        threads = WORKPOOL_THREADS_MAX;
+    }
+
+    // Common case: nothing to parallelize, so don't pay for thread startup
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(ctx, i);
+        }
+
+        return 1;
+    }
+
+    WorkPool pool = {
+        .next = 0,
+        .count = count,
+        .fn = fn,
+        .ctx = ctx
+    };
+
+    // Aim for several chunks per thread so a thread that drew slow items
+    // doesn't hold up the rest of the run
+    pool.chunk = count / ((size_t)threads * 8);
+
+    if (pool.chunk == 0) {
+        pool.chunk = 1;
+    } else if (pool.chunk > CHUNK_MAX) {
+        pool.chunk = CHUNK_MAX;
+    }
+
+    if (mtx_init(&pool.lock, mtx_plain) != thrd_success) {
+        for (size_t i = 0; i < count; i++) {
+            fn(ctx, i);
+        }
+
+        return 1;
+    }
+
+    thrd_t workers[WORKPOOL_THREADS_MAX];
+    unsigned int started = 0;
+
+    // The calling thread is a worker as well, so start one thread less
+    for (unsigned int i = 1; i < threads; i++) {
+        if (thrd_create(&workers[started], worker_main, &pool) != thrd_success) {
+            // Not fatal; the remaining threads will pick up the slack
+            break;
+        }
+
+        started++;
+    }
+
+    worker_main(&pool);
+
+    for (unsigned int i = 0; i < started; i++) {
+        thrd_join(workers[i], NULL);
+    }
+
+    mtx_destroy(&pool.lock);
+
+    return started + 1;
+}
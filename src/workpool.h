@@ -0,0 +1,55 @@
+/* workpool.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stddef.h>
+
+// Upper bound on the number of threads a pool may run
+#define WORKPOOL_THREADS_MAX 256
+
+/*!
+ * @brief
+ * Callback invoked once for every item of a work pool run.
+ *
+ * @param ctx
+ * Caller-supplied context pointer shared by all items.
+ *
+ * @param index
+ * Zero-based index of the item to process.
+ */
+typedef void (*WorkItemFn)(void *ctx, size_t index);
+
+/*!
+ * @brief
+ * Runs \p fn for every index in [0, \p count) across a fixed set of threads
+ * and returns once all items have been processed.
+ *
+ * @param threads
+ * Number of threads to process items with, including the calling thread. If
+ * this is 1 or less, or there is only a single item, the items are processed
+ * on the calling thread and no thread is started.
+ *
+ * @param count
+ * Number of items to process.
+ *
+ * @param fn
+ * Callback invoked for each item. It may be called concurrently from several
+ * threads, but never twice for the same index.
+ *
+ * @param ctx
+ * Context pointer passed to \p fn.
+ *
+ * @return
+ * The number of threads that actually processed items.
+ */
+unsigned int workpool_run(
+    unsigned int threads, size_t count,
+    WorkItemFn fn, void *ctx);
+
+#endif // WORKPOOL_H
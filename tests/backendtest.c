@@ -0,0 +1,247 @@
+/* backendtest.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks the file system backend against the files of a scratch directory:
+// opening and creating, reading and setting times through a handle and by
+// path, setting the current time on a file of another user, and the errors
+// reported for files that are missing or that cannot be created.
+//
+// Usage: backendtest [DIR]
+//
+//   DIR  Directory to create the scratch directory in (default .).
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "check.h"
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define TEST_PATH_CAPACITY 512
+
+// 2001-01-01T00:00:00Z and 2002-01-01T00:00:00Z, in whole seconds so that
+// every file system records them exactly
+#define TIME_A 126227808000000000ULL
+#define TIME_B 126543168000000000ULL
+
+#ifdef _WIN32
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+static void check_handle_times(const TCHAR *path) {
+    FsFile file;
+
+    CHECK(fs_open(&file, path, FS_OPEN_CREATE));
+
+    FsTimes set = { FS_TIME_OMIT, TIME_A, TIME_B };
+    FsTimes got;
+
+    CHECK(fs_set_times(&file, &set));
+    CHECK(fs_get_times(&file, &got));
+    CHECK(got.access == TIME_A && got.write == TIME_B);
+
+    // Omitted times are left as they are
+    set = (FsTimes) { FS_TIME_OMIT, FS_TIME_OMIT, TIME_A };
+
+    CHECK(fs_set_times(&file, &set));
+    CHECK(fs_get_times(&file, &got));
+    CHECK(got.access == TIME_A && got.write == TIME_A);
+
+    fs_close(&file);
+}
+
+static void check_path_times(const TCHAR *path) {
+    FsTimes set = { FS_TIME_OMIT, TIME_B, TIME_A };
+    FsTimes got;
+
+    CHECK(fs_set_times_by_path(path, true, &set));
+    CHECK(fs_stat_times(path, true, &got));
+    CHECK(got.access == TIME_B && got.write == TIME_A);
+}
+
+static void check_missing(const TCHAR *path) {
+    FsFile file;
+    FsTimes got;
+    FsTimes set = { FS_TIME_OMIT, TIME_A, TIME_A };
+
+    CHECK(!fs_open(&file, path, 0));
+    CHECK(fs_error_is_missing(fs_last_error()));
+
+    CHECK(!fs_stat_times(path, true, &got));
+    CHECK(fs_error_is_missing(fs_last_error()));
+
+    CHECK(!fs_set_times_by_path(path, true, &set));
+    CHECK(fs_error_is_missing(fs_last_error()));
+}
+
+#ifndef _WIN32
+/*!
+ * @brief
+ * Checks that a file that cannot be created is reported for why, and not as
+ * missing. A read-only directory refuses files to any user but root, who is
+ * still refused them in /sys.
+ */
+static void check_create_refused(const TCHAR *root) {
+    // Leaves room in path for the file name
+    TCHAR dir[TEST_PATH_CAPACITY / 2];
+    TCHAR path[TEST_PATH_CAPACITY];
+    bool own_dir = geteuid() != 0;
+
+    if (own_dir) {
+        // A scratch directory too deep for the name leaves nothing to check
+        if (snprintf(dir, TEST_PATH_CAPACITY / 2, "%s/readonly", root) >= TEST_PATH_CAPACITY / 2) {
+            return;
+        }
+
+        mkdir(dir, 0555);
+    } else if (fs_is_directory("/sys", true)) {
+        snprintf(dir, TEST_PATH_CAPACITY / 2, "/sys");
+    } else {
+        return;
+    }
+
+    snprintf(path, TEST_PATH_CAPACITY, "%s/backendtest-new", dir);
+
+    FsFile file;
+    bool opened = fs_open(&file, path, FS_OPEN_CREATE);
+
+    CHECK(!opened);
+    CHECK(opened || !fs_error_is_missing(fs_last_error()));
+
+    if (opened) {
+        fs_close(&file);
+        remove(path);
+    }
+
+    if (own_dir) {
+        rmdir(dir);
+    }
+}
+
+/*!
+ * @brief
+ * Checks that the current time can be set on a file that the caller may write
+ * but does not own, which POSIX allows for the current time only. Root owns
+ * such a file and hands it to a child that runs as another user; other users
+ * have no file of another user to try it on.
+ */
+static void check_now_unowned(const TCHAR *root) {
+    if (geteuid() != 0) {
+        return;
+    }
+
+    TCHAR path[TEST_PATH_CAPACITY];
+    snprintf(path, TEST_PATH_CAPACITY, "%s/unowned", root);
+
+    FsFile file;
+
+    CHECK(fs_open(&file, path, FS_OPEN_CREATE));
+    fs_close(&file);
+    CHECK(chmod(path, 0666) == 0);
+
+    FsTimes old = { FS_TIME_OMIT, TIME_A, TIME_A };
+    CHECK(fs_set_times_by_path(path, true, &old));
+
+    pid_t child = fork();
+
+    if (child == 0) {
+        // Relative paths need no search permission on the directories above,
+        // which the other user may lack
+        FsTimes now = { FS_TIME_OMIT, FS_TIME_NOW, FS_TIME_NOW };
+        FsTimes given = { FS_TIME_OMIT, TIME_B, TIME_B };
+
+        if (chdir(root) != 0 || setgid(65534) != 0 || setuid(65534) != 0) {
+            _exit(CHECK_SKIP);
+        }
+
+        CHECK(fs_set_times_by_path("unowned", true, &now));
+
+        // Opens the file as touch does, without creating it
+        bool opened = fs_open(&file, "unowned", 0);
+
+        CHECK(opened);
+
+        if (opened) {
+            CHECK(fs_set_times(&file, &now));
+            fs_close(&file);
+        }
+
+        // Only the owner may set a given time
+        CHECK(!fs_set_times_by_path("unowned", true, &given));
+        CHECK(fs_last_error() == EPERM);
+
+        _exit(check_exit_code());
+    }
+
+    int status;
+
+    CHECK(child > 0 && waitpid(child, &status, 0) == child);
+    CHECK(child > 0 && WIFEXITED(status) &&
+          (WEXITSTATUS(status) == EXIT_SUCCESS || WEXITSTATUS(status) == CHECK_SKIP));
+
+    FsTimes got;
+
+    CHECK(fs_stat_times(path, true, &got));
+    CHECK(got.write > TIME_B && got.access > TIME_B);
+
+    remove(path);
+}
+#endif
+
+int _tmain(int argc, TCHAR **argv) {
+    const TCHAR *dir = (argc > 1) ? argv[1] : _T(".");
+
+    TCHAR root[TEST_PATH_CAPACITY / 2];
+    _sntprintf(root, TEST_PATH_CAPACITY / 2, _T("%s%cbackendtest-files"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR file[TEST_PATH_CAPACITY];
+    _sntprintf(file, TEST_PATH_CAPACITY, _T("%s%cfile"), root, PATH_SEP);
+
+    TCHAR missing[TEST_PATH_CAPACITY];
+    _sntprintf(missing, TEST_PATH_CAPACITY, _T("%s%cmissing"), root, PATH_SEP);
+
+    check_handle_times(file);
+    check_path_times(file);
+    check_missing(missing);
+
+#ifndef _WIN32
+    check_create_refused(root);
+    check_now_unowned(root);
+#endif
+
+    // A time after this test was written
+    CHECK(fs_now() > 133800000000000000ULL);
+
+    _tremove(file);
+    remove_dir(root);
+
+    return check_exit_code();
+}
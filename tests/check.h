@@ -0,0 +1,38 @@
+/* check.h
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// What the tests in tests/ share: CHECK() reports a failed condition with its
+// location and counts it, and a test exits with check_exit_code() once it has
+// run all of its checks, so that one failure does not hide the others. A test
+// that cannot run where it is built exits with CHECK_SKIP, which CTest reports
+// as skipped rather than passed.
+
+#define CHECK_SKIP 77
+
+static unsigned long check_failures;
+
+#define CHECK(cond) \
+    ((cond) ? (void)0 : \
+        (check_failures++, \
+         fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond)))
+
+static int check_exit_code(void) {
+    if (check_failures > 0) {
+        fprintf(stderr, "%lu check(s) failed\n", check_failures);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,383 @@
+/* daemontest.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks the protocol between daemon_forward() and a server run by
+// daemon_serve() on a thread of this process: that every path of a request
+// reaches the server, empty ones included, that requests whose paths do not
+// match their count are rejected, that a reply which does not account for
+// every file is not taken as success, and that a client that stops sending,
+// or never reads its reply, does not hold the server.
+//
+// Usage: daemontest [DIR]
+//
+//   DIR  Directory to create the scratch directory in (default .).
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "daemon.h"
+#include "ipc.h"
+#include "check.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <threads.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define TEST_PATH_CAPACITY 512
+
+// Number of times to check whether a server is up before giving up
+#define SERVER_START_TRIES 500
+
+#ifdef _WIN32
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+static void sleep_ms(unsigned int ms) {
+    thrd_sleep(&(struct timespec) { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 }, NULL);
+}
+
+static int serve_main(void *arg) {
+    daemon_serve(arg, 1);
+    return 0;
+}
+
+/*!
+ * @brief
+ * A server that answers any request with the reply it is given, standing in
+ * for one that does not account for every file.
+ */
+typedef struct fake_server {
+    IpcServer *server;
+    const char *reply;
+} FakeServer;
+
+static int fake_main(void *arg) {
+    FakeServer *fake = arg;
+
+    for (;;) {
+        IpcConn *conn = ipc_accept(fake->server);
+
+        if (!conn) {
+            continue;
+        }
+
+        // Reads the whole request, which has an empty string after its fields
+        // and another after its paths, so that the client is not cut off
+        // while it still writes
+        char buf[4096];
+        size_t used = 0, received;
+        int empty = 0;
+
+        while (empty < 2 && used < sizeof(buf) &&
+               ipc_read(conn, &buf[used], sizeof(buf) - used, &received) && received > 0) {
+            for (size_t i = used; i < used + received; i++) {
+                if (buf[i] == '\0' && i > 0 && buf[i - 1] == '\0') {
+                    empty++;
+                }
+            }
+
+            used += received;
+        }
+
+        ipc_write(conn, fake->reply, strlen(fake->reply));
+        ipc_close(conn);
+    }
+
+    return 0;
+}
+
+static bool wait_for_server(const TCHAR *address) {
+    for (int tries = 0; tries < SERVER_START_TRIES; tries++) {
+        IpcConn *probe = ipc_connect(address);
+
+        if (probe) {
+            ipc_close(probe);
+            return true;
+        }
+
+        sleep_ms(10);
+    }
+
+    return false;
+}
+
+typedef struct failures {
+    size_t count;
+    const TCHAR *last;
+} Failures;
+
+static void record_failure(void *ctx, const TCHAR *path, FsError err) {
+    Failures *failures = ctx;
+    (void)err;
+
+    failures->count++;
+    failures->last = path;
+}
+
+/*!
+ * @brief
+ * Sends a request as is and reads the whole reply.
+ */
+static bool send_raw(const TCHAR *address, const char *req, size_t size, char *reply, size_t capacity) {
+    IpcConn *conn = ipc_connect(address);
+
+    if (!conn) {
+        return false;
+    }
+
+    size_t used = 0, received;
+    bool ok = ipc_write(conn, req, size);
+
+    while (ok && used + 1 < capacity &&
+           ipc_read(conn, &reply[used], capacity - used - 1, &received) && received > 0) {
+        used += received;
+    }
+
+    reply[used] = '\0';
+    ipc_close(conn);
+
+    return ok;
+}
+
+static bool exists(const TCHAR *path) {
+    FsTimes times;
+    return fs_stat_times(path, true, &times);
+}
+
+/*!
+ * @brief
+ * Checks that an empty path fails on its own, as on the command line, and
+ * that the paths after it are still touched.
+ */
+static void check_empty_path(const TCHAR *address, const TCHAR *root) {
+    TCHAR a[TEST_PATH_CAPACITY], b[TEST_PATH_CAPACITY];
+
+    _sntprintf(a, TEST_PATH_CAPACITY, _T("%s%ca"), root, PATH_SEP);
+    _sntprintf(b, TEST_PATH_CAPACITY, _T("%s%cb"), root, PATH_SEP);
+
+    const TCHAR *paths[] = { a, _T(""), b };
+    DaemonRequest req = {
+        .paths = paths,
+        .count = 3,
+        .ft_flags = FT_ACCESS | FT_WRITE,
+        .follow_symlinks = true
+    };
+
+    Failures failures = { 0 };
+
+    CHECK(daemon_forward(address, &req, record_failure, &failures) == DAEMON_FAILED);
+    CHECK(failures.count == 1 && failures.last == paths[1]);
+    CHECK(exists(a));
+    CHECK(exists(b));
+
+    _tremove(a);
+    _tremove(b);
+}
+
+/*!
+ * @brief
+ * Checks that requests are rejected when they have more paths than their
+ * count field gives, or when it is missing or invalid. One with fewer is not
+ * over until the client ends it, as a path may be empty, and is dropped
+ * without a reply once the server stops waiting for the rest.
+ */
+static void check_count_mismatch(const TCHAR *address) {
+    static const char fewer[] = "touch 1\0count=2\0\0/nonexistent/x\0";
+    static const char bad[] = "touch 1\0count=two\0\0/nonexistent/x\0";
+    static const char more[] = "touch 1\0count=1\0\0/nonexistent/x\0/nonexistent/y\0";
+    static const char none[] = "touch 1\0\0/nonexistent/x\0";
+
+    char reply[256];
+
+    // The terminating null character of each literal ends the request
+    CHECK(send_raw(address, fewer, sizeof(fewer), reply, sizeof(reply)));
+    CHECK(reply[0] == '\0');
+
+    CHECK(send_raw(address, bad, sizeof(bad), reply, sizeof(reply)));
+    CHECK(strcmp(reply, "error count\n") == 0);
+
+    CHECK(send_raw(address, more, sizeof(more), reply, sizeof(reply)));
+    CHECK(strcmp(reply, "error count\n") == 0);
+
+    CHECK(send_raw(address, none, sizeof(none), reply, sizeof(reply)));
+    CHECK(strcmp(reply, "error count\n") == 0);
+}
+
+/*!
+ * @brief
+ * Checks that a client that connects and sends nothing is dropped, and does
+ * not keep the only thread of the server from serving others.
+ */
+static void check_stalled_client(const TCHAR *address, const TCHAR *root) {
+    IpcConn *stalled = ipc_connect(address);
+
+    CHECK(stalled != NULL);
+
+    TCHAR c[TEST_PATH_CAPACITY];
+    _sntprintf(c, TEST_PATH_CAPACITY, _T("%s%cc"), root, PATH_SEP);
+
+    const TCHAR *paths[] = { c };
+    DaemonRequest req = {
+        .paths = paths,
+        .count = 1,
+        .ft_flags = FT_ACCESS | FT_WRITE,
+        .follow_symlinks = true
+    };
+
+    Failures failures = { 0 };
+
+    CHECK(daemon_forward(address, &req, record_failure, &failures) == DAEMON_OK);
+    CHECK(exists(c));
+
+    // The server closed the connection without replying
+    if (stalled) {
+        char reply[16];
+        size_t received;
+
+        CHECK(ipc_read(stalled, reply, sizeof(reply), &received) && received == 0);
+        ipc_close(stalled);
+    }
+
+    _tremove(c);
+}
+
+/*!
+ * @brief
+ * Checks that a client that sends a request but never reads the reply does
+ * not keep the only thread of the server from serving others once the reply
+ * is written.
+ */
+static void check_idle_reader(const TCHAR *address, const TCHAR *root) {
+    static const char req[] = "touch 1\0count=0\0\0";
+
+    IpcConn *idle = ipc_connect(address);
+
+    CHECK(idle != NULL);
+
+    // The terminating null character of the literal ends the request
+    CHECK(idle && ipc_write(idle, req, sizeof(req)));
+
+    TCHAR d[TEST_PATH_CAPACITY];
+    _sntprintf(d, TEST_PATH_CAPACITY, _T("%s%cd"), root, PATH_SEP);
+
+    const TCHAR *paths[] = { d };
+    DaemonRequest forwarded = {
+        .paths = paths,
+        .count = 1,
+        .ft_flags = FT_ACCESS | FT_WRITE,
+        .follow_symlinks = true
+    };
+
+    Failures failures = { 0 };
+
+    CHECK(daemon_forward(address, &forwarded, record_failure, &failures) == DAEMON_OK);
+    CHECK(exists(d));
+
+    // The reply is still there to read
+    if (idle) {
+        char reply[64];
+        size_t used = 0, received;
+
+        while (used + 1 < sizeof(reply) &&
+               ipc_read(idle, &reply[used], sizeof(reply) - used - 1, &received) && received > 0) {
+            used += received;
+        }
+
+        reply[used] = '\0';
+        CHECK(strcmp(reply, "ok 0 0\n") == 0);
+
+        ipc_close(idle);
+    }
+
+    _tremove(d);
+}
+
+/*!
+ * @brief
+ * Checks that the client does not take a reply that leaves files unaccounted
+ * for as success.
+ */
+static void check_short_reply(const TCHAR *address) {
+    const TCHAR *paths[] = { _T("x"), _T("y") };
+    DaemonRequest req = {
+        .paths = paths,
+        .count = 2,
+        .ft_flags = FT_ACCESS | FT_WRITE,
+        .follow_symlinks = true
+    };
+
+    Failures failures = { 0 };
+
+    CHECK(daemon_forward(address, &req, record_failure, &failures) == DAEMON_IO_ERROR);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    const TCHAR *dir = (argc > 1) ? argv[1] : _T(".");
+
+    TCHAR root[TEST_PATH_CAPACITY / 2];
+    _sntprintf(root, TEST_PATH_CAPACITY / 2, _T("%s%cdaemontest-files"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR address[TEST_PATH_CAPACITY];
+    TCHAR fake_address[TEST_PATH_CAPACITY];
+#ifdef _WIN32
+    _sntprintf(address, TEST_PATH_CAPACITY, _T("touch-daemontest-%lu"), GetCurrentProcessId());
+    _sntprintf(fake_address, TEST_PATH_CAPACITY, _T("touch-daemontest-fake-%lu"), GetCurrentProcessId());
+#else
+    _sntprintf(address, TEST_PATH_CAPACITY, _T("%s%csock"), root, PATH_SEP);
+    _sntprintf(fake_address, TEST_PATH_CAPACITY, _T("%s%cfake"), root, PATH_SEP);
+#endif
+
+    thrd_t server;
+
+    if (thrd_create(&server, serve_main, address) != thrd_success || !wait_for_server(address)) {
+        fprintf(stderr, "the server did not start\n");
+        return EXIT_FAILURE;
+    }
+
+    FakeServer fake = { ipc_listen(fake_address), "ok 5 0\n" };
+    thrd_t fake_thread;
+
+    if (!fake.server || thrd_create(&fake_thread, fake_main, &fake) != thrd_success) {
+        fprintf(stderr, "the fake server did not start\n");
+        return EXIT_FAILURE;
+    }
+
+    check_empty_path(address, root);
+    check_count_mismatch(address);
+    check_stalled_client(address, root);
+    check_idle_reader(address, root);
+    check_short_reply(fake_address);
+
+    // The servers end with the process
+    _tremove(address);
+    _tremove(fake_address);
+    remove_dir(root);
+
+    return check_exit_code();
+}
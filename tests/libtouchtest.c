@@ -0,0 +1,142 @@
+/* libtouchtest.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks that an operation of libtouch creates its files in batches, and that
+// it keeps doing so when it is passed to another thread between batches.
+// Files are created in a batch so that they are opened through the executor
+// of the operation, which existing files given a fixed time are not.
+//
+// Usage: libtouchtest [DIR]
+//
+//   DIR  Directory to create the scratch directory in (default .).
+
+#include "libtouch.h"
+#include "fsbackend.h"
+#include "platform.h"
+#include "check.h"
+
+#include <stdbool.h>
+#include <threads.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define TEST_PATH_CAPACITY 512
+
+// Number of files of each batch, enough for touch_batch() to run them together
+#define TEST_FILES 8
+
+// 2001-01-01T00:00:00Z
+#define TIME_A 126227808000000000ULL
+
+#ifdef _WIN32
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+typedef struct batch_job {
+    TouchOp *op;
+    const TCHAR *const *paths;
+} BatchJob;
+
+/*!
+ * @brief
+ * Touches the files of a job, which are missing, then checks that each one
+ * was created with the time of the operation.
+ */
+static int run_batch(void *arg) {
+    BatchJob *job = arg;
+    TouchResult results[TEST_FILES];
+
+    CHECK(touch_batch(job->paths, TEST_FILES, job->op, results) == 0);
+
+    for (size_t i = 0; i < TEST_FILES; i++) {
+        FsTimes got;
+
+        CHECK(results[i].ok);
+        CHECK(fs_stat_times(job->paths[i], true, &got));
+        CHECK(got.access == TIME_A && got.write == TIME_A);
+    }
+
+    return 0;
+}
+
+static void remove_files(const TCHAR *const *paths) {
+    for (size_t i = 0; i < TEST_FILES; i++) {
+        _tremove(paths[i]);
+    }
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    const TCHAR *dir = (argc > 1) ? argv[1] : _T(".");
+
+    TCHAR root[TEST_PATH_CAPACITY / 2];
+    _sntprintf(root, TEST_PATH_CAPACITY / 2, _T("%s%clibtouchtest-files"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR names[TEST_FILES][TEST_PATH_CAPACITY];
+    const TCHAR *paths[TEST_FILES];
+
+    for (size_t i = 0; i < TEST_FILES; i++) {
+        _sntprintf(names[i], TEST_PATH_CAPACITY, _T("%s%cf%zu"), root, PATH_SEP, i);
+        paths[i] = names[i];
+    }
+
+    TouchSpec spec = { .stamp = _T("2001-01-01T00:00:00Z") };
+    TouchSpecError why;
+    TouchOp *op = touch_op_open(&spec, &why);
+
+    if (!op) {
+        fprintf(stderr, "touch_op_open() failed with %d\n", (int)why);
+        return EXIT_FAILURE;
+    }
+
+    BatchJob job = { op, paths };
+
+    // The first batch opens the executor of the operation
+    run_batch(&job);
+
+    // Then another thread runs the next one with the same operation
+    remove_files(paths);
+
+    thrd_t thread;
+    bool started = thrd_create(&thread, run_batch, &job) == thrd_success;
+
+    CHECK(started);
+
+    if (started) {
+        thrd_join(thread, NULL);
+    }
+
+    // And the first thread once more
+    remove_files(paths);
+    run_batch(&job);
+
+    touch_op_close(op);
+    remove_files(paths);
+    remove_dir(root);
+
+    return check_exit_code();
+}
@@ -0,0 +1,43 @@
+# manifest.cmake
+# Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+#
+# This software may be modified and distributed under the terms
+# of the MIT license. See the LICENSE file for details.
+
+# Checks that of two manifest rows for the same file, the later one wins, even
+# when the rows reach the file through different spellings of its directory.
+#
+# Usage: cmake -DTOUCH=PATH -DWORK_DIR=PATH -P manifest.cmake
+
+set(root ${WORK_DIR}/manifest-files)
+file(REMOVE_RECURSE ${root})
+file(MAKE_DIRECTORY ${root}/a)
+
+set(tab "\t")
+set(manifest "./a/f1${tab}2009-01-01T00:00:00Z\n")
+
+foreach(i 1 2 3 4 5)
+    file(WRITE ${root}/a/f${i} "")
+    string(APPEND manifest "a/f${i}${tab}2001-01-01T00:00:00Z\n")
+endforeach()
+
+file(WRITE ${root}/manifest.txt ${manifest})
+
+execute_process(
+    COMMAND ${TOUCH} -j 1 -M manifest.txt
+    WORKING_DIRECTORY ${root}
+    RESULT_VARIABLE result)
+
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "touch -M failed")
+endif()
+
+foreach(i 1 2 3 4 5)
+    file(TIMESTAMP ${root}/a/f${i} year "%Y" UTC)
+
+    if(NOT year STREQUAL "2001")
+        message(FATAL_ERROR "a/f${i} was given the year ${year} rather than 2001")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE ${root})
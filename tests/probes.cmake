@@ -0,0 +1,39 @@
+# probes.cmake
+# Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+#
+# This software may be modified and distributed under the terms
+# of the MIT license. See the LICENSE file for details.
+
+# Checks that every probe of the "touch" provider listed in src/probes.h is
+# described by a note in the built binary, where perf and bpftrace look for
+# them.
+#
+# Usage: cmake -DREADELF=PATH -DBINARY=PATH -P probes.cmake
+
+set(PROBES
+    touch_start touch_end
+    open_start open_end
+    set_times_start set_times_end
+    parse_start parse_end
+    error)
+
+execute_process(
+    COMMAND ${READELF} -n ${BINARY}
+    OUTPUT_VARIABLE notes
+    RESULT_VARIABLE result)
+
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "readelf failed on ${BINARY}")
+endif()
+
+set(missing "")
+
+foreach(probe ${PROBES})
+    if(NOT notes MATCHES "Provider: touch\n[ \t]*Name: ${probe}\n")
+        list(APPEND missing ${probe})
+    endif()
+endforeach()
+
+if(missing)
+    message(FATAL_ERROR "${BINARY} lacks the probes: ${missing}")
+endif()
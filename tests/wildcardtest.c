@@ -0,0 +1,139 @@
+/* wildcardtest.c
+ * Copyright (C) 2026 Jad Altahan (https://github.com/xv)
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license. See the LICENSE file for details.
+ */
+
+// Checks that "[...]" is taken as part of a name when sets are disabled, as
+// they are by default on Windows, where brackets are legal in file names, and
+// as a set otherwise.
+//
+// Usage: wildcardtest [DIR]
+//
+//   DIR  Directory to create the scratch directory in (default .).
+
+#include "platform.h"
+#include "fsbackend.h"
+#include "wildcard.h"
+#include "check.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maximum length of a generated path, including the terminating null character
+#define TEST_PATH_CAPACITY 512
+
+#ifdef _WIN32
+static void make_dir(const TCHAR *path) {
+    _tmkdir(path);
+}
+
+static void remove_dir(const TCHAR *path) {
+    _trmdir(path);
+}
+#else
+static void make_dir(const TCHAR *path) {
+    mkdir(path, 0755);
+}
+
+static void remove_dir(const TCHAR *path) {
+    rmdir(path);
+}
+#endif
+
+/*!
+ * @brief
+ * Matches of an expansion, of which the test only needs the last.
+ */
+typedef struct matched {
+    size_t count;
+    TCHAR last[TEST_PATH_CAPACITY];
+} Matched;
+
+static void record_match(void *ctx, const TCHAR *path) {
+    Matched *matched = ctx;
+
+    matched->count++;
+    _sntprintf(matched->last, TEST_PATH_CAPACITY, _T("%s"), path);
+}
+
+static void ignore_error(void *ctx, const TCHAR *path, FsError err) {
+    (void)ctx;
+    (void)path;
+    (void)err;
+}
+
+static void create(const TCHAR *path) {
+    FsFile file;
+
+    CHECK(fs_open(&file, path, FS_OPEN_CREATE));
+    fs_close(&file);
+}
+
+/*!
+ * @brief
+ * Expands a pattern relative to the scratch directory and checks that it
+ * matches one file only, whose name is \p expected.
+ */
+static void check_single_match(const TCHAR *root, const TCHAR *pattern, bool sets, const TCHAR *expected) {
+    TCHAR full[TEST_PATH_CAPACITY];
+    _sntprintf(full, TEST_PATH_CAPACITY, _T("%s%c%s"), root, PATH_SEP, pattern);
+
+    Wildcard *wc = wildcard_compile(full, sets);
+    Matched matched = { 0 };
+    size_t matches = 0;
+
+    CHECK(wc != NULL);
+
+    if (!wc) {
+        return;
+    }
+
+    CHECK(wildcard_expand(wc, record_match, ignore_error, &matched, &matches));
+    CHECK(matches == 1 && matched.count == 1);
+
+    size_t len = _tcslen(matched.last);
+    size_t expected_len = _tcslen(expected);
+
+    CHECK(len >= expected_len && _tcscmp(&matched.last[len - expected_len], expected) == 0);
+
+    wildcard_free(wc);
+}
+
+int _tmain(int argc, TCHAR **argv) {
+    const TCHAR *dir = (argc > 1) ? argv[1] : _T(".");
+
+    TCHAR root[TEST_PATH_CAPACITY / 2];
+    _sntprintf(root, TEST_PATH_CAPACITY / 2, _T("%s%cwildcardtest-files"), dir, PATH_SEP);
+    make_dir(root);
+
+    TCHAR bracketed[TEST_PATH_CAPACITY], plain[TEST_PATH_CAPACITY];
+    _sntprintf(bracketed, TEST_PATH_CAPACITY, _T("%s%ca[1].txt"), root, PATH_SEP);
+    _sntprintf(plain, TEST_PATH_CAPACITY, _T("%s%ca1.txt"), root, PATH_SEP);
+
+    create(bracketed);
+    create(plain);
+
+    // A name with brackets only is a pattern where sets are enabled
+    CHECK(!wildcard_is_pattern(_T("a[1].txt"), false));
+    CHECK(wildcard_is_pattern(_T("a[1].txt"), true));
+    CHECK(wildcard_is_pattern(_T("a[1]*.txt"), false));
+
+    // Other wildcards still expand around brackets taken literally
+    check_single_match(root, _T("a[1]*"), false, _T("a[1].txt"));
+    check_single_match(root, _T("a[1]*"), true, _T("a1.txt"));
+
+    _tremove(bracketed);
+    _tremove(plain);
+    remove_dir(root);
+
+    return check_exit_code();
+}